@@ -7,9 +7,14 @@
 #include <chainparams.h>
 #include <evo/providertx.h>
 #include <evo/specialtx.h>
+#include <memusage.h>
+#include <algorithm>
+#include <functional>
 #include <regex>
+#include <set>
 #include <spork.h>
 #include <validation.h>
+#include <util/memory.h>
 #include <wallet/wallet.h>
 #include <univalue.h>
 
@@ -120,19 +125,289 @@ CDatabaseAssetData::CDatabaseAssetData() {
     SetNull();
 }
 
+//! std::set::insert semantics: an element with the same key that is already in the set is kept
+template<typename Set, typename T>
+static void SetInsert(Set &set, const T &value) {
+    if (!set.count(value)) set = set.insert(value);
+}
+
+template<typename Set, typename T>
+static void SetErase(Set &set, const T &value) {
+    if (set.count(value)) set = set.erase(value);
+}
+
+static size_t StringUsage(const std::string &str) {
+    // short strings are stored inside the std::string itself. Go by the size rather than the capacity so an entry
+    // is charged the same when it is added to and removed from the running totals, whichever copy is measured.
+    return str.size() > 15 ? memusage::MallocUsage(str.size() + 1) : 0;
+}
+
+CAssetsCacheUsage assetsCacheUsage;
+
+void CAssetsCacheUsage::EraseKey(const std::string &key) {
+    auto it = mapIndex.find(key);
+    if (it == mapIndex.end())
+        return;
+    nKeysUsage -= StringUsage(key);
+    listRecency.erase(it->second);
+    mapIndex.erase(it);
+}
+
+void CAssetsCacheUsage::Touch(const std::string &key, bool fCached) {
+    LOCK(cs);
+    if (!fCached) {
+        // a miss goes on to read the asset db, which costs far more than this
+        EraseKey(key);
+        return;
+    }
+    auto inserted = mapIndex.emplace(key, listRecency.end());
+    if (inserted.second) {
+        nKeysUsage += StringUsage(key);
+        listRecency.push_front(&inserted.first->first);
+        inserted.first->second = listRecency.begin();
+    } else {
+        listRecency.splice(listRecency.begin(), listRecency, inserted.first->second);
+    }
+}
+
+void CAssetsCacheUsage::Forget(const std::string &key) {
+    LOCK(cs);
+    EraseKey(key);
+}
+
+void CAssetsCacheUsage::Clear() {
+    LOCK(cs);
+    listRecency.clear();
+    mapIndex.clear();
+    nKeysUsage = 0;
+}
+
+void CAssetsCacheUsage::EvictLeastRecent(const std::function<bool()> &fDone,
+                                         const std::function<bool(const std::string &)> &evict) {
+    LOCK(cs);
+    auto it = listRecency.end();
+    while (it != listRecency.begin() && !fDone()) {
+        --it;
+        const std::string &key = **it;
+        if (!evict(key))
+            continue;
+        // it goes away with the key, the walk continues with the key used right after it
+        auto next = std::next(it);
+        EraseKey(key);
+        it = next;
+    }
+}
+
+bool CAssetsCacheUsage::IsTracked(const std::string &key) const {
+    LOCK(cs);
+    return mapIndex.count(key);
+}
+
+size_t CAssetsCacheUsage::Size() const {
+    LOCK(cs);
+    return mapIndex.size();
+}
+
+size_t CAssetsCacheUsage::DynamicMemoryUsage() const {
+    LOCK(cs);
+    return memusage::DynamicUsage(mapIndex) + nKeysUsage +
+           memusage::MallocUsage(sizeof(RecencyList::value_type) + 2 * sizeof(void *)) * listRecency.size();
+}
+
+// Keys of the entries in assetsCacheUsage, one prefix per map
+static std::string AssetUsageKey(const std::string &assetId) { return "a" + assetId; }
+
+static std::string AssetIdUsageKey(const std::string &name) { return "n" + name; }
+
+static std::string BalanceUsageKey(const std::pair<std::string, std::string> &key) {
+    return "b" + key.first + '\0' + key.second;
+}
+
+// Record lookups made through any cache against the entries of passetsCache
+static void TouchAsset(const std::string &assetId) {
+    assetsCacheUsage.Touch(AssetUsageKey(assetId), passetsCache && passetsCache->mapAsset.count(assetId));
+}
+
+static void TouchAssetId(const std::string &name) {
+    assetsCacheUsage.Touch(AssetIdUsageKey(name), passetsCache && passetsCache->mapAssetId.count(name));
+}
+
+static void TouchBalance(const std::pair<std::string, std::string> &key) {
+    assetsCacheUsage.Touch(BalanceUsageKey(key), passetsCache && passetsCache->mapAssetAddressAmount.count(key));
+}
+
+// immer keeps the entries in arrays inside its nodes, count a pointer and a bitmap word of node overhead per entry
+static const size_t IMMER_ENTRY_OVERHEAD = 2 * sizeof(void *);
+
+size_t CAssetsCache::AssetEntryUsage(const CDatabaseAssetData &data) {
+    return sizeof(std::string) + sizeof(CDatabaseAssetData) + IMMER_ENTRY_OVERHEAD + 2 * StringUsage(data.asset.assetId) +
+           StringUsage(data.asset.name) + StringUsage(data.asset.referenceHash);
+}
+
+size_t CAssetsCache::AssetIdEntryUsage(const std::string &name, const std::string &assetId) {
+    return 2 * sizeof(std::string) + IMMER_ENTRY_OVERHEAD + StringUsage(name) + StringUsage(assetId);
+}
+
+size_t CAssetsCache::BalanceEntryUsage(const std::pair<std::string, std::string> &key) {
+    return sizeof(key) + sizeof(CAmount128) + IMMER_ENTRY_OVERHEAD + StringUsage(key.first) + StringUsage(key.second);
+}
+
+size_t CAssetsCache::DynamicMemoryUsage() const {
+    // the access map only tracks the keys of passetsCache
+    return nMapsUsage + (this == passetsCache.get() ? assetsCacheUsage.DynamicMemoryUsage() : 0);
+}
+
+void CAssetsCache::SetAsset(const std::string &assetId, const CDatabaseAssetData &data) {
+    if (const CDatabaseAssetData *old = mapAsset.find(assetId))
+        nMapsUsage -= AssetEntryUsage(*old);
+    nMapsUsage += AssetEntryUsage(data);
+    mapAsset = mapAsset.set(assetId, data);
+    if (this == passetsCache.get())
+        assetsCacheUsage.Touch(AssetUsageKey(assetId), true);
+}
+
+void CAssetsCache::SetAssetId(const std::string &name, const std::string &assetId) {
+    if (const std::string *old = mapAssetId.find(name))
+        nMapsUsage -= AssetIdEntryUsage(name, *old);
+    nMapsUsage += AssetIdEntryUsage(name, assetId);
+    mapAssetId = mapAssetId.set(name, assetId);
+    if (this == passetsCache.get())
+        assetsCacheUsage.Touch(AssetIdUsageKey(name), true);
+}
+
+void CAssetsCache::SetAddressAmount(const std::pair<std::string, std::string> &key, const CAmount128 &amount) {
+    if (!mapAssetAddressAmount.count(key))
+        nMapsUsage += BalanceEntryUsage(key);
+    mapAssetAddressAmount = mapAssetAddressAmount.set(key, amount);
+    if (this == passetsCache.get())
+        assetsCacheUsage.Touch(BalanceUsageKey(key), true);
+}
+
+void CAssetsCache::NoteBalanceStored(const std::pair<std::string, std::string> &key) {
+    if (mapBalanceStored.count(key))
+        return;
+    bool fStored;
+    const bool *stored = passetsCache ? passetsCache->mapBalanceStored.find(key) : nullptr;
+    const CAmount128 *amount = passetsCache ? passetsCache->mapAssetAddressAmount.find(key) : nullptr;
+    if (stored) {
+        fStored = *stored;
+    } else if (amount) {
+        // passetsCache notes every balance it has changed, so this one is as the db has it, which drops zeros
+        fStored = *amount != 0;
+    } else {
+        fStored = passetsdb->HaveAssetAddressAmount(key.first, key.second);
+    }
+    mapBalanceStored = mapBalanceStored.set(key, fStored);
+}
+
+void CAssetsCache::EraseAsset(const std::string &assetId) {
+    if (const CDatabaseAssetData *old = mapAsset.find(assetId)) {
+        nMapsUsage -= AssetEntryUsage(*old);
+        mapAsset = mapAsset.erase(assetId);
+        if (this == passetsCache.get())
+            assetsCacheUsage.Forget(AssetUsageKey(assetId));
+    }
+}
+
+void CAssetsCache::EraseAssetId(const std::string &name) {
+    if (const std::string *old = mapAssetId.find(name)) {
+        nMapsUsage -= AssetIdEntryUsage(name, *old);
+        mapAssetId = mapAssetId.erase(name);
+        if (this == passetsCache.get())
+            assetsCacheUsage.Forget(AssetIdUsageKey(name));
+    }
+}
+
+void CAssetsCache::EraseAddressAmount(const std::pair<std::string, std::string> &key) {
+    if (mapAssetAddressAmount.count(key)) {
+        nMapsUsage -= BalanceEntryUsage(key);
+        mapAssetAddressAmount = mapAssetAddressAmount.erase(key);
+        if (this == passetsCache.get())
+            assetsCacheUsage.Forget(BalanceUsageKey(key));
+    }
+}
+
+void CAssetsCache::Trim() {
+    size_t usage = DynamicMemoryUsage();
+    if (usage <= nMaxMemoryUsage)
+        return;
+
+    // Evict down to 3/4 of the budget so the cache isn't trimmed again on the next block
+    const size_t nTargetUsage = nMaxMemoryUsage / 4 * 3;
+    const size_t nStartUsage = usage;
+
+    auto fDirtyAsset = [&](const std::string &assetId) {
+        CDatabaseAssetData data;
+        data.asset.assetId = assetId;
+        return NewAssetsToAdd.count(data) || NewAssetsToRemove.count(data);
+    };
+    std::set<std::pair<std::string, std::string>> dirtyBalances;
+    for (const auto &transfer : NewAssetsTransferToAdd)
+        dirtyBalances.emplace(transfer.transfer.assetId, transfer.address);
+    for (const auto &transfer : NewAssetsTranferToRemove)
+        dirtyBalances.emplace(transfer.transfer.assetId, transfer.address);
+
+    // The maps can't be changed while the list is walked, the picked entries are erased afterwards
+    std::vector<std::string> evictAssets, evictAssetIds;
+    std::vector<std::pair<std::string, std::string>> evictBalances;
+    assetsCacheUsage.EvictLeastRecent([&] { return usage <= nTargetUsage; }, [&](const std::string &key) {
+        const std::string name = key.substr(1);
+        size_t nUsage = 0;
+        if (key[0] == 'a') {
+            const CDatabaseAssetData *data = mapAsset.find(name);
+            if (data) {
+                if (fDirtyAsset(name))
+                    return false;
+                nUsage = AssetEntryUsage(*data);
+                evictAssets.push_back(name);
+            }
+        } else if (key[0] == 'n') {
+            const std::string *assetId = mapAssetId.find(name);
+            if (assetId) {
+                if (fDirtyAsset(*assetId))
+                    return false;
+                nUsage = AssetIdEntryUsage(name, *assetId);
+                evictAssetIds.push_back(name);
+            }
+        } else {
+            const size_t nSep = name.find('\0');
+            auto balance = std::make_pair(name.substr(0, nSep), name.substr(nSep + 1));
+            if (mapAssetAddressAmount.count(balance)) {
+                if (dirtyBalances.count(balance))
+                    return false;
+                nUsage = BalanceEntryUsage(balance);
+                evictBalances.push_back(std::move(balance));
+            }
+        }
+        usage -= std::min(usage, nUsage + StringUsage(key));
+        return true;
+    });
+    for (const auto &assetId : evictAssets)
+        EraseAsset(assetId);
+    for (const auto &name : evictAssetIds)
+        EraseAssetId(name);
+    for (const auto &balance : evictBalances)
+        EraseAddressAmount(balance);
+
+    LogPrint(BCLog::BENCHMARK, "%s: evicted %u entries, %u -> %u bytes\n", __func__,
+             evictAssets.size() + evictAssetIds.size() + evictBalances.size(), nStartUsage, DynamicMemoryUsage());
+}
+
 bool CAssetsCache::InsertAsset(CNewAssetTx newAsset, std::string assetId, int nHeight) {
     if (CheckIfAssetExists(assetId))
         return error("%s: Tried adding new asset, but it already existed in the map of assets: %s", __func__, assetId);
     CAssetMetaData test(assetId, newAsset);
     CDatabaseAssetData newAssetData(test, nHeight, uint256());
 
-    if (NewAssetsToRemove.count(newAssetData))
-        NewAssetsToRemove.erase(newAssetData);
+    SetErase(NewAssetsToRemove, newAssetData);
 
-    NewAssetsToAdd.insert(newAssetData);
+    SetInsert(NewAssetsToAdd, newAssetData);
 
-    mapAsset.insert(std::make_pair(assetId, newAssetData));
-    mapAssetId.insert(std::make_pair(newAssetData.asset.name, assetId));
+    // like std::map::insert, values that are already cached are kept
+    if (!mapAsset.count(assetId))
+        SetAsset(assetId, newAssetData);
+    if (!mapAssetId.count(newAssetData.asset.name))
+        SetAssetId(newAssetData.asset.name, assetId);
 
     return true;
 }
@@ -143,10 +418,10 @@ bool CAssetsCache::UpdateAsset(CUpdateAssetTx upAsset) {
         return false;
     }
 
-    if (NewAssetsToAdd.count(mapAsset[upAsset.assetId]))
-        NewAssetsToAdd.erase(mapAsset[upAsset.assetId]);
+    CDatabaseAssetData cachedAsset = mapAsset.at(upAsset.assetId);
+    SetErase(NewAssetsToAdd, cachedAsset);
 
-    NewAssetsToRemove.insert(mapAsset[upAsset.assetId]);
+    SetInsert(NewAssetsToRemove, cachedAsset);
 
     assetData.updatable = upAsset.updatable;
     assetData.referenceHash = upAsset.referenceHash;
@@ -158,32 +433,33 @@ bool CAssetsCache::UpdateAsset(CUpdateAssetTx upAsset) {
     assetData.ownerAddress = upAsset.ownerAddress;
     assetData.collateralAddress = upAsset.collateralAddress;
     //update cache
-    mapAsset[upAsset.assetId].asset = assetData;
+    cachedAsset.asset = assetData;
+    SetAsset(upAsset.assetId, cachedAsset);
     //update db
-    NewAssetsToAdd.insert(mapAsset[upAsset.assetId]);
+    SetInsert(NewAssetsToAdd, cachedAsset);
     return true;
 }
 
 bool CAssetsCache::UpdateAsset(std::string assetId, CAmount amount) {
-    if (mapAsset.count(assetId) > 0) {
-        if (NewAssetsToAdd.count(mapAsset[assetId]))
-            NewAssetsToAdd.erase(mapAsset[assetId]);
-
-        NewAssetsToRemove.insert(mapAsset[assetId]);
-        mapAsset[assetId].asset.circulatingSupply += amount / COIN;
-        mapAsset[assetId].asset.mintCount += 1;
-        NewAssetsToAdd.insert(mapAsset[assetId]);
+    if (const CDatabaseAssetData *cached = mapAsset.find(assetId)) {
+        CDatabaseAssetData cachedAsset = *cached;
+        SetErase(NewAssetsToAdd, cachedAsset);
+
+        SetInsert(NewAssetsToRemove, cachedAsset);
+        cachedAsset.asset.circulatingSupply += amount / COIN;
+        cachedAsset.asset.mintCount += 1;
+        SetAsset(assetId, cachedAsset);
+        SetInsert(NewAssetsToAdd, cachedAsset);
         return true;
     }
     return false;
 }
 
 bool CAssetsCache::RemoveAsset(std::string assetId) {
-    if (mapAsset.count(assetId) > 0) {
-        if (NewAssetsToAdd.count(mapAsset[assetId]))
-            NewAssetsToAdd.erase(mapAsset[assetId]);
+    if (const CDatabaseAssetData *cached = mapAsset.find(assetId)) {
+        SetErase(NewAssetsToAdd, *cached);
 
-        NewAssetsToRemove.insert(mapAsset[assetId]);
+        SetInsert(NewAssetsToRemove, *cached);
         return true;
     }
     return false;
@@ -197,10 +473,10 @@ bool CAssetsCache::UndoUpdateAsset(const CUpdateAssetTx upAsset,
             return false;
         }
 
-        if (NewAssetsToAdd.count(mapAsset[upAsset.assetId]))
-            NewAssetsToAdd.erase(mapAsset[upAsset.assetId]);
+        CDatabaseAssetData cachedAsset = mapAsset.at(upAsset.assetId);
+        SetErase(NewAssetsToAdd, cachedAsset);
 
-        NewAssetsToRemove.insert(mapAsset[upAsset.assetId]);
+        SetInsert(NewAssetsToRemove, cachedAsset);
 
         for (auto item: vUndoData) {
             if (item.first == upAsset.assetId) {
@@ -216,9 +492,10 @@ bool CAssetsCache::UndoUpdateAsset(const CUpdateAssetTx upAsset,
         }
 
         //update cache
-        mapAsset[upAsset.assetId].asset = assetData;
+        cachedAsset.asset = assetData;
+        SetAsset(upAsset.assetId, cachedAsset);
         //update db
-        NewAssetsToAdd.insert(mapAsset[upAsset.assetId]);
+        SetInsert(NewAssetsToAdd, cachedAsset);
         return true;
     }
     return false;
@@ -232,10 +509,10 @@ bool CAssetsCache::UndoMintAsset(const CMintAssetTx assetTx,
             return false;
         }
 
-        if (NewAssetsToAdd.count(mapAsset[assetTx.assetId]))
-            NewAssetsToAdd.erase(mapAsset[assetTx.assetId]);
+        CDatabaseAssetData cachedAsset = mapAsset.at(assetTx.assetId);
+        SetErase(NewAssetsToAdd, cachedAsset);
 
-        NewAssetsToRemove.insert(mapAsset[assetTx.assetId]);
+        SetInsert(NewAssetsToRemove, cachedAsset);
 
         for (auto item: vUndoData) {
             if (item.first == assetTx.assetId) {
@@ -245,9 +522,10 @@ bool CAssetsCache::UndoMintAsset(const CMintAssetTx assetTx,
         }
 
         //update cache
-        mapAsset[assetTx.assetId].asset = assetData;
+        cachedAsset.asset = assetData;
+        SetAsset(assetTx.assetId, cachedAsset);
         //update db
-        NewAssetsToAdd.insert(mapAsset[assetTx.assetId]);
+        SetInsert(NewAssetsToAdd, cachedAsset);
         return true;
     }
     return false;
@@ -263,58 +541,70 @@ bool CAssetsCache::CheckIfAssetExists(std::string assetId) {
     }
 
     if (mapAsset.count(assetId) > 0) {
+        assetsCacheUsage.nHits++;
+        TouchAsset(assetId);
         return true;
     }
 
     //check if the asset exist on the db
+    assetsCacheUsage.nMisses++;
     int nHeight;
     uint256 blockHash;
     CAssetMetaData asset;
+    bool found = false;
     if (passetsdb->ReadAssetData(assetId, asset, nHeight, blockHash)) {
-        CDatabaseAssetData newAsset(asset, nHeight, blockHash);
-        mapAsset.insert(std::make_pair(assetId, newAsset));
-        return true;
+        SetAsset(assetId, CDatabaseAssetData(asset, nHeight, blockHash));
+        found = true;
     }
-    return false;
+    TouchAsset(assetId);
+    return found;
 }
 
 bool CAssetsCache::GetAssetId(std::string name, std::string &assetId) {
     //try to get assetId by asset name
-    auto it = mapAssetId.find(name);
-    if (it != mapAssetId.end()) {
-        assetId = it->second;
+    if (const std::string *cachedId = mapAssetId.find(name)) {
+        assetsCacheUsage.nHits++;
+        assetId = *cachedId;
+        TouchAssetId(name);
         return true;
     }
     //try to get asset id from the db
+    assetsCacheUsage.nMisses++;
+    bool found = false;
     if (passetsdb->ReadAssetId(name, assetId)) {
-        mapAssetId.insert(std::make_pair(name, assetId));
-        return true;
+        SetAssetId(name, assetId);
+        found = true;
     }
-    return false;
+    TouchAssetId(name);
+    return found;
 }
 
 bool CAssetsCache::GetAssetMetaData(std::string assetId, CAssetMetaData &asset) {
-    auto it = mapAsset.find(assetId);
-    if (it != mapAsset.end()) {
-        asset = it->second.asset;
+    if (const CDatabaseAssetData *cached = mapAsset.find(assetId)) {
+        assetsCacheUsage.nHits++;
+        asset = cached->asset;
+        TouchAsset(assetId);
         return true;
     }
 
-    auto it2 = passetsCache->mapAsset.find(assetId);
-    if (it2 != passetsCache->mapAsset.end()) {
-        mapAsset.insert(std::make_pair(assetId, it2->second));
-        asset = it2->second.asset;
+    if (const CDatabaseAssetData *cached = passetsCache->mapAsset.find(assetId)) {
+        assetsCacheUsage.nHits++;
+        asset = cached->asset;
+        SetAsset(assetId, *cached);
+        TouchAsset(assetId);
         return true;
     }
 
+    assetsCacheUsage.nMisses++;
     int nHeight;
     uint256 blockHash;
+    bool found = false;
     if (passetsdb->ReadAssetData(assetId, asset, nHeight, blockHash)) {
-        CDatabaseAssetData newAsset(asset, nHeight, blockHash);
-        mapAsset.insert(std::make_pair(assetId, newAsset));
-        return true;
+        SetAsset(assetId, CDatabaseAssetData(asset, nHeight, blockHash));
+        found = true;
     }
-    return false;
+    TouchAsset(assetId);
+    return found;
 }
 
 //! This will get the amount that an address for a certain asset contains from the database if they cache doesn't already have it
@@ -324,76 +614,90 @@ bool GetBestAssetAddressAmount(CAssetsCache& cache, const std::string& assetId,
         auto pair = make_pair(assetId, address);
 
         // If the caches map has the pair, return true because the map already contains the best dirty amount
-        if (cache.mapAssetAddressAmount.count(pair))
+        if (cache.mapAssetAddressAmount.count(pair)) {
+            assetsCacheUsage.nHits++;
+            TouchBalance(pair);
             return true;
+        }
 
         // If the caches map has the pair, return true because the map already contains the best dirty amount
-        if (passetsCache->mapAssetAddressAmount.count(pair)) {
-            cache.mapAssetAddressAmount[pair] = passetsCache->mapAssetAddressAmount.at(pair);
+        if (const CAmount128 *amount = passetsCache->mapAssetAddressAmount.find(pair)) {
+            assetsCacheUsage.nHits++;
+            cache.SetAddressAmount(pair, *amount);
+            TouchBalance(pair);
             return true;
         }
 
         // If the database contains the assets address amount, insert it into the database and return true
+        assetsCacheUsage.nMisses++;
         CAmount128 nDBAmount;
+        bool found = false;
         if (passetsdb->ReadAssetAddressAmount(pair.first, pair.second, nDBAmount)) {
-            cache.mapAssetAddressAmount.insert(make_pair(pair, nDBAmount));
-            return true;
+            cache.SetAddressAmount(pair, nDBAmount);
+            found = true;
         }
+        if (!cache.mapBalanceStored.count(pair))
+            cache.mapBalanceStored = cache.mapBalanceStored.set(pair, found);
+        TouchBalance(pair);
+        return found;
     }
 
     // The amount wasn't found return false
     return false;
 }
 
-void CAssetsCache::AddAssetBlance(const CScript &script, const COutPoint &out) {
+void CAssetsCache::AddAssetBlance(const Coin &coin, const COutPoint &out) {
     if (fAssetIndex) {
         CAssetTransfer assetTransfer;
-        if (GetTransferAsset(script, assetTransfer)) {
-            CTxDestination dest;
-            ExtractDestination(script, dest);
-            std::string address = EncodeDestination(dest);
-            auto pair = std::make_pair(assetTransfer.assetId, address);
-            // Get the best amount
-            if (!GetBestAssetAddressAmount(*this, assetTransfer.assetId, address))
-                mapAssetAddressAmount.insert(std::make_pair(pair, 0));
-            //else
-                mapAssetAddressAmount[pair] += assetTransfer.nAmount;
-
-            // Add to cache so we can save to database
-            CAssetTransferEntry newTransfer(assetTransfer, address, out);
-
-            if (NewAssetsTranferToRemove.count(newTransfer))
-                NewAssetsTranferToRemove.erase(newTransfer);
-
-            NewAssetsTransferToAdd.insert(newTransfer);
+        if (GetCoinTransferAsset(coin, assetTransfer)) {
+            AddAssetBlance(coin.out.scriptPubKey, assetTransfer, out);
         }
     }
 }
 
-void CAssetsCache::RemoveAddressBalance(const CScript &script, const COutPoint &out) {
+void CAssetsCache::AddAssetBlance(const CScript &script, const CAssetTransfer &assetTransfer, const COutPoint &out) {
+    if (fAssetIndex) {
+        CTxDestination dest;
+        ExtractDestination(script, dest);
+        std::string address = EncodeDestination(dest);
+        auto pair = std::make_pair(assetTransfer.assetId, address);
+        // Get the best amount, an address without a balance starts at 0
+        GetBestAssetAddressAmount(*this, assetTransfer.assetId, address);
+        NoteBalanceStored(pair);
+        const CAmount128 *amount = mapAssetAddressAmount.find(pair);
+        SetAddressAmount(pair, (amount ? *amount : CAmount128(0)) + assetTransfer.nAmount);
+
+        // Add to cache so we can save to database
+        CAssetTransferEntry newTransfer(assetTransfer, address, out);
+
+        SetErase(NewAssetsTranferToRemove, newTransfer);
+
+        SetInsert(NewAssetsTransferToAdd, newTransfer);
+    }
+}
+
+void CAssetsCache::RemoveAddressBalance(const Coin &coin, const COutPoint &out) {
     if (fAssetIndex) {
         CAssetTransfer assetTransfer;
-        if (GetTransferAsset(script, assetTransfer)) {
+        if (GetCoinTransferAsset(coin, assetTransfer)) {
             CTxDestination dest;
-            ExtractDestination(script, dest);
+            ExtractDestination(coin.out.scriptPubKey, dest);
             std::string address = EncodeDestination(dest);
             
             auto pair = make_pair(assetTransfer.assetId, address);
             if (GetBestAssetAddressAmount(*this, assetTransfer.assetId, address)){
-               
-                if (mapAssetAddressAmount.count(pair))
-                    mapAssetAddressAmount[pair] -= assetTransfer.nAmount;
-
-                if (mapAssetAddressAmount.at(pair) < 0)
-                    mapAssetAddressAmount.at(pair) = 0;
+                NoteBalanceStored(pair);
+                CAmount128 amount = mapAssetAddressAmount.at(pair) - assetTransfer.nAmount;
+                if (amount < 0)
+                    amount = 0;
+                SetAddressAmount(pair, amount);
             }
             // Add to cache so we can save to database
             CAssetTransferEntry newTransfer(assetTransfer, address, out);
 
-            if (NewAssetsTransferToAdd.count(newTransfer))
-                NewAssetsTransferToAdd.erase(newTransfer);
+            SetErase(NewAssetsTransferToAdd, newTransfer);
 
-            NewAssetsTranferToRemove.insert(newTransfer);
+            SetInsert(NewAssetsTranferToRemove, newTransfer);
         }
     }
 }
@@ -418,39 +722,27 @@ bool CAssetsCache::DumpCacheToDatabase() {
                 return error("%s : %s", __func__, "_Failed Writing New Asset Data to database");
             }
         }
-        // Undo the transfering by updating the balances in the database
-        for (auto transferToRemove: NewAssetsTranferToRemove) {
-            auto pair = std::make_pair(transferToRemove.transfer.assetId, transferToRemove.address);
-            if (mapAssetAddressAmount.count(pair)) {
-                if (mapAssetAddressAmount.at(pair) == 0) {
-                    if (!passetsdb->EraseAssetAddressAmount(transferToRemove.transfer.assetId, transferToRemove.address)) {
-                        return error("%s : %s", __func__, "_Failed Erasing address balance from database");
-                    }
-                    if (!passetsdb->EraseAddressAssetAmount(transferToRemove.address, transferToRemove.transfer.assetId)) {
-                        return error("%s : %s", __func__, "_Failed Erasing address balance from database");
-                    }
-                } else {
-                    if (!passetsdb->WriteAssetAddressAmount(transferToRemove.transfer.assetId, transferToRemove.address, mapAssetAddressAmount.at(pair))) {
-                        return error("%s : %s", __func__, "_Failed Writing address balance to database");
-                    }
-                    if (!passetsdb->WriteAddressAssetAmount(transferToRemove.address, transferToRemove.transfer.assetId, mapAssetAddressAmount.at(pair))) {
-                        return error("%s : %s", __func__, "_Failed Writing address balance to database");
-                    }
-                }
-            }
-        }
-        for (auto newTransfer: NewAssetsTransferToAdd) {
-            auto pair = std::make_pair(newTransfer.transfer.assetId, newTransfer.address);
-            if (mapAssetAddressAmount.count(pair)) {
-                if (!passetsdb->WriteAssetAddressAmount(newTransfer.transfer.assetId, newTransfer.address, mapAssetAddressAmount.at(pair))) {
-                    return error("%s : %s", __func__, "_Failed Writing address balance to database");
-                }
-                if (!passetsdb->WriteAddressAssetAmount(newTransfer.address, newTransfer.transfer.assetId, mapAssetAddressAmount.at(pair))) {
-                    return error("%s : %s", __func__, "_Failed Writing address balance to database");
-                }
-            }
+        // Write the balances changed by transfers, the asset db erases the ones that dropped to zero and keeps
+        // count of how many addresses hold each asset and how many assets each address holds
+        std::map<std::pair<std::string, std::string>, CAssetBalanceChange> changedBalances;
+        auto addBalance = [&](const CAssetTransferEntry &transfer) {
+            const auto pair = std::make_pair(transfer.transfer.assetId, transfer.address);
+            const CAmount128 *amount = mapAssetAddressAmount.find(pair);
+            if (!amount || changedBalances.count(pair))
+                return;
+            const bool *stored = mapBalanceStored.find(pair);
+            changedBalances.emplace(pair, CAssetBalanceChange{*amount, stored ? *stored :
+                    passetsdb->HaveAssetAddressAmount(pair.first, pair.second)});
+        };
+        for (const auto &transfer : NewAssetsTransferToAdd)
+            addBalance(transfer);
+        for (const auto &transfer : NewAssetsTranferToRemove)
+            addBalance(transfer);
+        if (!passetsdb->UpdateBalances(changedBalances)) {
+            return error("%s : %s", __func__, "_Failed Writing address balances to database");
         }
         ClearDirtyCache();
+        Trim();
         return true;
     } catch (const std::runtime_error &e) {
         return error("%s : %s ", __func__, std::string("System error while flushing assets: ") + e.what());
@@ -463,38 +755,52 @@ bool CAssetsCache::Flush() {
 
     try {
         for (auto &item: NewAssetsToRemove) {
-            if (passetsCache->NewAssetsToAdd.count(item))
-                passetsCache->NewAssetsToAdd.erase(item);
-            passetsCache->NewAssetsToRemove.insert(item);
+            SetErase(passetsCache->NewAssetsToAdd, item);
+            SetInsert(passetsCache->NewAssetsToRemove, item);
         }
 
         for (auto &item: NewAssetsToAdd) {
-            if (passetsCache->NewAssetsToRemove.count(item))
-                passetsCache->NewAssetsToRemove.erase(item);
-            passetsCache->NewAssetsToAdd.insert(item);
+            SetErase(passetsCache->NewAssetsToRemove, item);
+            SetInsert(passetsCache->NewAssetsToAdd, item);
         }
 
         for (auto &item: NewAssetsTransferToAdd) {
-            if (passetsCache->NewAssetsTranferToRemove.count(item))
-                passetsCache->NewAssetsTranferToRemove.erase(item);
-            passetsCache->NewAssetsTransferToAdd.insert(item);
+            SetErase(passetsCache->NewAssetsTranferToRemove, item);
+            SetInsert(passetsCache->NewAssetsTransferToAdd, item);
         }
 
         for (auto &item: NewAssetsTranferToRemove) {
-            if (passetsCache->NewAssetsTransferToAdd.count(item))
-                passetsCache->NewAssetsTransferToAdd.erase(item);
-            passetsCache->NewAssetsTranferToRemove.insert(item);
+            SetErase(passetsCache->NewAssetsTransferToAdd, item);
+            SetInsert(passetsCache->NewAssetsTranferToRemove, item);
         }
 
-        for (auto &item : mapAssetAddressAmount)
-            passetsCache->mapAssetAddressAmount[item.first] = item.second;
-
-        for (auto &item: mapAsset)
-            passetsCache->mapAsset[item.first] = item.second;
-
-        for (auto &item: mapAssetId)
-            passetsCache->mapAssetId[item.first] = item.second;
-
+        // Only the entries named in the dirty sets were changed here, everything else in the maps was read from
+        // passetsCache or the db, so copying just those keeps the flush proportional to the block, not the cache
+        auto flushAsset = [this](const CDatabaseAssetData &item) {
+            if (const CDatabaseAssetData *data = mapAsset.find(item.asset.assetId))
+                passetsCache->SetAsset(item.asset.assetId, *data);
+            if (const std::string *assetId = mapAssetId.find(item.asset.name))
+                passetsCache->SetAssetId(item.asset.name, *assetId);
+        };
+        for (auto &item: NewAssetsToRemove)
+            flushAsset(item);
+        for (auto &item: NewAssetsToAdd)
+            flushAsset(item);
+
+        auto flushBalance = [this](const CAssetTransferEntry &item) {
+            const auto pair = std::make_pair(item.transfer.assetId, item.address);
+            if (const CAmount128 *amount = mapAssetAddressAmount.find(pair))
+                passetsCache->SetAddressAmount(pair, *amount);
+            const bool *stored = mapBalanceStored.find(pair);
+            if (stored && !passetsCache->mapBalanceStored.count(pair))
+                passetsCache->mapBalanceStored = passetsCache->mapBalanceStored.set(pair, *stored);
+        };
+        for (auto &item: NewAssetsTransferToAdd)
+            flushBalance(item);
+        for (auto &item: NewAssetsTranferToRemove)
+            flushBalance(item);
+
+        passetsCache->Trim();
         return true;
 
     } catch (const std::runtime_error &e) {
@@ -503,8 +809,13 @@ bool CAssetsCache::Flush() {
 }
 
 void AddAssets(const CTransaction &tx, int nHeight, CAssetsCache *assetCache,
-               std::pair <std::string, CBlockAssetUndo> *undoAssetData) {
+               std::pair <std::string, CBlockAssetUndo> *undoAssetData, const CTxAssetTransfers *assetTransfers) {
     if (Updates().IsAssetsActive(::ChainActive().Tip()) && assetCache) {
+        std::unique_ptr<CTxAssetTransfers> decodedTransfers;
+        if (!assetTransfers) {
+            decodedTransfers = MakeUnique<CTxAssetTransfers>(tx);
+            assetTransfers = decodedTransfers.get();
+        }
         if (tx.nType == TRANSACTION_NEW_ASSET) {
             CNewAssetTx assetTx;
             if (GetTxPayload(tx, assetTx)) {
@@ -533,12 +844,9 @@ void AddAssets(const CTransaction &tx, int nHeight, CAssetsCache *assetCache,
             CMintAssetTx assetTx;
             if (GetTxPayload(tx, assetTx)) {
                 CAmount amount = 0;
-                for (auto out: tx.vout) {
-                    if (out.scriptPubKey.IsAssetScript()) {
-                        CAssetTransfer assetTransfer;
-                        if (GetTransferAsset(out.scriptPubKey, assetTransfer))
-                            amount += assetTransfer.nAmount;
-                    }
+                for (size_t i = 0; i < tx.vout.size(); ++i) {
+                    if (const CAssetTransfer *assetTransfer = assetTransfers->Get(i))
+                        amount += assetTransfer->nAmount;
                 }
                 CAssetMetaData asset;
                 if (!assetCache->GetAssetMetaData(assetTx.assetId, asset))
@@ -560,9 +868,9 @@ void AddAssets(const CTransaction &tx, int nHeight, CAssetsCache *assetCache,
         //process asset transaction in order to track address balances
         if (fAssetIndex) {
             for (size_t i = 0; i < tx.vout.size(); ++i) {
-                if (tx.vout[i].scriptPubKey.IsAssetScript()) {
+                if (const CAssetTransfer *assetTransfer = assetTransfers->Get(i)) {
                     COutPoint out(tx.GetHash(), i);
-                    assetCache->AddAssetBlance(tx.vout[i].scriptPubKey, out);
+                    assetCache->AddAssetBlance(tx.vout[i].scriptPubKey, *assetTransfer, out);
                 }
             }
         }
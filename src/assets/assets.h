@@ -9,8 +9,19 @@
 #include <coins.h>
 #include <key_io.h>
 #include <pubkey.h>
+#include <saltedhasher.h>
+#include <sync.h>
 #include <assets/assetstype.h>
 
+#include <immer/map.hpp>
+#include <immer/set.hpp>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
 class CNewAssetTx;
 
 class CUpdateAssetTx;
@@ -22,7 +33,8 @@ class UniValue;
 struct CAssetOutputEntry;
 struct CBlockAssetUndo;
 
-#define MAX_CACHE_ASSETS_SIZE 2500
+//! -assetcache default, in megabytes
+static const int64_t DEFAULT_ASSETS_CACHE = 32;
 
 CAmount getAssetsFeesCoin();
 
@@ -115,6 +127,17 @@ public:
         return asset.assetId < rhs.asset.assetId;
     }
 
+    //! Hash and equality on assetId, matching operator<
+    struct KeyHasher {
+        std::size_t operator()(const CDatabaseAssetData &v) const { return StaticSaltedHasher()(v.asset.assetId); }
+    };
+
+    struct KeyEqual {
+        bool operator()(const CDatabaseAssetData &a, const CDatabaseAssetData &b) const {
+            return a.asset.assetId == b.asset.assetId;
+        }
+    };
+
     SERIALIZE_METHODS(CDatabaseAssetData, obj
     )
     {
@@ -139,46 +162,118 @@ struct CAssetTransferEntry
     {
         return out < rhs.out;
     }
+
+    //! Hash and equality on out, matching operator<
+    struct KeyHasher {
+        std::size_t operator()(const CAssetTransferEntry &v) const {
+            return StaticSaltedHasher()(std::make_pair(v.out.hash, v.out.n));
+        }
+    };
+
+    struct KeyEqual {
+        bool operator()(const CAssetTransferEntry &a, const CAssetTransferEntry &b) const { return a.out == b.out; }
+    };
 };
 
+/**
+ * The asset state is kept in persistent (immer) maps and sets. Copying a CAssetsCache to get a scratch view,
+ * as mempool acceptance and block validity checks do for every call, shares the structure with the original
+ * and is O(1) no matter how many assets and address balances it holds. Changes are made by replacing a map
+ * with an updated version, which only copies the path to the changed entry.
+ */
 class CAssets {
 public:
-    std::map <std::string, CDatabaseAssetData> mapAsset;
-    std::map <std::string, std::string> mapAssetId;
+    using AssetMap = immer::map<std::string, CDatabaseAssetData, StaticSaltedHasher>;
+    using AssetIdMap = immer::map<std::string, std::string, StaticSaltedHasher>;
+    using AssetAddressAmountMap = immer::map<std::pair<std::string, std::string>, CAmount128, StaticSaltedHasher>;
 
-    std::map <std::pair<std::string, std::string>, CAmount128> mapAssetAddressAmount;
+    //! Read freely, but change them through the CAssetsCache setters, which keep nMapsUsage up to date
+    AssetMap mapAsset;
+    AssetIdMap mapAssetId;
 
-    CAssets(const CAssets &assets) {
-        this->mapAsset = assets.mapAsset;
-        this->mapAssetId = assets.mapAssetId;
-        this->mapAssetAddressAmount = assets.mapAssetAddressAmount;
-    }
-
-    CAssets &operator=(const CAssets &other) {
-        mapAsset = other.mapAsset;
-        mapAssetId = other.mapAssetId;
-        mapAssetAddressAmount = other.mapAssetAddressAmount;
-        return *this;
-    }
+    AssetAddressAmountMap mapAssetAddressAmount;
 
     CAssets() {
         SetNull();
     }
 
     void SetNull() {
-        mapAsset.clear();
-        mapAssetId.clear();
-        mapAssetAddressAmount.clear();
+        mapAsset = AssetMap();
+        mapAssetId = AssetIdMap();
+        mapAssetAddressAmount = AssetAddressAmountMap();
+        nMapsUsage = 0;
     }
+
+protected:
+    //! running total of the estimated memory usage of the entries in the maps
+    size_t nMapsUsage{0};
+};
+
+/**
+ * The entries of passetsCache in the order they were last used, and how many lookups it served without reading the
+ * asset db. Lookups through every CAssetsCache are recorded here, including the ones block connection and mempool
+ * checks make on their own caches, so passetsCache keeps what they use. Every key passetsCache holds is on the list
+ * and no other, so Trim() just pops from its tail, and its memory is charged to the passetsCache budget.
+ */
+class CAssetsCacheUsage {
+private:
+    using RecencyList = std::list<const std::string *>;
+
+    mutable Mutex cs;
+    //! most recently used first, the strings are the keys of mapIndex
+    RecencyList listRecency GUARDED_BY(cs);
+    std::unordered_map<std::string, RecencyList::iterator, StaticSaltedHasher> mapIndex GUARDED_BY(cs);
+    //! heap usage of the keys in mapIndex
+    size_t nKeysUsage GUARDED_BY(cs){0};
+
+    void EraseKey(const std::string &key) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+public:
+    std::atomic<uint64_t> nHits{0};
+    std::atomic<uint64_t> nMisses{0};
+
+    /** Record a use of key, fCached tells whether passetsCache holds it, the key is dropped when it doesn't */
+    void Touch(const std::string &key, bool fCached);
+
+    /** Drop keys evicted from passetsCache */
+    void Forget(const std::string &key);
+
+    /** Drop all keys, when passetsCache is replaced */
+    void Clear();
+
+    /**
+     * Offer keys to evict, least recently used first, until fDone returns true. evict returns false for an entry
+     * that must be kept, which stays on the list, otherwise the key is dropped.
+     */
+    void EvictLeastRecent(const std::function<bool()> &fDone, const std::function<bool(const std::string &)> &evict);
+
+    bool IsTracked(const std::string &key) const;
+
+    size_t Size() const;
+
+    size_t DynamicMemoryUsage() const;
 };
 
+extern CAssetsCacheUsage assetsCacheUsage;
+
 class CAssetsCache : public CAssets {
 public:
-    std::set <CDatabaseAssetData> NewAssetsToRemove;
-    std::set <CDatabaseAssetData> NewAssetsToAdd;
+    using AssetDataSet = immer::set<CDatabaseAssetData, CDatabaseAssetData::KeyHasher, CDatabaseAssetData::KeyEqual>;
+    using AssetTransferSet = immer::set<CAssetTransferEntry, CAssetTransferEntry::KeyHasher, CAssetTransferEntry::KeyEqual>;
+
+    AssetDataSet NewAssetsToRemove;
+    AssetDataSet NewAssetsToAdd;
+
+    AssetTransferSet NewAssetsTranferToRemove;
+    AssetTransferSet NewAssetsTransferToAdd;
 
-    std::set <CAssetTransferEntry> NewAssetsTranferToRemove;
-    std::set <CAssetTransferEntry> NewAssetsTransferToAdd;
+    using BalanceStoredMap = immer::map<std::pair<std::string, std::string>, bool, StaticSaltedHasher>;
+
+    //! Whether the asset db held a balance for a key before it was changed, so writing it needs no lookup
+    BalanceStoredMap mapBalanceStored;
+
+    //! memory budget of passetsCache, see Trim()
+    size_t nMaxMemoryUsage{DEFAULT_ASSETS_CACHE << 20};
 
     CAssetsCache() :
             CAssets() {
@@ -186,26 +281,19 @@ public:
         ClearDirtyCache();
     }
 
-    CAssetsCache(CAssetsCache &cache) :
-            CAssets(cache) {
-        this->NewAssetsToRemove = cache.NewAssetsToRemove;
-        this->NewAssetsToAdd = cache.NewAssetsToAdd;
-
-        this->NewAssetsTranferToRemove = cache.NewAssetsTranferToRemove;
-        this->NewAssetsTransferToAdd = cache.NewAssetsTransferToAdd;
-    }
-
     bool InsertAsset(CNewAssetTx newAsset, std::string assetId, int nHeight);
 
     bool UpdateAsset(CUpdateAssetTx upAsset);
 
     bool UpdateAsset(std::string assetId, CAmount amount);
 
-    void AddAssetBlance(const CScript &script, const COutPoint &out);
+    void AddAssetBlance(const Coin &coin, const COutPoint &out);
+
+    void AddAssetBlance(const CScript &script, const CAssetTransfer &assetTransfer, const COutPoint &out);
     //undo asset
     bool RemoveAsset(std::string assetId);
 
-    void RemoveAddressBalance(const CScript &script, const COutPoint &out);
+    void RemoveAddressBalance(const Coin &coin, const COutPoint &out);
 
     bool UndoUpdateAsset(const CUpdateAssetTx upAsset,
                          const std::vector <std::pair<std::string, CBlockAssetUndo>> &vUndoData);
@@ -223,17 +311,47 @@ public:
 
     bool DumpCacheToDatabase();
 
+    /** Running total of the map entries, plus the recency list for passetsCache */
+    size_t DynamicMemoryUsage() const;
+
+    void SetAsset(const std::string &assetId, const CDatabaseAssetData &data);
+
+    void SetAssetId(const std::string &name, const std::string &assetId);
+
+    void SetAddressAmount(const std::pair<std::string, std::string> &key, const CAmount128 &amount);
+
+    /** Record in mapBalanceStored whether the asset db holds a balance for key, before it is changed */
+    void NoteBalanceStored(const std::pair<std::string, std::string> &key);
+
+    void EraseAsset(const std::string &assetId);
+
+    void EraseAssetId(const std::string &name);
+
+    void EraseAddressAmount(const std::pair<std::string, std::string> &key);
+
+    /** Evict the least recently used entries that are not waiting to be written until the cache fits in its budget */
+    void Trim();
+
+    static size_t AssetEntryUsage(const CDatabaseAssetData &data);
+
+    static size_t AssetIdEntryUsage(const std::string &name, const std::string &assetId);
+
+    static size_t BalanceEntryUsage(const std::pair<std::string, std::string> &key);
+
     void ClearDirtyCache() {
-        NewAssetsToAdd.clear();
-        NewAssetsToRemove.clear();
+        NewAssetsToAdd = AssetDataSet();
+        NewAssetsToRemove = AssetDataSet();
 
-        NewAssetsTransferToAdd.clear();
-        NewAssetsTranferToRemove.clear();
+        NewAssetsTransferToAdd = AssetTransferSet();
+        NewAssetsTranferToRemove = AssetTransferSet();
+        mapBalanceStored = BalanceStoredMap();
     }
 };
 
+/** assetTransfers are the already decoded outputs of tx, they are decoded here when it is nullptr */
 void AddAssets(const CTransaction &tx, int nHeight, CAssetsCache *assetCache = nullptr,
-               std::pair <std::string, CBlockAssetUndo> *undoAssetData = nullptr);
+               std::pair <std::string, CBlockAssetUndo> *undoAssetData = nullptr,
+               const CTxAssetTransfers *assetTransfers = nullptr);
 
 bool GetAssetData(const CScript &script, CAssetOutputEntry &data);
 
@@ -7,16 +7,24 @@
 #include <assets/assets.h>
 #include <assets/assetsdb.h>
 #include <consensus/params.h>
+#include <crypto/common.h>
+#include <optional.h>
 #include <script/ismine.h>
 #include <tinyformat.h>
 
 #include <boost/thread.hpp>
 
+#include <limits>
+#include <set>
+
 static const char ASSET_FLAG = 'A';
 static const char ASSET_NAME_TXID_FLAG = 'B';
 static const char BLOCK_ASSET_UNDO_DATA = 'U';
 static const char ASSET_ADDRESS_AMOUNT = 'C';
 static const char ADDRESS_ASSET_AMOUNT = 'D';
+static const char ASSET_HOLDER_COUNT = 'E';
+static const char ADDRESS_ASSET_COUNT = 'F';
+static const char HOLDER_COUNTS_FLAG = 'G';
 
 static size_t MAX_DATABASE_RESULTS = 50000;
 
@@ -82,6 +90,57 @@ bool CAssetsDB::EraseAddressAssetAmount(const std::string &address, const std::s
     return Erase(std::make_pair(ADDRESS_ASSET_AMOUNT, std::make_pair(address, assetId)));
 }
 
+bool CAssetsDB::HaveAssetAddressAmount(const std::string &assetId, const std::string &address) {
+    return Exists(std::make_pair(ASSET_ADDRESS_AMOUNT, std::make_pair(assetId, address)));
+}
+
+bool CAssetsDB::UpdateBalances(const std::map<std::pair<std::string, std::string>, CAssetBalanceChange> &balances) {
+    CDBBatch batch(*this);
+    std::map<std::string, int64_t> assetDeltas;
+    std::map<std::string, int64_t> addressDeltas;
+    for (const auto &balance : balances) {
+        const std::string &assetId = balance.first.first;
+        const std::string &address = balance.first.second;
+        const CAmount128 &amount = balance.second.amount;
+        const bool fStored = balance.second.fStored;
+        if (amount == 0) {
+            if (!fStored)
+                continue;
+            batch.Erase(std::make_pair(ASSET_ADDRESS_AMOUNT, std::make_pair(assetId, address)));
+            batch.Erase(std::make_pair(ADDRESS_ASSET_AMOUNT, std::make_pair(address, assetId)));
+            assetDeltas[assetId]--;
+            addressDeltas[address]--;
+        } else {
+            batch.Write(std::make_pair(ASSET_ADDRESS_AMOUNT, std::make_pair(assetId, address)), amount.str());
+            batch.Write(std::make_pair(ADDRESS_ASSET_AMOUNT, std::make_pair(address, assetId)), amount);
+            if (!fStored) {
+                assetDeltas[assetId]++;
+                addressDeltas[address]++;
+            }
+        }
+    }
+
+    // the counts go into the same batch, so they can't get out of step with the balances after a crash
+    auto apply = [&](const char flag, const std::map<std::string, int64_t> &deltas) {
+        for (const auto &delta : deltas) {
+            if (delta.second == 0)
+                continue;
+            auto key = std::make_pair(flag, delta.first);
+            uint64_t count = 0;
+            Read(key, count);
+            int64_t newCount = (int64_t)count + delta.second;
+            if (newCount > 0) {
+                batch.Write(key, (uint64_t)newCount);
+            } else {
+                batch.Erase(key);
+            }
+        }
+    };
+    apply(ASSET_HOLDER_COUNT, assetDeltas);
+    apply(ADDRESS_ASSET_COUNT, addressDeltas);
+    return WriteBatch(batch);
+}
+
 bool CAssetsDB::WriteBlockUndoAssetData(const uint256 &blockHash,
                                         const std::vector <std::pair<std::string, CBlockAssetUndo>> &assetUndoData) {
     return Write(std::make_pair(BLOCK_ASSET_UNDO_DATA, blockHash), assetUndoData);
@@ -102,6 +161,10 @@ bool CAssetsDB::LoadAssets() {
 
     pcursor->Seek(std::make_pair(ASSET_FLAG, std::string()));
 
+    // Warm up the cache with up to half of its budget, the rest is read through on demand
+    const size_t nMaxLoadUsage = passetsCache->nMaxMemoryUsage / 2;
+    size_t nLoadUsage = 0;
+
     // Load assets
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
@@ -109,12 +172,11 @@ bool CAssetsDB::LoadAssets() {
         if (pcursor->GetKey(key) && key.first == ASSET_FLAG) {
             CDatabaseAssetData data;
             if (pcursor->GetValue(data)) {
-                passetsCache->mapAsset.insert(std::make_pair(data.asset.assetId, data));
+                passetsCache->SetAsset(data.asset.assetId, data);
                 pcursor->Next();
 
-                // Loaded enough from database to have in memory.
-                // No need to load everything if it is just going to be removed from the cache
-                if (passetsCache->mapAsset.size() == MAX_CACHE_ASSETS_SIZE)
+                nLoadUsage += CAssetsCache::AssetEntryUsage(data);
+                if (nLoadUsage >= nMaxLoadUsage)
                     break;
             } else {
                 return error("%s: failed to read asset", __func__);
@@ -134,9 +196,9 @@ bool CAssetsDB::LoadAssets() {
         if (pcursor2->GetKey(key) && key.first == ASSET_NAME_TXID_FLAG) {
             std::string value;
             if (pcursor2->GetValue(value)) {
-                passetsCache->mapAssetId.insert(
-                        std::make_pair(key.second, value));
-                if (passetsCache->mapAssetId.size() > MAX_CACHE_ASSETS_SIZE)
+                passetsCache->SetAssetId(key.second, value);
+                nLoadUsage += CAssetsCache::AssetIdEntryUsage(key.second, value);
+                if (nLoadUsage >= nMaxLoadUsage)
                     break;
                 pcursor2->Next();
             } else {
@@ -147,187 +209,312 @@ bool CAssetsDB::LoadAssets() {
         }
     }
 
+    if (!Exists(HOLDER_COUNTS_FLAG) && !BuildHolderCounts())
+        return error("%s: failed to count asset holders", __func__);
+
     return true;
 }
 
-bool CAssetsDB::GetListAssets(std::vector<CDatabaseAssetData>& assets, const size_t count, const long start) {
-    ::ChainstateActive().ForceFlushStateToDisk();
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-    pcursor->Seek(std::make_pair(ASSET_FLAG, std::string()));
-
-    size_t skip = 0;
-    if (start >= 0) {
-        skip = start;
-    }
+bool CAssetsDB::BuildHolderCounts() {
+    LogPrintf("%s: counting asset holders...\n", __func__);
 
-    size_t loaded = 0;
-    size_t offset = 0;
+    std::map<std::string, uint64_t> assetCounts;
+    std::map<std::string, uint64_t> addressCounts;
 
-    // Load assets
-    while (pcursor->Valid() && loaded < count) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(ASSET_ADDRESS_AMOUNT, std::make_pair(std::string(), std::string())));
+    while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
-
-        std::pair<char, std::string> key;
-        if (pcursor->GetKey(key) && key.first == ASSET_FLAG) {
-            if (offset < skip) {
-                offset += 1;
-            } else {
-                CDatabaseAssetData data;
-                if (pcursor->GetValue(data)) {
-                    assets.push_back(data);
-                    loaded += 1;
-                } else {
-                    return error("%s: failed to read asset", __func__);
-                }
-            }
-            pcursor->Next();
-        } else {
+        std::pair<char, std::pair<std::string, std::string> > key; // <assetId, address>
+        if (!pcursor->GetKey(key) || key.first != ASSET_ADDRESS_AMOUNT)
             break;
-        }
+        assetCounts[key.second.first]++;
+        addressCounts[key.second.second]++;
+        pcursor->Next();
     }
 
-    return true;
+    CDBBatch batch(*this);
+    for (const auto &count : assetCounts)
+        batch.Write(std::make_pair(ASSET_HOLDER_COUNT, count.first), count.second);
+    for (const auto &count : addressCounts)
+        batch.Write(std::make_pair(ADDRESS_ASSET_COUNT, count.first), count.second);
+    batch.Write(HOLDER_COUNTS_FLAG, true);
+    return WriteBatch(batch, true);
 }
 
-bool CAssetsDB::GetListAssetsByAddress(std::vector<std::pair<std::string, CAmount128> >& vecAssetAmount, int& totalEntries, const bool& fGetTotal, const std::string& address, const size_t count, const long start) {
-    ::ChainstateActive().ForceFlushStateToDisk();
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-    pcursor->Seek(std::make_pair(ADDRESS_ASSET_AMOUNT, std::make_pair(address, std::string())));
-
-    if (fGetTotal) {
-        totalEntries = 0;
-        while (pcursor->Valid()) {
-            boost::this_thread::interruption_point();
-
-            std::pair<char, std::pair<std::string, std::string> > key;
-            if (pcursor->GetKey(key) && key.first == ADDRESS_ASSET_AMOUNT && key.second.first == address) {
-                totalEntries++;
-            }
-            pcursor->Next();
+namespace {
+/**
+ * Orders keys the way they are laid out in the database, i.e. by their serialization: the compact size length
+ * prefix first, then the bytes. The two parts are compared directly, without serializing the keys.
+ */
+struct DBKeyOrder {
+    static size_t EncodeLength(uint64_t nSize, unsigned char *out) {
+        if (nSize < 253) {
+            out[0] = nSize;
+            return 1;
         }
-        return true;
-    }
-
-    size_t skip = 0;
-    if (start >= 0) {
-        skip = start;
+        if (nSize <= std::numeric_limits<uint16_t>::max()) {
+            out[0] = 253;
+            WriteLE16(out + 1, nSize);
+            return 3;
+        }
+        if (nSize <= std::numeric_limits<uint32_t>::max()) {
+            out[0] = 254;
+            WriteLE32(out + 1, nSize);
+            return 5;
+        }
+        out[0] = 255;
+        WriteLE64(out + 1, nSize);
+        return 9;
     }
-    else {
-        // compute table size for backwards offset
-        long table_size = 0;
-        while (pcursor->Valid()) {
-            boost::this_thread::interruption_point();
 
-            std::pair<char, std::pair<std::string, std::string> > key;
-            if (pcursor->GetKey(key) && key.first == ADDRESS_ASSET_AMOUNT && key.second.first == address) {
-                table_size += 1;
-            }
-            pcursor->Next();
+    bool operator()(const std::string &a, const std::string &b) const {
+        if (a.size() != b.size()) {
+            unsigned char prefixA[9], prefixB[9];
+            const size_t nPrefixA = EncodeLength(a.size(), prefixA);
+            const size_t nPrefixB = EncodeLength(b.size(), prefixB);
+            const int cmp = memcmp(prefixA, prefixB, std::min(nPrefixA, nPrefixB));
+            return cmp < 0 || (cmp == 0 && nPrefixA < nPrefixB);
         }
-        skip = table_size + start;
-        pcursor->SeekToFirst();
+        // std::char_traits<char> compares bytes as unsigned char, like leveldb
+        return a.compare(b) < 0;
     }
-
-
-    size_t loaded = 0;
-    size_t offset = 0;
-
-    // Load assets
-    while (pcursor->Valid() && loaded < count && loaded < MAX_DATABASE_RESULTS) {
+};
+
+/** Changes not yet flushed to a database range, by key. nullopt marks an entry that will be erased. */
+template<typename T>
+using Overlay = std::map<std::string, Optional<T>, DBKeyOrder>;
+
+/**
+ * Visit the entries of a database range that follow `after`, merged with overlay, in key order.
+ * next() reads the next database entry of the range and returns false at its end, visit() returns false to stop.
+ */
+template<typename T, typename Next, typename Visit>
+void WalkMerged(const Overlay<T> &overlay, const std::string &after, Next next, Visit visit) {
+    const DBKeyOrder less;
+    auto it = after.empty() ? overlay.begin() : overlay.upper_bound(after);
+
+    std::string dbKey;
+    T dbValue;
+    bool fDb = next(dbKey, dbValue);
+    while (fDb && !after.empty() && !less(after, dbKey))
+        fDb = next(dbKey, dbValue);
+
+    while (fDb || it != overlay.end()) {
         boost::this_thread::interruption_point();
-
-        std::pair<char, std::pair<std::string, std::string> > key;
-        if (pcursor->GetKey(key) && key.first == ADDRESS_ASSET_AMOUNT && key.second.first == address) {
-                if (offset < skip) {
-                    offset += 1;
-                }
-                else {
-                    CAmount128 amount;
-                    if (pcursor->GetValue(amount)) {
-                        vecAssetAmount.emplace_back(std::make_pair(key.second.second, amount));
-                        loaded += 1;
-                    } else {
-                        return error("%s: failed to Address Asset Quanity", __func__);
-                    }
-                }
-            pcursor->Next();
+        if (fDb && (it == overlay.end() || less(dbKey, it->first))) {
+            if (!visit(dbKey, dbValue))
+                return;
+            fDb = next(dbKey, dbValue);
         } else {
-            break;
+            // the overlay shadows the database entry with the same key
+            if (fDb && !less(it->first, dbKey))
+                fDb = next(dbKey, dbValue);
+            if (it->second && !visit(it->first, *it->second))
+                return;
+            ++it;
         }
     }
-
-    return true;
 }
 
-// Can get to total count of addresses that belong to a certain assetId, or get you the list of all address that belong to a certain assetId
-bool CAssetsDB::GetListAddressByAssets(std::vector<std::pair<std::string, CAmount128> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetId, const size_t count, const long start) {
-    ::ChainstateActive().ForceFlushStateToDisk();
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-    pcursor->Seek(std::make_pair(ASSET_ADDRESS_AMOUNT, std::make_pair(assetId, std::string())));
+/** Collects a page of entries, skipping the first `skip` and noting whether more follow */
+template<typename T>
+struct PageCollector {
+    std::vector<T> &entries;
+    const size_t skip;
+    const size_t count;
+    size_t offset{0};
+    size_t loaded{0};
+    std::string lastKey;
+    bool fMore{false};
+
+    PageCollector(std::vector<T> &entriesIn, size_t skipIn, size_t countIn) :
+            entries(entriesIn), skip(skipIn), count(countIn) {}
+
+    bool Add(const std::string &key, const T &entry) {
+        if (offset < skip) {
+            offset += 1;
+            return true;
+        }
+        if (loaded >= count) {
+            fMore = true;
+            return false;
+        }
+        entries.push_back(entry);
+        loaded += 1;
+        lastKey = key;
+        return true;
+    }
 
-    if (fGetTotal) {
-        totalEntries = 0;
-        while (pcursor->Valid()) {
-            boost::this_thread::interruption_point();
+    std::string Cursor() const { return fMore ? lastKey : std::string(); }
+};
+
+/** Balances changed since the last flush for an asset (keyed by address) or an address (keyed by asset id) */
+Overlay<CAmount128> UnflushedBalances(const bool fByAsset, const std::string &filter) {
+    AssertLockHeld(cs_main);
+
+    Overlay<CAmount128> overlay;
+    if (!passetsCache)
+        return overlay;
+
+    auto add = [&](const CAssetTransferEntry &entry) {
+        const std::string &assetId = entry.transfer.assetId;
+        if ((fByAsset ? assetId : entry.address) != filter)
+            return;
+        if (const CAmount128 *amount = passetsCache->mapAssetAddressAmount.find(std::make_pair(assetId, entry.address))) {
+            // a balance that dropped to zero is erased by the next flush
+            Optional<CAmount128> balance;
+            if (*amount != 0)
+                balance = *amount;
+            overlay[fByAsset ? entry.address : assetId] = balance;
+        }
+    };
+    for (const auto &entry : passetsCache->NewAssetsTransferToAdd)
+        add(entry);
+    for (const auto &entry : passetsCache->NewAssetsTranferToRemove)
+        add(entry);
+    return overlay;
+}
 
+/**
+ * Number of entries in the balance range of `prefix`, from the maintained count adjusted by overlay. The overlay
+ * is merged with the database range through pcursor, which only moves forward since both are in key order.
+ */
+int CountBalances(CDBIterator &cursor, const char flag, const char countFlag, const std::string &prefix,
+                  const Overlay<CAmount128> &overlay) {
+    uint64_t count = 0;
+    std::pair<char, std::string> countKey;
+    cursor.Seek(std::make_pair(countFlag, prefix));
+    if (!cursor.Valid() || !cursor.GetKey(countKey) || countKey != std::make_pair(countFlag, prefix) ||
+        !cursor.GetValue(count))
+        count = 0;
+
+    const DBKeyOrder less;
+    int64_t total = count;
+    bool fSeeked = false;
+    bool fValid = false;
+    std::string dbKey;
+    for (const auto &entry : overlay) {
+        if (!fSeeked || (fValid && less(dbKey, entry.first))) {
+            cursor.Seek(std::make_pair(flag, std::make_pair(prefix, entry.first)));
             std::pair<char, std::pair<std::string, std::string> > key;
-            if (pcursor->GetKey(key) && key.first == ASSET_ADDRESS_AMOUNT && key.second.first == assetId) {
-                totalEntries += 1;
-            }
-            pcursor->Next();
+            fValid = cursor.Valid() && cursor.GetKey(key) && key.first == flag && key.second.first == prefix;
+            if (fValid)
+                dbKey = key.second.second;
+            fSeeked = true;
         }
+        // past the end of the range nothing else can be stored
+        const bool fHad = fValid && dbKey == entry.first;
+        total += (entry.second ? 1 : 0) - (fHad ? 1 : 0);
+    }
+    return (int)std::max<int64_t>(total, 0);
+}
+
+bool ListBalances(CDBWrapper &db, const char flag, const char countFlag, const std::string &prefix,
+                  std::vector<std::pair<std::string, CAmount128> > &vecAmounts, int &totalEntries, const bool fGetTotal,
+                  const size_t count, const long start, std::string &cursor) {
+    Overlay<CAmount128> overlay;
+    std::unique_ptr<CDBIterator> pcursor;
+    {
+        // An iterator reads the database as it was when it was created. Taking it together with the overlay
+        // gives a consistent view, without holding cs_main while the range is read.
+        LOCK(cs_main);
+        overlay = UnflushedBalances(flag == ASSET_ADDRESS_AMOUNT, prefix);
+        pcursor.reset(db.NewIterator());
+    }
+
+    if (fGetTotal) {
+        totalEntries = CountBalances(*pcursor, flag, countFlag, prefix, overlay);
         return true;
     }
 
     size_t skip = 0;
-    if (start >= 0) {
+    if (cursor.empty() && start > 0) {
         skip = start;
+    } else if (cursor.empty() && start < 0) {
+        // skip back from the end
+        skip = std::max<long>(CountBalances(*pcursor, flag, countFlag, prefix, overlay) + start, 0);
     }
-    else {
-        // compute table size for backwards offset
-        long table_size = 0;
-        while (pcursor->Valid()) {
-            boost::this_thread::interruption_point();
 
-            std::pair<char, std::pair<std::string, std::string> > key;
-            if (pcursor->GetKey(key) && key.first == ASSET_ADDRESS_AMOUNT && key.second.first == assetId) {
-                table_size += 1;
-            }
-            pcursor->Next();
-        }
-        skip = table_size + start;
-        pcursor->SeekToFirst();
-    }
+    pcursor->Seek(std::make_pair(flag, std::make_pair(prefix, cursor)));
 
-    size_t loaded = 0;
-    size_t offset = 0;
+    bool fError = false;
+    auto next = [&](std::string &key, CAmount128 &amount) {
+        std::pair<char, std::pair<std::string, std::string> > dbKey;
+        if (!pcursor->Valid() || !pcursor->GetKey(dbKey) || dbKey.first != flag || dbKey.second.first != prefix)
+            return false;
+        if (!pcursor->GetValue(amount)) {
+            fError = true;
+            return false;
+        }
+        key = dbKey.second.second;
+        pcursor->Next();
+        return true;
+    };
 
-    // Load assets
-    while (pcursor->Valid() && loaded < count && loaded < MAX_DATABASE_RESULTS) {
-        boost::this_thread::interruption_point();
+    PageCollector<std::pair<std::string, CAmount128> > page(vecAmounts, skip, std::min(count, MAX_DATABASE_RESULTS));
+    WalkMerged(overlay, cursor, next, [&](const std::string &key, const CAmount128 &amount) {
+        return page.Add(key, std::make_pair(key, amount));
+    });
+    if (fError)
+        return false;
 
-        std::pair<char, std::pair<std::string, std::string> > key;
-        if (pcursor->GetKey(key) && key.first == ASSET_ADDRESS_AMOUNT && key.second.first == assetId) {
-            if (offset < skip) {
-                offset += 1;
-            }
-            else {
-                CAmount128 amount;
-                if (pcursor->GetValue(amount)) {
-                    vecAddressAmount.emplace_back(std::make_pair(key.second.second, amount));
-                    loaded += 1;
-                } else {
-                    return error("%s: failed to Asset Address Quanity", __func__);
-                }
-            }
-            pcursor->Next();
-        } else {
-            break;
+    cursor = page.Cursor();
+    return true;
+}
+} // namespace
+
+bool CAssetsDB::GetListAssets(std::vector<CDatabaseAssetData>& assets, const size_t count, const long start, std::string& cursor) {
+    Overlay<CDatabaseAssetData> overlay;
+    std::unique_ptr<CDBIterator> pcursor;
+    {
+        // see ListBalances
+        LOCK(cs_main);
+        if (passetsCache) {
+            // the same order DumpCacheToDatabase applies them in
+            for (const auto &data : passetsCache->NewAssetsToRemove)
+                overlay[data.asset.assetId] = nullopt;
+            for (const auto &data : passetsCache->NewAssetsToAdd)
+                overlay[data.asset.assetId] = data;
         }
+        pcursor.reset(NewIterator());
     }
+    pcursor->Seek(std::make_pair(ASSET_FLAG, cursor));
+
+    bool fError = false;
+    auto next = [&](std::string &key, CDatabaseAssetData &data) {
+        std::pair<char, std::string> dbKey;
+        if (!pcursor->Valid() || !pcursor->GetKey(dbKey) || dbKey.first != ASSET_FLAG)
+            return false;
+        if (!pcursor->GetValue(data)) {
+            fError = true;
+            return false;
+        }
+        key = dbKey.second;
+        pcursor->Next();
+        return true;
+    };
+
+    PageCollector<CDatabaseAssetData> page(assets, cursor.empty() && start > 0 ? start : 0, count);
+    WalkMerged(overlay, cursor, next, [&](const std::string &key, const CDatabaseAssetData &data) {
+        return page.Add(key, data);
+    });
+    if (fError)
+        return error("%s: failed to read asset", __func__);
+
+    cursor = page.Cursor();
+    return true;
+}
+
+bool CAssetsDB::GetListAssetsByAddress(std::vector<std::pair<std::string, CAmount128> >& vecAssetAmount, int& totalEntries, const bool& fGetTotal, const std::string& address, const size_t count, const long start, std::string& cursor) {
+    if (!ListBalances(*this, ADDRESS_ASSET_AMOUNT, ADDRESS_ASSET_COUNT, address, vecAssetAmount, totalEntries, fGetTotal, count, start, cursor))
+        return error("%s: failed to Address Asset Quanity", __func__);
+    return true;
+}
 
+// Can get to total count of addresses that belong to a certain assetId, or get you the list of all address that belong to a certain assetId
+bool CAssetsDB::GetListAddressByAssets(std::vector<std::pair<std::string, CAmount128> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetId, const size_t count, const long start, std::string& cursor) {
+    if (!ListBalances(*this, ASSET_ADDRESS_AMOUNT, ASSET_HOLDER_COUNT, assetId, vecAddressAmount, totalEntries, fGetTotal, count, start, cursor))
+        return error("%s: failed to Asset Address Quanity", __func__);
     return true;
-}
\ No newline at end of file
+}
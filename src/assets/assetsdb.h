@@ -48,6 +48,12 @@ struct CBlockAssetUndo {
     }
 };
 
+/** A balance for CAssetsDB::UpdateBalances(), fStored tells whether the database holds one for its pair already */
+struct CAssetBalanceChange {
+    CAmount128 amount;
+    bool fStored;
+};
+
 /** Access to the block database (blocks/index/) */
 class CAssetsDB : public CDBWrapper {
 public:
@@ -90,11 +96,29 @@ public:
 
     bool EraseAddressAssetAmount(const std::string &address, const std::string &assetId);
 
+    bool HaveAssetAddressAmount(const std::string &assetId, const std::string &address);
+
+    /**
+     * Write the balances of (assetId, address) pairs, erasing the ones that are zero, together with the changes
+     * to the number of addresses holding each asset and of assets held by each address, in one batch
+     */
+    bool UpdateBalances(const std::map<std::pair<std::string, std::string>, CAssetBalanceChange> &balances);
+
     // Helper functions
     bool LoadAssets();
-    bool GetListAssets(std::vector<CDatabaseAssetData>& assets, const size_t count, const long start);
-    bool GetListAssetsByAddress(std::vector<std::pair<std::string, CAmount128> >& vecAssetAmount, int& totalEntries, const bool& fGetTotal, const std::string& address, const size_t count, const long start);
-    bool GetListAddressByAssets(std::vector<std::pair<std::string, CAmount128> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetId, const size_t count, const long start);
+
+    /** Count the holders of every asset and the assets of every address, for databases written before they were kept */
+    bool BuildHolderCounts();
+
+    /**
+     * The listings below merge the database with the changes of passetsCache that are not flushed yet, so they
+     * do not need to flush the chainstate first. When cursor is not empty the listing resumes after the entry it
+     * names and start is ignored. On return cursor names the last entry returned if more entries follow, or is
+     * empty otherwise. cs_main is only held while the changes and a database snapshot are taken.
+     */
+    bool GetListAssets(std::vector<CDatabaseAssetData>& assets, const size_t count, const long start, std::string& cursor);
+    bool GetListAssetsByAddress(std::vector<std::pair<std::string, CAmount128> >& vecAssetAmount, int& totalEntries, const bool& fGetTotal, const std::string& address, const size_t count, const long start, std::string& cursor);
+    bool GetListAddressByAssets(std::vector<std::pair<std::string, CAmount128> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetId, const size_t count, const long start, std::string& cursor);
 
 };
 
@@ -4,6 +4,10 @@
 
 #include <assets/assetstype.h>
 #include <streams.h>
+#include <sync.h>
+
+#include <cassert>
+#include <unordered_set>
 
 
 bool GetTransferAsset(const CScript &script, CAssetTransfer &assetTransfer) {
@@ -12,9 +16,8 @@ bool GetTransferAsset(const CScript &script, CAssetTransfer &assetTransfer) {
         return false;
     }
 
-    std::vector<unsigned char> vchAssetId;
-    vchAssetId.insert(vchAssetId.end(), script.begin() + nIndex, script.end());
-    CDataStream DSAsset(vchAssetId, SER_NETWORK, PROTOCOL_VERSION);
+    SpanReader DSAsset(SER_NETWORK, PROTOCOL_VERSION,
+                       Span<const unsigned char>(script.data() + nIndex, script.size() - nIndex));
     try {
         DSAsset >> assetTransfer;
     } catch (std::exception &e) {
@@ -25,6 +28,38 @@ bool GetTransferAsset(const CScript &script, CAssetTransfer &assetTransfer) {
     return true;
 }
 
+bool GetCoinTransferAsset(const Coin &coin, CAssetTransfer &assetTransfer) {
+    assert(coin.fAssetDecoded);
+    if (!coin.IsAsset()) {
+        return false;
+    }
+    assetTransfer.assetId = *coin.pAssetId;
+    assetTransfer.isUnique = coin.fAssetUnique;
+    assetTransfer.uniqueId = coin.fAssetUnique ? coin.nAssetUniqueId : MAX_UNIQUE_ID;
+    assetTransfer.nAmount = coin.nAssetAmount;
+    return true;
+}
+
+const std::string *InternAssetId(const std::string &assetId) {
+    static Mutex cs;
+    static std::unordered_set<std::string> setAssetIds;
+    LOCK(cs);
+    // the nodes of an unordered_set don't move, so the pointer stays valid
+    return &*setAssetIds.emplace(assetId).first;
+}
+
+CTxAssetTransfers::CTxAssetTransfers(const CTransaction &tx) {
+    for (size_t i = 0; i < tx.vout.size(); i++) {
+        if (!tx.vout[i].scriptPubKey.IsAssetScript())
+            continue;
+        if (vTransfers.empty()) {
+            vTransfers.resize(tx.vout.size());
+            vHaveTransfer.resize(tx.vout.size());
+        }
+        vHaveTransfer[i] = GetTransferAsset(tx.vout[i].scriptPubKey, vTransfers[i]);
+    }
+}
+
 void CAssetTransfer::BuildAssetTransaction(CScript &script) const {
     CDataStream AssetTransfer(SER_NETWORK, PROTOCOL_VERSION);
     AssetTransfer << *this;
@@ -48,7 +48,36 @@ public:
     void BuildAssetTransaction(CScript &script) const;
 };
 
+/** Decode the asset transfer of an asset script in place from the script bytes */
 bool GetTransferAsset(const CScript &script, CAssetTransfer &assetTransfer);
 
+/** The asset transfer of a coin, built from its decoded asset tag. False if the coin is no valid asset output. */
+bool GetCoinTransferAsset(const Coin &coin, CAssetTransfer &assetTransfer);
+
+/**
+ * A shared copy of assetId which lives as long as the process, so coins can refer to their asset by pointer. There
+ * is one per distinct asset id seen in a coin.
+ */
+const std::string *InternAssetId(const std::string &assetId);
+
+/**
+ * The asset transfers of the outputs of one transaction. Each asset output is decoded once when this is built,
+ * so the passes over a transaction while connecting it (indexes, supply, balances) don't decode it again.
+ */
+class CTxAssetTransfers {
+private:
+    //! indexed by output, both empty when the transaction has no asset output
+    std::vector<CAssetTransfer> vTransfers;
+    std::vector<bool> vHaveTransfer;
+
+public:
+    explicit CTxAssetTransfers(const CTransaction &tx);
+
+    /** The transfer of output n, nullptr if it isn't a valid asset output */
+    const CAssetTransfer *Get(size_t n) const {
+        return n < vHaveTransfer.size() && vHaveTransfer[n] ? &vTransfers[n] : nullptr;
+    }
+};
+
 
 #endif //FORTUNEBLOCK_ASSETS_FEES_H
\ No newline at end of file
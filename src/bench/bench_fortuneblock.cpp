@@ -83,6 +83,8 @@ int main(int argc, char **argv) {
     const fs::path bench_datadir{SetDataDir()};
 
     SHA256AutoDetect();
+    cn_slow_hash_autodetect();
+    CoreHashAutoDetect();
 
     RegisterPrettySignalHandlers();
     RegisterPrettyTerminateHander();
@@ -196,6 +196,17 @@ static void HASH_CN_cryptonight_turtlelite_hash(benchmark::Bench &bench) {
     HashCn(bench, 5);
 }
 
+/* Same as HASH_CN_cryptonight_cnfast_hash, but every hash starts from a freshly allocated 2 MB scratchpad */
+static void HASH_CN_cryptonight_cnfast_hash_cold_scratchpad(benchmark::Bench &bench) {
+    uint512 hashIn;
+    uint512 hashOut;
+    bench.minEpochIterations(100).run([&] {
+        cn_slow_hash_release_scratchpad();
+        cnHash(&hashIn, &hashOut, 64, 2);
+        hashIn = hashOut;
+    });
+}
+
 /* Hash 32 bytes via SHA */
 
 static void HASH_SHA256_32b(benchmark::Bench &bench) {
@@ -214,6 +225,15 @@ static void HASH_SHA256D64_1024(benchmark::Bench &bench) {
     });
 }
 
+/* Hash 1024 blobs 64 bytes each via SHA256 */
+
+static void HASH_SHA256_64_1024(benchmark::Bench &bench) {
+    std::vector <uint8_t> in(64 * 1024, 0);
+    bench.minEpochIterations(1000).run([&] {
+        SHA256_64(in.data(), in.data(), 1024);
+    });
+}
+
 /* FastRandom for uint32_t and bool */
 
 static void FastRandom_32bit(benchmark::Bench &bench) {
@@ -256,8 +276,10 @@ BENCHMARK(HASH_CN_cryptonight_cnfast_hash);
 BENCHMARK(HASH_CN_cryptonight_cnlite_hash);
 BENCHMARK(HASH_CN_cryptonight_turtle_hash);
 BENCHMARK(HASH_CN_cryptonight_turtlelite_hash);
+BENCHMARK(HASH_CN_cryptonight_cnfast_hash_cold_scratchpad);
 
 BENCHMARK(HASH_SHA256_32b);
 BENCHMARK(HASH_SHA256D64_1024);
+BENCHMARK(HASH_SHA256_64_1024);
 BENCHMARK(FastRandom_32bit);
 BENCHMARK(FastRandom_1bit);
\ No newline at end of file
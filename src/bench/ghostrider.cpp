@@ -0,0 +1,129 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <hash.h>
+#include <hash_selection.h>
+#include <primitives/block.h>
+#include <uint256.h>
+
+#include <vector>
+
+// The CryptoNight variants are in crypto_hash.cpp (HASH_CN_*)
+
+static void HashCore(benchmark::Bench &bench, int hashSelection) {
+    uint512 hashIn;
+    uint512 hashOut;
+    bench.minEpochIterations(10000).run([&] {
+        coreHash(&hashIn, &hashOut, 64, hashSelection);
+        hashIn = hashOut;
+    });
+}
+
+/* Four independent chains per call, reported per hash so it compares with HashCore */
+static void HashCore4Way(benchmark::Bench &bench, int hashSelection) {
+    uint512 hashes[4];
+    for (int i = 0; i < 4; ++i) *hashes[i].begin() = i + 1;
+    bench.batch(4).unit("hash").minEpochIterations(10000).run([&] {
+        coreHashBatch(hashes, hashes, 4, hashSelection);
+    });
+}
+
+static void HASH_GR_CORE_Blake(benchmark::Bench &bench) { HashCore(bench, 0); }
+static void HASH_GR_CORE_Bmw(benchmark::Bench &bench) { HashCore(bench, 1); }
+static void HASH_GR_CORE_Groestl(benchmark::Bench &bench) { HashCore(bench, 2); }
+static void HASH_GR_CORE_Jh(benchmark::Bench &bench) { HashCore(bench, 3); }
+static void HASH_GR_CORE_Keccak(benchmark::Bench &bench) { HashCore(bench, 4); }
+static void HASH_GR_CORE_Skein(benchmark::Bench &bench) { HashCore(bench, 5); }
+static void HASH_GR_CORE_Luffa(benchmark::Bench &bench) { HashCore(bench, 6); }
+static void HASH_GR_CORE_Cubehash(benchmark::Bench &bench) { HashCore(bench, 7); }
+static void HASH_GR_CORE_Shavite(benchmark::Bench &bench) { HashCore(bench, 8); }
+static void HASH_GR_CORE_Simd(benchmark::Bench &bench) { HashCore(bench, 9); }
+static void HASH_GR_CORE_Echo(benchmark::Bench &bench) { HashCore(bench, 10); }
+
+static void HASH_GR_CORE_Blake_4way(benchmark::Bench &bench) { HashCore4Way(bench, 0); }
+static void HASH_GR_CORE_Bmw_4way(benchmark::Bench &bench) { HashCore4Way(bench, 1); }
+static void HASH_GR_CORE_Jh_4way(benchmark::Bench &bench) { HashCore4Way(bench, 3); }
+static void HASH_GR_CORE_Keccak_4way(benchmark::Bench &bench) { HashCore4Way(bench, 4); }
+static void HASH_GR_CORE_Skein_4way(benchmark::Bench &bench) { HashCore4Way(bench, 5); }
+
+/*
+ * The cost of a GhostRider hash is dominated by the three CryptoNight variants hashPrevBlock selects.
+ * These parents select the three cheapest (CNTurtlelite, CNTurtle, CNDarklite), the three most expensive
+ * (CNFast, CNDark, CNLite) and a mix of both (CNDarklite, CNTurtlelite, CNFast).
+ */
+static const uint256 PREV_LIGHT_CN = uint256S("b0c7c8b7b4c3ccb3b8cfc0bfbccbc4bba0d7d8a7a4d3dca3a8dfd0afacdbd4ab");
+static const uint256 PREV_HEAVY_CN = uint256S("2370ee7e2774ea7a2b78e6762f7ce2723360fe6e3764fa6a3b68f6663f6cf262");
+static const uint256 PREV_MIXED_CN = uint256S("812964ad852d60a989216ca58d2568a1913974bd953d70b999317cb59d3578b1");
+
+static void HashFortuneHeader(benchmark::Bench &bench, const uint256 &prevBlockHash) {
+    uint256 hash;
+    std::vector <uint8_t> in(80, 0);
+    bench.minEpochIterations(100).run([&] {
+        hash = HashFortune(in.begin(), in.end(), prevBlockHash);
+        in[76]++;
+    });
+}
+
+static void HASH_GR_0080b_light_cn(benchmark::Bench &bench) { HashFortuneHeader(bench, PREV_LIGHT_CN); }
+static void HASH_GR_0080b_mixed_cn(benchmark::Bench &bench) { HashFortuneHeader(bench, PREV_MIXED_CN); }
+static void HASH_GR_0080b_heavy_cn(benchmark::Bench &bench) { HashFortuneHeader(bench, PREV_HEAVY_CN); }
+
+/* Same as HASH_GR_0080b_mixed_cn, but four nonces at a time the way the miner hashes them */
+static void HASH_GR_0080b_mixed_cn_batch4(benchmark::Bench &bench) {
+    const GhostRiderSchedule schedule(PREV_MIXED_CN);
+    uint256 hashes[4];
+    std::vector <uint8_t> in(4 * 80, 0);
+    bench.batch(4).unit("hash").minEpochIterations(25).run([&] {
+        for (int i = 0; i < 4; ++i) in[i * 80 + 76]++;
+        HashFortuneBatch(in.data(), 80, 4, schedule, hashes);
+    });
+}
+
+/* A new header every iteration: the hash is computed and inserted into the cache */
+static void POW_GetPOWHash_cold(benchmark::Bench &bench) {
+    CBlockHeader header;
+    header.hashPrevBlock = PREV_MIXED_CN;
+    uint256 hash;
+    bench.minEpochIterations(100).run([&] {
+        header.nNonce++;
+        hash = header.GetPOWHash();
+    });
+}
+
+/* The same header every iteration: a cache hit */
+static void POW_GetPOWHash_warm(benchmark::Bench &bench) {
+    CBlockHeader header;
+    header.hashPrevBlock = PREV_MIXED_CN;
+    uint256 hash = header.GetPOWHash();
+    bench.minEpochIterations(100000).run([&] {
+        hash = header.GetPOWHash();
+    });
+}
+
+BENCHMARK(HASH_GR_CORE_Blake);
+BENCHMARK(HASH_GR_CORE_Bmw);
+BENCHMARK(HASH_GR_CORE_Groestl);
+BENCHMARK(HASH_GR_CORE_Jh);
+BENCHMARK(HASH_GR_CORE_Keccak);
+BENCHMARK(HASH_GR_CORE_Skein);
+BENCHMARK(HASH_GR_CORE_Luffa);
+BENCHMARK(HASH_GR_CORE_Cubehash);
+BENCHMARK(HASH_GR_CORE_Shavite);
+BENCHMARK(HASH_GR_CORE_Simd);
+BENCHMARK(HASH_GR_CORE_Echo);
+
+BENCHMARK(HASH_GR_CORE_Blake_4way);
+BENCHMARK(HASH_GR_CORE_Bmw_4way);
+BENCHMARK(HASH_GR_CORE_Jh_4way);
+BENCHMARK(HASH_GR_CORE_Keccak_4way);
+BENCHMARK(HASH_GR_CORE_Skein_4way);
+
+BENCHMARK(HASH_GR_0080b_light_cn);
+BENCHMARK(HASH_GR_0080b_mixed_cn);
+BENCHMARK(HASH_GR_0080b_heavy_cn);
+BENCHMARK(HASH_GR_0080b_mixed_cn_batch4);
+
+BENCHMARK(POW_GetPOWHash_cold);
+BENCHMARK(POW_GetPOWHash_warm);
@@ -0,0 +1,51 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <evo/deterministicmns.h>
+#include <random.h>
+#include <test/test_fortuneblock.h>
+
+/* A list of confirmed, payable smartnodes as CLLMQUtils::GetAllQuorumMembers sees it */
+static CDeterministicMNList BuildMNList(int mnCount) {
+    FastRandomContext rng(true);
+    const CAmount collateral = Params().GetConsensus().nCollaterals.getCollateral(0);
+
+    CDeterministicMNList mnList(uint256(), 1000, 0);
+    for (int i = 0; i < mnCount; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>(i);
+        dmn->proTxHash = rng.rand256();
+        dmn->collateralOutpoint = COutPoint(rng.rand256(), 0);
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->keyIDOwner.SetHex(strprintf("%040x", i + 1));
+        state->nRegisteredHeight = 1;
+        state->nCollateralAmount = collateral;
+        state->UpdateConfirmedHash(dmn->proTxHash, rng.rand256());
+        dmn->pdmnState = state;
+        mnList.AddMN(dmn);
+    }
+    return mnList;
+}
+
+static void CalculateQuorum(benchmark::Bench &bench, int mnCount, size_t quorumSize) {
+    BasicTestingSetup test_setup{CBaseChainParams::REGTEST};
+
+    const auto mnList = BuildMNList(mnCount);
+    uint256 modifier;
+    bench.minEpochIterations(10).run([&] {
+        auto members = mnList.CalculateQuorum(quorumSize, modifier);
+        assert(members.size() == quorumSize);
+        // a new modifier per quorum, as in the DKG intervals
+        modifier = members.front()->proTxHash;
+    });
+}
+
+static void QuorumCalculation_1000MNs(benchmark::Bench &bench) { CalculateQuorum(bench, 1000, 400); }
+static void QuorumCalculation_5000MNs(benchmark::Bench &bench) { CalculateQuorum(bench, 5000, 400); }
+static void QuorumCalculation_10000MNs(benchmark::Bench &bench) { CalculateQuorum(bench, 10000, 400); }
+
+BENCHMARK(QuorumCalculation_1000MNs);
+BENCHMARK(QuorumCalculation_5000MNs);
+BENCHMARK(QuorumCalculation_10000MNs);
@@ -7,8 +7,11 @@
 #define FORTUNEBLOCK_CRYPTO_BLS_BATCHVERIFIER_H
 
 #include <bls/bls.h>
+#include <bls/bls_worker.h>
 
+#include <algorithm>
 #include <map>
+#include <set>
 #include <vector>
 
 template<typename SourceId, typename MessageId>
@@ -229,4 +232,77 @@ private:
     }
 };
 
+// Splits the pushed messages into multiple CBLSBatchVerifier batches, which are then verified in parallel by
+// CBLSWorker::VerifyBatches. Messages with the same shard key (e.g. the signing session) always end up in the same
+// batch, as those are the ones sharing a message hash and thus a pairing. Bad sources and messages are the union of
+// what the individual batches found, so these are attributed the same way as with a single CBLSBatchVerifier
+template<typename SourceId, typename MessageId>
+class CBLSShardedBatchVerifier {
+private:
+    // smaller batches don't save enough pairings to be worth splitting the messages further
+    static const size_t MIN_MESSAGES_PER_BATCH = 8;
+
+    struct Message {
+        uint256 shardKey;
+        SourceId sourceId;
+        MessageId msgId;
+        uint256 msgHash;
+        CBLSSignature sig;
+        CBLSPublicKey pubKey;
+    };
+
+    bool secureVerification;
+    bool perMessageFallback;
+
+    std::vector <Message> messages;
+    std::set <SourceId> sources;
+
+public:
+    std::set <SourceId> badSources;
+    std::set <MessageId> badMessages;
+
+public:
+    CBLSShardedBatchVerifier(bool _secureVerification, bool _perMessageFallback) :
+            secureVerification(_secureVerification),
+            perMessageFallback(_perMessageFallback) {
+    }
+
+    void PushMessage(const uint256 &shardKey, const SourceId &sourceId, const MessageId &msgId, const uint256 &msgHash,
+                     const CBLSSignature &sig, const CBLSPublicKey &pubKey) {
+        assert(sig.IsValid() && pubKey.IsValid());
+
+        messages.emplace_back(Message{shardKey, sourceId, msgId, msgHash, sig, pubKey});
+        sources.emplace(sourceId);
+    }
+
+    size_t GetUniqueSourceCount() const {
+        return sources.size();
+    }
+
+    size_t GetBatchCount(CBLSWorker &worker) const {
+        return std::max<size_t>(1, std::min(worker.GetVerifyThreadCount(), messages.size() / MIN_MESSAGES_PER_BATCH));
+    }
+
+    void Verify(CBLSWorker &worker) {
+        const size_t batchCount = GetBatchCount(worker);
+
+        std::vector <CBLSBatchVerifier<SourceId, MessageId>> batches;
+        batches.reserve(batchCount);
+        for (size_t i = 0; i < batchCount; i++) {
+            batches.emplace_back(secureVerification, perMessageFallback);
+        }
+        for (const auto &msg: messages) {
+            batches[msg.shardKey.GetCheapHash() % batchCount].PushMessage(msg.sourceId, msg.msgId, msg.msgHash,
+                                                                           msg.sig, msg.pubKey);
+        }
+
+        worker.VerifyBatches(batches);
+
+        for (const auto &batch: batches) {
+            badSources.insert(batch.badSources.begin(), batch.badSources.end());
+            badMessages.insert(batch.badMessages.begin(), batch.badMessages.end());
+        }
+    }
+};
+
 #endif //FORTUNEBLOCK_CRYPTO_BLS_BATCHVERIFIER_H
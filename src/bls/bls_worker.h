@@ -10,9 +10,13 @@
 
 #include <ctpl_stl.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <utility>
+#include <vector>
 
 // Low level BLS/DKG stuff. All very compute intensive and optimized for parallelization
 // The worker tries to parallelize as much as possible and utilizes a few properties of BLS aggregation to speed up things
@@ -157,6 +161,41 @@ public:
 
     bool IsAsyncVerifyInProgress();
 
+    // Number of threads VerifyBatches spreads the batches over, the calling thread included
+    size_t GetVerifyThreadCount() { return (size_t) workerPool.size() + 1; }
+
+    // Calls Verify() on each of the given batch verifiers (e.g. CBLSBatchVerifier), in parallel on the worker pool.
+    // The calling thread takes batches as well and only waits for batches which are already being verified, so
+    // unrelated jobs queued in the pool (e.g. DKG work) never delay this
+    template<typename BatchVerifier>
+    void VerifyBatches(std::vector <BatchVerifier> &batches) {
+        struct State {
+            std::atomic <size_t> next{0};
+            std::mutex mutex;
+            std::condition_variable cond;
+            size_t done{0};
+        };
+        auto state = std::make_shared<State>();
+        const size_t count = batches.size();
+        // pool jobs might only start after we returned, by then there is nothing left for them to take
+        auto work = [state, count, pBatches = batches.data()]() {
+            for (size_t i = state->next++; i < count; i = state->next++) {
+                pBatches[i].Verify();
+                std::unique_lock <std::mutex> l(state->mutex);
+                if (++state->done == count) {
+                    state->cond.notify_all();
+                }
+            }
+        };
+        for (size_t i = 1; i < std::min(count, GetVerifyThreadCount()); i++) {
+            workerPool.push([work](int threadId) { work(); });
+        }
+        work();
+
+        std::unique_lock <std::mutex> l(state->mutex);
+        state->cond.wait(l, [&state, count] { return state->done == count; });
+    }
+
 private:
     void PushSigVerifyBatch();
 };
@@ -182,6 +182,10 @@ public:
     uint32_t nBits;
     uint32_t nNonce;
 
+    //! GhostRider PoW hash of the header, null until the header passed CheckBlockHeader().
+    //! Stored in the block tree db next to the index entry so it is never recomputed.
+    uint256 hashPow;
+
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
     int32_t nSequenceId;
 
@@ -208,6 +212,7 @@ public:
         nTime = 0;
         nBits = 0;
         nNonce = 0;
+        hashPow.SetNull();
     }
 
     CBlockIndex() {
@@ -254,6 +259,11 @@ public:
         return block;
     }
 
+    uint256 GetPOWHash() const {
+        if (!hashPow.IsNull()) return hashPow;
+        return GetBlockHeader().GetPOWHash();
+    }
+
     uint256 GetBlockHash() const {
         return phashBlock == nullptr ? uint256() : *phashBlock;
     }
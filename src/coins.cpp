@@ -4,12 +4,27 @@
 
 #include <coins.h>
 
+#include <assets/assetstype.h>
 #include <consensus/consensus.h>
 #include <logging.h>
 #include <memusage.h>
 #include <random.h>
 #include <future/utils.h>
 
+void Coin::DecodeAssetTag() {
+    ClearAssetTag();
+    fAssetDecoded = true;
+    CAssetTransfer assetTransfer;
+    if (!GetTransferAsset(out.scriptPubKey, assetTransfer))
+        return;
+    pAssetId = InternAssetId(assetTransfer.assetId);
+    nAssetAmount = assetTransfer.nAmount;
+    if (assetTransfer.isUnique) {
+        fAssetUnique = true;
+        nAssetUniqueId = assetTransfer.uniqueId;
+    }
+}
+
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const { return false; }
 
 uint256 CCoinsView::GetBestBlock() const { return uint256(); }
@@ -61,6 +76,8 @@ CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const
     Coin tmp;
     if (!base->GetCoin(outpoint, tmp))
         return cacheCoins.end();
+    if (!tmp.fAssetDecoded)
+        tmp.DecodeAssetTag();
     CCoinsMap::iterator ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint),
                                                  std::forward_as_tuple(std::move(tmp))).first;
     if (ret->second.coin.IsSpent()) {
@@ -84,6 +101,8 @@ bool CCoinsViewCache::GetCoin(const COutPoint &outpoint, Coin &coin) const {
 void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin &&coin, bool possible_overwrite) {
     assert(!coin.IsSpent());
     if (coin.out.scriptPubKey.IsUnspendable()) return;
+    if (!coin.fAssetDecoded)
+        coin.DecodeAssetTag();
     CCoinsMap::iterator it;
     bool inserted;
     std::tie(it, inserted) = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint),
@@ -125,9 +144,11 @@ void AddCoins(CCoinsViewCache &cache, const CTransaction &tx, int nHeight, bool
         // Coinbase transactions can always be overwritten, in order to correctly
         // deal with the pre-BIP30 occurrences of duplicate coinbase transactions.
         Coin coin = Coin(tx.vout[i], nHeight, fCoinbase, 0, std::vector<uint8_t>());
+        // decoded once here, every cache the coin passes through afterwards copies the tag
+        coin.DecodeAssetTag();
         COutPoint outpoint = COutPoint(txid, i);
         maybeSetPayload(coin, outpoint, tx.nType, tx.vExtraPayload);
-        cache.AddCoin(outpoint, Coin(tx.vout[i], nHeight, fCoinbase, coin.nType, coin.vExtraPayload), overwrite);
+        cache.AddCoin(outpoint, std::move(coin), overwrite);
     }
 }
 
@@ -11,6 +11,7 @@
 #include <core_memusage.h>
 #include <hash.h>
 #include <memusage.h>
+#include <prevector.h>
 #include <serialize.h>
 #include <uint256.h>
 
@@ -18,7 +19,9 @@
 #include <stdint.h>
 
 #include <functional>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 /**
  * A UTXO entry.
@@ -26,9 +29,17 @@
  * Serialized format:
  * - VARINT((coinbase ? 1 : 0) | (height << 1))
  * - the non-spent CTxOut (via CTxOutCompressor)
+ * - VARINT(nType)
+ * - vExtraPayload
+ *
+ * The asset transfer of an asset output is kept in decoded form next to it (the asset tag), so spending the coin
+ * doesn't parse the script again. The tag is not serialized, it is decoded when the coin is created or read.
  */
 class Coin {
 public:
+    //! only the locked output of a future transaction carries a payload, all other coins keep theirs empty
+    typedef prevector<12, uint8_t> extra_payload_type;
+
     //! unspent transaction output
     CTxOut out;
 
@@ -40,17 +51,31 @@ public:
 
     uint16_t nType = 0;
 
-    std::vector <uint8_t> vExtraPayload;
+    //! whether the asset tag below is decoded from out, coins in a CCoinsViewCache always are
+    bool fAssetDecoded = false;
+
+    bool fAssetUnique = false;
+
+    extra_payload_type vExtraPayload;
+
+    //! the asset tag: interned id (see InternAssetId) of the transferred asset, nullptr if out is no valid transfer
+    const std::string *pAssetId = nullptr;
+
+    CAmount nAssetAmount = 0;
+
+    //! the first id transferred, if fAssetUnique
+    uint64_t nAssetUniqueId = 0;
 
     //! construct a Coin from a CTxOut and height/coinbase information.
 //    Coin(CTxOut&& outIn, int nHeightIn, bool fCoinBaseIn, std::vector<uint8_t> && vExtraPayloadIn) : out(std::move(outIn)), fCoinBase(fCoinBaseIn), nHeight(nHeightIn),vExtraPayload(std::move(vExtraPayloadIn)) {}
 //    Coin(const CTxOut& outIn, int nHeightIn, bool fCoinBaseIn, const std::vector<uint8_t> & vExtraPayloadIn) : out(outIn), fCoinBase(fCoinBaseIn),nHeight(nHeightIn), vExtraPayload(vExtraPayloadIn) {}
-    Coin(CTxOut &&outIn, int nHeightIn, bool fCoinBaseIn, uint16_t type, std::vector <uint8_t> extraPayload) :
+    Coin(CTxOut &&outIn, int nHeightIn, bool fCoinBaseIn, uint16_t type, const std::vector <uint8_t> &extraPayload) :
             out(std::move(outIn)), fCoinBase(fCoinBaseIn), nHeight(nHeightIn), nType(type),
-            vExtraPayload(extraPayload) {}
+            vExtraPayload(extraPayload.begin(), extraPayload.end()) {}
 
-    Coin(const CTxOut &outIn, int nHeightIn, bool fCoinBaseIn, uint16_t type, std::vector <uint8_t> extraPayload) :
-            out(outIn), fCoinBase(fCoinBaseIn), nHeight(nHeightIn), nType(type), vExtraPayload(extraPayload) {}
+    Coin(const CTxOut &outIn, int nHeightIn, bool fCoinBaseIn, uint16_t type, const std::vector <uint8_t> &extraPayload) :
+            out(outIn), fCoinBase(fCoinBaseIn), nHeight(nHeightIn), nType(type),
+            vExtraPayload(extraPayload.begin(), extraPayload.end()) {}
 
     void Clear() {
         out.SetNull();
@@ -58,7 +83,22 @@ public:
         nHeight = 0;
         nType = 0;
         vExtraPayload.clear();
-        vExtraPayload.resize(0);
+        ClearAssetTag();
+    }
+
+    /** Decode the asset tag from out. Has to be called again whenever out changes. */
+    void DecodeAssetTag();
+
+    void ClearAssetTag() {
+        fAssetDecoded = false;
+        fAssetUnique = false;
+        pAssetId = nullptr;
+        nAssetAmount = 0;
+        nAssetUniqueId = 0;
+    }
+
+    bool IsAsset() const {
+        return pAssetId != nullptr;
     }
 
     //! empty constructor
@@ -87,6 +127,7 @@ public:
         ::Unserialize(s, Using<TxOutCompression>(out));
         ::Unserialize(s, VARINT(nType));
         ::Unserialize(s, vExtraPayload);
+        DecodeAssetTag();
     }
 
     bool IsSpent() const {
@@ -94,7 +135,7 @@ public:
     }
 
     size_t DynamicMemoryUsage() const {
-        return memusage::DynamicUsage(out.scriptPubKey);
+        return memusage::DynamicUsage(out.scriptPubKey) + memusage::DynamicUsage(vExtraPayload);
     }
 };
 
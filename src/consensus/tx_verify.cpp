@@ -250,6 +250,33 @@ unsigned int GetTransactionSigOpCount(const CTransaction &tx, const CCoinsViewCa
     return nSigOps;
 }
 
+inline bool checkAssetAmount(const std::string &assetId, CAmount nAmount, bool isUnique, uint64_t uniqueId,
+                             CValidationState &state, std::map <std::string, CAmount> &nAssetVin,
+                             std::map <std::string, std::vector<std::pair<uint64_t, uint64_t>>> &nMapids) {
+    if (!validateAmount(assetId, nAmount)) {
+        return state.DoS(100, false, REJECT_INVALID, "bad-assets-transfer-amount");
+    }
+
+    if (nAssetVin.count(assetId))
+        nAssetVin[assetId] += nAmount;
+    else
+        nAssetVin.insert(std::make_pair(assetId, nAmount));
+
+    if (isUnique) {
+        uint64_t idRange = uniqueId + nAmount / COIN;
+
+        if (!nMapids.count(assetId))
+            nMapids.insert({assetId, {}});
+
+        nMapids[assetId].emplace_back(std::make_pair(uniqueId, idRange));
+    }
+
+    if (!MoneyRange(nAmount) || !MoneyRange(nAssetVin.at(assetId))) {
+        return state.DoS(100, false, REJECT_INVALID, "bad-asset-inputvalues-outofrange");
+    }
+    return true;
+}
+
 inline bool checkOutput(const CTxOut &out, CValidationState &state, CAmount &nValueIn,
                         std::map <std::string, CAmount> &nAssetVin,
                         std::map <std::string, std::vector<std::pair<uint64_t, uint64_t>>> &nMapids) {
@@ -268,27 +295,36 @@ inline bool checkOutput(const CTxOut &out, CValidationState &state, CAmount &nVa
             return state.DoS(100, false, REJECT_INVALID, "bad-asset-transfer");
         }
 
-        if (!validateAmount(assetTransfer.assetId, assetTransfer.nAmount)) {
-            return state.DoS(100, false, REJECT_INVALID, "bad-assets-transfer-amount");
-        }
+        return checkAssetAmount(assetTransfer.assetId, assetTransfer.nAmount, assetTransfer.isUnique,
+                                assetTransfer.uniqueId, state, nAssetVin, nMapids);
+    }
 
-        if (nAssetVin.count(assetTransfer.assetId))
-            nAssetVin[assetTransfer.assetId] += assetTransfer.nAmount;
-        else
-            nAssetVin.insert(std::make_pair(assetTransfer.assetId, assetTransfer.nAmount));
+    return true;
+}
 
-        if (assetTransfer.isUnique) {
-            uint64_t idRange = assetTransfer.uniqueId + assetTransfer.nAmount / COIN;
+/** checkOutput for a spent coin, its asset transfer comes from the asset tag instead of the script */
+inline bool checkInput(const Coin &coin, CValidationState &state, CAmount &nValueIn,
+                       std::map <std::string, CAmount> &nAssetVin,
+                       std::map <std::string, std::vector<std::pair<uint64_t, uint64_t>>> &nMapids) {
+    // coins in a CCoinsViewCache are always decoded
+    assert(coin.fAssetDecoded);
 
-            if (!nMapids.count(assetTransfer.assetId))
-                nMapids.insert({assetTransfer.assetId, {}});
+    // Check for negative or overflow values
+    nValueIn += coin.out.nValue;
+    if (!MoneyRange(coin.out.nValue) || !MoneyRange(nValueIn)) {
+        return state.DoS(100, false, REJECT_INVALID, "bad-txns-inputvalues-outofrange");
+    }
 
-            nMapids[assetTransfer.assetId].emplace_back(std::make_pair(assetTransfer.uniqueId, idRange));
-        }
+    if (coin.out.scriptPubKey.IsAssetScript()) {
+        if (coin.out.nValue != 0)
+            return state.DoS(100, false, REJECT_INVALID, "bad-asset-value-outofrange");
 
-        if (!MoneyRange(assetTransfer.nAmount) || !MoneyRange(nAssetVin.at(assetTransfer.assetId))) {
-            return state.DoS(100, false, REJECT_INVALID, "bad-asset-inputvalues-outofrange");
+        if (!coin.IsAsset()) {
+            return state.DoS(100, false, REJECT_INVALID, "bad-asset-transfer");
         }
+
+        return checkAssetAmount(*coin.pAssetId, coin.nAssetAmount, coin.fAssetUnique, coin.nAssetUniqueId, state,
+                                nAssetVin, nMapids);
     }
 
     return true;
@@ -357,7 +393,7 @@ bool Consensus::CheckTxInputs(const CTransaction &tx, CValidationState &state, c
                                  strprintf("tried to spend coinbase at depth %d", nSpendHeight - coin.nHeight));
         }
 
-        if (!checkOutput(coin.out, state, nValueIn, nAssetVin, mapVinIds))
+        if (!checkInput(coin, state, nValueIn, nAssetVin, mapVinIds))
             return false;
 
         const char *futureValidationError = validateFutureCoin(coin, nSpendHeight);
@@ -370,7 +406,7 @@ bool Consensus::CheckTxInputs(const CTransaction &tx, CValidationState &state, c
     std::map <std::string, CAmount> nAssetVout;
     std::map <std::string, std::vector<std::pair<uint64_t, uint64_t>>> mapVoutIds;
 
-    for (auto out: tx.vout) {
+    for (const auto &out: tx.vout) {
         if (!checkOutput(out, state, value_out, nAssetVout, mapVoutIds))
             return false;
     }
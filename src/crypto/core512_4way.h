@@ -0,0 +1,24 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_CORE512_4WAY_H
+#define BITCOIN_CRYPTO_CORE512_4WAY_H
+
+/**
+ * Multi-buffer (AVX2) versions of the 512-bit sph hashes used by the GhostRider core hash chain.
+ *
+ * Every function hashes four independent 64-byte messages in lockstep: in points to 4 * 64 bytes (message i
+ * at in + 64 * i) and the four 64-byte digests are written to out the same way. The results are bit for bit
+ * identical to sph_<algo>512 over each message, see CoreHashAutoDetect() for the dispatch and self test.
+ */
+
+namespace core512_avx2 {
+void Blake512_4way(unsigned char *out, const unsigned char *in);
+void Bmw512_4way(unsigned char *out, const unsigned char *in);
+void Jh512_4way(unsigned char *out, const unsigned char *in);
+void Keccak512_4way(unsigned char *out, const unsigned char *in);
+void Skein512_4way(unsigned char *out, const unsigned char *in);
+}
+
+#endif // BITCOIN_CRYPTO_CORE512_4WAY_H
@@ -0,0 +1,549 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// AVX2 versions of the 512-bit core hashes, four messages per call, one 64-bit lane of a YMM register each.
+// The lane vector is a GCC/clang vector type so the round functions read like the scalar sph code.
+// Each kernel only handles a single 64-byte message, so padding and length encoding are constants here;
+// see crypto/<algo>.c for the general sph implementations these mirror.
+
+#ifdef ENABLE_AVX2
+
+#include <crypto/common.h>
+#include <crypto/core512_4way.h>
+
+#include <stdint.h>
+
+namespace core512_avx2 {
+namespace {
+
+typedef uint64_t V __attribute__((vector_size(32)));
+
+V inline __attribute__((always_inline)) K(uint64_t x) { return V{x, x, x, x}; }
+V inline __attribute__((always_inline)) RotL(V x, int n) { return (x << n) | (x >> (64 - n)); }
+V inline __attribute__((always_inline)) RotR(V x, int n) { return (x >> n) | (x << (64 - n)); }
+
+V inline __attribute__((always_inline)) LoadLE(const unsigned char *in, int word)
+{
+    return V{ReadLE64(in + 8 * word), ReadLE64(in + 64 + 8 * word), ReadLE64(in + 128 + 8 * word), ReadLE64(in + 192 + 8 * word)};
+}
+
+V inline __attribute__((always_inline)) LoadBE(const unsigned char *in, int word)
+{
+    return V{ReadBE64(in + 8 * word), ReadBE64(in + 64 + 8 * word), ReadBE64(in + 128 + 8 * word), ReadBE64(in + 192 + 8 * word)};
+}
+
+void inline __attribute__((always_inline)) StoreLE(unsigned char *out, int word, V x)
+{
+    for (int lane = 0; lane < 4; ++lane) WriteLE64(out + 64 * lane + 8 * word, x[lane]);
+}
+
+void inline __attribute__((always_inline)) StoreBE(unsigned char *out, int word, V x)
+{
+    for (int lane = 0; lane < 4; ++lane) WriteBE64(out + 64 * lane + 8 * word, x[lane]);
+}
+
+/** Blake-512 */
+namespace blake {
+
+const uint64_t IV[8] = {
+        0x6A09E667F3BCC908, 0xBB67AE8584CAA73B, 0x3C6EF372FE94F82B, 0xA54FF53A5F1D36F1,
+        0x510E527FADE682D1, 0x9B05688C2B3E6C1F, 0x1F83D9ABFB41BD6B, 0x5BE0CD19137E2179
+};
+
+const uint64_t C[16] = {
+        0x243F6A8885A308D3, 0x13198A2E03707344, 0xA4093822299F31D0, 0x082EFA98EC4E6C89,
+        0x452821E638D01377, 0xBE5466CF34E90C6C, 0xC0AC29B7C97C50DD, 0x3F84D5B5B5470917,
+        0x9216D5D98979FB1B, 0xD1310BA698DFB5AC, 0x2FFD72DBD01ADFB7, 0xB8E1AFED6A267E96,
+        0xBA7C9045F12C7F99, 0x24A19947B3916CF7, 0x0801F2E2858EFC16, 0x636920D871574E69
+};
+
+const uint8_t SIGMA[10][16] = {
+        { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+        {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+        {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+        { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+        { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+        { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+        {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+        {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+        { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+        {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0}
+};
+
+void inline __attribute__((always_inline)) G(const V *m, const uint8_t *s, int i, V &a, V &b, V &c, V &d)
+{
+    a += b + (m[s[2 * i]] ^ K(C[s[2 * i + 1]]));
+    d = RotR(d ^ a, 32);
+    c += d;
+    b = RotR(b ^ c, 25);
+    a += b + (m[s[2 * i + 1]] ^ K(C[s[2 * i]]));
+    d = RotR(d ^ a, 16);
+    c += d;
+    b = RotR(b ^ c, 11);
+}
+
+} // namespace blake
+
+/** BMW-512 */
+namespace bmw {
+
+const uint64_t IV[16] = {
+        0x8081828384858687, 0x88898A8B8C8D8E8F, 0x9091929394959697, 0x98999A9B9C9D9E9F,
+        0xA0A1A2A3A4A5A6A7, 0xA8A9AAABACADAEAF, 0xB0B1B2B3B4B5B6B7, 0xB8B9BABBBCBDBEBF,
+        0xC0C1C2C3C4C5C6C7, 0xC8C9CACBCCCDCECF, 0xD0D1D2D3D4D5D6D7, 0xD8D9DADBDCDDDEDF,
+        0xE0E1E2E3E4E5E6E7, 0xE8E9EAEBECEDEEEF, 0xF0F1F2F3F4F5F6F7, 0xF8F9FAFBFCFDFEFF
+};
+
+V inline __attribute__((always_inline)) S0(V x) { return (x >> 1) ^ (x << 3) ^ RotL(x, 4) ^ RotL(x, 37); }
+V inline __attribute__((always_inline)) S1(V x) { return (x >> 1) ^ (x << 2) ^ RotL(x, 13) ^ RotL(x, 43); }
+V inline __attribute__((always_inline)) S2(V x) { return (x >> 2) ^ (x << 1) ^ RotL(x, 19) ^ RotL(x, 53); }
+V inline __attribute__((always_inline)) S3(V x) { return (x >> 2) ^ (x << 2) ^ RotL(x, 28) ^ RotL(x, 59); }
+V inline __attribute__((always_inline)) S4(V x) { return (x >> 1) ^ x; }
+V inline __attribute__((always_inline)) S5(V x) { return (x >> 2) ^ x; }
+
+V inline __attribute__((always_inline)) AddElement(const V *m, const V *h, int j)
+{
+    return (RotL(m[j & 15], (j & 15) + 1) + RotL(m[(j + 3) & 15], ((j + 3) & 15) + 1)
+            - RotL(m[(j + 10) & 15], ((j + 10) & 15) + 1) + K((uint64_t)(j + 16) * 0x0555555555555555ULL))
+           ^ h[(j + 7) & 15];
+}
+
+void inline __attribute__((always_inline)) Compress(const V *m, const V *h, V *dh)
+{
+    V x[16], q[32];
+    for (int i = 0; i < 16; ++i) x[i] = m[i] ^ h[i];
+
+    q[ 0] = S0(x[ 5] - x[ 7] + x[10] + x[13] + x[14]) + h[ 1];
+    q[ 1] = S1(x[ 6] - x[ 8] + x[11] + x[14] - x[15]) + h[ 2];
+    q[ 2] = S2(x[ 0] + x[ 7] + x[ 9] - x[12] + x[15]) + h[ 3];
+    q[ 3] = S3(x[ 0] - x[ 1] + x[ 8] - x[10] + x[13]) + h[ 4];
+    q[ 4] = S4(x[ 1] + x[ 2] + x[ 9] - x[11] - x[14]) + h[ 5];
+    q[ 5] = S0(x[ 3] - x[ 2] + x[10] - x[12] + x[15]) + h[ 6];
+    q[ 6] = S1(x[ 4] - x[ 0] - x[ 3] - x[11] + x[13]) + h[ 7];
+    q[ 7] = S2(x[ 1] - x[ 4] - x[ 5] - x[12] - x[14]) + h[ 8];
+    q[ 8] = S3(x[ 2] - x[ 5] - x[ 6] + x[13] - x[15]) + h[ 9];
+    q[ 9] = S4(x[ 0] - x[ 3] + x[ 6] - x[ 7] + x[14]) + h[10];
+    q[10] = S0(x[ 8] - x[ 1] - x[ 4] - x[ 7] + x[15]) + h[11];
+    q[11] = S1(x[ 8] - x[ 0] - x[ 2] - x[ 5] + x[ 9]) + h[12];
+    q[12] = S2(x[ 1] + x[ 3] - x[ 6] - x[ 9] + x[10]) + h[13];
+    q[13] = S3(x[ 2] + x[ 4] + x[ 7] + x[10] + x[11]) + h[14];
+    q[14] = S4(x[ 3] - x[ 5] + x[ 8] - x[11] - x[12]) + h[15];
+    q[15] = S0(x[12] - x[ 4] - x[ 6] - x[ 9] + x[13]) + h[ 0];
+
+    for (int i = 16; i < 18; ++i) {
+        q[i] = S1(q[i - 16]) + S2(q[i - 15]) + S3(q[i - 14]) + S0(q[i - 13])
+               + S1(q[i - 12]) + S2(q[i - 11]) + S3(q[i - 10]) + S0(q[i - 9])
+               + S1(q[i - 8]) + S2(q[i - 7]) + S3(q[i - 6]) + S0(q[i - 5])
+               + S1(q[i - 4]) + S2(q[i - 3]) + S3(q[i - 2]) + S0(q[i - 1])
+               + AddElement(m, h, i - 16);
+    }
+    for (int i = 18; i < 32; ++i) {
+        q[i] = q[i - 16] + RotL(q[i - 15], 5) + q[i - 14] + RotL(q[i - 13], 11)
+               + q[i - 12] + RotL(q[i - 11], 27) + q[i - 10] + RotL(q[i - 9], 32)
+               + q[i - 8] + RotL(q[i - 7], 37) + q[i - 6] + RotL(q[i - 5], 43)
+               + q[i - 4] + RotL(q[i - 3], 53) + S4(q[i - 2]) + S5(q[i - 1])
+               + AddElement(m, h, i - 16);
+    }
+
+    const V xl = q[16] ^ q[17] ^ q[18] ^ q[19] ^ q[20] ^ q[21] ^ q[22] ^ q[23];
+    const V xh = xl ^ q[24] ^ q[25] ^ q[26] ^ q[27] ^ q[28] ^ q[29] ^ q[30] ^ q[31];
+    dh[ 0] = ((xh <<  5) ^ (q[16] >>  5) ^ m[ 0]) + (xl ^ q[24] ^ q[ 0]);
+    dh[ 1] = ((xh >>  7) ^ (q[17] <<  8) ^ m[ 1]) + (xl ^ q[25] ^ q[ 1]);
+    dh[ 2] = ((xh >>  5) ^ (q[18] <<  5) ^ m[ 2]) + (xl ^ q[26] ^ q[ 2]);
+    dh[ 3] = ((xh >>  1) ^ (q[19] <<  5) ^ m[ 3]) + (xl ^ q[27] ^ q[ 3]);
+    dh[ 4] = ((xh >>  3) ^ q[20] ^ m[ 4]) + (xl ^ q[28] ^ q[ 4]);
+    dh[ 5] = ((xh <<  6) ^ (q[21] >>  6) ^ m[ 5]) + (xl ^ q[29] ^ q[ 5]);
+    dh[ 6] = ((xh >>  4) ^ (q[22] <<  6) ^ m[ 6]) + (xl ^ q[30] ^ q[ 6]);
+    dh[ 7] = ((xh >> 11) ^ (q[23] <<  2) ^ m[ 7]) + (xl ^ q[31] ^ q[ 7]);
+    dh[ 8] = RotL(dh[4],  9) + (xh ^ q[24] ^ m[ 8]) + ((xl << 8) ^ q[23] ^ q[ 8]);
+    dh[ 9] = RotL(dh[5], 10) + (xh ^ q[25] ^ m[ 9]) + ((xl >> 6) ^ q[16] ^ q[ 9]);
+    dh[10] = RotL(dh[6], 11) + (xh ^ q[26] ^ m[10]) + ((xl << 6) ^ q[17] ^ q[10]);
+    dh[11] = RotL(dh[7], 12) + (xh ^ q[27] ^ m[11]) + ((xl << 4) ^ q[18] ^ q[11]);
+    dh[12] = RotL(dh[0], 13) + (xh ^ q[28] ^ m[12]) + ((xl >> 3) ^ q[19] ^ q[12]);
+    dh[13] = RotL(dh[1], 14) + (xh ^ q[29] ^ m[13]) + ((xl >> 4) ^ q[20] ^ q[13]);
+    dh[14] = RotL(dh[2], 15) + (xh ^ q[30] ^ m[14]) + ((xl >> 7) ^ q[21] ^ q[14]);
+    dh[15] = RotL(dh[3], 16) + (xh ^ q[31] ^ m[15]) + ((xl >> 2) ^ q[22] ^ q[15]);
+}
+
+} // namespace bmw
+
+/** JH-512, in the bitsliced big-endian representation of crypto/jh.c */
+namespace jh {
+
+const uint64_t IV[16] = {
+        0x6fd14b963e00aa17, 0x636a2e057a15d543, 0x8a225e8d0c97ef0b, 0xe9341259f2b3c361,
+        0x891da0c1536f801e, 0x2aa9056bea2b6d80, 0x588eccdb2075baa6, 0xa90f3a76baf83bf7,
+        0x0169e60541e34a69, 0x46b58a8e2e6fe65a, 0x1047a7d0c1843c24, 0x3b6e71b12d5ac199,
+        0xcf57f6ec9db1f856, 0xa706887c5716b156, 0xe3c2fcdfe68517fb, 0x545a4678cc8cdd4b
+};
+
+const uint64_t C[168] = {
+        0x72d5dea2df15f867, 0x7b84150ab7231557,
+        0x81abd6904d5a87f6, 0x4e9f4fc5c3d12b40,
+        0xea983ae05c45fa9c, 0x03c5d29966b2999a,
+        0x660296b4f2bb538a, 0xb556141a88dba231,
+        0x03a35a5c9a190edb, 0x403fb20a87c14410,
+        0x1c051980849e951d, 0x6f33ebad5ee7cddc,
+        0x10ba139202bf6b41, 0xdc786515f7bb27d0,
+        0x0a2c813937aa7850, 0x3f1abfd2410091d3,
+        0x422d5a0df6cc7e90, 0xdd629f9c92c097ce,
+        0x185ca70bc72b44ac, 0xd1df65d663c6fc23,
+        0x976e6c039ee0b81a, 0x2105457e446ceca8,
+        0xeef103bb5d8e61fa, 0xfd9697b294838197,
+        0x4a8e8537db03302f, 0x2a678d2dfb9f6a95,
+        0x8afe7381f8b8696c, 0x8ac77246c07f4214,
+        0xc5f4158fbdc75ec4, 0x75446fa78f11bb80,
+        0x52de75b7aee488bc, 0x82b8001e98a6a3f4,
+        0x8ef48f33a9a36315, 0xaa5f5624d5b7f989,
+        0xb6f1ed207c5ae0fd, 0x36cae95a06422c36,
+        0xce2935434efe983d, 0x533af974739a4ba7,
+        0xd0f51f596f4e8186, 0x0e9dad81afd85a9f,
+        0xa7050667ee34626a, 0x8b0b28be6eb91727,
+        0x47740726c680103f, 0xe0a07e6fc67e487b,
+        0x0d550aa54af8a4c0, 0x91e3e79f978ef19e,
+        0x8676728150608dd4, 0x7e9e5a41f3e5b062,
+        0xfc9f1fec4054207a, 0xe3e41a00cef4c984,
+        0x4fd794f59dfa95d8, 0x552e7e1124c354a5,
+        0x5bdf7228bdfe6e28, 0x78f57fe20fa5c4b2,
+        0x05897cefee49d32e, 0x447e9385eb28597f,
+        0x705f6937b324314a, 0x5e8628f11dd6e465,
+        0xc71b770451b920e7, 0x74fe43e823d4878a,
+        0x7d29e8a3927694f2, 0xddcb7a099b30d9c1,
+        0x1d1b30fb5bdc1be0, 0xda24494ff29c82bf,
+        0xa4e7ba31b470bfff, 0x0d324405def8bc48,
+        0x3baefc3253bbd339, 0x459fc3c1e0298ba0,
+        0xe5c905fdf7ae090f, 0x947034124290f134,
+        0xa271b701e344ed95, 0xe93b8e364f2f984a,
+        0x88401d63a06cf615, 0x47c1444b8752afff,
+        0x7ebb4af1e20ac630, 0x4670b6c5cc6e8ce6,
+        0xa4d5a456bd4fca00, 0xda9d844bc83e18ae,
+        0x7357ce453064d1ad, 0xe8a6ce68145c2567,
+        0xa3da8cf2cb0ee116, 0x33e906589a94999a,
+        0x1f60b220c26f847b, 0xd1ceac7fa0d18518,
+        0x32595ba18ddd19d3, 0x509a1cc0aaa5b446,
+        0x9f3d6367e4046bba, 0xf6ca19ab0b56ee7e,
+        0x1fb179eaa9282174, 0xe9bdf7353b3651ee,
+        0x1d57ac5a7550d376, 0x3a46c2fea37d7001,
+        0xf735c1af98a4d842, 0x78edec209e6b6779,
+        0x41836315ea3adba8, 0xfac33b4d32832c83,
+        0xa7403b1f1c2747f3, 0x5940f034b72d769a,
+        0xe73e4e6cd2214ffd, 0xb8fd8d39dc5759ef,
+        0x8d9b0c492b49ebda, 0x5ba2d74968f3700d,
+        0x7d3baed07a8d5584, 0xf5a5e9f0e4f88e65,
+        0xa0b8a2f436103b53, 0x0ca8079e753eec5a,
+        0x9168949256e8884f, 0x5bb05c55f8babc4c,
+        0xe3bb3b99f387947b, 0x75daf4d6726b1c5d,
+        0x64aeac28dc34b36d, 0x6c34a550b828db71,
+        0xf861e2f2108d512a, 0xe3db643359dd75fc,
+        0x1cacbcf143ce3fa2, 0x67bbd13c02e843b0,
+        0x330a5bca8829a175, 0x7f34194db416535c,
+        0x923b94c30e794d1e, 0x797475d7b6eeaf3f,
+        0xeaa8d4f7be1a3921, 0x5cf47e094c232751,
+        0x26a32453ba323cd2, 0x44a3174a6da6d5ad,
+        0xb51d3ea6aff2c908, 0x83593d98916b3c56,
+        0x4cf87ca17286604d, 0x46e23ecc086ec7f6,
+        0x2f9833b3b1bc765e, 0x2bd666a5efc4e62a,
+        0x06f4b6e8bec1d436, 0x74ee8215bcef2163,
+        0xfdc14e0df453c969, 0xa77d5ac406585826,
+        0x7ec1141606e0fa16, 0x7e90af3d28639d3f,
+        0xd2c9f2e3009bd20c, 0x5faace30b7d40c30,
+        0x742a5116f2e03298, 0x0deb30d8e3cef89a,
+        0x4bc59e7bb5f17992, 0xff51e66e048668d3,
+        0x9b234d57e6966731, 0xcce6a6f3170a7505,
+        0xb17681d913326cce, 0x3c175284f805a262,
+        0xf42bcbb378471547, 0xff46548223936a48,
+        0x38df58074e5e6565, 0xf2fc7c89fc86508e,
+        0x31702e44d00bca86, 0xf04009a23078474e,
+        0x65a0ee39d1f73883, 0xf75ee937e42c3abd,
+        0x2197b2260113f86f, 0xa344edd1ef9fdee7,
+        0x8ba0df15762592d9, 0x3c85f7f612dc42be,
+        0xd8a7ec7cab27b07e, 0x538d7ddaaa3ea8de,
+        0xaa25ce93bd0269d8, 0x5af643fd1a7308f9,
+        0xc05fefda174a19a5, 0x974d66334cfd216a,
+        0x35b49831db411570, 0xea1e0fbbedcd549b,
+        0x9ad063a151974072, 0xf6759dbf91476fe2
+};
+
+void inline __attribute__((always_inline)) Sb(V &x0, V &x1, V &x2, V &x3, V c)
+{
+    x3 = ~x3;
+    x0 ^= c & ~x2;
+    const V tmp = c ^ (x0 & x1);
+    x0 ^= x2 & x3;
+    x3 ^= ~x1 & x2;
+    x1 ^= x0 & x2;
+    x2 ^= x0 & ~x3;
+    x0 ^= x1 | x3;
+    x3 ^= x1 & x2;
+    x1 ^= tmp & x0;
+    x2 ^= tmp;
+}
+
+void inline __attribute__((always_inline)) Lb(V &x0, V &x1, V &x2, V &x3, V &x4, V &x5, V &x6, V &x7)
+{
+    x4 ^= x1;
+    x5 ^= x2;
+    x6 ^= x3 ^ x0;
+    x7 ^= x0;
+    x0 ^= x5;
+    x1 ^= x6;
+    x2 ^= x7 ^ x4;
+    x3 ^= x4;
+}
+
+/** Swap the bit groups of width 2^ro of both halves of a 128-bit word, ro == 6 swaps the halves */
+template<int ro>
+void inline __attribute__((always_inline)) W(V &hi, V &lo)
+{
+    if (ro == 6) {
+        const V t = hi;
+        hi = lo;
+        lo = t;
+    } else {
+        static const uint64_t masks[6] = {
+                0x5555555555555555, 0x3333333333333333, 0x0F0F0F0F0F0F0F0F,
+                0x00FF00FF00FF00FF, 0x0000FFFF0000FFFF, 0x00000000FFFFFFFF
+        };
+        const V c = K(masks[ro]);
+        const int n = 1 << ro;
+        hi = ((hi >> n) & c) | ((hi & c) << n);
+        lo = ((lo >> n) & c) | ((lo & c) << n);
+    }
+}
+
+/** One of the 42 rounds of E8 over the state h[16] (h[2 * i] / h[2 * i + 1] are the high / low half of word i) */
+template<int ro>
+void inline __attribute__((always_inline)) Round(V *h, int r)
+{
+    Sb(h[0], h[4], h[8], h[12], K(C[4 * r + 0]));
+    Sb(h[1], h[5], h[9], h[13], K(C[4 * r + 1]));
+    Sb(h[2], h[6], h[10], h[14], K(C[4 * r + 2]));
+    Sb(h[3], h[7], h[11], h[15], K(C[4 * r + 3]));
+    Lb(h[0], h[4], h[8], h[12], h[2], h[6], h[10], h[14]);
+    Lb(h[1], h[5], h[9], h[13], h[3], h[7], h[11], h[15]);
+    W<ro>(h[2], h[3]);
+    W<ro>(h[6], h[7]);
+    W<ro>(h[10], h[11]);
+    W<ro>(h[14], h[15]);
+}
+
+void inline __attribute__((always_inline)) E8(V *h)
+{
+    for (int r = 0; r < 42; r += 7) {
+        Round<0>(h, r + 0);
+        Round<1>(h, r + 1);
+        Round<2>(h, r + 2);
+        Round<3>(h, r + 3);
+        Round<4>(h, r + 4);
+        Round<5>(h, r + 5);
+        Round<6>(h, r + 6);
+    }
+}
+
+void inline __attribute__((always_inline)) Block(V *h, const V *m)
+{
+    for (int i = 0; i < 8; ++i) h[i] ^= m[i];
+    E8(h);
+    for (int i = 0; i < 8; ++i) h[i + 8] ^= m[i];
+}
+
+} // namespace jh
+
+/** Keccak-512 (original Keccak padding, as in crypto/keccak.c) */
+namespace keccak {
+
+const uint64_t RC[24] = {
+        0x0000000000000001, 0x0000000000008082, 0x800000000000808A, 0x8000000080008000,
+        0x000000000000808B, 0x0000000080000001, 0x8000000080008081, 0x8000000000008009,
+        0x000000000000008A, 0x0000000000000088, 0x0000000080008009, 0x000000008000000A,
+        0x000000008000808B, 0x800000000000008B, 0x8000000000008089, 0x8000000000008003,
+        0x8000000000008002, 0x8000000000000080, 0x000000000000800A, 0x800000008000000A,
+        0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008
+};
+
+/** Rotation of each lane (x + 5 * y) in rho */
+const int RHO[25] = {0, 1, 62, 28, 27, 36, 44, 6, 55, 20, 3, 10, 43, 25, 39, 41, 45, 15, 21, 8, 18, 2, 61, 56, 14};
+
+void inline __attribute__((always_inline)) F1600(V *a)
+{
+    V b[25], c[5];
+#pragma GCC unroll 24
+    for (int round = 0; round < 24; ++round) {
+        // Theta
+#pragma GCC unroll 5
+        for (int x = 0; x < 5; ++x) c[x] = a[x] ^ a[x + 5] ^ a[x + 10] ^ a[x + 15] ^ a[x + 20];
+#pragma GCC unroll 5
+        for (int x = 0; x < 5; ++x) {
+            const V d = c[(x + 4) % 5] ^ RotL(c[(x + 1) % 5], 1);
+#pragma GCC unroll 5
+            for (int y = 0; y < 25; y += 5) a[y + x] ^= d;
+        }
+        // Rho and pi: lane (x, y) moves to (y, 2x + 3y)
+#pragma GCC unroll 5
+        for (int y = 0; y < 5; ++y) {
+#pragma GCC unroll 5
+            for (int x = 0; x < 5; ++x) {
+                const int i = x + 5 * y;
+                b[y + 5 * ((2 * x + 3 * y) % 5)] = RHO[i] ? RotL(a[i], RHO[i]) : a[i];
+            }
+        }
+        // Chi
+#pragma GCC unroll 5
+        for (int y = 0; y < 25; y += 5) {
+#pragma GCC unroll 5
+            for (int x = 0; x < 5; ++x) a[y + x] = b[y + x] ^ (~b[y + (x + 1) % 5] & b[y + (x + 2) % 5]);
+        }
+        // Iota
+        a[0] ^= K(RC[round]);
+    }
+}
+
+} // namespace keccak
+
+/** Skein-512-512 */
+namespace skein {
+
+const uint64_t IV[8] = {
+        0x4903ADFF749C51CE, 0x0D95DE399746DF03, 0x8FD1934127C79BCE, 0x9A255629FF352CB1,
+        0x5DB62599DF6CA7B0, 0xEABE394CA9D5C3F4, 0x991112C71A75B523, 0xAE18A40B660FCC33
+};
+
+void inline __attribute__((always_inline)) Mix(V &x0, V &x1, int rc)
+{
+    x0 += x1;
+    x1 = RotL(x1, rc) ^ x0;
+}
+
+void inline __attribute__((always_inline)) AddKey(V *p, const V *k, const uint64_t *t, int s)
+{
+    for (int i = 0; i < 8; ++i) p[i] += k[(s + i) % 9];
+    p[5] += K(t[s % 3]);
+    p[6] += K(t[(s + 1) % 3]);
+    p[7] += K(s);
+}
+
+/** One UBI block: h = Threefish-512(key h, tweak t0/t1, message m) ^ m */
+void inline __attribute__((always_inline)) Ubi(V *h, const V *m, uint64_t t0, uint64_t t1)
+{
+    V k[9], p[8];
+    const uint64_t t[3] = {t0, t1, t0 ^ t1};
+    k[8] = K(0x1BD11BDAA9FC1A22);
+    for (int i = 0; i < 8; ++i) {
+        k[i] = h[i];
+        k[8] ^= h[i];
+        p[i] = m[i];
+    }
+#pragma GCC unroll 9
+    for (int s = 0; s < 18; s += 2) {
+        AddKey(p, k, t, s);
+        Mix(p[0], p[1], 46); Mix(p[2], p[3], 36); Mix(p[4], p[5], 19); Mix(p[6], p[7], 37);
+        Mix(p[2], p[1], 33); Mix(p[4], p[7], 27); Mix(p[6], p[5], 14); Mix(p[0], p[3], 42);
+        Mix(p[4], p[1], 17); Mix(p[6], p[3], 49); Mix(p[0], p[5], 36); Mix(p[2], p[7], 39);
+        Mix(p[6], p[1], 44); Mix(p[0], p[7],  9); Mix(p[2], p[5], 54); Mix(p[4], p[3], 56);
+        AddKey(p, k, t, s + 1);
+        Mix(p[0], p[1], 39); Mix(p[2], p[3], 30); Mix(p[4], p[5], 34); Mix(p[6], p[7], 24);
+        Mix(p[2], p[1], 13); Mix(p[4], p[7], 50); Mix(p[6], p[5], 10); Mix(p[0], p[3], 17);
+        Mix(p[4], p[1], 25); Mix(p[6], p[3], 29); Mix(p[0], p[5], 39); Mix(p[2], p[7], 43);
+        Mix(p[6], p[1],  8); Mix(p[0], p[7], 35); Mix(p[2], p[5], 56); Mix(p[4], p[3], 22);
+    }
+    AddKey(p, k, t, 18);
+    for (int i = 0; i < 8; ++i) h[i] = m[i] ^ p[i];
+}
+
+} // namespace skein
+
+} // namespace
+
+void Blake512_4way(unsigned char *out, const unsigned char *in)
+{
+    using namespace blake;
+    // The 64-byte message and its padding fill exactly one 128-byte block, counter = 512 bits
+    V m[16], v[16];
+    for (int i = 0; i < 8; ++i) m[i] = LoadBE(in, i);
+    m[8] = K(0x8000000000000000);
+    m[9] = m[10] = m[11] = m[12] = m[14] = K(0);
+    m[13] = K(1);
+    m[15] = K(512);
+
+    for (int i = 0; i < 8; ++i) v[i] = K(IV[i]);
+    for (int i = 0; i < 4; ++i) v[i + 8] = K(C[i]);
+    v[12] = K(512 ^ C[4]);
+    v[13] = K(512 ^ C[5]);
+    v[14] = K(C[6]);
+    v[15] = K(C[7]);
+    for (int r = 0; r < 16; ++r) {
+        const uint8_t *s = SIGMA[r % 10];
+        G(m, s, 0, v[0], v[4], v[ 8], v[12]);
+        G(m, s, 1, v[1], v[5], v[ 9], v[13]);
+        G(m, s, 2, v[2], v[6], v[10], v[14]);
+        G(m, s, 3, v[3], v[7], v[11], v[15]);
+        G(m, s, 4, v[0], v[5], v[10], v[15]);
+        G(m, s, 5, v[1], v[6], v[11], v[12]);
+        G(m, s, 6, v[2], v[7], v[ 8], v[13]);
+        G(m, s, 7, v[3], v[4], v[ 9], v[14]);
+    }
+    for (int i = 0; i < 8; ++i) StoreBE(out, i, K(IV[i]) ^ v[i] ^ v[i + 8]);
+}
+
+void Bmw512_4way(unsigned char *out, const unsigned char *in)
+{
+    using namespace bmw;
+    // One block holding the message, 0x80 and the 512 bit length, then the final compression
+    V m[16], h[16], h2[16];
+    for (int i = 0; i < 8; ++i) m[i] = LoadLE(in, i);
+    m[8] = K(0x80);
+    for (int i = 9; i < 15; ++i) m[i] = K(0);
+    m[15] = K(512);
+    for (int i = 0; i < 16; ++i) h[i] = K(IV[i]);
+    Compress(m, h, h2);
+    for (int i = 0; i < 16; ++i) h[i] = K(0xaaaaaaaaaaaaaaa0ULL + i);
+    Compress(h2, h, m);
+    for (int i = 0; i < 8; ++i) StoreLE(out, i, m[i + 8]);
+}
+
+void Jh512_4way(unsigned char *out, const unsigned char *in)
+{
+    using namespace jh;
+    // The message is one full block, the second block is 0x80 ... and the 512 bit length
+    V h[16], m[8];
+    for (int i = 0; i < 16; ++i) h[i] = K(IV[i]);
+    for (int i = 0; i < 8; ++i) m[i] = LoadBE(in, i);
+    Block(h, m);
+    m[0] = K(0x8000000000000000);
+    for (int i = 1; i < 7; ++i) m[i] = K(0);
+    m[7] = K(512);
+    Block(h, m);
+    for (int i = 0; i < 8; ++i) StoreBE(out, i, h[i + 8]);
+}
+
+void Keccak512_4way(unsigned char *out, const unsigned char *in)
+{
+    using namespace keccak;
+    // 72-byte rate: the message fills 8 lanes, the 9th only holds the padding bits
+    V a[25];
+    for (int i = 0; i < 8; ++i) a[i] = LoadLE(in, i);
+    a[8] = K(0x8000000000000001);
+    for (int i = 9; i < 25; ++i) a[i] = K(0);
+    F1600(a);
+    for (int i = 0; i < 8; ++i) StoreLE(out, i, a[i]);
+}
+
+void Skein512_4way(unsigned char *out, const unsigned char *in)
+{
+    using namespace skein;
+    // A single message block (first and final, 64 bytes), then the output block
+    V h[8], m[8];
+    for (int i = 0; i < 8; ++i) {
+        h[i] = K(IV[i]);
+        m[i] = LoadLE(in, i);
+    }
+    Ubi(h, m, 64, 0xF000000000000000);
+    for (int i = 0; i < 8; ++i) m[i] = K(0);
+    Ubi(h, m, 8, 0xFF00000000000000);
+    for (int i = 0; i < 8; ++i) StoreLE(out, i, h[i]);
+}
+
+} // namespace core512_avx2
+
+#endif
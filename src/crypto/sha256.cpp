@@ -31,10 +31,14 @@ void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
 
 namespace sha256d64_sse41 {
     void Transform_4way(unsigned char *out, const unsigned char *in);
+
+    void Transform64_4way(unsigned char *out, const unsigned char *in);
 }
 
 namespace sha256d64_avx2 {
     void Transform_8way(unsigned char *out, const unsigned char *in);
+
+    void Transform64_8way(unsigned char *out, const unsigned char *in);
 }
 
 namespace sha256d64_x86_shani {
@@ -476,6 +480,30 @@ namespace {
     TransformD64Type TransformD64_2way = nullptr;
     TransformD64Type TransformD64_4way = nullptr;
     TransformD64Type TransformD64_8way = nullptr;
+    TransformD64Type Transform64_4way = nullptr;
+    TransformD64Type Transform64_8way = nullptr;
+
+    /** Single SHA256 of one 64-byte blob using the selected Transform. */
+    void Transform64(unsigned char *out, const unsigned char *in) {
+        uint32_t s[8];
+        static const unsigned char padding[64] = {
+                0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0
+        };
+        sha256::Initialize(s);
+        Transform(s, in, 1);
+        Transform(s, padding, 1);
+        WriteBE32(out + 0, s[0]);
+        WriteBE32(out + 4, s[1]);
+        WriteBE32(out + 8, s[2]);
+        WriteBE32(out + 12, s[3]);
+        WriteBE32(out + 16, s[4]);
+        WriteBE32(out + 20, s[5]);
+        WriteBE32(out + 24, s[6]);
+        WriteBE32(out + 28, s[7]);
+    }
 
     bool SelfTest() {
         // Input state (equal to the initial SHA256 state)
@@ -560,6 +588,22 @@ namespace {
             if (!std::equal(out, out + 256, result_d64)) return false;
         }
 
+        // Test Transform64_4way and Transform64_8way against Transform64, which only depends on Transform
+        unsigned char result_64[256];
+        for (size_t i = 0; i < 8; ++i) {
+            Transform64(result_64 + 32 * i, data + 1 + 64 * i);
+        }
+        if (Transform64_4way) {
+            unsigned char out[128];
+            Transform64_4way(out, data + 1);
+            if (!std::equal(out, out + 128, result_64)) return false;
+        }
+        if (Transform64_8way) {
+            unsigned char out[256];
+            Transform64_8way(out, data + 1);
+            if (!std::equal(out, out + 256, result_64)) return false;
+        }
+
         return true;
     }
 
@@ -626,6 +670,7 @@ std::string SHA256AutoDetect() {
 #endif
 #if defined(ENABLE_SSE41) && !defined(BUILD_BITCOIN_INTERNAL)
         TransformD64_4way = sha256d64_sse41::Transform_4way;
+        Transform64_4way = sha256d64_sse41::Transform64_4way;
         ret += ",sse41(4way)";
 #endif
     }
@@ -633,6 +678,7 @@ std::string SHA256AutoDetect() {
 #if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
+        Transform64_8way = sha256d64_avx2::Transform64_8way;
         ret += ",avx2(8way)";
     }
 #endif
@@ -759,3 +805,28 @@ void SHA256D64(unsigned char *out, const unsigned char *in, size_t blocks) {
         --blocks;
     }
 }
+
+void SHA256_64(unsigned char *out, const unsigned char *in, size_t blocks) {
+    if (Transform64_8way) {
+        while (blocks >= 8) {
+            Transform64_8way(out, in);
+            out += 256;
+            in += 512;
+            blocks -= 8;
+        }
+    }
+    if (Transform64_4way) {
+        while (blocks >= 4) {
+            Transform64_4way(out, in);
+            out += 128;
+            in += 256;
+            blocks -= 4;
+        }
+    }
+    while (blocks) {
+        Transform64(out, in);
+        out += 32;
+        in += 64;
+        --blocks;
+    }
+}
@@ -40,4 +40,11 @@ std::string SHA256AutoDetect();
  */
 void SHA256D64(unsigned char *output, const unsigned char *input, size_t blocks);
 
+/** Compute multiple single SHA256's of 64-byte blobs.
+ *  output:  pointer to a blocks*32 byte output buffer
+ *  input:   pointer to a blocks*64 byte input buffer
+ *  blocks:  the number of hashes to compute.
+ */
+void SHA256_64(unsigned char *output, const unsigned char *input, size_t blocks);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
@@ -61,6 +61,12 @@ void cn_slow_hash(const char *input, char *output, uint32_t len, int variant, ui
 
 void cn_fast_hash(const char *input, char *output, uint32_t len);
 
+void cn_slow_hash_release_scratchpad(void);
+
+const char *cn_slow_hash_autodetect(void);
+
+void cn_slow_hash_use_standard(void);
+
 static void do_blake_hash(const void *input, size_t len, char *output);
 
 void do_groestl_hash(const void *input, size_t len, char *output);
@@ -5,11 +5,20 @@
 // Portions Copyright (c) 2018 The Monero developers
 // Portions Copyright (c) 2018 The TurtleCoin Developers
 
+#if defined(HAVE_CONFIG_H)
+#include <config/fortuneblock-config.h>
+#endif
+
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <pthread.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
 #include <cryptonote/slow-hash.h>
 #include <cryptonote/oaes_lib.h>
 #include <cryptonote/c_keccak.h>
@@ -20,8 +29,17 @@
 #include <cryptonote/int-util.h>
 #include <cryptonote/variant2_int_sqrt.h>
 
-#if defined(_MSC_VER)
-#include <malloc.h>
+#if defined(ENABLE_X86_AESNI) && !defined(BUILD_BITCOIN_INTERNAL) && (defined(__x86_64__) || defined(__amd64__))
+#define CN_HAVE_X86_AESNI
+#include <cpuid.h>
+
+/* Implemented in slow-hash_x86_aesni.c, which is compiled with -maes */
+void cn_slow_hash_core_x86_aesni(uint8_t *long_state, uint8_t *text, const uint8_t *init,
+                                 const uint8_t *explode_keys, const uint8_t *implode_keys,
+                                 const uint8_t *a, const uint8_t *b, size_t init_rounds, size_t iterations,
+                                 size_t aes_rounds, int variant, uint64_t tweak1_2);
+
+static int cn_use_x86_aesni = 0;
 #endif
 
 #define AES_BLOCK_SIZE  16
@@ -191,6 +209,131 @@ static inline void xor_blocks_dst(const uint8_t* a, const uint8_t* b, uint8_t* d
     ((uint64_t*) dst)[1] = ((uint64_t*) a)[1] ^ ((uint64_t*) b)[1];
 }
 
+/*
+ * Per-thread working memory of cn_slow_hash. The long_state scratchpad (sized for the largest variant) and
+ * the AES context are allocated the first time a thread hashes and are reused for every following hash,
+ * so neither the allocations nor the page faults of a fresh multi-megabyte buffer are paid per hash.
+ * Every byte of long_state is rewritten by the explode phase, so nothing needs clearing between hashes.
+ */
+struct cn_scratchpad {
+  uint8_t *long_state;
+  void *map_base;    /* start of the mmap()ed region, NULL if long_state was malloc()ed */
+  size_t map_size;
+  oaes_ctx *aes_ctx;
+};
+
+static pthread_key_t cn_scratchpad_key;
+static pthread_once_t cn_scratchpad_key_once = PTHREAD_ONCE_INIT;
+
+static void cn_scratchpad_free(void *ptr)
+{
+  struct cn_scratchpad *pad = (struct cn_scratchpad *) ptr;
+  if (pad == NULL)
+    return;
+#if !defined(_WIN32)
+  if (pad->map_base != NULL)
+    munmap(pad->map_base, pad->map_size);
+  else
+#endif
+    free(pad->long_state);
+  oaes_free((OAES_CTX **) &pad->aes_ctx);
+  free(pad);
+}
+
+static void cn_scratchpad_key_init(void)
+{
+  pthread_key_create(&cn_scratchpad_key, cn_scratchpad_free);
+}
+
+static void cn_scratchpad_alloc_long_state(struct cn_scratchpad *pad)
+{
+#if !defined(_WIN32) && defined(MAP_ANONYMOUS)
+  void *p;
+#if defined(MAP_HUGETLB)
+  /* An explicit huge page backs the whole 2 MB scratchpad with a single TLB entry */
+  p = mmap(NULL, CN_MAX_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p != MAP_FAILED) {
+    pad->map_base = p;
+    pad->map_size = CN_MAX_PAGE_SIZE;
+    pad->long_state = (uint8_t *) p;
+    return;
+  }
+#endif
+  /* No huge pages reserved: over-allocate so the scratchpad can be aligned for transparent huge pages */
+  p = mmap(NULL, 2 * CN_MAX_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p != MAP_FAILED) {
+    uintptr_t aligned = ((uintptr_t) p + CN_MAX_PAGE_SIZE - 1) & ~((uintptr_t) CN_MAX_PAGE_SIZE - 1);
+#if defined(MADV_HUGEPAGE)
+    madvise((void *) aligned, CN_MAX_PAGE_SIZE, MADV_HUGEPAGE);
+#endif
+    pad->map_base = p;
+    pad->map_size = 2 * CN_MAX_PAGE_SIZE;
+    pad->long_state = (uint8_t *) aligned;
+    return;
+  }
+#endif
+  pad->map_base = NULL;
+  pad->map_size = 0;
+  pad->long_state = (uint8_t *) malloc(CN_MAX_PAGE_SIZE);
+}
+
+static struct cn_scratchpad *cn_get_scratchpad(void)
+{
+  struct cn_scratchpad *pad;
+
+  pthread_once(&cn_scratchpad_key_once, cn_scratchpad_key_init);
+  pad = (struct cn_scratchpad *) pthread_getspecific(cn_scratchpad_key);
+  if (pad != NULL)
+    return pad;
+
+  pad = (struct cn_scratchpad *) calloc(1, sizeof(struct cn_scratchpad));
+  if (pad != NULL) {
+    cn_scratchpad_alloc_long_state(pad);
+    pad->aes_ctx = (oaes_ctx *) oaes_alloc();
+  }
+  if (pad == NULL || pad->long_state == NULL || pad->aes_ctx == NULL) {
+    fprintf(stderr, "Cryptonight failed to allocate its scratchpad\n");
+    _exit(1);
+  }
+  /* Touch the scratchpad once so the page faults are taken here and not during the first hash */
+  memset(pad->long_state, 0, CN_MAX_PAGE_SIZE);
+  pthread_setspecific(cn_scratchpad_key, pad);
+  return pad;
+}
+
+void cn_slow_hash_release_scratchpad(void)
+{
+  pthread_once(&cn_scratchpad_key_once, cn_scratchpad_key_init);
+  cn_scratchpad_free(pthread_getspecific(cn_scratchpad_key));
+  pthread_setspecific(cn_scratchpad_key, NULL);
+}
+
+const char *cn_slow_hash_autodetect(void)
+{
+#if defined(CN_HAVE_X86_AESNI)
+  unsigned int eax, ebx, ecx, edx;
+  cn_use_x86_aesni = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && ((ecx >> 25) & 1) && ((edx >> 26) & 1);
+  if (cn_use_x86_aesni)
+    return "x86_aesni";
+#endif
+  return "standard";
+}
+
+void cn_slow_hash_use_standard(void)
+{
+#if defined(CN_HAVE_X86_AESNI)
+  cn_use_x86_aesni = 0;
+#endif
+}
+
+static void cn_slow_hash_finish(union cn_slow_hash_state *state, const uint8_t *text, char *output)
+{
+  memcpy(state->init, text, INIT_SIZE_BYTE);
+  hash_permutation(&state->hs);
+  /*memcpy(hash, &state, 32);*/
+  extra_hashes[state->hs.b[0] & 3](state, 200, output);
+}
+
 void cn_slow_hash(const char* input, char* output, uint32_t len, int variant, uint32_t page_size, uint32_t iterations, size_t aes_rounds)
 {
   union cn_slow_hash_state state;
@@ -199,28 +342,39 @@ void cn_slow_hash(const char* input, char* output, uint32_t len, int variant, ui
   uint8_t b[AES_BLOCK_SIZE * 2];
   uint8_t c[AES_BLOCK_SIZE];
   uint8_t aes_key[AES_KEY_SIZE];
-  oaes_ctx* aes_ctx;
+  struct cn_scratchpad *pad = cn_get_scratchpad();
+  oaes_ctx* aes_ctx = pad->aes_ctx;
+  uint8_t *long_state = pad->long_state;
 
   size_t init_rounds = (page_size / INIT_SIZE_BYTE);
 
-#if defined(_MSC_VER)
-  uint8_t *long_state = (uint8_t *)_malloca(page_size);
-#else
-#if defined(__APPLE__)
-  uint8_t *long_state = (uint8_t *)calloc(page_size, sizeof(uint8_t));
-#else
-  uint8_t *long_state = (uint8_t *)malloc(page_size);
-#endif
-#endif
+  assert(page_size <= CN_MAX_PAGE_SIZE);
   hash_process(&state.hs, (const uint8_t*) input, len);
   memcpy(text, state.init, INIT_SIZE_BYTE);
   memcpy(aes_key, state.hs.b, AES_KEY_SIZE);
-  aes_ctx = (oaes_ctx*) oaes_alloc();
   size_t i, j;
 
   VARIANT1_INIT();
   VARIANT2_INIT(b, state);
 
+  for (i = 0; i < 16; i++) {
+    a[i] = state.k[i] ^ state.k[32 + i];
+    b[i] = state.k[16 + i] ^ state.k[48 + i];
+  }
+
+#if defined(CN_HAVE_X86_AESNI)
+  if (cn_use_x86_aesni && variant < 2) {
+    uint8_t explode_keys[10 * AES_BLOCK_SIZE];
+    oaes_key_import_data(aes_ctx, aes_key, AES_KEY_SIZE);
+    memcpy(explode_keys, aes_ctx->key->exp_data, sizeof(explode_keys));
+    oaes_key_import_data(aes_ctx, &state.hs.b[32], AES_KEY_SIZE);
+    cn_slow_hash_core_x86_aesni(long_state, text, state.init, explode_keys, aes_ctx->key->exp_data, a, b,
+                                init_rounds, iterations, aes_rounds, variant, tweak1_2);
+    cn_slow_hash_finish(&state, text, output);
+    return;
+  }
+#endif
+
   oaes_key_import_data(aes_ctx, aes_key, AES_KEY_SIZE);
   for (i = 0; i < init_rounds; i++) {
     for (j = 0; j < INIT_SIZE_BLK; j++) {
@@ -231,11 +385,6 @@ void cn_slow_hash(const char* input, char* output, uint32_t len, int variant, ui
     memcpy(&long_state[i * INIT_SIZE_BYTE], text, INIT_SIZE_BYTE);
   }
 
-  for (i = 0; i < 16; i++) {
-    a[i] = state.k[i] ^ state.k[32 + i];
-    b[i] = state.k[16 + i] ^ state.k[48 + i];
-  }
-
   for (i = 0; i < iterations; i++) {
     /* Dependency chain: address -> read value ------+
     * written value <-+ hard function (AES or MUL) <+
@@ -286,12 +435,7 @@ void cn_slow_hash(const char* input, char* output, uint32_t len, int variant, ui
       aesb_pseudo_round(&text[j * AES_BLOCK_SIZE], &text[j * AES_BLOCK_SIZE], aes_ctx->key->exp_data);
     }
   }
-  memcpy(state.init, text, INIT_SIZE_BYTE);
-  hash_permutation(&state.hs);
-  /*memcpy(hash, &state, 32);*/
-  extra_hashes[state.hs.b[0] & 3](&state, 200, output);
-  oaes_free((OAES_CTX **) &aes_ctx);
-  free(long_state);
+  cn_slow_hash_finish(&state, text, output);
 }
 
 void cn_fast_hash(const char* input, char* output, uint32_t len) {
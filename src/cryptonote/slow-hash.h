@@ -28,6 +28,9 @@
 
 #define CN_TURTLE_LITE_AES_ROUNDS 8192
 
+/* Largest page_size of all variants, the per-thread scratchpad is allocated with this size */
+#define CN_MAX_PAGE_SIZE      2097152
+
 typedef unsigned char BitSequence;
 typedef unsigned long long DataLength;
 
@@ -49,6 +52,12 @@ extern "C" {
 
   void cn_slow_hash(const char* input, char* output, uint32_t len, int variant, uint32_t page_size, uint32_t iterations, size_t aes_rounds);
   void cn_fast_hash(const char* input, char* output, uint32_t len);
+  /* Free the calling thread's scratchpad now instead of at thread exit */
+  void cn_slow_hash_release_scratchpad(void);
+  /* Select the fastest cn_slow_hash implementation the CPU supports and return its name */
+  const char* cn_slow_hash_autodetect(void);
+  /* Fall back to the portable implementation, used to cross check the accelerated ones */
+  void cn_slow_hash_use_standard(void);
 
 //-----------------------------------------------------------------------------------
   inline void cryptonight_dark_fast_hash(const char* input, char* output, uint32_t len) {
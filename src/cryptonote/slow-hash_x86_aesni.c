@@ -0,0 +1,103 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// AES-NI implementation of the memory-hard part of cn_slow_hash (explode, main loop, implode).
+// It is only called after cn_slow_hash_autodetect() found AES-NI support and only for variants 0 and 1,
+// see slow-hash.c for the portable reference implementation.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(ENABLE_X86_AESNI) && (defined(__x86_64__) || defined(__amd64__))
+
+#include <immintrin.h>
+
+#include <cryptonote/int-util.h>
+
+#define AES_BLOCK_SIZE  16
+#define INIT_SIZE_BLK   8
+#define INIT_SIZE_BYTE  (INIT_SIZE_BLK * AES_BLOCK_SIZE)
+#define AES_ROUNDS      10
+
+/* Ten full AES rounds over all eight text blocks, interleaved so the AES unit pipelines them */
+static inline void aesni_pseudo_rounds(__m128i *x, const __m128i *k)
+{
+  int r, i;
+  for (r = 0; r < AES_ROUNDS; r++) {
+    for (i = 0; i < INIT_SIZE_BLK; i++) {
+      x[i] = _mm_aesenc_si128(x[i], k[r]);
+    }
+  }
+}
+
+void cn_slow_hash_core_x86_aesni(uint8_t *long_state, uint8_t *text, const uint8_t *init,
+                                 const uint8_t *explode_keys, const uint8_t *implode_keys,
+                                 const uint8_t *a, const uint8_t *b, size_t init_rounds, size_t iterations,
+                                 size_t aes_rounds, int variant, uint64_t tweak1_2)
+{
+  __m128i k[AES_ROUNDS];
+  __m128i x[INIT_SIZE_BLK];
+  __m128i _b, _c;
+  uint64_t a0, a1, c0;
+  const uint64_t mask = aes_rounds - 1;
+  size_t i, j;
+
+  /* Explode */
+  for (i = 0; i < AES_ROUNDS; i++)
+    k[i] = _mm_loadu_si128((const __m128i *) &explode_keys[i * AES_BLOCK_SIZE]);
+  for (j = 0; j < INIT_SIZE_BLK; j++)
+    x[j] = _mm_loadu_si128((const __m128i *) &text[j * AES_BLOCK_SIZE]);
+  for (i = 0; i < init_rounds; i++) {
+    aesni_pseudo_rounds(x, k);
+    for (j = 0; j < INIT_SIZE_BLK; j++)
+      _mm_store_si128((__m128i *) &long_state[i * INIT_SIZE_BYTE + j * AES_BLOCK_SIZE], x[j]);
+  }
+
+  /* Main loop, see cn_slow_hash for the meaning of each step */
+  memcpy(&a0, a, 8);
+  memcpy(&a1, a + 8, 8);
+  _b = _mm_loadu_si128((const __m128i *) b);
+  for (i = 0; i < iterations; i++) {
+    uint8_t *p = &long_state[((a0 / AES_BLOCK_SIZE) & mask) * AES_BLOCK_SIZE];
+    _c = _mm_aesenc_si128(_mm_load_si128((const __m128i *) p), _mm_set_epi64x(a1, a0));
+    _mm_store_si128((__m128i *) p, _mm_xor_si128(_b, _c));
+    if (variant == 1) {
+      const uint8_t tmp = p[11];
+      const uint8_t index = (((tmp >> 3) & 6) | (tmp & 1)) << 1;
+      p[11] = tmp ^ ((0x75310 >> index) & 0x30);
+    }
+
+    c0 = (uint64_t) _mm_cvtsi128_si64(_c);
+    uint64_t *q = (uint64_t *) &long_state[((c0 / AES_BLOCK_SIZE) & mask) * AES_BLOCK_SIZE];
+    const uint64_t t0 = q[0];
+    const uint64_t t1 = q[1];
+    uint64_t hi;
+    const uint64_t lo = mul128(c0, t0, &hi);
+    a0 += hi;
+    a1 += lo;
+    q[0] = a0;
+    q[1] = a1;
+    a0 ^= t0;
+    a1 ^= t1;
+    if (variant == 1)
+      q[1] ^= tweak1_2;
+    _b = _c;
+  }
+
+  /* Implode */
+  for (i = 0; i < AES_ROUNDS; i++)
+    k[i] = _mm_loadu_si128((const __m128i *) &implode_keys[i * AES_BLOCK_SIZE]);
+  for (j = 0; j < INIT_SIZE_BLK; j++)
+    x[j] = _mm_loadu_si128((const __m128i *) &init[j * AES_BLOCK_SIZE]);
+  for (i = 0; i < init_rounds; i++) {
+    for (j = 0; j < INIT_SIZE_BLK; j++)
+      x[j] = _mm_xor_si128(x[j], _mm_load_si128((const __m128i *) &long_state[i * INIT_SIZE_BYTE + j * AES_BLOCK_SIZE]));
+    aesni_pseudo_rounds(x, k);
+  }
+  for (j = 0; j < INIT_SIZE_BLK; j++)
+    _mm_storeu_si128((__m128i *) &text[j * AES_BLOCK_SIZE], x[j]);
+}
+
+#endif
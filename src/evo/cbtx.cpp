@@ -143,30 +143,16 @@ bool CalcCbTxMerkleRootMNList(const CBlock &block, const CBlockIndex *pindexPrev
         LogPrint(BCLog::BENCHMARK, "            - CSimplifiedMNList: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2),
                  nTimeSMNL * 0.000001);
 
-        static CSimplifiedMNList smlCached;
-        static uint256 merkleRootCached;
-        static bool mutatedCached{false};
-
-        if (sml == smlCached) {
-            merkleRootRet = merkleRootCached;
-            if (mutatedCached) {
-                return state.DoS(100, false, REJECT_INVALID, "mutated-cached-calc-cb-mnmerkleroot");
-            }
-            return true;
-        }
+        static CSimplifiedMNListMerkleCache merkleCache;
 
         bool mutated = false;
-        merkleRootRet = sml.CalcMerkleRoot(&mutated);
+        merkleRootRet = merkleCache.CalcMerkleRoot(std::move(sml), &mutated);
 
         int64_t nTime4 = GetTimeMicros();
         nTimeMerkle += nTime4 - nTime3;
         LogPrint(BCLog::BENCHMARK, "            - CalcMerkleRoot: %.2fms [%.2fs]\n", 0.001 * (nTime4 - nTime3),
                  nTimeMerkle * 0.000001);
 
-        smlCached = std::move(sml);
-        merkleRootCached = merkleRootRet;
-        mutatedCached = mutated;
-
         if (mutated) {
             return state.DoS(100, false, REJECT_INVALID, "mutated-calc-cb-mnmerkleroot");
         }
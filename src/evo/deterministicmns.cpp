@@ -13,6 +13,7 @@
 #include <chainparams.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <crypto/sha256.h>
 #include <script/standard.h>
 #include <ui_interface.h>
 #include <validation.h>
@@ -26,6 +27,21 @@ static const std::string DB_LIST_SNAPSHOT = "dmn_S";
 static const std::string DB_LIST_DIFF = "dmn_D";
 static const int CACHE_CLEANUP_BLOCKS = 40;
 
+// Rough heap cost of one smartnode in a list: the entry, its state and its slots in the immer maps
+static const size_t DMN_LIST_ENTRY_USAGE = sizeof(CDeterministicMN) + sizeof(CDeterministicMNState) + 8 * sizeof(uint256);
+// A changed smartnode gets a new entry and state, and the immer maps copy the nodes on the path to it
+static const size_t DMN_LIST_CHANGE_USAGE = DMN_LIST_ENTRY_USAGE + 4 * 32 * sizeof(uint256);
+
+// Cached lists share their smartnodes and most of their immer nodes with the lists they were derived from, so a list is
+// accounted in full only when no list it shares with is cached, and otherwise by the changes replayed on top of it
+static size_t ListMemoryUsage(const CDeterministicMNList &mnList) {
+    return sizeof(CDeterministicMNList) + mnList.GetAllMNsCount() * DMN_LIST_ENTRY_USAGE;
+}
+
+static size_t DiffChangeCount(const CDeterministicMNListDiff &diff) {
+    return diff.addedMNs.size() + diff.updatedMNs.size() + diff.removedMns.size();
+}
+
 std::unique_ptr <CDeterministicMNManager> deterministicMNManager;
 
 std::string CDeterministicMNState::ToString() const {
@@ -222,37 +238,30 @@ CDeterministicMNCPtr CDeterministicMNList::GetMNPayee() const {
         return nullptr;
     }
 
-    CDeterministicMNCPtr best;
-    ForEachMN(true, [&](const CDeterministicMNCPtr &dmn) {
-        if (!best || CompareByLastPaid(dmn, best)) {
-            best = dmn;
+    // mnPaymentOrder only holds non-banned MNs, so this only skips MNs with a collateral that is not payable anymore
+    for (const auto &dmn: mnPaymentOrder) {
+        if (IsMNValid(dmn)) {
+            return dmn;
         }
-    });
-
-    return best;
+    }
+    return nullptr;
 }
 
 std::vector <CDeterministicMNCPtr> CDeterministicMNList::GetProjectedMNPayees(int nCount) const {
+    // outside of mainnet a negative count projects all payees
     if (nCount < 0 && Params().NetworkIDString() == CBaseChainParams::MAIN) {
         return {};
     }
-    nCount = std::min(nCount, int(GetValidMNsCount()));
-//	if (nCount > validMnCount) {
-//		nCount = validMnCount;
-//	}
 
     std::vector <CDeterministicMNCPtr> result;
-    result.reserve(nCount);
-    //CAmount collateralAmount = Params
-    ForEachMN(true, [&](const CDeterministicMNCPtr &dmn) {
-        result.emplace_back(dmn);
-    });
-    std::sort(result.begin(), result.end(), [&](const CDeterministicMNCPtr &a, const CDeterministicMNCPtr &b) {
-        return CompareByLastPaid(a, b);
-    });
-
-    if (result.size() > nCount) {
-        result.resize(nCount);
+    result.reserve(std::min((size_t) nCount, mnPaymentOrder.size()));
+    for (const auto &dmn: mnPaymentOrder) {
+        if (result.size() == (size_t) nCount) {
+            break;
+        }
+        if (IsMNValid(dmn)) {
+            result.emplace_back(dmn);
+        }
     }
 
     return result;
@@ -262,49 +271,61 @@ std::vector <CDeterministicMNCPtr>
 CDeterministicMNList::CalculateQuorum(size_t maxSize, const uint256 &modifier) const {
     auto scores = CalculateScores(modifier);
 
-    // sort is descending order
-    std::sort(scores.rbegin(), scores.rend(), [](const std::pair <arith_uint256, CDeterministicMNCPtr> &a,
-                                                 const std::pair <arith_uint256, CDeterministicMNCPtr> &b) {
-        if (a.first == b.first) {
-            // this should actually never happen, but we should stay compatible with how the non-deterministic MNs did the sorting
-            return a.second->collateralOutpoint < b.second->collateralOutpoint;
-        }
-        return a.first < b.first;
-    });
+    // only the top maxSize entries are needed, in descending order
+    // the collateralOutpoint tie break makes this a total order, so the result does not depend on the partial sort
+    auto middle = scores.begin() + std::min(maxSize, scores.size());
+    std::partial_sort(scores.begin(), middle, scores.end(),
+                      [](const std::pair <arith_uint256, CDeterministicMNCPtr> &a,
+                         const std::pair <arith_uint256, CDeterministicMNCPtr> &b) {
+                          if (a.first == b.first) {
+                              // this should actually never happen, but we should stay compatible with how the non-deterministic MNs did the sorting
+                              return b.second->collateralOutpoint < a.second->collateralOutpoint;
+                          }
+                          return b.first < a.first;
+                      });
 
-    // take top maxSize entries and return it
     std::vector <CDeterministicMNCPtr> result;
-    result.resize(std::min(maxSize, scores.size()));
-    for (size_t i = 0; i < result.size(); i++) {
-        result[i] = std::move(scores[i].second);
+    result.reserve(middle - scores.begin());
+    for (auto it = scores.begin(); it != middle; ++it) {
+        result.emplace_back(std::move(it->second));
     }
     return result;
 }
 
 std::vector <std::pair<arith_uint256, CDeterministicMNCPtr>>
 CDeterministicMNList::CalculateScores(const uint256 &modifier) const {
-    std::vector <std::pair<arith_uint256, CDeterministicMNCPtr>> scores;
-    scores.reserve(GetAllMNsCount());
+    std::vector <CDeterministicMNCPtr> dmns;
+    dmns.reserve(GetAllMNsCount());
     ForEachMN(true, nHeight, [&](const CDeterministicMNCPtr &dmn) {
         if (dmn->pdmnState->confirmedHash.IsNull()) {
             // we only take confirmed MNs into account to avoid hash grinding on the ProRegTxHash to sneak MNs into a
             // future quorums
             return;
         }
-        // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
-        // Please note that this is not a double-sha256 but a single-sha256
-        // The first part is already precalculated (confirmedHashWithProRegTxHash)
-        // TODO When https://github.com/bitcoin/bitcoin/pull/13191 gets backported, implement something that is similar but for single-sha256
-        uint256 h;
-        CSHA256 sha256;
-        sha256.Write(dmn->pdmnState->confirmedHashWithProRegTxHash.begin(),
-                     dmn->pdmnState->confirmedHashWithProRegTxHash.size());
-        sha256.Write(modifier.begin(), modifier.size());
-        sha256.Finalize(h.begin());
-
-        scores.emplace_back(UintToArith256(h), dmn);
+        dmns.emplace_back(dmn);
     });
 
+    // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
+    // Please note that this is not a double-sha256 but a single-sha256
+    // The first part is already precalculated (confirmedHashWithProRegTxHash), so every MN hashes exactly one 64 byte
+    // blob and all of them can go through the multi-way SHA256 kernels at once
+    std::vector <unsigned char> blobs(dmns.size() * 64);
+    for (size_t i = 0; i < dmns.size(); i++) {
+        const auto &h = dmns[i]->pdmnState->confirmedHashWithProRegTxHash;
+        std::copy(h.begin(), h.end(), blobs.begin() + i * 64);
+        std::copy(modifier.begin(), modifier.end(), blobs.begin() + i * 64 + 32);
+    }
+    std::vector <unsigned char> hashes(dmns.size() * 32);
+    SHA256_64(hashes.data(), blobs.data(), dmns.size());
+
+    std::vector <std::pair<arith_uint256, CDeterministicMNCPtr>> scores;
+    scores.reserve(dmns.size());
+    for (size_t i = 0; i < dmns.size(); i++) {
+        uint256 h;
+        std::copy(hashes.begin() + i * 32, hashes.begin() + (i + 1) * 32, h.begin());
+        scores.emplace_back(UintToArith256(h), std::move(dmns[i]));
+    }
+
     return scores;
 }
 
@@ -421,6 +442,94 @@ CSimplifiedMNListDiff CDeterministicMNList::BuildSimplifiedDiff(const CDetermini
     return diffRet;
 }
 
+namespace {
+/**
+ * Where a proTxHash sits in an MnMap. The map is a hash trie which iterates a node's own entries before the ones of
+ * its children, both by the hash bits of that level, so this is all it takes to order entries the way ForEachMN()
+ * visits them.
+ */
+struct MnMapPosition {
+    size_t nHash;
+    uint32_t nDepth;
+};
+
+constexpr auto MN_MAP_BITS = immer::default_bits;
+
+MnMapPosition GetMnMapPosition(const CDeterministicMNList::MnMap &map, const uint256 &proTxHash) {
+    using namespace immer::detail::hamts;
+    using bitmap_t = typename get_bitmap_type<MN_MAP_BITS>::type;
+    MnMapPosition pos{std::hash<uint256>{}(proTxHash), 0};
+    auto node = map.impl().root;
+    for (auto hash = pos.nHash; pos.nDepth < max_depth<MN_MAP_BITS>; hash >>= MN_MAP_BITS, pos.nDepth++) {
+        const auto bit = bitmap_t{1u} << (hash & mask<MN_MAP_BITS>);
+        if (!(node->nodemap() & bit)) {
+            break;
+        }
+        node = node->children()[popcount(node->nodemap() & (bit - 1))];
+    }
+    return pos;
+}
+
+bool MnMapOrder(const MnMapPosition &a, const MnMapPosition &b) {
+    using immer::detail::hamts::mask;
+    auto ha = a.nHash, hb = b.nHash;
+    for (uint32_t nDepth = 0;; nDepth++, ha >>= MN_MAP_BITS, hb >>= MN_MAP_BITS) {
+        if (a.nDepth == nDepth || b.nDepth == nDepth) {
+            // the entries of a node come before the ones of its children
+            if (a.nDepth != b.nDepth) {
+                return a.nDepth == nDepth;
+            }
+            return (ha & mask<MN_MAP_BITS>) < (hb & mask<MN_MAP_BITS>);
+        }
+        if ((ha & mask<MN_MAP_BITS>) != (hb & mask<MN_MAP_BITS>)) {
+            return (ha & mask<MN_MAP_BITS>) < (hb & mask<MN_MAP_BITS>);
+        }
+    }
+}
+} // namespace
+
+CSimplifiedMNListDiff
+CDeterministicMNList::BuildSimplifiedDiff(const CDeterministicMNList &to, const std::set <uint64_t> &internalIds) const {
+    CSimplifiedMNListDiff diffRet;
+    diffRet.baseBlockHash = blockHash;
+    diffRet.blockHash = to.blockHash;
+
+    // Emit the entries in mnMap order like the full comparison does, peers may hash the lists as sent
+    std::vector <std::pair<MnMapPosition, CSimplifiedMNListEntry>> changed;
+    std::vector <std::pair<MnMapPosition, uint256>> deleted;
+    for (const auto &internalId: internalIds) {
+        auto fromPtr = GetMNByInternalId(internalId);
+        auto toPtr = to.GetMNByInternalId(internalId);
+        if (toPtr == nullptr) {
+            // an MN which was added and removed again in between is in neither list
+            if (fromPtr != nullptr) {
+                deleted.emplace_back(GetMnMapPosition(mnMap, fromPtr->proTxHash), fromPtr->proTxHash);
+            }
+        } else if (fromPtr == nullptr) {
+            changed.emplace_back(GetMnMapPosition(to.mnMap, toPtr->proTxHash), CSimplifiedMNListEntry(*toPtr));
+        } else if (fromPtr != toPtr) {
+            CSimplifiedMNListEntry sme(*toPtr);
+            if (sme != CSimplifiedMNListEntry(*fromPtr)) {
+                changed.emplace_back(GetMnMapPosition(to.mnMap, toPtr->proTxHash), std::move(sme));
+            }
+        }
+    }
+
+    auto byPosition = [](const auto &a, const auto &b) { return MnMapOrder(a.first, b.first); };
+    std::sort(changed.begin(), changed.end(), byPosition);
+    std::sort(deleted.begin(), deleted.end(), byPosition);
+    diffRet.mnList.reserve(changed.size());
+    for (auto &p: changed) {
+        diffRet.mnList.emplace_back(std::move(p.second));
+    }
+    diffRet.deletedMNs.reserve(deleted.size());
+    for (const auto &p: deleted) {
+        diffRet.deletedMNs.emplace_back(p.second);
+    }
+
+    return diffRet;
+}
+
 CDeterministicMNList
 CDeterministicMNList::ApplyDiff(const CBlockIndex *pindex, const CDeterministicMNListDiff &diff) const {
     CDeterministicMNList result = *this;
@@ -487,6 +596,7 @@ void CDeterministicMNList::AddMN(const CDeterministicMNCPtr &dmn, bool fBumpTota
 
     mnMap = mnMap.set(dmn->proTxHash, dmn);
     mnInternalIdMap = mnInternalIdMap.set(dmn->GetInternalId(), dmn->proTxHash);
+    AddToPaymentOrder(dmn);
     if (fBumpTotalCount) {
         // nTotalRegisteredCount acts more like a checkpoint, not as a limit,
         nTotalRegisteredCount = std::max(dmn->GetInternalId() + 1, (uint64_t) nTotalRegisteredCount);
@@ -523,7 +633,13 @@ void CDeterministicMNList::UpdateMN(const CDeterministicMNCPtr &oldDmn,
                           oldDmn->proTxHash.ToString(), pdmnState->pubKeyOperator.Get().ToString())));
     }
 
+    // oldDmn might be a stale copy, the one in mnMap is what mnPaymentOrder was sorted by
+    auto curDmn = mnMap.find(oldDmn->proTxHash);
+    if (curDmn) {
+        RemoveFromPaymentOrder(*curDmn);
+    }
     mnMap = mnMap.set(oldDmn->proTxHash, dmn);
+    AddToPaymentOrder(dmn);
 }
 
 void CDeterministicMNList::UpdateMN(const uint256 &proTxHash,
@@ -579,6 +695,31 @@ void CDeterministicMNList::RemoveMN(const uint256 &proTxHash) {
 
     mnMap = mnMap.erase(proTxHash);
     mnInternalIdMap = mnInternalIdMap.erase(dmn->GetInternalId());
+    RemoveFromPaymentOrder(dmn);
+}
+
+void CDeterministicMNList::AddToPaymentOrder(const CDeterministicMNCPtr &dmn) {
+    if (IsMNPoSeBanned(dmn)) {
+        return;
+    }
+    auto it = std::lower_bound(mnPaymentOrder.begin(), mnPaymentOrder.end(), dmn,
+                               [](const CDeterministicMNCPtr &a, const CDeterministicMNCPtr &b) {
+                                   return CompareByLastPaid(a, b);
+                               });
+    mnPaymentOrder = mnPaymentOrder.insert(it - mnPaymentOrder.begin(), dmn);
+}
+
+void CDeterministicMNList::RemoveFromPaymentOrder(const CDeterministicMNCPtr &dmn) {
+    if (IsMNPoSeBanned(dmn)) {
+        return;
+    }
+    auto it = std::lower_bound(mnPaymentOrder.begin(), mnPaymentOrder.end(), dmn,
+                               [](const CDeterministicMNCPtr &a, const CDeterministicMNCPtr &b) {
+                                   return CompareByLastPaid(a, b);
+                               });
+    // CompareByLastPaid falls back to proTxHash, so the only entry with an equal key is dmn itself
+    assert(it != mnPaymentOrder.end() && (*it)->proTxHash == dmn->proTxHash);
+    mnPaymentOrder = mnPaymentOrder.erase(it - mnPaymentOrder.begin());
 }
 
 bool CDeterministicMNManager::ProcessBlock(const CBlock &block, const CBlockIndex *pindex, CValidationState &_state,
@@ -618,13 +759,14 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock &block, const CBlockInde
         evoDb.Write(std::make_pair(DB_LIST_DIFF, newList.GetBlockHash()), diff);
         if ((nHeight % DISK_SNAPSHOT_PERIOD) == 0 || oldList.GetHeight() == -1) {
             evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT, newList.GetBlockHash()), newList);
-            mnListsCache.emplace(newList.GetBlockHash(), newList);
+            CacheList(newList, oldList.GetBlockHash(), DiffChangeCount(diff));
             LogPrintf("CDeterministicMNManager::%s -- Wrote snapshot. nHeight=%d, mapCurMNs.allMNsCount=%d\n",
                       __func__, nHeight, newList.GetAllMNsCount());
         }
 
         diff.nHeight = pindex->nHeight;
-        mnListDiffsCache.emplace(pindex->GetBlockHash(), diff);
+        CacheDiff(pindex->GetBlockHash(), diff);
+        TrimCache();
     } catch (const std::exception &e) {
         LogPrintf("CDeterministicMNManager::%s -- internal error: %s\n", __func__, e.what());
         return _state.DoS(100, false, REJECT_INVALID, "failed-dmn-block");
@@ -667,8 +809,8 @@ bool CDeterministicMNManager::UndoBlock(const CBlock &block, const CBlockIndex *
             prevList = GetListForBlock(pindex->pprev);
         }
 
-        mnListsCache.erase(blockHash);
-        mnListDiffsCache.erase(blockHash);
+        EraseCachedList(blockHash);
+        EraseCachedDiff(blockHash);
     }
 
     if (diff.HasChanges()) {
@@ -976,23 +1118,28 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex
 
     CDeterministicMNList snapshot;
     std::list<const CBlockIndex *> listDiffIndexes;
+    bool fCached = false;
+
+    cacheStats.nLookups++;
 
     while (true) {
         // try using cache before reading from disk
         auto itLists = mnListsCache.find(pindex->GetBlockHash());
         if (itLists != mnListsCache.end()) {
-            snapshot = itLists->second;
+            itLists->second.nLastAccess = ++nCacheAccessCounter;
+            snapshot = itLists->second.mnList;
+            fCached = true;
             break;
         }
 
         if (evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+            cacheStats.nDiskReads++;
+            CacheList(snapshot, uint256(), 0);
             break;
         }
 
         // no snapshot found yet, check diffs
-        auto itDiffs = mnListDiffsCache.find(pindex->GetBlockHash());
-        if (itDiffs != mnListDiffsCache.end()) {
+        if (mnListDiffsCache.count(pindex->GetBlockHash())) {
             listDiffIndexes.emplace_front(pindex);
             pindex = pindex->pprev;
             continue;
@@ -1002,30 +1149,47 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex
         if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), diff)) {
             // no snapshot and no diff on disk means that it's the initial snapshot
             snapshot = CDeterministicMNList(pindex->GetBlockHash(), -1, 0);
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+            CacheList(snapshot, uint256(), 0);
             break;
         }
+        cacheStats.nDiskReads++;
 
         diff.nHeight = pindex->nHeight;
-        mnListDiffsCache.emplace(pindex->GetBlockHash(), std::move(diff));
+        CacheDiff(pindex->GetBlockHash(), std::move(diff));
         listDiffIndexes.emplace_front(pindex);
         pindex = pindex->pprev;
     }
 
+    // changes applied since the last list that went into the cache, that's what a newly cached list adds to it
+    uint256 baseHash = snapshot.GetBlockHash();
+    size_t nChanges = 0;
     for (const auto &diffIndex: listDiffIndexes) {
-        const auto &diff = mnListDiffsCache.at(diffIndex->GetBlockHash());
+        const auto &diff = mnListDiffsCache.at(diffIndex->GetBlockHash()).diff;
         if (diff.HasChanges()) {
             snapshot = snapshot.ApplyDiff(diffIndex, diff);
+            nChanges += DiffChangeCount(diff);
         } else {
             snapshot.SetBlockHash(diffIndex->GetBlockHash());
             snapshot.SetHeight(diffIndex->nHeight);
         }
+        if (diffIndex->nHeight % nCheckpointInterval == 0) {
+            // materialize a checkpoint, later lookups above it stop here instead of replaying from further down
+            CacheList(snapshot, baseHash, nChanges);
+            baseHash = snapshot.GetBlockHash();
+            nChanges = 0;
+        }
+    }
+
+    cacheStats.nReplayedDiffs += listDiffIndexes.size();
+    cacheStats.nMaxReplay = std::max<uint64_t>(cacheStats.nMaxReplay, listDiffIndexes.size());
+    if (fCached && listDiffIndexes.empty()) {
+        cacheStats.nHits++;
     }
 
     if (tipIndex) {
         // always keep a snapshot for the tip
         if (snapshot.GetBlockHash() == tipIndex->GetBlockHash()) {
-            mnListsCache.emplace(snapshot.GetBlockHash(), snapshot);
+            CacheList(snapshot, baseHash, nChanges);
         } else {
             // keep snapshots for yet alive quorums
             if (ranges::any_of(Params().GetConsensus().llmqs, [&snapshot, this](const auto &p_llmq) {
@@ -1035,10 +1199,11 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex
                        (snapshot.GetHeight() + params.dkgInterval * (params.keepOldConnections + 1) >=
                         tipIndex->nHeight);
             })) {
-                mnListsCache.emplace(snapshot.GetBlockHash(), snapshot);
+                CacheList(snapshot, baseHash, nChanges);
             }
         }
     }
+    TrimCache();
     UpdateLLMQParams(snapshot.GetAllMNsCount(), snapshot.GetHeight(), pindex, sporkManager.IsSporkActive(SPORK_21_LOW_LLMQ_PARAMS));
     return snapshot;
 }
@@ -1096,14 +1261,15 @@ void CDeterministicMNManager::CleanupCache(int nHeight) {
     std::vector <uint256> toDeleteLists;
     std::vector <uint256> toDeleteDiffs;
     for (const auto &p: mnListsCache) {
-        if (p.second.GetHeight() + LIST_DIFFS_CACHE_SIZE < nHeight) {
+        const int nListHeight = p.second.mnList.GetHeight();
+        if (nListHeight + LIST_DIFFS_CACHE_SIZE < nHeight) {
             toDeleteLists.emplace_back(p.first);
             continue;
         }
-        bool fQuorumCache = ranges::any_of(Params().GetConsensus().llmqs, [&nHeight, &p](const auto &p_llmq) {
+        bool fQuorumCache = ranges::any_of(Params().GetConsensus().llmqs, [&nHeight, &nListHeight](const auto &p_llmq) {
             const auto &[_, params] = p_llmq;
-            return (p.second.GetHeight() % params.dkgInterval == 0) &&
-                   (p.second.GetHeight() + params.dkgInterval * (params.keepOldConnections + 1) >= nHeight);
+            return (nListHeight % params.dkgInterval == 0) &&
+                   (nListHeight + params.dkgInterval * (params.keepOldConnections + 1) >= nHeight);
         });
         if (fQuorumCache) {
             // at least one quorum could be using it, keep it
@@ -1112,25 +1278,190 @@ void CDeterministicMNManager::CleanupCache(int nHeight) {
         // no alive quorums using it, see if it was a cache for the tip or for a now outdated quorum
         if (tipIndex && tipIndex->pprev && (p.first == tipIndex->pprev->GetBlockHash())) {
             toDeleteLists.emplace_back(p.first);
-        } else if (ranges::any_of(Params().GetConsensus().llmqs, [&p](const auto &p_llmq) {
-            return p.second.GetHeight() % p_llmq.second.dkgInterval == 0;
+        } else if (ranges::any_of(Params().GetConsensus().llmqs, [&nListHeight](const auto &p_llmq) {
+            return nListHeight % p_llmq.second.dkgInterval == 0;
         })) {
             toDeleteLists.emplace_back(p.first);
         }
     }
     for (const auto &h: toDeleteLists) {
-        mnListsCache.erase(h);
+        EraseCachedList(h);
     }
     for (const auto &p: mnListDiffsCache) {
-        if (p.second.nHeight + LIST_DIFFS_CACHE_SIZE < nHeight) {
+        if (p.second.diff.nHeight + LIST_DIFFS_CACHE_SIZE < nHeight) {
             toDeleteDiffs.emplace_back(p.first);
         }
     }
     for (const auto &h: toDeleteDiffs) {
-        mnListDiffsCache.erase(h);
+        EraseCachedDiff(h);
     }
 }
 
+void CDeterministicMNManager::CacheList(const CDeterministicMNList &mnList, const uint256 &baseHash, size_t nChanges) {
+    AssertLockHeld(cs);
+
+    auto it = mnListsCache.find(mnList.GetBlockHash());
+    if (it != mnListsCache.end()) {
+        it->second.nLastAccess = ++nCacheAccessCounter;
+        return;
+    }
+    CListCacheEntry entry{mnList, uint256(), ListMemoryUsage(mnList), ++nCacheAccessCounter};
+    if (!baseHash.IsNull() && baseHash != mnList.GetBlockHash() && mnListsCache.count(baseHash)) {
+        entry.baseHash = baseHash;
+        entry.nUsage = sizeof(CDeterministicMNList) + nChanges * DMN_LIST_CHANGE_USAGE;
+        mnListsCacheDependents[baseHash].emplace(mnList.GetBlockHash());
+    }
+    nCacheUsage += entry.nUsage;
+    mnListsCache.emplace(mnList.GetBlockHash(), std::move(entry));
+}
+
+void CDeterministicMNManager::CacheDiff(const uint256 &blockHash, CDeterministicMNListDiff diff) {
+    AssertLockHeld(cs);
+
+    if (mnListDiffsCache.count(blockHash)) {
+        return;
+    }
+    const size_t nUsage = sizeof(CDiffCacheEntry) + ::GetSerializeSize(diff, SER_DISK, CLIENT_VERSION);
+    mnListDiffsCache.emplace(blockHash, CDiffCacheEntry{std::move(diff), nUsage});
+    nCacheUsage += nUsage;
+}
+
+void CDeterministicMNManager::EraseCachedList(const uint256 &blockHash) {
+    AssertLockHeld(cs);
+
+    auto it = mnListsCache.find(blockHash);
+    if (it == mnListsCache.end()) {
+        return;
+    }
+    const uint256 erasedBase = it->second.baseHash;
+    const size_t nErasedUsage = it->second.nUsage;
+    nCacheUsage -= nErasedUsage;
+    mnListsCache.erase(it);
+    if (!erasedBase.IsNull()) {
+        auto itBase = mnListsCacheDependents.find(erasedBase);
+        itBase->second.erase(blockHash);
+        if (itBase->second.empty()) {
+            mnListsCacheDependents.erase(itBase);
+        }
+    }
+
+    auto itDependents = mnListsCacheDependents.find(blockHash);
+    if (itDependents == mnListsCacheDependents.end()) {
+        return;
+    }
+    const auto dependents = std::move(itDependents->second);
+    mnListsCacheDependents.erase(itDependents);
+
+    // The lists derived from the erased one now differ from their nearest cached base by its changes and theirs.
+    // If it was charged in full, the first of them is charged in full instead and the others are based on it.
+    uint256 newRootHash;
+    size_t nNewRootChanges = 0;
+    for (const auto &hash: dependents) {
+        CListCacheEntry &entry = mnListsCache.at(hash);
+        size_t nUsage;
+        if (!erasedBase.IsNull()) {
+            entry.baseHash = erasedBase;
+            nUsage = entry.nUsage + nErasedUsage;
+        } else if (newRootHash.IsNull()) {
+            newRootHash = hash;
+            nNewRootChanges = entry.nUsage;
+            entry.baseHash.SetNull();
+            nUsage = ListMemoryUsage(entry.mnList);
+        } else {
+            entry.baseHash = newRootHash;
+            nUsage = entry.nUsage + nNewRootChanges;
+        }
+        if (!entry.baseHash.IsNull()) {
+            mnListsCacheDependents[entry.baseHash].emplace(hash);
+        }
+        nCacheUsage = nCacheUsage - entry.nUsage + nUsage;
+        entry.nUsage = nUsage;
+    }
+}
+
+void CDeterministicMNManager::EraseCachedDiff(const uint256 &blockHash) {
+    AssertLockHeld(cs);
+
+    auto it = mnListDiffsCache.find(blockHash);
+    if (it != mnListDiffsCache.end()) {
+        nCacheUsage -= it->second.nUsage;
+        mnListDiffsCache.erase(it);
+    }
+}
+
+void CDeterministicMNManager::TrimCache() {
+    AssertLockHeld(cs);
+
+    if (nCacheUsage <= nMaxCacheUsage) {
+        return;
+    }
+    const size_t nTargetUsage = nMaxCacheUsage / 4 * 3;
+
+    std::vector <std::pair<uint64_t, uint256>> lists;
+    lists.reserve(mnListsCache.size());
+    for (const auto &p: mnListsCache) {
+        // every block and most RPCs start from the tip list
+        if (tipIndex && p.first == tipIndex->GetBlockHash()) {
+            continue;
+        }
+        lists.emplace_back(p.second.nLastAccess, p.first);
+    }
+    std::sort(lists.begin(), lists.end());
+    for (const auto &p: lists) {
+        if (nCacheUsage <= nTargetUsage) {
+            return;
+        }
+        EraseCachedList(p.second);
+        cacheStats.nEvictions++;
+    }
+
+    // diffs are small and cheap to read back, only drop them if the lists alone didn't do it, oldest first
+    std::vector <std::pair<int, uint256>> diffs;
+    diffs.reserve(mnListDiffsCache.size());
+    for (const auto &p: mnListDiffsCache) {
+        diffs.emplace_back(p.second.diff.nHeight, p.first);
+    }
+    std::sort(diffs.begin(), diffs.end());
+    for (const auto &p: diffs) {
+        if (nCacheUsage <= nTargetUsage) {
+            return;
+        }
+        EraseCachedDiff(p.second);
+    }
+}
+
+bool CDeterministicMNManager::GetListDiff(const CBlockIndex *pindex, CDeterministicMNListDiff &diffRet) {
+    LOCK(cs);
+
+    auto it = mnListDiffsCache.find(pindex->GetBlockHash());
+    if (it != mnListDiffsCache.end()) {
+        diffRet = it->second.diff;
+        return true;
+    }
+
+    if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), diffRet)) {
+        return false;
+    }
+    cacheStats.nDiskReads++;
+
+    diffRet.nHeight = pindex->nHeight;
+    CacheDiff(pindex->GetBlockHash(), diffRet);
+    TrimCache();
+    return true;
+}
+
+CDeterministicMNListCacheStats CDeterministicMNManager::GetCacheStats() {
+    LOCK(cs);
+
+    CDeterministicMNListCacheStats stats = cacheStats;
+    stats.nLists = mnListsCache.size();
+    stats.nDiffs = mnListDiffsCache.size();
+    stats.nUsage = nCacheUsage;
+    stats.nMaxUsage = nMaxCacheUsage;
+    stats.nCheckpointInterval = nCheckpointInterval;
+    return stats;
+}
+
 void CDeterministicMNManager::UpgradeDiff(CDBBatch &batch, const CBlockIndex *pindexNext,
                                           const CDeterministicMNList &curMNList, CDeterministicMNList &newMNList) {
     CDataStream oldDiffData(SER_DISK, CLIENT_VERSION);
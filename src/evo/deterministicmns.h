@@ -19,9 +19,11 @@
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 #endif
 
+#include <immer/flex_vector.hpp>
 #include <immer/map.hpp>
 
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #if defined(MAC_OSX)
@@ -303,6 +305,7 @@ public:
     using MnMap = immer::map<uint256, CDeterministicMNCPtr>;
     using MnInternalIdMap = immer::map<uint64_t, uint256>;
     using MnUniquePropertyMap = immer::map <uint256, std::pair<uint256, uint32_t>>;
+    using MnPaymentOrder = immer::flex_vector<CDeterministicMNCPtr>;
 
 private:
     uint256 blockHash;
@@ -315,6 +318,10 @@ private:
     // we keep track of this as checking for duplicates would otherwise be painfully slow
     MnUniquePropertyMap mnUniquePropertyMap;
 
+    // all MNs which are not PoSe banned, sorted by the order in which they get paid (see CompareByLastPaid)
+    // this is derived from mnMap and not serialized, it lets us find the next payees without sorting the whole list
+    MnPaymentOrder mnPaymentOrder;
+
 public:
     CDeterministicMNList() = default;
 
@@ -351,6 +358,7 @@ public:
         mnMap = MnMap();
         mnUniquePropertyMap = MnUniquePropertyMap();
         mnInternalIdMap = MnInternalIdMap();
+        mnPaymentOrder = MnPaymentOrder();
 
         SerializationOpBase(s, CSerActionUnserialize());
 
@@ -506,6 +514,13 @@ public:
 
     [[nodiscard]] CSimplifiedMNListDiff BuildSimplifiedDiff(const CDeterministicMNList &to) const;
 
+    /**
+     * Same as BuildSimplifiedDiff(to), but only looks at the MNs with the given internal ids. Passing the ids touched
+     * by the list diffs of all blocks between both lists gives the same result without visiting every MN.
+     */
+    [[nodiscard]] CSimplifiedMNListDiff
+    BuildSimplifiedDiff(const CDeterministicMNList &to, const std::set <uint64_t> &internalIds) const;
+
     [[nodiscard]] CDeterministicMNList ApplyDiff(const CBlockIndex *pindex, const CDeterministicMNListDiff &diff) const;
 
     void AddMN(const CDeterministicMNCPtr &dmn, bool fBumpTotalCount = true);
@@ -533,6 +548,10 @@ public:
     }
 
 private:
+    void AddToPaymentOrder(const CDeterministicMNCPtr &dmn);
+
+    void RemoveFromPaymentOrder(const CDeterministicMNCPtr &dmn);
+
     template<typename T>
     [[nodiscard]] bool AddUniqueProperty(const CDeterministicMNCPtr &dmn, const T &v) {
         static const T nullValue;
@@ -673,11 +692,49 @@ public:
     }
 };
 
+//! -dmnlistcache default, in megabytes
+static const int64_t DEFAULT_DMN_LIST_CACHE = 64;
+//! -dmnlistcheckpoint default, in blocks
+static const int DEFAULT_DMN_LIST_CHECKPOINT = 32;
+
+struct CDeterministicMNListCacheStats {
+    //! GetListForBlock calls
+    uint64_t nLookups{0};
+    //! lookups answered by a cached list without replaying any diff
+    uint64_t nHits{0};
+    //! snapshots and diffs read from the evo db
+    uint64_t nDiskReads{0};
+    //! diffs applied over all lookups, and the longest replay of a single lookup
+    uint64_t nReplayedDiffs{0};
+    uint64_t nMaxReplay{0};
+    //! lists dropped to stay under the memory budget
+    uint64_t nEvictions{0};
+
+    size_t nLists{0};
+    size_t nDiffs{0};
+    size_t nUsage{0};
+    size_t nMaxUsage{0};
+    int nCheckpointInterval{0};
+};
+
 class CDeterministicMNManager {
     static const int DISK_SNAPSHOT_PERIOD = 576; // once per day
     static const int DISK_SNAPSHOTS = 3; // keep cache for 3 disk snapshots to have 2 full days covered
     static const int LIST_DIFFS_CACHE_SIZE = DISK_SNAPSHOT_PERIOD * DISK_SNAPSHOTS;
 
+    struct CListCacheEntry {
+        CDeterministicMNList mnList;
+        //! the cached list this one was derived from and shares its unchanged structure with, null if charged in full
+        uint256 baseHash;
+        size_t nUsage;
+        uint64_t nLastAccess;
+    };
+
+    struct CDiffCacheEntry {
+        CDeterministicMNListDiff diff;
+        size_t nUsage;
+    };
+
 public:
     RecursiveMutex cs;
 
@@ -693,15 +750,34 @@ private:
     CEvoDB &evoDb;
     CConnman &connman;
 
-    std::unordered_map <uint256, CDeterministicMNList, StaticSaltedHasher> mnListsCache
+    // lists are also materialized in memory every nCheckpointInterval blocks while replaying diffs, so a lookup
+    // replays at most that many diffs once the checkpoint below it is cached
+    const int nCheckpointInterval;
+    // estimated memory the cached lists and diffs may use before the least recently used lists are evicted
+    const size_t nMaxCacheUsage;
+
+    std::unordered_map <uint256, CListCacheEntry, StaticSaltedHasher> mnListsCache
     GUARDED_BY(cs);
-    std::unordered_map <uint256, CDeterministicMNListDiff, StaticSaltedHasher> mnListDiffsCache
+    //! the cached lists derived from each cached list, by the hash of the list they are based on
+    std::unordered_map <uint256, std::unordered_set<uint256, StaticSaltedHasher>, StaticSaltedHasher> mnListsCacheDependents
+    GUARDED_BY(cs);
+    std::unordered_map <uint256, CDiffCacheEntry, StaticSaltedHasher> mnListDiffsCache
+    GUARDED_BY(cs);
+    size_t nCacheUsage
+    GUARDED_BY(cs) {0};
+    uint64_t nCacheAccessCounter
+    GUARDED_BY(cs) {0};
+    CDeterministicMNListCacheStats cacheStats
     GUARDED_BY(cs);
     const CBlockIndex *tipIndex
     GUARDED_BY(cs) {nullptr};
 
 public:
-    explicit CDeterministicMNManager(CEvoDB &_evoDb, CConnman &_connman) : evoDb(_evoDb), connman(_connman) {}
+    explicit CDeterministicMNManager(CEvoDB &_evoDb, CConnman &_connman,
+                                     int _nCheckpointInterval = DEFAULT_DMN_LIST_CHECKPOINT,
+                                     size_t _nMaxCacheUsage = DEFAULT_DMN_LIST_CACHE << 20) :
+            evoDb(_evoDb), connman(_connman), nCheckpointInterval(std::max(_nCheckpointInterval, 1)),
+            nMaxCacheUsage(_nMaxCacheUsage) {}
 
     ~CDeterministicMNManager() = default;
 
@@ -730,6 +806,11 @@ public:
 
     CDeterministicMNList GetListAtChainTip();
 
+    /** The diff ProcessBlock stored for the given block, false if there is none (i.e. the initial snapshot). */
+    bool GetListDiff(const CBlockIndex *pindex, CDeterministicMNListDiff &diffRet);
+
+    CDeterministicMNListCacheStats GetCacheStats();
+
     // Test if given TX is a ProRegTx which also contains the collateral at index n
     static bool IsProTxWithCollateral(const CTransactionRef &tx, uint32_t n);
 
@@ -747,6 +828,32 @@ private:
     void CleanupCache(int nHeight)
 
     EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /**
+     * Cache a list derived from the list at baseHash by nChanges smartnode changes. It is charged for those changes
+     * while that list is cached, and in full otherwise. Pass a null baseHash for a list read from disk.
+     */
+    void CacheList(const CDeterministicMNList &mnList, const uint256 &baseHash, size_t nChanges)
+
+    EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    void CacheDiff(const uint256 &blockHash, CDeterministicMNListDiff diff)
+
+    EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /** Erase a list, the lists derived from it take over its charge as they keep the shared structure alive */
+    void EraseCachedList(const uint256 &blockHash)
+
+    EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    void EraseCachedDiff(const uint256 &blockHash)
+
+    EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /** Evict the least recently used lists, then the oldest diffs, until the cache is under 3/4 of its budget. */
+    void TrimCache()
+
+    EXCLUSIVE_LOCKS_REQUIRED(cs);
 };
 
 extern std::unique_ptr <CDeterministicMNManager> deterministicMNManager;
@@ -13,7 +13,10 @@
 #include <evo/specialtx.h>
 
 #include <pubkey.h>
+#include <saltedhasher.h>
 #include <serialize.h>
+#include <sync.h>
+#include <unordered_lru_cache.h>
 #include <version.h>
 
 #include <base58.h>
@@ -90,6 +93,37 @@ uint256 CSimplifiedMNList::CalcMerkleRoot(bool *pmutated) const {
     return ComputeMerkleRoot(leaves, pmutated);
 }
 
+uint256 CSimplifiedMNListMerkleCache::CalcMerkleRoot(CSimplifiedMNList &&smlIn, bool *pmutated) {
+    std::vector <uint256> newLeaves;
+    newLeaves.reserve(smlIn.mnList.size());
+    bool fChanged = smlIn.mnList.size() != sml.mnList.size();
+
+    // both lists are sorted by proRegTxHash, so a single pass finds the previous version of each entry
+    size_t j = 0;
+    for (const auto &e: smlIn.mnList) {
+        while (j < sml.mnList.size() && sml.mnList[j]->proRegTxHash < e->proRegTxHash) {
+            j++;
+        }
+        if (j < sml.mnList.size() && *sml.mnList[j] == *e) {
+            newLeaves.emplace_back(leaves[j]);
+        } else {
+            newLeaves.emplace_back(e->CalcHash());
+            fChanged = true;
+        }
+    }
+
+    sml = std::move(smlIn);
+    leaves = std::move(newLeaves);
+    if (fChanged) {
+        mutated = false;
+        merkleRoot = ComputeMerkleRoot(leaves, &mutated);
+    }
+    if (pmutated) {
+        *pmutated = mutated;
+    }
+    return merkleRoot;
+}
+
 bool CSimplifiedMNList::operator==(const CSimplifiedMNList &rhs) const {
     return mnList.size() == rhs.mnList.size() && std::equal(mnList.begin(), mnList.end(), rhs.mnList.begin(),
                                                             [](const std::unique_ptr <CSimplifiedMNListEntry> &left,
@@ -191,6 +225,15 @@ void CSimplifiedMNListDiff::ToJson(UniValue &obj) const {
     }
 }
 
+//! diffs further apart than this are built by comparing the full lists instead of replaying the per-block diffs
+static const int MAX_INCREMENTAL_SIMPLIFIED_DIFF_BLOCKS = 64;
+
+// Light clients keep asking for the same few diffs (previous block or last ChainLock to the tip), so the most recent
+// ones are kept. A diff between two given blocks never changes, the active chain check above the lookup is enough.
+static Mutex cs_mnListDiffCache;
+static unordered_lru_cache<std::pair<uint256, uint256>, std::shared_ptr<const CSimplifiedMNListDiff>,
+        StaticSaltedHasher, 32> mnListDiffCache GUARDED_BY(cs_mnListDiffCache);
+
 bool
 BuildSimplifiedMNListDiff(const uint256 &baseBlockHash, const uint256 &blockHash, CSimplifiedMNListDiff &mnListDiffRet,
                           std::string &errorRet) {
@@ -222,10 +265,39 @@ BuildSimplifiedMNListDiff(const uint256 &baseBlockHash, const uint256 &blockHash
         return false;
     }
 
+    {
+        LOCK(cs_mnListDiffCache);
+        std::shared_ptr<const CSimplifiedMNListDiff> cached;
+        if (mnListDiffCache.get(std::make_pair(baseBlockHash, blockHash), cached)) {
+            mnListDiffRet = *cached;
+            return true;
+        }
+    }
+
     LOCK(deterministicMNManager->cs);
     auto baseDmnList = deterministicMNManager->GetListForBlock(baseBlockIndex);
     auto dmnList = deterministicMNManager->GetListForBlock(blockIndex);
-    mnListDiffRet = baseDmnList.BuildSimplifiedDiff(dmnList);
+
+    // Only the MNs touched by the per-block diffs in between can differ, so for the usual requests (previous block or
+    // last ChainLock to the tip) there is no need to compare the full lists
+    std::set <uint64_t> changedIds;
+    bool fIncremental = blockIndex->nHeight - baseBlockIndex->nHeight <= MAX_INCREMENTAL_SIMPLIFIED_DIFF_BLOCKS;
+    for (const CBlockIndex *pindex = blockIndex; fIncremental && pindex != baseBlockIndex; pindex = pindex->pprev) {
+        CDeterministicMNListDiff diff;
+        if (!deterministicMNManager->GetListDiff(pindex, diff)) {
+            fIncremental = false;
+            break;
+        }
+        for (const auto &dmn: diff.addedMNs) {
+            changedIds.emplace(dmn->GetInternalId());
+        }
+        for (const auto &p: diff.updatedMNs) {
+            changedIds.emplace(p.first);
+        }
+        changedIds.insert(diff.removedMns.begin(), diff.removedMns.end());
+    }
+    mnListDiffRet = fIncremental ? baseDmnList.BuildSimplifiedDiff(dmnList, changedIds)
+                                 : baseDmnList.BuildSimplifiedDiff(dmnList);
 
     // We need to return the value that was provided by the other peer as it otherwise won't be able to recognize the
     // response. This will usually be identical to the block found in baseBlockIndex. The only difference is when a
@@ -254,5 +326,9 @@ BuildSimplifiedMNListDiff(const uint256 &baseBlockHash, const uint256 &blockHash
     vMatch[0] = true; // only coinbase matches
     mnListDiffRet.cbTxMerkleTree = CPartialMerkleTree(vHashes, vMatch);
 
+    LOCK(cs_mnListDiffCache);
+    mnListDiffCache.insert(std::make_pair(baseBlockHash, blockHash),
+                           std::make_shared<const CSimplifiedMNListDiff>(mnListDiffRet));
+
     return true;
 }
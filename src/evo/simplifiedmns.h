@@ -78,6 +78,21 @@ public:
     bool operator==(const CSimplifiedMNList &rhs) const;
 };
 
+/**
+ * Merkle root of the simplified list as it changes from block to block. The leaf hashes of the previous list are kept,
+ * so only entries which were added or changed since then are hashed again and an unchanged list is not hashed at all.
+ */
+class CSimplifiedMNListMerkleCache {
+private:
+    CSimplifiedMNList sml;
+    std::vector <uint256> leaves;
+    uint256 merkleRoot;
+    bool mutated{false};
+
+public:
+    uint256 CalcMerkleRoot(CSimplifiedMNList &&smlIn, bool *pmutated = nullptr);
+};
+
 /// P2P messages
 
 class CGetSimplifiedMNListDiff {
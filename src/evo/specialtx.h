@@ -48,6 +48,18 @@ inline bool GetTxPayload(const std::vector<unsigned char> &payload, T &obj) {
     return ds.empty();
 }
 
+/** For payloads kept outside of a transaction, e.g. the one of a future coin */
+template<typename T>
+inline bool GetTxPayload(Span<const unsigned char> payload, T &obj) {
+    SpanReader ds(SER_NETWORK, PROTOCOL_VERSION, payload);
+    try {
+        ds >> obj;
+    } catch (std::exception &e) {
+        return false;
+    }
+    return ds.empty();
+}
+
 template<typename T>
 inline bool GetTxPayload(const CMutableTransaction &tx, T &obj) {
     return GetTxPayload(tx.vExtraPayload, obj);
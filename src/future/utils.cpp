@@ -13,7 +13,7 @@ void maybeSetPayload(Coin &coin, const COutPoint &outpoint, const uint16_t &nTyp
         CFutureTx futureTx;
         if (GetTxPayload(vExtraPayload, futureTx) && outpoint.n == futureTx.lockOutputIndex) {
             coin.nType = nType;
-            coin.vExtraPayload = vExtraPayload;
+            coin.vExtraPayload.assign(vExtraPayload.begin(), vExtraPayload.end());
         }
     }
 }
@@ -242,3 +242,38 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256 &val, uint3
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+void HashFortuneBatch(const unsigned char *inputs, size_t inputLen, size_t count, const GhostRiderSchedule &schedule,
+                      uint256 *hashes) {
+    const auto &core = schedule.GetCoreIndexes();
+    const auto &cn = schedule.GetCnIndexes();
+    // Same stage sequence as HashFortune, cur holds the output of the previous stage for every input
+    std::vector<uint512> cur(count), next(count);
+    // cnHash only writes the low 256 bits, the rest of its output must be zero like a fresh uint512
+    const auto cnStage = [&](int variant) {
+        for (size_t i = 0; i < count; ++i) {
+            next[i].SetNull();
+            cnHash(&cur[i], &next[i], 64, variant);
+        }
+        cur.swap(next);
+    };
+
+    for (size_t i = 0; i < count; ++i) {
+        coreHash(inputs + i * inputLen, &cur[i], inputLen, core[0]);
+    }
+    for (int s = 1; s < 5; ++s) {
+        coreHashBatch(cur.data(), next.data(), count, core[s]);
+        cur.swap(next);
+    }
+    cnStage(cn[0]);
+    for (int s = 5; s < 10; ++s) {
+        coreHashBatch(cur.data(), next.data(), count, core[s]);
+        cur.swap(next);
+    }
+    cnStage(cn[1]);
+    coreHashBatch(cur.data(), next.data(), count, core[10]);
+    cur.swap(next);
+    cnStage(cn[2]);
+
+    for (size_t i = 0; i < count; ++i) hashes[i] = cur[i].trim256();
+}
@@ -323,44 +323,40 @@ uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256 &val);
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256 &val, uint32_t extra);
 
 /* ----------- Ghost Rider Hash ------------------------------------------------ */
+/**
+ * GhostRider: five core hashes, a CryptoNight round, five core hashes, a CryptoNight round, one core hash
+ * and a final CryptoNight round, in the order given by schedule.
+ */
 template<typename T1>
-inline uint256 HashFortune(const T1 pbegin, const T1 pend, const uint256 PrevBlockHash) {
+inline uint256 HashFortune(const T1 pbegin, const T1 pend, const GhostRiderSchedule &schedule) {
     static unsigned char pblank[1];
 
-    uint512 hash[18];
-    HashSelection hashSelection(PrevBlockHash, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, {0, 1, 2, 3, 4, 5});
-    std::vector<int> randomCNs(hashSelection.getCnIndexes());
-    std::vector<int> coreHashIndexes(hashSelection.getAlgoIndexes());
-    for (int i = 0; i < 14; ++i) {
-        const void *toHash;
-        int lenToHash;
-        if (i == 0) {
-            toHash = (pbegin == pend ? pblank : static_cast<const void *>(&pbegin[0]));
-            lenToHash = (pend - pbegin) * sizeof(pbegin[0]);
-        } else {
-            toHash = static_cast<const void *>(&hash[i - 1]);
-            lenToHash = 64;
-        }
-        int coreSelection = -1;
-        int cnSelection = -1;
-        if (i < 5) {
-            coreSelection = coreHashIndexes[i];
-        } else if (i == 5) {
-            cnSelection = randomCNs[0];
-        } else if (i < 11) {
-            coreSelection = coreHashIndexes[i - 1];
-        } else if (i == 11) {
-            cnSelection = randomCNs[1];
-        } else if (i < 13) {
-            coreSelection = coreHashIndexes[i - 2];
-        } else if (i == 13) {
-            cnSelection = randomCNs[2];
-        }
-
-        coreHash(toHash, &hash[i], lenToHash, coreSelection);
-        cnHash(&hash[i - 1], &hash[i], lenToHash, cnSelection);
-    }
+    const auto &core = schedule.GetCoreIndexes();
+    const auto &cn = schedule.GetCnIndexes();
+    uint512 hash[14];
+
+    coreHash(pbegin == pend ? pblank : static_cast<const void *>(&pbegin[0]), &hash[0],
+             (pend - pbegin) * sizeof(pbegin[0]), core[0]);
+    for (int i = 1; i < 5; ++i) coreHash(&hash[i - 1], &hash[i], 64, core[i]);
+    cnHash(&hash[4], &hash[5], 64, cn[0]);
+    for (int i = 6; i < 11; ++i) coreHash(&hash[i - 1], &hash[i], 64, core[i - 1]);
+    cnHash(&hash[10], &hash[11], 64, cn[1]);
+    coreHash(&hash[11], &hash[12], 64, core[10]);
+    cnHash(&hash[12], &hash[13], 64, cn[2]);
     return hash[13].trim256();
 }
 
+template<typename T1>
+inline uint256 HashFortune(const T1 pbegin, const T1 pend, const uint256 PrevBlockHash) {
+    return HashFortune(pbegin, pend, GhostRiderSchedule(PrevBlockHash));
+}
+
+/**
+ * HashFortune of count inputs of inputLen bytes each (input i at inputs + i * inputLen) sharing one schedule,
+ * e.g. one header with different nonces. Each core hash stage runs over all inputs at once through
+ * coreHashBatch; the results are the same as calling HashFortune on every input.
+ */
+void HashFortuneBatch(const unsigned char *inputs, size_t inputLen, size_t count, const GhostRiderSchedule &schedule,
+                      uint256 *hashes);
+
 #endif // BITCOIN_HASH_H
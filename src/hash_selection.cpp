@@ -7,157 +7,188 @@
  */
 // Copyright (c) 2024 The FortuneBlock developers
 
+#if defined(HAVE_CONFIG_H)
+#include <config/fortuneblock-config.h>
+#endif
+
 #include <hash_selection.h>
+#include <compat/cpuid.h>
+#include <crypto/core512_4way.h>
 #include <cryptonote/slow-hash.h>
-#include <sstream>
-
-
 
-std::vector<int> HashSelection::getRandomIndexes(std::vector<int> indexes) {
-    std::vector<int> groupIndexes;
-    unsigned int totalIndexes = indexes.size();
-    unsigned int indexCount = 0;
-    int i = 63;
-    //printf("%d index=", totalIndexes);
-    for (; i >= 0; i--) {
-        unsigned int hashSelection = this->PrevBlockHash.GetNibble(i);
-        if (hashSelection >= totalIndexes) {
-            hashSelection = hashSelection % totalIndexes;
-        }
-        int index = indexes[hashSelection];
-        if (index >= 0) {
-            //printf("%d,", index);
-            groupIndexes.push_back(index);
-            indexes[hashSelection] = -1;
-            indexCount++;
+#include <assert.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+const char *const coreAlgoNames[GhostRiderSchedule::CORE_ALGO_COUNT] = {
+        "Blake",      //0
+        "Bmw",        //1
+        "Groestl",    //2
+        "Jh",         //3
+        "Keccak",     //4
+        "Skein",      //5
+        "Luffa",      //6
+        "Cubehash",   //7
+        "Shavite",    //8
+        "Simd",       //9
+        "Echo"        //A
+};
+
+const char *const cnVariantNames[GhostRiderSchedule::CN_VARIANT_COUNT] = {
+        "CNDark",        //0
+        "CNDarklite",    //1
+        "CNFast",        //2
+        "CNLite",        //3
+        "CNTurtle",      //4
+        "CNTurtlelite"   //5
+};
+
+/**
+ * Permute 0..N-1 by the nibbles of prevBlockHash, most significant first: each nibble (mod N) picks an index
+ * that hasn't been picked yet, and indexes no nibble picked are appended in ascending order.
+ */
+template<size_t N>
+void SelectOrder(const uint256 &prevBlockHash, std::array<uint8_t, N> &order) {
+    bool used[N] = {};
+    size_t count = 0;
+    for (int i = 63; i >= 0 && count < N; i--) {
+        unsigned int selection = prevBlockHash.GetNibble(i);
+        if (selection >= N) {
+            selection %= N;
         }
-        if (indexCount == indexes.size()) {
-            break;
+        if (!used[selection]) {
+            used[selection] = true;
+            order[count++] = selection;
         }
     }
-    //printf("indexCount=%d------------------------\n",indexCount);
-    if (i < 0 && indexCount < totalIndexes) {
-        for (unsigned int j = 0; j < indexes.size(); j++) {
-            int index = indexes[j];
-            if (index >= 0) {
-                //printf("%d,", index);
-                groupIndexes.push_back(index);
-            }
+    for (size_t j = 0; j < N && count < N; j++) {
+        if (!used[j]) {
+            order[count++] = j;
         }
     }
-    return groupIndexes;
 }
 
+template<typename Context, void (*Init)(void *), void (*Update)(void *, const void *, size_t), void (*Close)(void *, void *)>
+void CoreHashImpl(const void *toHash, uint512 *hash, int lenToHash) {
+    Context ctx;
+    Init(&ctx);
+    Update(&ctx, toHash, lenToHash);
+    Close(&ctx, static_cast<void *>(hash));
+}
 
-std::string HashSelection::getHashSelectionString()
-{
-    std::ostringstream selectedAlgoes;
+typedef void (*CoreHashFn)(const void *toHash, uint512 *hash, int lenToHash);
+
+const CoreHashFn coreHashFns[GhostRiderSchedule::CORE_ALGO_COUNT] = {
+        CoreHashImpl<sph_blake512_context, sph_blake512_init, sph_blake512, sph_blake512_close>,               //0
+        CoreHashImpl<sph_bmw512_context, sph_bmw512_init, sph_bmw512, sph_bmw512_close>,                       //1
+        CoreHashImpl<sph_groestl512_context, sph_groestl512_init, sph_groestl512, sph_groestl512_close>,       //2
+        CoreHashImpl<sph_jh512_context, sph_jh512_init, sph_jh512, sph_jh512_close>,                           //3
+        CoreHashImpl<sph_keccak512_context, sph_keccak512_init, sph_keccak512, sph_keccak512_close>,           //4
+        CoreHashImpl<sph_skein512_context, sph_skein512_init, sph_skein512, sph_skein512_close>,               //5
+        CoreHashImpl<sph_luffa512_context, sph_luffa512_init, sph_luffa512, sph_luffa512_close>,               //6
+        CoreHashImpl<sph_cubehash512_context, sph_cubehash512_init, sph_cubehash512, sph_cubehash512_close>,   //7
+        CoreHashImpl<sph_shavite512_context, sph_shavite512_init, sph_shavite512, sph_shavite512_close>,       //8
+        CoreHashImpl<sph_simd512_context, sph_simd512_init, sph_simd512, sph_simd512_close>,                   //9
+        CoreHashImpl<sph_echo512_context, sph_echo512_init, sph_echo512, sph_echo512_close>                    //A
+};
+
+typedef void (*CoreHash4WayFn)(unsigned char *out, const unsigned char *in);
+
+/** Multi-buffer implementation per core algorithm, nullptr where coreHashBatch has to hash one input at a time */
+CoreHash4WayFn coreHash4WayFns[GhostRiderSchedule::CORE_ALGO_COUNT] = {};
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL) && defined(HAVE_GETCPUID)
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled() {
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
 
-    // Helper function to append selected algoes
-    auto appendAlgoes = [&](int start, int end) {
-        for (int i = start; i < end; ++i) {
-            int selectedAlgoIndex = this->algoIndexes[i];
-            std::string selectedAlgo = this->algoMap[selectedAlgoIndex];
-            selectedAlgoes << selectedAlgo;
+/** Compare every enabled multi-buffer implementation with the scalar one on a few inputs */
+bool CoreHashSelfTest() {
+    uint512 in[4], out[4], expected;
+    for (int lane = 0; lane < 4; ++lane) {
+        for (int i = 0; i < 64; ++i) in[lane].begin()[i] = (unsigned char) (lane * 64 + i * 7);
+    }
+    for (int algo = 0; algo < GhostRiderSchedule::CORE_ALGO_COUNT; ++algo) {
+        if (!coreHash4WayFns[algo]) continue;
+        coreHash4WayFns[algo](out[0].begin(), in[0].begin());
+        for (int lane = 0; lane < 4; ++lane) {
+            coreHashFns[algo](&in[lane], &expected, 64);
+            if (out[lane] != expected) return false;
         }
-    };
-
-    // First 5 algoes
-    appendAlgoes(0, 5);
-
-    // First CN variant
-    std::string selectedCN_1 = this->cnVariantMap[this->cnIndexes[0]];
-    selectedAlgoes << selectedCN_1;
-
-    // Next 5 algoes
-    appendAlgoes(5, 10);
-
-    // Second CN variant
-    std::string selectedCN_2 = this->cnVariantMap[this->cnIndexes[1]];
-    selectedAlgoes << selectedCN_2;
-
-    // Final algo
-    appendAlgoes(10, 11);
+    }
+    return true;
+}
 
-    // Third CN variant
-    std::string selectedCN_3 = this->cnVariantMap[this->cnIndexes[2]];
-    selectedAlgoes << selectedCN_3;
+} // namespace
 
-    return selectedAlgoes.str();
+GhostRiderSchedule::GhostRiderSchedule(const uint256 &prevBlockHash) {
+    SelectOrder(prevBlockHash, cnIndexes);
+    SelectOrder(prevBlockHash, coreIndexes);
 }
 
+std::string GhostRiderSchedule::ToString() const {
+    std::string selectedAlgoes;
+    for (int i = 0; i < 5; ++i) selectedAlgoes += coreAlgoNames[coreIndexes[i]];
+    selectedAlgoes += cnVariantNames[cnIndexes[0]];
+    for (int i = 5; i < 10; ++i) selectedAlgoes += coreAlgoNames[coreIndexes[i]];
+    selectedAlgoes += cnVariantNames[cnIndexes[1]];
+    selectedAlgoes += coreAlgoNames[coreIndexes[10]];
+    selectedAlgoes += cnVariantNames[cnIndexes[2]];
+    return selectedAlgoes;
+}
 
 void coreHash(const void *toHash, uint512 *hash, int lenToHash, int hashSelection) {
-    sph_blake512_context ctx_blake;      //0
-    sph_bmw512_context ctx_bmw;        //1
-    sph_groestl512_context ctx_groestl;    //2
-    sph_jh512_context ctx_jh;         //3
-    sph_keccak512_context ctx_keccak;     //4
-    sph_skein512_context ctx_skein;      //5
-    sph_luffa512_context ctx_luffa;      //6
-    sph_cubehash512_context ctx_cubehash;   //7
-    sph_shavite512_context ctx_shavite;    //8
-    sph_simd512_context ctx_simd;       //9
-    sph_echo512_context ctx_echo;       //A
-
-    switch (hashSelection) {
-        case 0:
-            sph_blake512_init(&ctx_blake);
-            sph_blake512(&ctx_blake, toHash, lenToHash);
-            sph_blake512_close(&ctx_blake, static_cast<void *>(hash));
-            break;
-        case 1:
-            sph_bmw512_init(&ctx_bmw);
-            sph_bmw512(&ctx_bmw, toHash, lenToHash);
-            sph_bmw512_close(&ctx_bmw, static_cast<void *>(hash));
-            break;
-        case 2:
-            sph_groestl512_init(&ctx_groestl);
-            sph_groestl512(&ctx_groestl, toHash, lenToHash);
-            sph_groestl512_close(&ctx_groestl, static_cast<void *>(hash));
-            break;
-        case 3:
-            sph_jh512_init(&ctx_jh);
-            sph_jh512(&ctx_jh, toHash, lenToHash);
-            sph_jh512_close(&ctx_jh, static_cast<void *>(hash));
-            break;
-        case 4:
-            sph_keccak512_init(&ctx_keccak);
-            sph_keccak512(&ctx_keccak, toHash, lenToHash);
-            sph_keccak512_close(&ctx_keccak, static_cast<void *>(hash));
-            break;
-        case 5:
-            sph_skein512_init(&ctx_skein);
-            sph_skein512(&ctx_skein, toHash, lenToHash);
-            sph_skein512_close(&ctx_skein, static_cast<void *>(hash));
-            break;
-        case 6:
-            sph_luffa512_init(&ctx_luffa);
-            sph_luffa512(&ctx_luffa, toHash, lenToHash);
-            sph_luffa512_close(&ctx_luffa, static_cast<void *>(hash));
-            break;
-        case 7:
-            sph_cubehash512_init(&ctx_cubehash);
-            sph_cubehash512(&ctx_cubehash, toHash, lenToHash);
-            sph_cubehash512_close(&ctx_cubehash, static_cast<void *>(hash));
-            break;
-        case 8:
-            sph_shavite512_init(&ctx_shavite);
-            sph_shavite512(&ctx_shavite, toHash, lenToHash);
-            sph_shavite512_close(&ctx_shavite, static_cast<void *>(hash));
-            break;
-        case 9:
-            sph_simd512_init(&ctx_simd);
-            sph_simd512(&ctx_simd, toHash, lenToHash);
-            sph_simd512_close(&ctx_simd, static_cast<void *>(hash));
-            break;
-        case 10:
-            sph_echo512_init(&ctx_echo);
-            sph_echo512(&ctx_echo, toHash, lenToHash);
-            sph_echo512_close(&ctx_echo, static_cast<void *>(hash));
-            break;
+    if (hashSelection >= 0 && hashSelection < GhostRiderSchedule::CORE_ALGO_COUNT) {
+        coreHashFns[hashSelection](toHash, hash, lenToHash);
+    }
+}
+void coreHashBatch(const uint512 *toHash, uint512 *hash, size_t count, int hashSelection) {
+    if (hashSelection < 0 || hashSelection >= GhostRiderSchedule::CORE_ALGO_COUNT) return;
+    // uint512 is a plain 64-byte blob, so an array of them is the 4 * 64 byte layout the 4-way functions expect
+    static_assert(sizeof(uint512) == 64, "uint512 must not be padded");
+    size_t i = 0;
+    if (const CoreHash4WayFn fn = coreHash4WayFns[hashSelection]) {
+        for (; i + 4 <= count; i += 4) {
+            fn(hash[i].begin(), toHash[i].begin());
+        }
+    }
+    for (; i < count; ++i) {
+        coreHashFns[hashSelection](&toHash[i], &hash[i], 64);
+    }
+}
 
+std::string CoreHashAutoDetect() {
+    std::string ret = "standard";
+    std::fill(std::begin(coreHash4WayFns), std::end(coreHash4WayFns), nullptr);
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL) && defined(HAVE_GETCPUID)
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    bool have_avx2 = false;
+    if (have_xsave && have_avx && AVXEnabled()) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
     }
+    if (have_avx2) {
+        coreHash4WayFns[0] = core512_avx2::Blake512_4way;
+        coreHash4WayFns[1] = core512_avx2::Bmw512_4way;
+        coreHash4WayFns[3] = core512_avx2::Jh512_4way;
+        coreHash4WayFns[4] = core512_avx2::Keccak512_4way;
+        coreHash4WayFns[5] = core512_avx2::Skein512_4way;
+        ret = "avx2(4way blake,bmw,jh,keccak,skein)";
+    }
+#endif
+
+    assert(CoreHashSelfTest());
+    return ret;
 }
 
 void cnHash(uint512 *toHash, uint512 *hash, int lenToHash, int hashSelection) {
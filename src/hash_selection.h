@@ -13,8 +13,8 @@
 #define FORTUNEBLOCK_SELECTION_H_
 
 #include <uint256.h>
+#include <array>
 #include <string>
-#include <vector>
 
 #include <crypto/sph_blake.h>
 #include <crypto/sph_bmw.h>
@@ -42,56 +42,38 @@ void coreHash(const void *toHash, uint512 *hash, int lenToHash, int hashSelectio
 
 void cnHash(uint512 *toHash, uint512 *hash, int lenToHash, int hashSelection);
 
-class HashSelection {
+/**
+ * coreHash over count independent 64-byte inputs (toHash[i] -> hash[i]). Groups of four go through the
+ * multi-buffer implementation of the algorithm if CoreHashAutoDetect() enabled one, the rest is hashed one by one.
+ */
+void coreHashBatch(const uint512 *toHash, uint512 *hash, size_t count, int hashSelection);
+
+/** Enable the fastest multi-buffer core hashes this CPU supports. Returns a description of the selection. */
+std::string CoreHashAutoDetect();
+
+/**
+ * Order in which HashFortune applies its core and CryptoNight algorithms. It only depends on hashPrevBlock,
+ * so it can be derived once and reused for every header (nonce) built on the same parent.
+ */
+class GhostRiderSchedule {
 public:
-    HashSelection(const uint256 prevBlockHash, const std::vector<int> algoIndexes, std::vector<int> cnIndexes) {
-        this->PrevBlockHash = prevBlockHash;
-        this->algoMap = {
-                "Blake",      //0
-                "Bmw",        //1
-                "Groestl",    //2
-                "Jh",         //3
-                "Keccak",     //4
-                "Skein",      //5
-                "Luffa",      //6
-                "Cubehash",   //7
-                "Shavite",    //8
-                "Simd",       //9
-                "Echo"        //A
-
-        };
-        this->cnVariantMap = {
-                "CNDark",        //0
-                "CNDarklite",    //1
-                "CNFast",        //2
-                "CNLite",        //3
-                "CNTurtle",      //4
-                "CNTurtlelite"   //5
-
-        };
-        //printf("before getRandomIndexes cnIndexes\n");
-        this->cnIndexes = this->getRandomIndexes(cnIndexes);
-        //printf("before getRandomIndexes cnIndexes\n");
-        this->algoIndexes = this->getRandomIndexes(algoIndexes);
-    }
-
-//	int getHashSelection(int index);
-//	static int getGroupHashSelection(uint256 blockHash);
-    std::vector<int> getRandomIndexes(std::vector<int> indexes);
-
-    std::string getHashSelectionString();
-
-    std::vector<int> getCnIndexes() { return this->cnIndexes; }
-
-    std::vector<int> getAlgoIndexes() { return this->algoIndexes; }
-
-protected:
-    uint256 PrevBlockHash;
-    std::vector<int> algoIndexes;
-    std::vector<int> cnIndexes;
-    std::vector <std::string> cnVariantMap;
-    std::vector <std::string> algoMap;
+    static constexpr int CORE_ALGO_COUNT = 11;
+    static constexpr int CN_VARIANT_COUNT = 6;
+    /** Number of CryptoNight rounds in one hash, only the first CN_ROUNDS of cnIndexes are used */
+    static constexpr int CN_ROUNDS = 3;
+
+    explicit GhostRiderSchedule(const uint256 &prevBlockHash);
+
+    const std::array<uint8_t, CORE_ALGO_COUNT> &GetCoreIndexes() const { return coreIndexes; }
+
+    const std::array<uint8_t, CN_VARIANT_COUNT> &GetCnIndexes() const { return cnIndexes; }
+
+    /** Names of the selected algorithms in the order they are applied, e.g. "BlakeBmw...CNDark..." */
+    std::string ToString() const;
 
+private:
+    std::array<uint8_t, CORE_ALGO_COUNT> coreIndexes;
+    std::array<uint8_t, CN_VARIANT_COUNT> cnIndexes;
 };
 
 #endif /* FORTUNEBLOCK_SELECTION_H_ */
@@ -12,6 +12,9 @@
 #include <serialize.h>
 #include <uint256.h>
 
+#include <string>
+#include <tuple>
+
 struct CSpentIndexKey : IndexKey {
     CSpentIndexKey(uint256 t, unsigned int i) :
             IndexKey(t, i) {
@@ -364,6 +367,42 @@ struct CAddressIndexIteratorKey {
     }
 };
 
+struct CAddressIndexIteratorAssetKey {
+    unsigned int type;
+    uint160 hashBytes;
+    std::string asset;
+
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        ser_writedata8(s, type);
+        hashBytes.Serialize(s);
+        ::Serialize(s, asset);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s) {
+        type = ser_readdata8(s);
+        hashBytes.Unserialize(s);
+        ::Unserialize(s, asset);
+    }
+
+    CAddressIndexIteratorAssetKey(unsigned int addressType, uint160 addressHash, std::string assetId) {
+        type = addressType;
+        hashBytes = addressHash;
+        asset = assetId;
+    }
+
+    CAddressIndexIteratorAssetKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = 0;
+        hashBytes.SetNull();
+        asset = "";
+    }
+};
+
 struct CAddressIndexIteratorHeightKey {
     unsigned int type;
     uint160 hashBytes;
@@ -404,4 +443,131 @@ struct CAddressIndexIteratorHeightKey {
     }
 };
 
+struct CAddressIndexIteratorAssetHeightKey {
+    unsigned int type;
+    uint160 hashBytes;
+    std::string asset;
+    int blockHeight;
+
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        ser_writedata8(s, type);
+        hashBytes.Serialize(s);
+        ::Serialize(s, asset);
+        ser_writedata32be(s, blockHeight);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s) {
+        type = ser_readdata8(s);
+        hashBytes.Unserialize(s);
+        ::Unserialize(s, asset);
+        blockHeight = ser_readdata32be(s);
+    }
+
+    CAddressIndexIteratorAssetHeightKey(unsigned int addressType, uint160 addressHash, std::string assetId, int height) {
+        type = addressType;
+        hashBytes = addressHash;
+        asset = assetId;
+        blockHeight = height;
+    }
+
+    CAddressIndexIteratorAssetHeightKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = 0;
+        hashBytes.SetNull();
+        asset = "";
+        blockHeight = 0;
+    }
+};
+
+/** Running totals of the address index deltas of one address and asset */
+struct CAddressBalanceKey {
+    unsigned int type;
+    uint160 hashBytes;
+    std::string asset;
+
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        ser_writedata8(s, type);
+        hashBytes.Serialize(s);
+        ::Serialize(s, asset);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s) {
+        type = ser_readdata8(s);
+        hashBytes.Unserialize(s);
+        ::Unserialize(s, asset);
+    }
+
+    CAddressBalanceKey(unsigned int addressType, uint160 addressHash, std::string assetId) {
+        type = addressType;
+        hashBytes = addressHash;
+        asset = assetId;
+    }
+
+    explicit CAddressBalanceKey(const CAddressIndexKey &key) :
+            CAddressBalanceKey(key.type, key.hashBytes, key.asset) {}
+
+    CAddressBalanceKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = 0;
+        hashBytes.SetNull();
+        asset = "";
+    }
+
+    friend bool operator<(const CAddressBalanceKey &a, const CAddressBalanceKey &b) {
+        return std::tie(a.type, a.hashBytes, a.asset) < std::tie(b.type, b.hashBytes, b.asset);
+    }
+
+    friend bool operator==(const CAddressBalanceKey &a, const CAddressBalanceKey &b) {
+        return a.type == b.type && a.hashBytes == b.hashBytes && a.asset == b.asset;
+    }
+};
+
+struct CAddressBalanceValue {
+    //! sum of all deltas
+    CAmount balance;
+    //! sum of the positive deltas
+    CAmount received;
+
+    SERIALIZE_METHODS(CAddressBalanceValue, obj
+    )
+    {
+        READWRITE(obj.balance, obj.received);
+    }
+
+    CAddressBalanceValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+    }
+
+    void Add(CAmount delta) {
+        balance += delta;
+        if (delta > 0)
+            received += delta;
+    }
+
+    void Remove(CAmount delta) {
+        balance -= delta;
+        if (delta > 0)
+            received -= delta;
+    }
+
+    bool IsNull() const {
+        return balance == 0 && received == 0;
+    }
+};
+
 #endif // BITCOIN_SPENTINDEX_H
@@ -249,6 +249,7 @@ void PrepareShutdown(NodeContext &node) {
     threadGroup.interrupt_all();
     threadGroup.join_all();
     StopScriptCheckWorkerThreads();
+    StopPowHeaderWorkerThreads();
 
     // After there are no more peers/RPC left to give us new data which may generate
     // CValidationInterface callbacks, flush them...
@@ -266,8 +267,7 @@ void PrepareShutdown(NodeContext &node) {
             CFlatDB <CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
             flatdb3.Dump(governance);
         }
-        CFlatDB <CPowCache> flatdb7("powcache.dat", "powCache");
-        flatdb7.Dump(CPowCache::Instance());
+        CPowCache::Instance().Flush();
     }
 
     // After the threads that potentially access these pointers have been stopped,
@@ -503,6 +503,16 @@ void SetupServerArgs() {
     gArgs.AddArg("-dbcache=<n>",
                  strprintf("Set database cache size in megabytes (%d to %d, default: %d)", nMinDbCache, nMaxDbCache,
                            nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-assetcache=<n>",
+                 strprintf("Set asset cache size in megabytes (default: %d)", DEFAULT_ASSETS_CACHE),
+                 ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-dmnlistcache=<n>",
+                 strprintf("Set smartnode list cache size in megabytes (default: %d)", DEFAULT_DMN_LIST_CACHE),
+                 ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-dmnlistcheckpoint=<n>",
+                 strprintf("Keep a smartnode list in memory every <n> blocks while rebuilding historical lists, "
+                           "bounding how many blocks a lookup replays (default: %d)", DEFAULT_DMN_LIST_CHECKPOINT),
+                 ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-powcachesize=<n>",
                  strprintf("Set ProofOfWork cache size in megabytes (default: %d)", DEFAULT_POW_CACHE_SIZE),
                  ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -510,7 +520,7 @@ void SetupServerArgs() {
                  strprintf("Whether to validate ProofOfWork cache (default: %u)", DEFAULT_VALIDATE_POW_CACHE),
                  ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-powmaxloadsize",
-                 strprintf("Set ProofOfWork maximum elements to load (default: %d)", DEFAULT_MAX_LOAD_SIZE),
+                 strprintf("Set the number of new ProofOfWork hashes written to disk at once (default: %d)", DEFAULT_MAX_LOAD_SIZE),
                  ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-debuglogfile=<file>", strprintf(
             "Specify location of debug log file. Relative paths will be prefixed by a net-specific datadir location. (0 to disable; default: %s)",
@@ -571,8 +581,11 @@ void SetupServerArgs() {
                  strprintf("Set max pow cache size (number of pow hashes) that keeping in memory (default: %d)",
                            DEFAULT_POW_CACHE_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-powmaxloadsize", strprintf(
-            "Set max pow cache load size (number of pow hashes) that to be written to powcache.dat (default: %d)",
+            "Set the number of new pow hashes to collect before appending them to the on-disk pow cache (default: %d)",
             DEFAULT_MAX_LOAD_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-powcachestoresize", strprintf(
+            "Set the number of pow hashes kept in the on-disk pow cache, the oldest are dropped beyond it (default: %d)",
+            DEFAULT_POW_CACHE_STORE_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     gArgs.AddArg("-powcachevalidate",
                  "Enable validation of pow hashes from the cache (default: %true). Use of this option will significantly slow down wallet synchronization.",
                  ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -1768,6 +1781,10 @@ bool AppInitSanityChecks() {
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string cn_algo = cn_slow_hash_autodetect();
+    LogPrintf("Using the '%s' CryptoNight implementation\n", cn_algo);
+    std::string core_hash_algo = CoreHashAutoDetect();
+    LogPrintf("Using the '%s' GhostRider core hash implementation\n", core_hash_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1871,6 +1888,12 @@ bool AppInitMain(const util::Ref &context, NodeContext &node, interfaces::BlockA
         StartScriptCheckWorkerThreads(script_threads);
     }
 
+    int pow_header_threads = std::min((int) gArgs.GetArg("-powheaderthreads", DEFAULT_POWHEADERTHREADS), GetNumCores());
+    LogPrintf("Header PoW verification uses %d threads\n", std::max(pow_header_threads, 0));
+    if (pow_header_threads >= 1) {
+        StartPowHeaderWorkerThreads(pow_header_threads);
+    }
+
     std::vector <std::string> vSporkAddresses;
     if (gArgs.IsArgSet("-sporkaddr")) {
         vSporkAddresses = gArgs.GetArgs("-sporkaddr");
@@ -2104,22 +2127,30 @@ bool AppInitMain(const util::Ref &context, NodeContext &node, interfaces::BlockA
         return InitError(_("Failed to load sporks cache from") + "\n" + (GetDataDir() / "sporks.dat").string());
     }
 
-    // ********************************************************* Step 7b: load powcache.dat
+    // ********************************************************* Step 7b: open the POW cache
     {
-        fs::path pathDB = GetDataDir();
-        std::string strDBName = "powcache.dat";
-
-        LOCK(cs_pow);
-        // Always load the powcache if available:
         uiInterface.InitMessage(_("Loading POW cache..."));
-        fs::path powCacheFile = pathDB / strDBName;
-        if (!fs::exists(powCacheFile)) {
-            uiInterface.InitMessage("Loading POW cache for the first time. This could take a minute...");
+        fs::path powCacheDir = GetDataDir() / "powcache";
+        if (!CPowCache::Instance().Open(powCacheDir)) {
+            return InitError(_("Failed to open POW cache in") + "\n" + powCacheDir.string());
         }
 
-        CFlatDB <CPowCache> flatdb7(strDBName, "powCache");
-        if (!flatdb7.Load(CPowCache::Instance())) {
-            return InitError(_("Failed to load POW cache from") + "\n" + (pathDB / strDBName).string());
+        // Import a powcache.dat written by older versions once, it is superseded by the segments in powcache/
+        fs::path legacyFile = GetDataDir() / "powcache.dat";
+        if (fs::exists(legacyFile)) {
+            CFlatDB <CPowCache> flatdb7("powcache.dat", "powCache");
+            if (flatdb7.Load(CPowCache::Instance()) && CPowCache::Instance().Flush()) {
+                fs::remove(legacyFile);
+            } else {
+                // move it out of the way, or every start would try it again
+                fs::path badFile = GetDataDir() / "powcache.dat.bad";
+                if (RenameOver(legacyFile, badFile)) {
+                    LogPrintf("Failed to import %s, it was moved to %s\n", legacyFile.string(), badFile.string());
+                } else {
+                    LogPrintf("Failed to import %s, removing it\n", legacyFile.string());
+                    fs::remove(legacyFile);
+                }
+            }
         }
     }
 
@@ -2181,12 +2212,24 @@ bool AppInitMain(const util::Ref &context, NodeContext &node, interfaces::BlockA
                 // new CBlockTreeDB tries to delete the existing file, which
                 // fails if it's still open from the previous loop. Close it first:
                 pblocktree.reset();
+                if (fReset) {
+                    // -reindex wipes the block tree, hand the PoW hashes stored in it to the POW cache
+                    // first so the headers don't have to be hashed again
+                    CPowCache &powCache = CPowCache::Instance();
+                    CBlockTreeDB(nBlockTreeDBCache).ReadPOWHashes([&powCache](const uint256 &blockHash,
+                                                                              const uint256 &powHash) {
+                        powCache.Import(blockHash, powHash);
+                    });
+                    powCache.Flush();
+                }
                 pblocktree.reset(new CBlockTreeDB(nBlockTreeDBCache, false, fReset));
 
                 passetsdb.reset();
                 passetsdb.reset(new CAssetsDB(nBlockTreeDBCache, false, fReset));
                 passetsCache.reset();
                 passetsCache.reset(new CAssetsCache());
+                assetsCacheUsage.Clear();
+                passetsCache->nMaxMemoryUsage = std::max<int64_t>(gArgs.GetArg("-assetcache", DEFAULT_ASSETS_CACHE), 1) << 20;
 
                 if (!passetsdb->LoadAssets()) {
                     strLoadError = _("Failed to load Assets Database");
@@ -2198,7 +2241,9 @@ bool AppInitMain(const util::Ref &context, NodeContext &node, interfaces::BlockA
                 evoDb.reset();
                 evoDb.reset(new CEvoDB(nEvoDbCache, false, fReset || fReindexChainState));
                 deterministicMNManager.reset();
-                deterministicMNManager.reset(new CDeterministicMNManager(*evoDb, *node.connman));
+                deterministicMNManager.reset(new CDeterministicMNManager(*evoDb, *node.connman,
+                                                                         gArgs.GetArg("-dmnlistcheckpoint", DEFAULT_DMN_LIST_CHECKPOINT),
+                                                                         std::max<int64_t>(gArgs.GetArg("-dmnlistcache", DEFAULT_DMN_LIST_CACHE), 1) << 20));
 
                 llmq::InitLLMQSystem(*evoDb, *node.mempool, *node.connman, false, fReset || fReindexChainState);
 
@@ -29,10 +29,10 @@ namespace llmq {
         quorumBlockProcessor = new CQuorumBlockProcessor(evoDb, connman);
         quorumDKGSessionManager = new CDKGSessionManager(connman, *blsWorker, unitTests, fWipe);
         quorumManager = new CQuorumManager(evoDb, connman, *blsWorker, *quorumDKGSessionManager);
-        quorumSigSharesManager = new CSigSharesManager(connman);
-        quorumSigningManager = new CSigningManager(connman, unitTests, fWipe);
+        quorumSigSharesManager = new CSigSharesManager(connman, *blsWorker);
+        quorumSigningManager = new CSigningManager(connman, *blsWorker, unitTests, fWipe);
         chainLocksHandler = new CChainLocksHandler(mempool, connman);
-        quorumInstantSendManager = new CInstantSendManager(mempool, connman, unitTests, fWipe);
+        quorumInstantSendManager = new CInstantSendManager(mempool, connman, *blsWorker, unitTests, fWipe);
 
         // TODO: remove at some point of future upgrades. it is used only to wipe old db.
         auto llmqDbTmp = std::make_unique<CDBWrapper>(unitTests ? "" : (GetDataDir() / "llmq"), 1 << 20, unitTests,
@@ -86,19 +86,124 @@ namespace llmq {
                 it->Next();
             }
             batch.Write(DB_VERSION, CInstantSendDb::CURRENT_VERSION);
-            db->WriteBatch(batch);
+            if (!db->WriteBatch(batch)) {
+                LogPrintf("CInstantSendDb::%s -- failed to write the upgraded DB\n", __func__);
+            }
+        }
+    }
+
+    void CInstantSendDb::Batch::AddNew(const uint256 &hash, const CInstantSendLock &islock) {
+        auto p = std::make_shared<CInstantSendLock>(islock);
+        entries.push_back({Op::NEW, hash, p, 0});
+        newLocks[hash] = p;
+        newTxids[p->txid] = hash;
+        for (const auto &in: p->inputs) {
+            newOutpoints[in] = hash;
+        }
+        archived.erase(hash);
+    }
+
+    void CInstantSendDb::Batch::AddArchived(const uint256 &hash, const CInstantSendLockPtr &islock, int nHeight) {
+        entries.push_back({Op::ARCHIVED, hash, islock, nHeight});
+        if (newLocks.erase(hash)) {
+            auto it = newTxids.find(islock->txid);
+            if (it != newTxids.end() && it->second == hash) {
+                newTxids.erase(it);
+            }
+            for (const auto &in: islock->inputs) {
+                auto it2 = newOutpoints.find(in);
+                if (it2 != newOutpoints.end() && it2->second == hash) {
+                    newOutpoints.erase(it2);
+                }
+            }
         }
+        archived.emplace(hash);
+    }
+
+    void CInstantSendDb::Batch::Clear() {
+        entries.clear();
+        newLocks.clear();
+        newTxids.clear();
+        newOutpoints.clear();
+        archived.clear();
     }
 
-    void CInstantSendDb::WriteNewInstantSendLock(const uint256 &hash, const CInstantSendLock &islock) {
+    bool CInstantSendDb::WriteCommitBatch(CDBBatch &batch) {
+        AssertLockHeld(cs_db);
+        return db->WriteBatch(batch);
+    }
+
+    bool CInstantSendDb::CommitBatch(Batch &batch) {
         LOCK(cs_db);
-        CDBBatch batch(*db);
-        batch.Write(std::make_tuple(std::string(DB_ISLOCK_BY_HASH), hash), islock);
-        batch.Write(std::make_tuple(std::string(DB_HASH_BY_TXID), islock.txid), hash);
+        // Other writers may have run since the batch was collected, e.g. RemoveConfirmedInstantSendLocks() might have
+        // archived an IS Lock this batch archives too. So the DB ops are only built now and the caches are touched
+        // after they are on disk, never before.
+        CDBBatch dbBatch(*db);
+        std::vector<const Batch::Entry *> applied;
+        std::unordered_set <uint256, StaticSaltedHasher> written;
+        for (const auto &e: batch.entries) {
+            switch (e.op) {
+                case Batch::Op::NEW:
+                    dbBatch.Write(std::make_tuple(std::string(DB_ISLOCK_BY_HASH), e.hash), *e.islock);
+                    dbBatch.Write(std::make_tuple(std::string(DB_HASH_BY_TXID), e.islock->txid), e.hash);
+                    for (const auto &in: e.islock->inputs) {
+                        dbBatch.Write(std::make_tuple(std::string(DB_HASH_BY_OUTPOINT), in), e.hash);
+                    }
+                    written.emplace(e.hash);
+                    break;
+                case Batch::Op::MINED:
+                    WriteInstantSendLockMined(dbBatch, e.hash, e.nHeight);
+                    break;
+                case Batch::Op::ARCHIVED:
+                    if (!written.count(e.hash) && GetInstantSendLockByHashInternal(e.hash, false) == nullptr) {
+                        // already removed by someone else
+                        continue;
+                    }
+                    RemoveInstantSendLock(dbBatch, e.hash, e.islock);
+                    WriteInstantSendLockArchived(dbBatch, e.hash, e.nHeight);
+                    break;
+            }
+            applied.push_back(&e);
+        }
+
+        bool ret = WriteCommitBatch(dbBatch);
+        if (!ret) {
+            LogPrintf("CInstantSendDb::%s -- failed to write %d islocks\n", __func__, batch.newLocks.size());
+        } else {
+            for (const auto *e: applied) {
+                if (e->op == Batch::Op::NEW) {
+                    islockCache.insert(e->hash, e->islock);
+                    txidCache.insert(e->islock->txid, e->hash);
+                    for (const auto &in: e->islock->inputs) {
+                        outpointCache.insert(in, e->hash);
+                    }
+                } else if (e->op == Batch::Op::ARCHIVED) {
+                    islockCache.erase(e->hash);
+                    txidCache.erase(e->islock->txid);
+                    for (const auto &in: e->islock->inputs) {
+                        outpointCache.erase(in);
+                    }
+                }
+            }
+        }
+        batch.Clear();
+        return ret;
+    }
+
+    void CInstantSendDb::WriteNewInstantSendLock(const uint256 &hash, const CInstantSendLock &islock, Batch *batch) {
+        if (batch) {
+            batch->AddNew(hash, islock);
+            return;
+        }
+
+        LOCK(cs_db);
+        CDBBatch dbBatch(*db);
+        dbBatch.Write(std::make_tuple(std::string(DB_ISLOCK_BY_HASH), hash), islock);
+        dbBatch.Write(std::make_tuple(std::string(DB_HASH_BY_TXID), islock.txid), hash);
         for (auto &in: islock.inputs) {
-            batch.Write(std::make_tuple(std::string(DB_HASH_BY_OUTPOINT), in), hash);
+            dbBatch.Write(std::make_tuple(std::string(DB_HASH_BY_OUTPOINT), in), hash);
         }
-        db->WriteBatch(batch);
+        db->WriteBatch(dbBatch);
 
         auto p = std::make_shared<CInstantSendLock>(islock);
         islockCache.insert(hash, p);
@@ -138,11 +243,15 @@ namespace llmq {
         return std::make_tuple(k, htobe32(std::numeric_limits<uint32_t>::max() - nHeight), islockHash);
     }
 
-    void CInstantSendDb::WriteInstantSendLockMined(const uint256 &hash, int nHeight) {
+    void CInstantSendDb::WriteInstantSendLockMined(const uint256 &hash, int nHeight, Batch *batch) {
+        if (batch) {
+            batch->entries.push_back({Batch::Op::MINED, hash, nullptr, nHeight});
+            return;
+        }
         LOCK(cs_db);
-        CDBBatch batch(*db);
-        WriteInstantSendLockMined(batch, hash, nHeight);
-        db->WriteBatch(batch);
+        CDBBatch dbBatch(*db);
+        WriteInstantSendLockMined(dbBatch, hash, nHeight);
+        db->WriteBatch(dbBatch);
     }
 
     void CInstantSendDb::WriteInstantSendLockMined(CDBBatch &batch, const uint256 &hash, int nHeight) {
@@ -281,7 +390,10 @@ namespace llmq {
         db->WriteBatch(batch);
     }
 
-    bool CInstantSendDb::KnownInstantSendLock(const uint256 &islockHash) const {
+    bool CInstantSendDb::KnownInstantSendLock(const uint256 &islockHash, const Batch *batch) const {
+        if (batch && (batch->newLocks.count(islockHash) || batch->archived.count(islockHash))) {
+            return true;
+        }
         LOCK(cs_db);
         return GetInstantSendLockByHashInternal(islockHash) != nullptr ||
                db->Exists(std::make_tuple(std::string(DB_ARCHIVED_BY_HASH), islockHash));
@@ -346,12 +458,28 @@ namespace llmq {
         return islockHash;
     }
 
-    CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByTxid(const uint256 &txid) const {
+    CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByTxid(const uint256 &txid, const Batch *batch) const {
+        if (batch) {
+            auto it = batch->newTxids.find(txid);
+            if (it != batch->newTxids.end()) {
+                return batch->newLocks.at(it->second);
+            }
+        }
         LOCK(cs_db);
-        return GetInstantSendLockByHashInternal(GetInstantSendLockHashByTxidInternal(txid));
+        const uint256 islockHash = GetInstantSendLockHashByTxidInternal(txid);
+        if (batch && batch->archived.count(islockHash)) {
+            return nullptr;
+        }
+        return GetInstantSendLockByHashInternal(islockHash);
     }
 
-    CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByInput(const COutPoint &outpoint) const {
+    CInstantSendLockPtr CInstantSendDb::GetInstantSendLockByInput(const COutPoint &outpoint, const Batch *batch) const {
+        if (batch) {
+            auto it = batch->newOutpoints.find(outpoint);
+            if (it != batch->newOutpoints.end()) {
+                return batch->newLocks.at(it->second);
+            }
+        }
         LOCK(cs_db);
         uint256 islockHash;
         if (!outpointCache.get(outpoint, islockHash)) {
@@ -360,6 +488,9 @@ namespace llmq {
             }
             outpointCache.insert(outpoint, islockHash);
         }
+        if (batch && batch->archived.count(islockHash)) {
+            return nullptr;
+        }
         return GetInstantSendLockByHashInternal(islockHash);
     }
 
@@ -432,14 +563,18 @@ namespace llmq {
         return result;
     }
 
-    void CInstantSendDb::RemoveAndArchiveInstantSendLock(const CInstantSendLockPtr &islock, int nHeight) {
-        LOCK(cs_db);
-
-        CDBBatch batch(*db);
+    void CInstantSendDb::RemoveAndArchiveInstantSendLock(const CInstantSendLockPtr &islock, int nHeight, Batch *batch) {
         const auto hash = ::SerializeHash(*islock);
-        RemoveInstantSendLock(batch, hash, islock, false);
-        WriteInstantSendLockArchived(batch, hash, nHeight);
-        db->WriteBatch(batch);
+        if (batch) {
+            batch->AddArchived(hash, islock, nHeight);
+            return;
+        }
+
+        LOCK(cs_db);
+        CDBBatch dbBatch(*db);
+        RemoveInstantSendLock(dbBatch, hash, islock, false);
+        WriteInstantSendLockArchived(dbBatch, hash, nHeight);
+        db->WriteBatch(dbBatch);
     }
 
 ////////////////
@@ -855,11 +990,46 @@ namespace llmq {
             }
         }
 
+        // Drop locks we know already and locks for TXs which already have a deterministic lock before doing any of
+        // the expensive work. These only show up in the cache lookups of CInstantSendDb in most cases. Locks whose
+        // recovered sig the signing manager doesn't have yet are kept, verifying them hands it a reconstructed one
+        auto llmqType = Params().GetConsensus().llmqTypeInstantSend;
+        cxxtimer::Timer preCheckTimer(true);
+        size_t nDropped = 0;
+        for (auto it = pend.begin(); it != pend.end();) {
+            const auto &islock = it->second.second;
+            if (!quorumSigningManager->HasRecoveredSigForId(llmqType, islock->GetRequestId())) {
+                ++it;
+                continue;
+            }
+            if (db.KnownInstantSendLock(it->first)) {
+                it = pend.erase(it);
+                nDropped++;
+                continue;
+            }
+            const auto sameTxIsLock = db.GetInstantSendLockByTxid(islock->txid);
+            if (sameTxIsLock != nullptr && sameTxIsLock->IsDeterministic()) {
+                LogPrint(BCLog::INSTANTSEND,
+                         "CInstantSendManager::%s -- txid=%s, islock=%s: dropping islock, other islock=%s, peer=%d\n",
+                         __func__, islock->txid.ToString(), it->first.ToString(),
+                         ::SerializeHash(*sameTxIsLock).ToString(), it->second.first);
+                it = pend.erase(it);
+                nDropped++;
+                continue;
+            }
+            ++it;
+        }
+        preCheckTimer.stop();
+
+        if (nDropped != 0) {
+            LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- dropped known locks. count=%d, pt=%d\n", __func__,
+                     nDropped, preCheckTimer.count());
+        }
+
         if (pend.empty()) {
-            return false;
+            return fMoreWork;
         }
 
-        auto llmqType = Params().GetConsensus().llmqTypeInstantSend;
         auto dkgInterval = GetLLMQParams(llmqType).dkgInterval;
 
         // First check against the current active set and don't ban
@@ -887,7 +1057,8 @@ namespace llmq {
                                                                                      bool ban) {
         auto llmqType = Params().GetConsensus().llmqTypeInstantSend;
 
-        CBLSBatchVerifier <NodeId, uint256> batchVerifier(false, true, 8);
+        // sharded by islock and verified in parallel on the BLS worker pool
+        CBLSShardedBatchVerifier <NodeId, uint256> batchVerifier(false, true);
         std::unordered_map <uint256, CRecoveredSig> recSigs;
 
         size_t verifyCount = 0;
@@ -936,7 +1107,7 @@ namespace llmq {
                 return {};
             }
             uint256 signHash = CLLMQUtils::BuildSignHash(llmqType, quorum->qc->quorumHash, id, islock->txid);
-            batchVerifier.PushMessage(nodeId, hash, signHash, islock->sig.Get(), quorum->qc->quorumPublicKey);
+            batchVerifier.PushMessage(signHash, nodeId, hash, signHash, islock->sig.Get(), quorum->qc->quorumPublicKey);
             verifyCount++;
 
             // We can reconstruct the CRecoveredSig objects from the islock and pass it to the signing manager, which
@@ -949,14 +1120,16 @@ namespace llmq {
         }
 
         cxxtimer::Timer verifyTimer(true);
-        batchVerifier.Verify();
+        batchVerifier.Verify(blsWorker);
         verifyTimer.stop();
 
         LogPrint(BCLog::INSTANTSEND,
-                 "CInstantSendManager::%s -- verified locks. count=%d, alreadyVerified=%d, vt=%d, nodes=%d\n", __func__,
-                 verifyCount, alreadyVerified, verifyTimer.count(), batchVerifier.GetUniqueSourceCount());
+                 "CInstantSendManager::%s -- verified locks. count=%d, alreadyVerified=%d, batches=%d, vt=%d, nodes=%d\n",
+                 __func__, verifyCount, alreadyVerified, batchVerifier.GetBatchCount(blsWorker), verifyTimer.count(),
+                 batchVerifier.GetUniqueSourceCount());
 
         std::unordered_set <uint256> badISLocks;
+        std::vector <std::tuple<NodeId, uint256, CInstantSendLockPtr, CTransactionRef>> accepted;
 
         if (ban && !batchVerifier.badSources.empty()) {
             LOCK(cs_main);
@@ -966,6 +1139,9 @@ namespace llmq {
                 Misbehaving(nodeId, 20);
             }
         }
+        // All good locks go to the DB in a single batch, only then they are relayed and announced
+        cxxtimer::Timer writeTimer(true);
+        CInstantSendDb::Batch batch;
         for (const auto &p: pend) {
             auto &hash = p.first;
             auto nodeId = p.second.first;
@@ -979,7 +1155,30 @@ namespace llmq {
                 continue;
             }
 
-            ProcessInstantSendLock(nodeId, hash, islock);
+            CTransactionRef tx;
+            if (PrepareInstantSendLock(nodeId, hash, islock, tx, &batch)) {
+                accepted.emplace_back(nodeId, hash, islock, tx);
+            }
+        }
+        if (!db.CommitBatch(batch)) {
+            // nothing of it is known now, so don't announce it either
+            accepted.clear();
+        }
+        writeTimer.stop();
+
+        cxxtimer::Timer notifyTimer(true);
+        for (const auto &[nodeId, hash, islock, tx]: accepted) {
+            FinishInstantSendLock(nodeId, hash, islock, tx);
+        }
+
+        for (const auto &p: pend) {
+            auto &hash = p.first;
+            auto nodeId = p.second.first;
+            auto &islock = p.second.second;
+
+            if (badISLocks.count(hash)) {
+                continue;
+            }
 
             // See comment further on top. We pass a reconstructed recovered sig to the signing manager to avoid
             // double-verification of the sig.
@@ -995,12 +1194,25 @@ namespace llmq {
                 }
             }
         }
+        notifyTimer.stop();
+
+        LogPrint(BCLog::INSTANTSEND,
+                 "CInstantSendManager::%s -- processed locks. count=%d, bad=%d, accepted=%d, wt=%d, nt=%d\n", __func__,
+                 pend.size(), badISLocks.size(), accepted.size(), writeTimer.count(), notifyTimer.count());
 
         return badISLocks;
     }
 
     void
     CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256 &hash, const CInstantSendLockPtr &islock) {
+        CTransactionRef tx;
+        if (PrepareInstantSendLock(from, hash, islock, tx)) {
+            FinishInstantSendLock(from, hash, islock, tx);
+        }
+    }
+
+    bool CInstantSendManager::PrepareInstantSendLock(NodeId from, const uint256 &hash, const CInstantSendLockPtr &islock,
+                                                     CTransactionRef &tx, CInstantSendDb::Batch *batch) {
         LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: processing islock, peer=%d\n",
                  __func__,
                  islock->txid.ToString(), hash.ToString(), from);
@@ -1009,13 +1221,12 @@ namespace llmq {
             creatingInstantSendLocks.erase(islock->GetRequestId());
             txToCreatingInstantSendLocks.erase(islock->txid);
         }
-        if (db.KnownInstantSendLock(hash)) {
-            return;
+        if (db.KnownInstantSendLock(hash, batch)) {
+            return false;
         }
 
         uint256 hashBlock;
-        CTransactionRef tx = GetTransaction(/* block_index */ nullptr, &mempool, islock->txid, Params().GetConsensus(),
-                                                              hashBlock);
+        tx = GetTransaction(/* block_index */ nullptr, &mempool, islock->txid, Params().GetConsensus(), hashBlock);
         const CBlockIndex *pindexMined{nullptr};
         // we ignore failure here as we must be able to propagate the lock even if we don't have the TX locally
         if (tx && !hashBlock.IsNull()) {
@@ -1030,11 +1241,11 @@ namespace llmq {
                          "CInstantSendManager::%s -- txlock=%s, islock=%s: dropping islock as it already got a ChainLock in block %s, peer=%d\n",
                          __func__,
                          islock->txid.ToString(), hash.ToString(), hashBlock.ToString(), from);
-                return;
+                return false;
             }
         }
 
-        const auto sameTxIsLock = db.GetInstantSendLockByTxid(islock->txid);
+        const auto sameTxIsLock = db.GetInstantSendLockByTxid(islock->txid, batch);
         if (sameTxIsLock != nullptr) {
             if (sameTxIsLock->IsDeterministic() == islock->IsDeterministic()) {
                 // should not happen, investigate
@@ -1044,15 +1255,15 @@ namespace llmq {
             }
             if (sameTxIsLock->IsDeterministic()) {
                 // can happen, nothing to do
-                return;
+                return false;
             } else if (islock->IsDeterministic()) {
                 // can happen, remove and archive the non-deterministic sameTxIsLock
                 db.RemoveAndArchiveInstantSendLock(sameTxIsLock, WITH_LOCK(::cs_main,
-                return ::ChainActive().Height()));
+                return ::ChainActive().Height()), batch);
             }
         } else {
             for (const auto &in: islock->inputs) {
-                const auto sameOutpointIsLock = db.GetInstantSendLockByInput(in);
+                const auto sameOutpointIsLock = db.GetInstantSendLockByInput(in, batch);
                 if (sameOutpointIsLock != nullptr) {
                     LogPrintf(
                             "CInstantSendManager::%s -- txid=%s, islock=%s: conflicting outpoint in islock. input=%s, other islock=%s, peer=%d\n",
@@ -1068,12 +1279,17 @@ namespace llmq {
             LOCK(cs_pendingLocks);
             pendingNoTxInstantSendLocks.try_emplace(hash, std::make_pair(from, islock));
         } else {
-            db.WriteNewInstantSendLock(hash, *islock);
+            db.WriteNewInstantSendLock(hash, *islock, batch);
             if (pindexMined) {
-                db.WriteInstantSendLockMined(hash, pindexMined->nHeight);
+                db.WriteInstantSendLockMined(hash, pindexMined->nHeight, batch);
             }
         }
 
+        return true;
+    }
+
+    void CInstantSendManager::FinishInstantSendLock(NodeId from, const uint256 &hash, const CInstantSendLockPtr &islock,
+                                                    const CTransactionRef &tx) {
         // This will also add children TXs to pendingRetryTxs
         RemoveNonLockedTx(islock->txid, true);
         // We don't need the recovered sigs for the inputs anymore. This prevents unnecessary propagation of these sigs.
@@ -133,20 +133,73 @@ namespace llmq {
 
         EXCLUSIVE_LOCKS_REQUIRED(cs_db);
 
+    protected:
+        /** Writes a batch collected by CommitBatch(), overridden by the unit tests to make it fail */
+        virtual bool WriteCommitBatch(CDBBatch &batch)
+
+        EXCLUSIVE_LOCKS_REQUIRED(cs_db);
+
     public:
+        /**
+         * IS Lock writes collected by one caller and applied together by CommitBatch(). Neither the DB nor the caches
+         * see them before that, lookups which are given the batch see its IS Locks already.
+         */
+        class Batch {
+            friend class CInstantSendDb;
+
+            enum class Op {
+                NEW, MINED, ARCHIVED
+            };
+            struct Entry {
+                Op op;
+                uint256 hash;
+                CInstantSendLockPtr islock;
+                int nHeight;
+            };
+            //! the writes in the order they were made, CommitBatch() replays them
+            std::vector <Entry> entries;
+
+            //! IS Locks written by this batch and not archived by it again
+            std::unordered_map <uint256, CInstantSendLockPtr, StaticSaltedHasher> newLocks;
+            std::unordered_map <uint256, uint256, StaticSaltedHasher> newTxids;
+            std::unordered_map <COutPoint, uint256, SaltedOutpointHasher> newOutpoints;
+            //! IS Locks archived by this batch, they are hidden from lookups but still known
+            std::unordered_set <uint256, StaticSaltedHasher> archived;
+
+            void AddNew(const uint256 &hash, const CInstantSendLock &islock);
+
+            void AddArchived(const uint256 &hash, const CInstantSendLockPtr &islock, int nHeight);
+
+            void Clear();
+
+        public:
+            bool empty() const { return entries.empty(); }
+        };
+
         explicit CInstantSendDb(bool unitTests, bool fWipe) :
                 db(std::make_unique<CDBWrapper>(unitTests ? "" : (GetDataDir() / "llmq/isdb"), 32 << 20, unitTests,
                                                 fWipe)) {}
 
+        virtual ~CInstantSendDb() = default;
+
         void Upgrade()
 
         LOCKS_EXCLUDED(cs_db);
 
-        void WriteNewInstantSendLock(const uint256 &hash, const CInstantSendLock &islock)
+        /**
+         * Writes the batch and only then applies it to the caches, returns false if it couldn't be written. Nothing
+         * of it is applied in that case. The batch is empty afterwards either way.
+         */
+        bool CommitBatch(Batch &batch)
+
+        LOCKS_EXCLUDED(cs_db);
+
+        /** Writes to the DB right away, or into batch if one is given */
+        void WriteNewInstantSendLock(const uint256 &hash, const CInstantSendLock &islock, Batch *batch = nullptr)
 
         LOCKS_EXCLUDED(cs_db);
 
-        void WriteInstantSendLockMined(const uint256 &hash, int nHeight)
+        void WriteInstantSendLockMined(const uint256 &hash, int nHeight, Batch *batch = nullptr)
 
         LOCKS_EXCLUDED(cs_db);
 
@@ -167,7 +220,7 @@ namespace llmq {
 
         LOCKS_EXCLUDED(cs_db);
 
-        bool KnownInstantSendLock(const uint256 &islockHash) const
+        bool KnownInstantSendLock(const uint256 &islockHash, const Batch *batch = nullptr) const
 
         LOCKS_EXCLUDED(cs_db);
 
@@ -191,11 +244,11 @@ namespace llmq {
                 return GetInstantSendLockHashByTxidInternal(txid);
                 };
 
-        CInstantSendLockPtr GetInstantSendLockByTxid(const uint256 &txid) const
+        CInstantSendLockPtr GetInstantSendLockByTxid(const uint256 &txid, const Batch *batch = nullptr) const
 
         LOCKS_EXCLUDED(cs_db);
 
-        CInstantSendLockPtr GetInstantSendLockByInput(const COutPoint &outpoint) const
+        CInstantSendLockPtr GetInstantSendLockByInput(const COutPoint &outpoint, const Batch *batch = nullptr) const
 
         LOCKS_EXCLUDED(cs_db);
 
@@ -203,7 +256,7 @@ namespace llmq {
 
         LOCKS_EXCLUDED(cs_db);
 
-        void RemoveAndArchiveInstantSendLock(const CInstantSendLockPtr &islock, int nHeight)
+        void RemoveAndArchiveInstantSendLock(const CInstantSendLockPtr &islock, int nHeight, Batch *batch = nullptr)
 
         LOCKS_EXCLUDED(cs_db);
     };
@@ -212,6 +265,7 @@ namespace llmq {
     private:
         CInstantSendDb db;
         CConnman &connman;
+        CBLSWorker &blsWorker;
         CTxMemPool &mempool;
 
         std::atomic<bool> fUpgradedDB{false};
@@ -269,8 +323,9 @@ namespace llmq {
         GUARDED_BY(cs_pendingRetry);
 
     public:
-        explicit CInstantSendManager(CTxMemPool &_mempool, CConnman &_connman, bool unitTests, bool fWipe) : db(
-                unitTests, fWipe), mempool(_mempool), connman(_connman) { workInterrupt.reset(); }
+        explicit CInstantSendManager(CTxMemPool &_mempool, CConnman &_connman, CBLSWorker &_blsWorker, bool unitTests,
+                                     bool fWipe) : db(unitTests, fWipe), mempool(_mempool), connman(_connman),
+                                                   blsWorker(_blsWorker) { workInterrupt.reset(); }
 
         ~CInstantSendManager() = default;
 
@@ -322,6 +377,22 @@ namespace llmq {
         LOCKS_EXCLUDED(cs_creating, cs_pendingLocks
         );
 
+        /**
+         * First half of ProcessInstantSendLock: checks a verified IS Lock against the known ones and writes it to the
+         * DB, or to batch if one is given. Returns false if the lock is not needed.
+         */
+        bool PrepareInstantSendLock(NodeId from, const uint256 &hash, const CInstantSendLockPtr &islock,
+                                    CTransactionRef &tx, CInstantSendDb::Batch *batch = nullptr)
+
+        LOCKS_EXCLUDED(cs_creating, cs_pendingLocks
+        );
+
+        /** Second half of ProcessInstantSendLock, run once the IS Lock is written: relays and notifies about it. */
+        void FinishInstantSendLock(NodeId from, const uint256 &hash, const CInstantSendLockPtr &islock,
+                                   const CTransactionRef &tx)
+
+        LOCKS_EXCLUDED(cs_pendingLocks);
+
         void AddNonLockedTx(const CTransactionRef &tx, const CBlockIndex *pindexMined)
 
         LOCKS_EXCLUDED(cs_pendingLocks, cs_nonLocked
@@ -228,8 +228,49 @@ namespace llmq {
         LogPrintf("CRecoveredSigsDb::%d -- done\n", __func__);
     }
 
+    void CRecoveredSigsDb::PendingWrites::Add(const CRecoveredSig &recSig, uint32_t writeTime) {
+        auto id = std::make_pair(recSig.getLlmqType(), recSig.getId());
+        byId.erase(id);
+        byId.emplace(std::piecewise_construct, std::forward_as_tuple(id), std::forward_as_tuple(recSig, writeTime));
+        byHash.emplace(recSig.GetHash(), id);
+        bySignHash.emplace(recSig.buildSignHash());
+    }
+
+    void CRecoveredSigsDb::PendingWrites::Clear() {
+        byId.clear();
+        byHash.clear();
+        bySignHash.clear();
+    }
+
+    CRecoveredSigsDb::~CRecoveredSigsDb() {
+        FlushPendingWrites();
+    }
+
+    const std::pair<CRecoveredSig, uint32_t> *
+    CRecoveredSigsDb::FindPendingWrite(Consensus::LLMQType llmqType, const uint256 &id) const {
+        AssertLockHeld(cs);
+
+        auto k = std::make_pair(llmqType, id);
+        auto it = pendingWrites.byId.find(k);
+        if (it != pendingWrites.byId.end()) {
+            return &it->second;
+        }
+        it = flushingWrites.byId.find(k);
+        if (it != flushingWrites.byId.end()) {
+            return &it->second;
+        }
+        return nullptr;
+    }
+
     bool
     CRecoveredSigsDb::HasRecoveredSig(Consensus::LLMQType llmqType, const uint256 &id, const uint256 &msgHash) const {
+        {
+            LOCK(cs);
+            if (const auto *p = FindPendingWrite(llmqType, id)) {
+                return p->first.getMsgHash() == msgHash;
+            }
+        }
+
         auto k = std::make_tuple(std::string("rs_r"), llmqType, id, msgHash);
         return db->Exists(k);
     }
@@ -242,6 +283,10 @@ namespace llmq {
             if (hasSigForIdCache.get(cacheKey, ret)) {
                 return ret;
             }
+            if (FindPendingWrite(llmqType, id) != nullptr) {
+                hasSigForIdCache.insert(cacheKey, true);
+                return true;
+            }
         }
 
 
@@ -260,6 +305,10 @@ namespace llmq {
             if (hasSigForSessionCache.get(signHash, ret)) {
                 return ret;
             }
+            if (pendingWrites.bySignHash.count(signHash) || flushingWrites.bySignHash.count(signHash)) {
+                hasSigForSessionCache.insert(signHash, true);
+                return true;
+            }
         }
 
         auto k = std::make_tuple(std::string("rs_s"), signHash);
@@ -277,6 +326,10 @@ namespace llmq {
             if (hasSigForHashCache.get(hash, ret)) {
                 return ret;
             }
+            if (pendingWrites.byHash.count(hash) || flushingWrites.byHash.count(hash)) {
+                hasSigForHashCache.insert(hash, true);
+                return true;
+            }
         }
 
         auto k = std::make_tuple(std::string("rs_h"), hash);
@@ -288,10 +341,18 @@ namespace llmq {
     }
 
     bool CRecoveredSigsDb::ReadRecoveredSig(Consensus::LLMQType llmqType, const uint256 &id, CRecoveredSig &ret) const {
-        auto k = std::make_tuple(std::string("rs_r"), llmqType, id);
-
         CDataStream ds(SER_DISK, CLIENT_VERSION);
-        if (!db->ReadDataStream(k, ds)) {
+        bool fPending = false;
+        {
+            LOCK(cs);
+            if (const auto *p = FindPendingWrite(llmqType, id)) {
+                ds << p->first;
+                fPending = true;
+            }
+        }
+
+        auto k = std::make_tuple(std::string("rs_r"), llmqType, id);
+        if (!fPending && !db->ReadDataStream(k, ds)) {
             return false;
         }
 
@@ -304,9 +365,22 @@ namespace llmq {
     }
 
     bool CRecoveredSigsDb::GetRecoveredSigByHash(const uint256 &hash, CRecoveredSig &ret) const {
-        auto k1 = std::make_tuple(std::string("rs_h"), hash);
         std::pair <Consensus::LLMQType, uint256> k2;
-        if (!db->Read(k1, k2)) {
+        bool fPending = false;
+        {
+            LOCK(cs);
+            for (const auto *w : {&pendingWrites, &flushingWrites}) {
+                auto it = w->byHash.find(hash);
+                if (it != w->byHash.end()) {
+                    k2 = it->second;
+                    fPending = true;
+                    break;
+                }
+            }
+        }
+
+        auto k1 = std::make_tuple(std::string("rs_h"), hash);
+        if (!fPending && !db->Read(k1, k2)) {
             return false;
         }
 
@@ -319,40 +393,72 @@ namespace llmq {
     }
 
     void CRecoveredSigsDb::WriteRecoveredSig(const llmq::CRecoveredSig &recSig) {
-        CDBBatch batch(*db);
-
-        uint32_t curTime = GetAdjustedTime();
-
-        // we put these close to each other to leverage leveldb's key compaction
-        // this way, the second key can be used for fast HasRecoveredSig checks while the first key stores the recSig
-        auto k1 = std::make_tuple(std::string("rs_r"), recSig.getLlmqType(), recSig.getId());
-        auto k2 = std::make_tuple(std::string("rs_r"), recSig.getLlmqType(), recSig.getId(), recSig.getMsgHash());
-        batch.Write(k1, recSig);
-        // this key is also used to store the current time, so that we can easily get to the "rs_t" key when we have the id
-        batch.Write(k2, curTime);
+        size_t pendingCount;
+        {
+            LOCK(cs);
+            pendingWrites.Add(recSig, GetAdjustedTime());
+            pendingCount = pendingWrites.byId.size();
 
-        // store by object hash
-        auto k3 = std::make_tuple(std::string("rs_h"), recSig.GetHash());
-        batch.Write(k3, std::make_pair(recSig.getLlmqType(), recSig.getId()));
+            hasSigForIdCache.insert(std::make_pair(recSig.getLlmqType(), recSig.getId()), true);
+            hasSigForSessionCache.insert(recSig.buildSignHash(), true);
+            hasSigForHashCache.insert(recSig.GetHash(), true);
+        }
 
-        // store by signHash
-        auto signHash = recSig.buildSignHash();
-        auto k4 = std::make_tuple(std::string("rs_s"), signHash);
-        batch.Write(k4, (uint8_t) 1);
+        if (pendingCount >= MAX_PENDING_WRITES) {
+            FlushPendingWrites();
+        }
+    }
 
-        // store by current time. Allows fast cleanup of old recSigs
-        auto k5 = std::make_tuple(std::string("rs_t"), (uint32_t) htobe32(curTime), recSig.getLlmqType(),
-                                  recSig.getId());
-        batch.Write(k5, (uint8_t) 1);
-
-        db->WriteBatch(batch);
+    void CRecoveredSigsDb::FlushPendingWrites() {
+        LOCK(cs_flush);
 
+        CDBBatch batch(*db);
         {
             LOCK(cs);
-            hasSigForIdCache.insert(std::make_pair(recSig.getLlmqType(), recSig.getId()), true);
-            hasSigForSessionCache.insert(signHash, true);
-            hasSigForHashCache.insert(recSig.GetHash(), true);
+            if (pendingWrites.Empty()) {
+                return;
+            }
+            std::swap(pendingWrites, flushingWrites);
+
+            for (const auto &p: flushingWrites.byId) {
+                const CRecoveredSig &recSig = p.second.first;
+                const uint32_t writeTime = p.second.second;
+                const uint256 signHash = recSig.buildSignHash();
+
+                // we put these close to each other to leverage leveldb's key compaction
+                // this way, the second key can be used for fast HasRecoveredSig checks while the first key stores the recSig
+                auto k1 = std::make_tuple(std::string("rs_r"), recSig.getLlmqType(), recSig.getId());
+                auto k2 = std::make_tuple(std::string("rs_r"), recSig.getLlmqType(), recSig.getId(), recSig.getMsgHash());
+                batch.Write(k1, recSig);
+                // this key is also used to store the write time, so that we can easily get to the "rs_t" key when we have the id
+                batch.Write(k2, writeTime);
+
+                // store by object hash
+                auto k3 = std::make_tuple(std::string("rs_h"), recSig.GetHash());
+                batch.Write(k3, std::make_pair(recSig.getLlmqType(), recSig.getId()));
+
+                // store by signHash
+                auto k4 = std::make_tuple(std::string("rs_s"), signHash);
+                batch.Write(k4, (uint8_t) 1);
+
+                // store by write time. Allows fast cleanup of old recSigs. The value carries the remaining parts of
+                // the index keys, so that cleanup does not have to read the recSig itself
+                auto k5 = std::make_tuple(std::string("rs_t"), (uint32_t) htobe32(writeTime), recSig.getLlmqType(),
+                                          recSig.getId());
+                batch.Write(k5, std::make_tuple(recSig.getMsgHash(), recSig.GetHash(), signHash));
+            }
         }
+
+        // flushingWrites stays visible to lookups until the batch is in the db
+        db->WriteBatch(batch);
+
+        LOCK(cs);
+        flushingWrites.Clear();
+    }
+
+    size_t CRecoveredSigsDb::GetPendingWriteCount() const {
+        LOCK(cs);
+        return pendingWrites.byId.size() + flushingWrites.byId.size();
     }
 
     void CRecoveredSigsDb::RemoveRecoveredSig(CDBBatch &batch, Consensus::LLMQType llmqType, const uint256 &id,
@@ -398,6 +504,8 @@ namespace llmq {
 
 // Completely remove any traces of the recovered sig
     void CRecoveredSigsDb::RemoveRecoveredSig(Consensus::LLMQType llmqType, const uint256 &id) {
+        FlushPendingWrites();
+
         LOCK(cs);
         CDBBatch batch(*db);
         RemoveRecoveredSig(batch, llmqType, id, true, true);
@@ -407,6 +515,8 @@ namespace llmq {
 // Remove the recovered sig itself and all keys required to get from id -> recSig
 // This will leave the byHash key in-place so that HasRecoveredSigForHash still returns true
     void CRecoveredSigsDb::TruncateRecoveredSig(Consensus::LLMQType llmqType, const uint256 &id) {
+        FlushPendingWrites();
+
         LOCK(cs);
         CDBBatch batch(*db);
         RemoveRecoveredSig(batch, llmqType, id, false, false);
@@ -414,14 +524,53 @@ namespace llmq {
     }
 
     void CRecoveredSigsDb::CleanupOldRecoveredSigs(int64_t maxAge) {
+        // Only whole buckets are deleted, so that expired recSigs are erased in one pass per bucket instead of a
+        // handful on every call. The recSigs of a bucket live at most one bucket longer than maxAge.
+        const int64_t bucketSize = std::max<int64_t>(1, std::min<int64_t>(CLEANUP_BUCKET_SECONDS, maxAge));
+        const uint32_t endTime = (uint32_t) ((GetAdjustedTime() - maxAge) / bucketSize * bucketSize);
+
+        uint32_t startTime;
+        {
+            LOCK(cs);
+            if (endTime <= lastCleanupEndTime) {
+                return;
+            }
+            startTime = lastCleanupEndTime;
+        }
+
         std::unique_ptr <CDBIterator> pcursor(db->NewIterator());
 
-        auto start = std::make_tuple(std::string("rs_t"), (uint32_t) 0, (Consensus::LLMQType) 0, uint256());
-        uint32_t endTime = (uint32_t)(GetAdjustedTime() - maxAge);
+        // start where the previous cleanup stopped, so we don't have to skip over the tombstones it left behind
+        auto start = std::make_tuple(std::string("rs_t"), (uint32_t) htobe32(startTime), (Consensus::LLMQType) 0,
+                                     uint256());
         pcursor->Seek(start);
 
-        std::vector <std::pair<Consensus::LLMQType, uint256>> toDelete;
-        std::vector < decltype(start) > toDelete2;
+        CDBBatch batch(*db);
+        std::vector <std::pair<Consensus::LLMQType, uint256>> erasedIds;
+        std::vector <uint256> erasedHashes;
+        std::vector <uint256> erasedSignHashes;
+        // written before the "rs_t" key carried the index keys, these still need a lookup of the recSig
+        std::vector <std::pair<Consensus::LLMQType, uint256>> legacy;
+        size_t cnt = 0;
+
+        auto writeBatch = [&]() {
+            db->WriteBatch(batch);
+            batch.Clear();
+
+            LOCK(cs);
+            for (const auto &e: erasedIds) {
+                hasSigForIdCache.erase(e);
+            }
+            for (const auto &h: erasedHashes) {
+                hasSigForHashCache.erase(h);
+            }
+            for (const auto &h: erasedSignHashes) {
+                hasSigForSessionCache.erase(h);
+            }
+            erasedIds.clear();
+            erasedHashes.clear();
+            erasedSignHashes.clear();
+        };
 
         while (pcursor->Valid()) {
             decltype(start)
@@ -434,37 +583,51 @@ namespace llmq {
                 break;
             }
 
-            toDelete.emplace_back(std::get<2>(k), std::get<3>(k));
-            toDelete2.emplace_back(k);
+            const Consensus::LLMQType llmqType = std::get<2>(k);
+            const uint256 &id = std::get<3>(k);
+
+            std::tuple <uint256, uint256, uint256> v;
+            if (pcursor->GetValueSize() == sizeof(uint8_t) || !pcursor->GetValue(v)) {
+                legacy.emplace_back(llmqType, id);
+            } else {
+                const uint256 &msgHash = std::get<0>(v);
+                const uint256 &hash = std::get<1>(v);
+                const uint256 &signHash = std::get<2>(v);
+                batch.Erase(std::make_tuple(std::string("rs_r"), llmqType, id));
+                batch.Erase(std::make_tuple(std::string("rs_r"), llmqType, id, msgHash));
+                batch.Erase(std::make_tuple(std::string("rs_h"), hash));
+                batch.Erase(std::make_tuple(std::string("rs_s"), signHash));
+                erasedIds.emplace_back(llmqType, id);
+                erasedHashes.emplace_back(hash);
+                erasedSignHashes.emplace_back(signHash);
+            }
+            batch.Erase(k);
+            cnt++;
+
+            if (batch.SizeEstimate() >= (1 << 24)) {
+                writeBatch();
+            }
 
             pcursor->Next();
         }
         pcursor.reset();
 
-        if (toDelete.empty()) {
-            return;
-        }
-
-        CDBBatch batch(*db);
-        {
+        if (!legacy.empty()) {
             LOCK(cs);
-            for (const auto &e: toDelete) {
+            for (const auto &e: legacy) {
                 RemoveRecoveredSig(batch, e.first, e.second, true, false);
-
-                if (batch.SizeEstimate() >= (1 << 24)) {
-                    db->WriteBatch(batch);
-                    batch.Clear();
-                }
             }
         }
+        writeBatch();
 
-        for (const auto &e: toDelete2) {
-            batch.Erase(e);
+        {
+            LOCK(cs);
+            lastCleanupEndTime = endTime;
         }
 
-        db->WriteBatch(batch);
-
-        LogPrint(BCLog::LLMQ, "CRecoveredSigsDb::%d -- deleted %d entries\n", __func__, toDelete.size());
+        if (cnt != 0) {
+            LogPrint(BCLog::LLMQ, "CRecoveredSigsDb::%d -- deleted %d entries\n", __func__, cnt);
+        }
     }
 
     bool CRecoveredSigsDb::HasVotedOnId(Consensus::LLMQType llmqType, const uint256 &id) const {
@@ -531,8 +694,8 @@ namespace llmq {
 
 //////////////////
 
-    CSigningManager::CSigningManager(CConnman &_connman, bool fMemory, bool fWipe) :
-            db(fMemory, fWipe), connman(_connman) {
+    CSigningManager::CSigningManager(CConnman &_connman, CBLSWorker &_blsWorker, bool fMemory, bool fWipe) :
+            db(fMemory, fWipe), connman(_connman), blsWorker(_blsWorker) {
     }
 
     bool CSigningManager::AlreadyHave(const CInv &inv) const {
@@ -721,8 +884,9 @@ namespace llmq {
         }
 
         // It's ok to perform insecure batched verification here as we verify against the quorum public keys, which are not
-        // craftable by individual entities, making the rogue public key attack impossible
-        CBLSBatchVerifier <NodeId, uint256> batchVerifier(false, false);
+        // craftable by individual entities, making the rogue public key attack impossible.
+        // Recovered sigs are sharded by signing session and verified in parallel on the BLS worker pool
+        CBLSShardedBatchVerifier <NodeId, uint256> batchVerifier(false, false);
 
         size_t verifyCount = 0;
         for (const auto &p: recSigsByNode) {
@@ -737,18 +901,20 @@ namespace llmq {
                 }
 
                 const auto &quorum = quorums.at(std::make_pair(recSig->getLlmqType(), recSig->getQuorumHash()));
-                batchVerifier.PushMessage(nodeId, recSig->GetHash(), recSig->buildSignHash(), recSig->sig.Get(),
+                const uint256 signHash = recSig->buildSignHash();
+                batchVerifier.PushMessage(signHash, nodeId, recSig->GetHash(), signHash, recSig->sig.Get(),
                                           quorum->qc->quorumPublicKey);
                 verifyCount++;
             }
         }
 
         cxxtimer::Timer verifyTimer(true);
-        batchVerifier.Verify();
+        batchVerifier.Verify(blsWorker);
         verifyTimer.stop();
 
-        LogPrint(BCLog::LLMQ, "CSigningManager::%s -- verified recovered sig(s). count=%d, vt=%d, nodes=%d\n", __func__,
-                 verifyCount, verifyTimer.count(), recSigsByNode.size());
+        LogPrint(BCLog::LLMQ, "CSigningManager::%s -- verified recovered sig(s). count=%d, batches=%d, vt=%d, nodes=%d\n",
+                 __func__, verifyCount, batchVerifier.GetBatchCount(blsWorker), verifyTimer.count(),
+                 recSigsByNode.size());
 
         std::unordered_set <uint256, StaticSaltedHasher> processed;
         for (const auto &p: recSigsByNode) {
@@ -853,6 +1019,10 @@ namespace llmq {
 
     void CSigningManager::Cleanup() {
         int64_t now = GetTimeMillis();
+        if (now - lastWriteFlushTime >= 1000) {
+            db.FlushPendingWrites();
+            lastWriteFlushTime = now;
+        }
         if (now - lastCleanupTime < 5000) {
             return;
         }
@@ -19,9 +19,12 @@
 #include <evo/evodb.h>
 
 #include <unordered_map>
+#include <unordered_set>
 
 using NodeId = int64_t;
 
+class CBLSWorker;
+
 class CConnman;
 
 class CInv;
@@ -120,7 +123,27 @@ namespace llmq {
     };
 
     class CRecoveredSigsDb {
+    public:
+        // WriteRecoveredSig() flushes inline once this many recovered sigs are queued
+        static const size_t MAX_PENDING_WRITES = 1000;
+        // CleanupOldRecoveredSigs() only deletes whole buckets of this many seconds (or maxAge, if smaller)
+        static const int64_t CLEANUP_BUCKET_SECONDS = 60 * 60;
+
     private:
+        // Recovered sigs which are queued for the next FlushPendingWrites() call. Lookups check these before going
+        // to the db so that callers always see their own writes.
+        struct PendingWrites {
+            std::unordered_map<std::pair<Consensus::LLMQType, uint256>, std::pair<CRecoveredSig, uint32_t>, StaticSaltedHasher> byId;
+            std::unordered_map<uint256, std::pair<Consensus::LLMQType, uint256>, StaticSaltedHasher> byHash;
+            std::unordered_set<uint256, StaticSaltedHasher> bySignHash;
+
+            void Add(const CRecoveredSig &recSig, uint32_t writeTime);
+
+            void Clear();
+
+            bool Empty() const { return byId.empty(); }
+        };
+
         std::unique_ptr <CDBWrapper> db{nullptr};
 
         mutable RecursiveMutex cs;
@@ -131,6 +154,15 @@ namespace llmq {
         mutable unordered_lru_cache<uint256, bool, StaticSaltedHasher, 30000> hasSigForHashCache
         GUARDED_BY(cs);
 
+        PendingWrites pendingWrites GUARDED_BY(cs);
+        // the writes FlushPendingWrites() is currently committing, still visible to lookups until the batch is written
+        PendingWrites flushingWrites GUARDED_BY(cs);
+        // serializes FlushPendingWrites()
+        Mutex cs_flush;
+
+        // all "rs_t" keys older than this have been deleted already
+        uint32_t lastCleanupEndTime GUARDED_BY(cs){0};
+
     public:
         explicit CRecoveredSigsDb(bool fMemory, bool fWipe) :
                 db(std::make_unique<CDBWrapper>(fMemory ? "" : (GetDataDir() / "llmq/recsigdb"), 8 << 20, fMemory,
@@ -138,6 +170,8 @@ namespace llmq {
             MigrateRecoveredSigs();
         }
 
+        ~CRecoveredSigsDb();
+
         bool HasRecoveredSig(Consensus::LLMQType llmqType, const uint256 &id, const uint256 &msgHash) const;
 
         bool HasRecoveredSigForId(Consensus::LLMQType llmqType, const uint256 &id) const;
@@ -150,8 +184,14 @@ namespace llmq {
 
         bool GetRecoveredSigById(Consensus::LLMQType llmqType, const uint256 &id, CRecoveredSig &ret) const;
 
+        // queues the recovered sig, it is written to disk by the next FlushPendingWrites()
         void WriteRecoveredSig(const CRecoveredSig &recSig);
 
+        // writes all queued recovered sigs in a single batch
+        void FlushPendingWrites();
+
+        size_t GetPendingWriteCount() const;
+
         void RemoveRecoveredSig(Consensus::LLMQType llmqType, const uint256 &id);
 
         void TruncateRecoveredSig(Consensus::LLMQType llmqType, const uint256 &id);
@@ -172,6 +212,10 @@ namespace llmq {
 
         bool ReadRecoveredSig(Consensus::LLMQType llmqType, const uint256 &id, CRecoveredSig &ret) const;
 
+        const std::pair<CRecoveredSig, uint32_t> *FindPendingWrite(Consensus::LLMQType llmqType, const uint256 &id) const
+
+        EXCLUSIVE_LOCKS_REQUIRED(cs);
+
         void RemoveRecoveredSig(CDBBatch &batch, Consensus::LLMQType llmqType, const uint256 &id, bool deleteHashKey,
                                 bool deleteTimeKey)
 
@@ -197,6 +241,7 @@ namespace llmq {
         mutable RecursiveMutex cs;
 
         CConnman &connman;
+        CBLSWorker &blsWorker;
         CRecoveredSigsDb db;
 
         // Incoming and not verified yet
@@ -210,12 +255,13 @@ namespace llmq {
         GUARDED_BY(cs);
 
         int64_t lastCleanupTime{0};
+        int64_t lastWriteFlushTime{0};
 
         std::vector<CRecoveredSigsListener *> recoveredSigsListeners
         GUARDED_BY(cs);
 
     public:
-        CSigningManager(CConnman &_connman, bool fMemory, bool fWipe);
+        CSigningManager(CConnman &_connman, CBLSWorker &_blsWorker, bool fMemory, bool fWipe);
 
         bool AlreadyHave(const CInv &inv) const;
 
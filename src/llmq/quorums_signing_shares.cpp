@@ -615,8 +615,9 @@ namespace llmq {
         }
 
         // It's ok to perform insecure batched verification here as we verify against the quorum public key shares,
-        // which are not craftable by individual entities, making the rogue public key attack impossible
-        CBLSBatchVerifier <NodeId, SigShareKey> batchVerifier(false, true);
+        // which are not craftable by individual entities, making the rogue public key attack impossible.
+        // Shares are sharded by signing session and verified in parallel on the BLS worker pool
+        CBLSShardedBatchVerifier <NodeId, SigShareKey> batchVerifier(false, true);
 
         cxxtimer::Timer prepareTimer(true);
         size_t verifyCount = 0;
@@ -645,19 +646,21 @@ namespace llmq {
                     assert(false);
                 }
 
-                batchVerifier.PushMessage(nodeId, sigShare.GetKey(), sigShare.GetSignHash(), sigShare.sigShare.Get(),
-                                          pubKeyShare);
+                batchVerifier.PushMessage(sigShare.GetSignHash(), nodeId, sigShare.GetKey(), sigShare.GetSignHash(),
+                                          sigShare.sigShare.Get(), pubKeyShare);
                 verifyCount++;
             }
         }
         prepareTimer.stop();
 
         cxxtimer::Timer verifyTimer(true);
-        batchVerifier.Verify();
+        batchVerifier.Verify(blsWorker);
         verifyTimer.stop();
 
-        LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- verified sig shares. count=%d, pt=%d, vt=%d, nodes=%d\n",
-                 __func__, verifyCount, prepareTimer.count(), verifyTimer.count(), sigSharesByNodes.size());
+        LogPrint(BCLog::LLMQ_SIGS,
+                 "CSigSharesManager::%s -- verified sig shares. count=%d, batches=%d, pt=%d, vt=%d, nodes=%d\n",
+                 __func__, verifyCount, batchVerifier.GetBatchCount(blsWorker), prepareTimer.count(),
+                 verifyTimer.count(), sigSharesByNodes.size());
 
         for (const auto &[nodeId, v]: sigSharesByNodes) {
             if (batchVerifier.badSources.count(nodeId)) {
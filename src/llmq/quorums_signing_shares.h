@@ -407,11 +407,12 @@ private:
     GUARDED_BY(cs);
 
     CConnman &connman;
+    CBLSWorker &blsWorker;
     int64_t lastCleanupTime{0};
     std::atomic <uint32_t> recoveredSigsCounter{0};
 
 public:
-    explicit CSigSharesManager(CConnman &_connman) : connman(_connman) {
+    CSigSharesManager(CConnman &_connman, CBLSWorker &_blsWorker) : connman(_connman), blsWorker(_blsWorker) {
         workInterrupt.reset();
     };
 
@@ -46,6 +46,7 @@
 
 #include <boost/thread.hpp>
 #include <algorithm>
+#include <array>
 #include <memory>
 #include <utility>
 
@@ -2055,11 +2056,10 @@ void static FortuneblockMiner(const CChainParams& chainparams, NodeContext& node
                 return;
             }
             CBlock *pblock = &pblocktemplate->block;
-            HashSelection hashSelection(pblock->hashPrevBlock, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10},
-                                        {0, 1, 2, 3, 4, 5});
+            const GhostRiderSchedule schedule(pblock->hashPrevBlock);
             alsoHashString.clear();
-            alsoHashString.append(hashSelection.getHashSelectionString());
-            LogPrintf("Algos: %s\n", hashSelection.getHashSelectionString());
+            alsoHashString.append(schedule.ToString());
+            LogPrintf("Algos: %s\n", alsoHashString);
             IncrementExtraNonce(pblock, pindexPrev, nExtraNonce);
 
             LogPrintf("FortuneblockMiner -- Running miner with %u transactions in block (%u bytes)\n", pblock->vtx.size(),
@@ -2072,8 +2072,16 @@ void static FortuneblockMiner(const CChainParams& chainparams, NodeContext& node
             arith_uint256 hashTarget = arith_uint256().SetCompact(pblock->nBits);
             while (true) {
                 uint256 hash;
+                // Nonces are hashed MINER_HASH_BATCH at a time, the batch is dropped whenever we leave the inner loop
+                // because the header may change (nTime, nNonce) before we return to it
+                std::array<uint256, MINER_HASH_BATCH> hashBatch;
+                size_t batchPos = hashBatch.size();
                 while (true) {
-                    hash = pblock->ComputeHash();
+                    if (batchPos == hashBatch.size()) {
+                        pblock->ComputeHashes(schedule, hashBatch.data(), hashBatch.size());
+                        batchPos = 0;
+                    }
+                    hash = hashBatch[batchPos++];
                     if (UintToArith256(hash) <= hashTarget) {
                         // Found a solution
                         SetThreadPriority(THREAD_PRIORITY_NORMAL);
@@ -27,6 +27,8 @@ class CScript;
 namespace Consensus { struct Params; };
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Number of consecutive nonces the internal miner hashes in one HashFortuneBatch call */
+static const size_t MINER_HASH_BATCH = 4;
 
 struct CBlockTemplate {
     CBlock block;
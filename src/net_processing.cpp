@@ -1987,6 +1987,9 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, ChainstateMan
         }
     }
 
+    // Hash the whole batch in parallel before ProcessNewBlockHeaders checks the PoW one header at a time under cs_main
+    PrecomputeHeadersPoW(headers);
+
     CValidationState state;
     CBlockHeader first_invalid_header;
     if (!chainman.ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast, &first_invalid_header)) {
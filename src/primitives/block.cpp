@@ -26,29 +26,24 @@ uint256 CBlockHeader::ComputeHash() const {
     return HashFortune(BEGIN(nVersion), END(nNonce), hashPrevBlock);
 }
 
-uint256 CBlockHeader::GetPOWHash(bool readCache) const {
-    LOCK(cs_pow);
-    CPowCache &cache(CPowCache::Instance());
-
-    uint256 headerHash = GetHash();
-    uint256 powHash;
-    bool found = false;
+uint256 CBlockHeader::ComputeHash(const GhostRiderSchedule &schedule) const {
+    return HashFortune(BEGIN(nVersion), END(nNonce), schedule);
+}
 
-    if (readCache) {
-        found = cache.get(headerHash, powHash);
+void CBlockHeader::ComputeHashes(const GhostRiderSchedule &schedule, uint256 *hashes, size_t count) const {
+    const size_t headerLen = END(nNonce) - BEGIN(nVersion);
+    std::vector<unsigned char> headers(headerLen * count);
+    for (size_t i = 0; i < count; ++i) {
+        unsigned char *header = &headers[i * headerLen];
+        const uint32_t nonce = nNonce + i;
+        memcpy(header, BEGIN(nVersion), headerLen);
+        memcpy(header + headerLen - sizeof(nonce), &nonce, sizeof(nonce));
     }
+    HashFortuneBatch(headers.data(), headerLen, count, schedule, hashes);
+}
 
-    if (!found || cache.IsValidate()) {
-        uint256 powHash2 = ComputeHash();
-        if (found && powHash2 != powHash) {
-            LogPrintf("PowCache failure: headerHash: %s, from cache: %s, computed: %s, correcting\n",
-                      headerHash.ToString(), powHash.ToString(), powHash2.ToString());
-        }
-        powHash = powHash2;
-        cache.erase(headerHash); // If it exists, replace it
-        cache.insert(headerHash, powHash2);
-    }
-    return powHash;
+uint256 CBlockHeader::GetPOWHash(bool readCache) const {
+    return CPowCache::Instance().GetOrCompute(GetHash(), [this] { return ComputeHash(); }, readCache);
 }
 
 std::string CBlock::ToString() const {
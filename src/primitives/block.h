@@ -20,6 +20,8 @@
  * in the block is a special one that creates a new coin owned by the creator
  * of the block.
  */
+class GhostRiderSchedule;
+
 class CBlockHeader {
 public:
     // header
@@ -57,6 +59,12 @@ public:
     /// Compute the POW hash using GhostRider algorithm
     uint256 ComputeHash() const;
 
+    /// Compute the POW hash reusing a schedule derived from hashPrevBlock, e.g. when trying many nonces
+    uint256 ComputeHash(const GhostRiderSchedule &schedule) const;
+
+    /// Compute the POW hashes of this header with nonces nNonce .. nNonce + count - 1 in one batch
+    void ComputeHashes(const GhostRiderSchedule &schedule, uint256 *hashes, size_t count) const;
+
     /// Caching lookup/computation of POW hash using GhostRider algorithm
     uint256 GetPOWHash(bool readCache = true) const;
 
@@ -1,58 +1,211 @@
 // Copyright (c) 2022-2023 The Raptoreum developers
+// Copyright (c) 2024 The FortuneBlock developers
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <primitives/powcache.h>
 #include <primitives/block.h>
-#include <flat-database.h>
 #include <hash.h>
 #include <sync.h>
 #include <util/system.h>
 
-RecursiveMutex cs_pow;
-
-CPowCache *CPowCache::instance = nullptr;
+#include <algorithm>
 
 CPowCache &CPowCache::Instance() {
-    if (CPowCache::instance == nullptr) {
+    static CPowCache instance([] {
         int powCacheSize = gArgs.GetArg("-powcachesize", DEFAULT_POW_CACHE_SIZE);
-        bool powCacheValidate = gArgs.GetArg("-powcachevalidate", 0) > 0;
-        int maxLoadSize = gArgs.GetArg("-powmaxloadsize", DEFAULT_MAX_LOAD_SIZE);
+        return powCacheSize == 0 ? DEFAULT_POW_CACHE_SIZE : powCacheSize;
+    }(), gArgs.GetArg("-powcachevalidate", 0) > 0, gArgs.GetArg("-powmaxloadsize", DEFAULT_MAX_LOAD_SIZE),
+       std::max<int64_t>(1, gArgs.GetArg("-powcachestoresize", DEFAULT_POW_CACHE_STORE_SIZE)));
+    return instance;
+}
 
-        powCacheSize = powCacheSize == 0 ? DEFAULT_POW_CACHE_SIZE : powCacheSize;
+void CPowCache::DoMaintenance() {
+    if (!store) return;
+    // Append new hashes once enough have been computed, existing segments are never rewritten
+    if (store->PendingSize() >= nMaxLoadSize) {
+        store->Flush();
+    }
+    if (store->CompactableCount() > CPowCacheStore::MAX_SEGMENTS) {
+        store->Compact();
+    }
+    // rotate out the oldest hashes, the block index keeps the PoW hash of every connected block anyway
+    store->Prune(nMaxStoreSize);
+}
 
-        CPowCache::instance = new CPowCache(powCacheSize, powCacheValidate, maxLoadSize);
+CPowCache::CPowCache(int maxSize, bool validate, int maxLoadSize, uint64_t maxStoreSize)
+        : nVersion(CURRENT_VERSION),
+          nMaxLoadSize(maxLoadSize),
+          nMaxStoreSize(maxStoreSize),
+          bValidate(validate) {
+    const size_t shardSize = std::max<size_t>(1, (maxSize + SHARD_COUNT - 1) / SHARD_COUNT);
+    shards.reserve(SHARD_COUNT);
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        shards.emplace_back(std::make_unique<Shard>(shardSize));
     }
-    return *instance;
+    if (bValidate) LogPrintf("PowCache: Validation and auto correction enabled\n");
 }
 
-void CPowCache::DoMaintenance() {
-    LOCK(cs_pow);
-    // If cache has grown enough, save it:
-    if (cacheMap.size() - nLoadedSize > nMaxLoadSize) {
-        CFlatDB <CPowCache> flatDb("powcache.dat", "powCache");
-        flatDb.Dump(*this);
+CPowCache::~CPowCache() {
+}
+
+bool CPowCache::Open(const fs::path &dir) {
+    store = std::make_unique<CPowCacheStore>(dir);
+    if (!store->Open()) {
+        store.reset();
+        return false;
     }
+    return true;
 }
 
-CPowCache::CPowCache(int maxSize, bool validate, int maxLoadSize)
-        : unordered_lru_cache<uint256, uint256, std::hash < uint256>>
+bool CPowCache::Flush() {
+    return !store || store->Flush();
+}
 
-(maxSize)
-,
+uint256 CPowCache::GetOrCompute(const uint256 &headerHash, const std::function<uint256()> &compute, bool readCache) {
+    Shard &shard = GetShard(headerHash);
 
-nVersion (CURRENT_VERSION)
-, nLoadedSize(0)
-, bValidate(validate)
-, nMaxLoadSize(maxLoadSize) {
-    if (bValidate) LogPrintf("PowCache: Validation and auto correction enabled\n");
+    uint256 cachedHash;
+    bool found = false;
+    std::promise<uint256> promise;
+    std::shared_future<uint256> pending;
+    {
+        LOCK(shard.cs);
+        if (readCache) {
+            found = shard.cache.get(headerHash, cachedHash);
+            if (found && !bValidate) {
+                return cachedHash;
+            }
+        }
+        auto it = shard.inFlight.find(headerHash);
+        if (it != shard.inFlight.end()) {
+            pending = it->second;
+        } else {
+            shard.inFlight.emplace(headerHash, promise.get_future().share());
+        }
+    }
+
+    if (pending.valid()) {
+        // Somebody else is already computing this hash, wait for them
+        return pending.get();
+    }
+
+    // The lookup may have to read from disk, so it is done outside of the shard lock as well
+    uint256 storedHash;
+    const bool stored = store && store->Find(headerHash, storedHash);
+    if (readCache && stored && !found) {
+        cachedHash = storedHash;
+        found = true;
+        if (!bValidate) {
+            {
+                LOCK(shard.cs);
+                shard.cache.insert(headerHash, storedHash);
+                shard.inFlight.erase(headerHash);
+            }
+            promise.set_value(storedHash);
+            return storedHash;
+        }
+    }
+
+    uint256 powHash;
+    try {
+        powHash = compute();
+    } catch (...) {
+        {
+            LOCK(shard.cs);
+            shard.inFlight.erase(headerHash);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    if (found && powHash != cachedHash) {
+        LogPrintf("PowCache failure: headerHash: %s, from cache: %s, computed: %s, correcting\n",
+                  headerHash.ToString(), cachedHash.ToString(), powHash.ToString());
+    }
+    if (!stored || powHash != storedHash) {
+        Persist(headerHash, powHash);
+    }
+
+    {
+        LOCK(shard.cs);
+        shard.cache.insert(headerHash, powHash);
+        shard.inFlight.erase(headerHash);
+    }
+    promise.set_value(powHash);
+    return powHash;
 }
 
-CPowCache::~CPowCache() {
+bool CPowCache::get(const uint256 &headerHash, uint256 &powHash) const {
+    Shard &shard = GetShard(headerHash);
+    {
+        LOCK(shard.cs);
+        if (shard.cache.get(headerHash, powHash)) return true;
+    }
+    // read through to the store outside of the shard lock, the lookup may have to page in a segment
+    if (!store || !store->Find(headerHash, powHash)) return false;
+    LOCK(shard.cs);
+    shard.cache.insert(headerHash, powHash);
+    return true;
+}
+
+bool CPowCache::exists(const uint256 &headerHash) const {
+    Shard &shard = GetShard(headerHash);
+    {
+        LOCK(shard.cs);
+        if (shard.cache.exists(headerHash)) return true;
+    }
+    uint256 powHash;
+    return store && store->Find(headerHash, powHash);
+}
+
+void CPowCache::insert(const uint256 &headerHash, const uint256 &powHash) {
+    Shard &shard = GetShard(headerHash);
+    {
+        LOCK(shard.cs);
+        shard.cache.insert(headerHash, powHash);
+    }
+    Persist(headerHash, powHash);
+}
+
+void CPowCache::erase(const uint256 &headerHash) {
+    Shard &shard = GetShard(headerHash);
+    LOCK(shard.cs);
+    shard.cache.erase(headerHash);
+}
+
+void CPowCache::Import(const uint256 &headerHash, const uint256 &powHash) {
+    uint256 storedHash;
+    if (store && !(store->Find(headerHash, storedHash) && storedHash == powHash)) {
+        store->Append(headerHash, powHash);
+    }
+}
+
+size_t CPowCache::size() const {
+    size_t total = 0;
+    for (const auto &shard : shards) {
+        LOCK(shard->cs);
+        total += shard->cache.size();
+    }
+    return total;
+}
+
+std::vector<std::pair<uint256, uint256>> CPowCache::GetEntries() const {
+    std::vector<std::pair<uint256, uint256>> entries;
+    for (const auto &shard : shards) {
+        LOCK(shard->cs);
+        shard->cache.for_each([&entries](const uint256 &headerHash, const uint256 &powHash) {
+            entries.emplace_back(headerHash, powHash);
+        });
+    }
+    return entries;
 }
 
 void CPowCache::Clear() {
-    cacheMap.clear();
+    for (const auto &shard : shards) {
+        LOCK(shard->cs);
+        shard->cache.clear();
+    }
 }
 
 void CPowCache::CheckAndRemove() {
@@ -60,6 +213,9 @@ void CPowCache::CheckAndRemove() {
 
 std::string CPowCache::ToString() const {
     std::ostringstream info;
-    info << "PowCache: elements: " << (int) cacheMap.size();
+    info << "PowCache: elements: " << size() << ", shards: " << shards.size();
+    if (store) {
+        info << ", stored: " << store->RecordCount() << " in " << store->SegmentCount() << " segments";
+    }
     return info.str();
 }
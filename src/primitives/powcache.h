@@ -1,83 +1,149 @@
 // Copyright (c) 2022-2023 The Raptoreum developers
+// Copyright (c) 2024 The FortuneBlock developers
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #ifndef BITCOIN_POWCACHE_H
 #define BITCOIN_POWCACHE_H
 
+#include <fs.h>
+#include <primitives/powcachestore.h>
 #include <uint256.h>
 #include <sync.h>
 #include <serialize.h>
 #include <unordered_lru_cache.h>
 #include <util/system.h>
 
-extern RecursiveMutex cs_pow;
-
-class CPowCache : public unordered_lru_cache<uint256, uint256, std::hash < uint256>>
+#include <functional>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Cache of block header hash -> GhostRider PoW hash.
+ *
+ * The cache is split into shards selected by the header hash, each guarded by its own lock, so threads
+ * validating different headers do not contend. Locks are only held for the lookup/insert itself, the
+ * PoW hash is always computed outside of them. Concurrent requests for the same header are folded into
+ * one computation: the first caller publishes a future which the others wait on.
+ *
+ * Once Open() has been called, misses fall back to the memory mapped CPowCacheStore and newly computed or
+ * inserted hashes are appended to it. DoMaintenance() flushes, compacts and prunes the store down to
+ * -powcachestoresize hashes.
+ */
+class CPowCache {
+public:
+    static const size_t SHARD_COUNT = 16;
 
-{
 private:
-static CPowCache *instance;
-static const int CURRENT_VERSION = 1;
+    static const int CURRENT_VERSION = 1;
+
+    struct Shard {
+        Mutex cs;
+        unordered_lru_cache<uint256, uint256, std::hash<uint256>> cache GUARDED_BY(cs);
+        std::unordered_map<uint256, std::shared_future<uint256>, std::hash<uint256>> inFlight GUARDED_BY(cs);
+
+        explicit Shard(size_t maxSize) : cache(maxSize) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    std::unique_ptr<CPowCacheStore> store;
 
-int nVersion;
-int nLoadedSize;
-int nMaxLoadSize;
-bool bValidate;
-RecursiveMutex cs;
+    int nVersion;
+    size_t nMaxLoadSize;
+    uint64_t nMaxStoreSize;
+    bool bValidate;
+
+    Shard &GetShard(const uint256 &headerHash) const {
+        // the header hash is a uniformly distributed double-SHA256, so any of its bits make a fair shard key
+        return *shards[headerHash.GetCheapHash() % shards.size()];
+    }
+
+    std::vector<std::pair<uint256, uint256>> GetEntries() const;
+
+    void Persist(const uint256 &headerHash, const uint256 &powHash) {
+        if (store) store->Append(headerHash, powHash);
+    }
 
 public:
 
-static CPowCache &Instance();
+    static CPowCache &Instance();
 
-CPowCache(int maxSize = DEFAULT_POW_CACHE_SIZE, bool validate = DEFAULT_VALIDATE_POW_CACHE,
-          int maxLoadSize = DEFAULT_MAX_LOAD_SIZE);
+    CPowCache(int maxSize = DEFAULT_POW_CACHE_SIZE, bool validate = DEFAULT_VALIDATE_POW_CACHE,
+              int maxLoadSize = DEFAULT_MAX_LOAD_SIZE, uint64_t maxStoreSize = DEFAULT_POW_CACHE_STORE_SIZE);
 
-virtual ~
+    CPowCache(const CPowCache &) = delete;
+    CPowCache &operator=(const CPowCache &) = delete;
 
-CPowCache();
+    virtual ~CPowCache();
 
-void Clear();
+    /** Attach the on-disk store in dir. Must be called before the cache is used from other threads. */
+    bool Open(const fs::path &dir);
 
-void CheckAndRemove();
+    /** Write all hashes computed since the last flush to the on-disk store. */
+    bool Flush();
 
-bool IsValidate() const { return bValidate; }
+    /**
+     * Return the PoW hash of the header identified by headerHash, calling compute() on a cache miss.
+     * If another thread is already computing the same hash, wait for its result instead of computing it twice.
+     * With readCache == false (or with -powcachevalidate) cached values are ignored and recomputed.
+     */
+    uint256 GetOrCompute(const uint256 &headerHash, const std::function<uint256()> &compute, bool readCache = true);
 
-void DoMaintenance();
+    /** Look headerHash up in memory, then in the on-disk store. */
+    bool get(const uint256 &headerHash, uint256 &powHash) const;
 
-std::string ToString() const;
+    /** Whether headerHash is known, either in memory or in the on-disk store. */
+    bool exists(const uint256 &headerHash) const;
 
-ADD_POWCACHE_METHOD
+    /** Cache powHash in memory and append it to the on-disk store. */
+    void insert(const uint256 &headerHash, const uint256 &powHash);
 
-template<typename Stream, typename Operation>
-inline void SerializationOp(Stream &s, Operation ser_action) {
-    LOCK(cs);
-    READWRITE(nVersion);
+    void erase(const uint256 &headerHash);
 
-    uint64_t cacheSize = (uint64_t) cacheMap.size();
-    READWRITE(COMPACTSIZE(cacheSize));
+    /** Add a hash verified elsewhere (e.g. kept in the block index) to the on-disk store unless it is known already. */
+    void Import(const uint256 &headerHash, const uint256 &powHash);
 
-    if (ser_action.ForRead()) {
+    size_t size() const;
+
+    void Clear();
+
+    void CheckAndRemove();
+
+    bool IsValidate() const { return bValidate; }
+
+    void DoMaintenance();
+
+    std::string ToString() const;
+
+    // Legacy powcache.dat format, only read at startup to import it into the store
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        std::vector<std::pair<uint256, uint256>> entries = GetEntries();
+        s << nVersion;
+        WriteCompactSize(s, entries.size());
+        for (const auto &entry : entries) {
+            s << entry.first;
+            s << entry.second;
+        }
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s) {
+        s >> nVersion;
+        uint64_t cacheSize = ReadCompactSize(s);
         uint256 headerHash;
         uint256 powHash;
-        for (int i = 0; i < cacheSize; ++i) {
-            READWRITE(headerHash);
-            READWRITE(powHash);
+        for (uint64_t i = 0; i < cacheSize; ++i) {
+            s >> headerHash;
+            s >> powHash;
             insert(headerHash, powHash);
         }
         nVersion = CURRENT_VERSION;
-        nLoadedSize = cacheMap.size();
-    } else {
-        for (auto it = cacheMap.begin(); it != cacheMap.end(); ++it) {
-            uint256 headerHash = it->first;
-            uint256 powHash = it->second.first;
-            READWRITE(headerHash);
-            READWRITE(powHash);
-        };
-        nLoadedSize = cacheMap.size();
     }
-}
-
 };
 
 #endif // BITCOIN_POWCACHE_H
@@ -0,0 +1,435 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <primitives/powcachestore.h>
+
+#include <chainparams.h>
+#include <crypto/common.h>
+#include <logging.h>
+#include <util/strencodings.h>
+#include <util/system.h>
+
+#include <algorithm>
+#include <functional>
+#include <string.h>
+
+#ifdef WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const unsigned char SEGMENT_MAGIC[8] = {'p', 'o', 'w', 'c', 'a', 'c', 'h', 'e'};
+const std::string SEGMENT_PREFIX = "segment_";
+const std::string SEGMENT_SUFFIX = ".dat";
+
+int CompareRecord(const unsigned char *record, const uint256 &headerHash) {
+    return memcmp(record, headerHash.begin(), 32);
+}
+
+std::string SegmentFileName(uint32_t sequence) {
+    return strprintf("%s%08u%s", SEGMENT_PREFIX, sequence, SEGMENT_SUFFIX);
+}
+
+bool ParseSegmentFileName(const std::string &name, uint32_t &sequence) {
+    if (name.size() <= SEGMENT_PREFIX.size() + SEGMENT_SUFFIX.size() ||
+        name.compare(0, SEGMENT_PREFIX.size(), SEGMENT_PREFIX) != 0 ||
+        name.compare(name.size() - SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX.size(), SEGMENT_SUFFIX) != 0) {
+        return false;
+    }
+    return ParseUInt32(name.substr(SEGMENT_PREFIX.size(),
+                                   name.size() - SEGMENT_PREFIX.size() - SEGMENT_SUFFIX.size()), &sequence);
+}
+
+void WriteHeader(unsigned char *header, uint64_t count) {
+    memset(header, 0, CPowCacheStore::HEADER_SIZE);
+    memcpy(header, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    memcpy(header + 8, Params().MessageStart(), CMessageHeader::MESSAGE_START_SIZE);
+    WriteLE32(header + 12, CPowCacheStore::CURRENT_VERSION);
+    WriteLE64(header + 16, count);
+}
+} // namespace
+
+/** A read-only, memory mapped segment file. */
+class CPowCacheStore::Segment {
+private:
+    const unsigned char *data{nullptr};
+    size_t size{0};
+    uint64_t nRecords{0};
+#ifdef WIN32
+    std::vector<unsigned char> buffer;
+#endif
+
+    Segment(const fs::path &pathIn, uint32_t sequenceIn) : path(pathIn), sequence(sequenceIn) {}
+
+public:
+    const fs::path path;
+    const uint32_t sequence;
+
+    static std::shared_ptr<const Segment> Map(const fs::path &path, uint32_t sequence);
+
+    ~Segment() {
+#ifndef WIN32
+        if (data != nullptr) munmap(const_cast<unsigned char *>(data), size);
+#endif
+    }
+
+    uint64_t Count() const { return nRecords; }
+
+    const unsigned char *Record(uint64_t i) const { return data + HEADER_SIZE + i * RECORD_SIZE; }
+
+    bool Find(const uint256 &headerHash, uint256 &powHash) const {
+        uint64_t lo = 0, hi = nRecords;
+        while (lo < hi) {
+            const uint64_t mid = lo + (hi - lo) / 2;
+            const int cmp = CompareRecord(Record(mid), headerHash);
+            if (cmp == 0) {
+                memcpy(powHash.begin(), Record(mid) + 32, 32);
+                return true;
+            }
+            if (cmp < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return false;
+    }
+};
+
+std::shared_ptr<const CPowCacheStore::Segment> CPowCacheStore::Segment::Map(const fs::path &path, uint32_t sequence) {
+    std::shared_ptr<Segment> segment(new Segment(path, sequence));
+#ifdef WIN32
+    std::ifstream file(path.string(), std::ios::binary);
+    segment->buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (file.bad()) {
+        LogPrintf("PowCacheStore: failed to read %s\n", path.string());
+        return nullptr;
+    }
+    segment->data = segment->buffer.data();
+    segment->size = segment->buffer.size();
+#else
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd < 0) {
+        LogPrintf("PowCacheStore: failed to open %s\n", path.string());
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) HEADER_SIZE) {
+        close(fd);
+        LogPrintf("PowCacheStore: %s is truncated\n", path.string());
+        return nullptr;
+    }
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        LogPrintf("PowCacheStore: failed to map %s\n", path.string());
+        return nullptr;
+    }
+    // lookups are binary searches, read ahead only wastes page cache
+    madvise(addr, st.st_size, MADV_RANDOM);
+    segment->data = static_cast<const unsigned char *>(addr);
+    segment->size = st.st_size;
+#endif
+
+    if (segment->size < HEADER_SIZE || memcmp(segment->data, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0) {
+        LogPrintf("PowCacheStore: %s has an invalid header\n", path.string());
+        return nullptr;
+    }
+    if (memcmp(segment->data + 8, Params().MessageStart(), CMessageHeader::MESSAGE_START_SIZE) != 0) {
+        LogPrintf("PowCacheStore: %s belongs to another network\n", path.string());
+        return nullptr;
+    }
+    const uint32_t version = ReadLE32(segment->data + 12);
+    if (version != CURRENT_VERSION) {
+        LogPrintf("PowCacheStore: %s has unsupported version %u\n", path.string(), version);
+        return nullptr;
+    }
+    segment->nRecords = ReadLE64(segment->data + 16);
+    if (segment->nRecords != (segment->size - HEADER_SIZE) / RECORD_SIZE ||
+        (segment->size - HEADER_SIZE) % RECORD_SIZE != 0) {
+        LogPrintf("PowCacheStore: %s size does not match its record count\n", path.string());
+        return nullptr;
+    }
+    return segment;
+}
+
+CPowCacheStore::CPowCacheStore(const fs::path &dirIn) : dir(dirIn), nNextSequence(0) {
+}
+
+CPowCacheStore::~CPowCacheStore() {
+}
+
+bool CPowCacheStore::Open() {
+    LOCK2(cs_write, cs);
+    segments.clear();
+    nNextSequence = 0;
+
+    if (!TryCreateDirectories(dir) && !fs::is_directory(dir)) {
+        return error("%s: failed to create %s", __func__, dir.string());
+    }
+
+    std::vector<std::pair<uint32_t, fs::path>> files;
+    try {
+        for (fs::directory_iterator it(dir); it != fs::directory_iterator(); ++it) {
+            const std::string name = it->path().filename().string();
+            uint32_t sequence;
+            if (it->path().extension() == ".tmp") {
+                // left over from an interrupted Flush() or Compact()
+                fs::remove(it->path());
+            } else if (ParseSegmentFileName(name, sequence)) {
+                files.emplace_back(sequence, it->path());
+            }
+        }
+    } catch (const fs::filesystem_error &e) {
+        return error("%s: failed to scan %s: %s", __func__, dir.string(), e.what());
+    }
+    std::sort(files.begin(), files.end());
+
+    uint64_t records = 0;
+    for (const auto &file : files) {
+        nNextSequence = std::max(nNextSequence, file.first + 1);
+        std::shared_ptr<const Segment> segment = Segment::Map(file.second, file.first);
+        if (segment) {
+            records += segment->Count();
+            segments.push_back(std::move(segment));
+        }
+    }
+    LogPrintf("PowCacheStore: mapped %u segments with %u records from %s\n", segments.size(), records, dir.string());
+    return true;
+}
+
+std::vector<std::shared_ptr<const CPowCacheStore::Segment>> CPowCacheStore::GetSegments() const {
+    LOCK(cs);
+    return segments;
+}
+
+bool CPowCacheStore::Find(const uint256 &headerHash, uint256 &powHash) const {
+    std::vector<std::shared_ptr<const Segment>> snapshot;
+    {
+        LOCK(cs);
+        auto it = pending.find(headerHash);
+        if (it != pending.end()) {
+            powHash = it->second;
+            return true;
+        }
+        snapshot = segments;
+    }
+    // search outside of cs, a lookup may page fault while the segment is read from disk
+    for (auto it = snapshot.rbegin(); it != snapshot.rend(); ++it) {
+        if ((*it)->Find(headerHash, powHash)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CPowCacheStore::Append(const uint256 &headerHash, const uint256 &powHash) {
+    LOCK(cs);
+    pending[headerHash] = powHash;
+}
+
+bool CPowCacheStore::WriteSegment(uint32_t sequence, const std::function<bool(unsigned char *)> &next,
+                                  std::shared_ptr<const Segment> &segmentOut) {
+    const fs::path path = dir / SegmentFileName(sequence);
+    const fs::path tmpPath = dir / (SegmentFileName(sequence) + ".tmp");
+
+    FILE *file = fsbridge::fopen(tmpPath, "wb");
+    if (file == nullptr) {
+        return error("%s: failed to open %s", __func__, tmpPath.string());
+    }
+
+    unsigned char header[HEADER_SIZE];
+    unsigned char record[RECORD_SIZE];
+    uint64_t count = 0;
+    // the record count is only known at the end, write a placeholder header and patch it afterwards
+    WriteHeader(header, count);
+    bool ok = fwrite(header, 1, HEADER_SIZE, file) == HEADER_SIZE;
+    while (ok && next(record)) {
+        ok = fwrite(record, 1, RECORD_SIZE, file) == RECORD_SIZE;
+        ++count;
+    }
+    if (ok) {
+        WriteHeader(header, count);
+        ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(header, 1, HEADER_SIZE, file) == HEADER_SIZE &&
+             FileCommit(file);
+    }
+    fclose(file);
+    if (!ok || !RenameOver(tmpPath, path)) {
+        fs::remove(tmpPath);
+        return error("%s: failed to write %s", __func__, path.string());
+    }
+
+    segmentOut = Segment::Map(path, sequence);
+    return segmentOut != nullptr;
+}
+
+bool CPowCacheStore::Flush() {
+    LOCK(cs_write);
+    std::vector<std::pair<uint256, uint256>> entries;
+    uint32_t sequence;
+    {
+        LOCK(cs);
+        if (pending.empty()) return true;
+        entries.assign(pending.begin(), pending.end());
+        sequence = nNextSequence++;
+    }
+
+    // pending holds one entry per header, so sorting is all that is left to do
+    std::sort(entries.begin(), entries.end(), [](const std::pair<uint256, uint256> &a,
+                                                 const std::pair<uint256, uint256> &b) {
+        return a.first < b.first;
+    });
+
+    size_t pos = 0;
+    std::shared_ptr<const Segment> segment;
+    const bool ok = WriteSegment(sequence, [&entries, &pos](unsigned char *record) {
+        if (pos == entries.size()) return false;
+        memcpy(record, entries[pos].first.begin(), 32);
+        memcpy(record + 32, entries[pos].second.begin(), 32);
+        ++pos;
+        return true;
+    }, segment);
+
+    LOCK(cs);
+    if (!ok) {
+        // keep the entries buffered for the next attempt
+        return false;
+    }
+    segments.push_back(std::move(segment));
+    // drop what was written, unless it was replaced while the segment was being written
+    for (const auto &entry : entries) {
+        auto it = pending.find(entry.first);
+        if (it != pending.end() && it->second == entry.second) {
+            pending.erase(it);
+        }
+    }
+    return true;
+}
+
+namespace {
+/** Number of segments at the end of segments (the newest) that are still below MAX_SEGMENT_RECORDS. */
+template<typename Segments>
+size_t CountCompactable(const Segments &segments) {
+    size_t count = 0;
+    while (count < segments.size() &&
+           segments[segments.size() - count - 1]->Count() < CPowCacheStore::MAX_SEGMENT_RECORDS) {
+        ++count;
+    }
+    return count;
+}
+} // namespace
+
+bool CPowCacheStore::Compact() {
+    LOCK(cs_write);
+    const auto all = GetSegments();
+    const size_t compactable = CountCompactable(all);
+    if (compactable <= 1) return true;
+    // only the newest segments are merged, so the merged one keeps its place in the age order
+    const std::vector<std::shared_ptr<const Segment>> merging(all.end() - compactable, all.end());
+
+    uint32_t sequence;
+    {
+        LOCK(cs);
+        sequence = nNextSequence++;
+    }
+
+    // k-way merge of the sorted segments, on equal header hashes the newest segment wins
+    std::vector<uint64_t> cursors(merging.size(), 0);
+    std::shared_ptr<const Segment> segment;
+    const bool ok = WriteSegment(sequence, [&merging, &cursors](unsigned char *record) {
+        const unsigned char *best = nullptr;
+        for (size_t i = 0; i < merging.size(); ++i) {
+            if (cursors[i] == merging[i]->Count()) continue;
+            const unsigned char *candidate = merging[i]->Record(cursors[i]);
+            if (best == nullptr || memcmp(candidate, best, 32) <= 0) {
+                best = candidate;
+            }
+        }
+        if (best == nullptr) return false;
+        memcpy(record, best, RECORD_SIZE);
+        for (size_t i = 0; i < merging.size(); ++i) {
+            if (cursors[i] != merging[i]->Count() && memcmp(merging[i]->Record(cursors[i]), record, 32) == 0) {
+                ++cursors[i];
+            }
+        }
+        return true;
+    }, segment);
+    if (!ok) return false;
+
+    {
+        LOCK(cs);
+        // Flush() and Prune() can't run concurrently, so the merged segments are still the newest ones
+        segments.erase(segments.end() - merging.size(), segments.end());
+        segments.push_back(segment);
+    }
+    LogPrintf("PowCacheStore: compacted %u segments into %s with %u records\n", merging.size(),
+              segment->path.filename().string(), segment->Count());
+
+    // readers still holding the old segments keep their mappings, unlinking the files is safe
+    for (const auto &old : merging) {
+        try {
+            fs::remove(old->path);
+        } catch (const fs::filesystem_error &e) {
+            LogPrintf("PowCacheStore: failed to remove %s: %s\n", old->path.string(), e.what());
+        }
+    }
+    return true;
+}
+
+void CPowCacheStore::Prune(uint64_t maxRecords) {
+    LOCK(cs_write);
+    std::vector<std::shared_ptr<const Segment>> removed;
+    {
+        LOCK(cs);
+        uint64_t records = 0;
+        for (const auto &segment : segments) {
+            records += segment->Count();
+        }
+        size_t count = 0;
+        while (records > maxRecords && segments.size() - count > 1) {
+            records -= segments[count]->Count();
+            removed.push_back(segments[count]);
+            ++count;
+        }
+        segments.erase(segments.begin(), segments.begin() + count);
+    }
+
+    for (const auto &old : removed) {
+        LogPrintf("PowCacheStore: pruned %s with %u records\n", old->path.filename().string(), old->Count());
+        try {
+            fs::remove(old->path);
+        } catch (const fs::filesystem_error &e) {
+            LogPrintf("PowCacheStore: failed to remove %s: %s\n", old->path.string(), e.what());
+        }
+    }
+}
+
+size_t CPowCacheStore::PendingSize() const {
+    LOCK(cs);
+    return pending.size();
+}
+
+size_t CPowCacheStore::CompactableCount() const {
+    LOCK(cs);
+    return CountCompactable(segments);
+}
+
+size_t CPowCacheStore::SegmentCount() const {
+    LOCK(cs);
+    return segments.size();
+}
+
+size_t CPowCacheStore::RecordCount() const {
+    LOCK(cs);
+    size_t count = 0;
+    for (const auto &segment : segments) {
+        count += segment->Count();
+    }
+    return count;
+}
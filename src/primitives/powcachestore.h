@@ -0,0 +1,96 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_PRIMITIVES_POWCACHESTORE_H
+#define BITCOIN_PRIMITIVES_POWCACHESTORE_H
+
+#include <fs.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Append-only on-disk store of header hash -> PoW hash pairs backing CPowCache.
+ *
+ * The store is a directory of immutable segment files. A segment is a fixed 64 byte header followed by
+ * 64 byte records (header hash, PoW hash) sorted by header hash, so it is memory mapped and binary searched
+ * in place: nothing is deserialized at startup and pages are only read when a lookup touches them.
+ *
+ * New entries are buffered by Append() and written out as a new segment by Flush(), existing segments are
+ * never rewritten. Compact() merges the newest segments holding less than MAX_SEGMENT_RECORDS records into
+ * one, so the store settles into a few large segments ordered by age. Prune() drops the oldest of them to
+ * keep the store below a record limit. When the same header hash is found in several segments the newest
+ * one wins.
+ */
+class CPowCacheStore {
+public:
+    static const uint32_t CURRENT_VERSION = 1;
+    static const size_t HEADER_SIZE = 64;
+    static const size_t RECORD_SIZE = 64;
+    static const size_t MAX_SEGMENTS = 8;
+    //! segments with at least this many records are no longer merged by Compact()
+    static const uint64_t MAX_SEGMENT_RECORDS = 1 << 20;
+
+private:
+    class Segment;
+
+    const fs::path dir;
+
+    mutable Mutex cs;
+    //! oldest first
+    std::vector<std::shared_ptr<const Segment>> segments GUARDED_BY(cs);
+    std::unordered_map<uint256, uint256, std::hash<uint256>> pending GUARDED_BY(cs);
+    uint32_t nNextSequence GUARDED_BY(cs);
+
+    //! serializes Flush() and Compact() so segment sequence numbers always follow their age
+    Mutex cs_write;
+
+    std::vector<std::shared_ptr<const Segment>> GetSegments() const;
+
+    /** Write the records produced by next() (in header hash order) as a new segment and map it. */
+    bool WriteSegment(uint32_t sequence, const std::function<bool(unsigned char *)> &next,
+                      std::shared_ptr<const Segment> &segmentOut);
+
+public:
+    explicit CPowCacheStore(const fs::path &dirIn);
+
+    ~CPowCacheStore();
+
+    CPowCacheStore(const CPowCacheStore &) = delete;
+    CPowCacheStore &operator=(const CPowCacheStore &) = delete;
+
+    /** Map all segments found in the directory, creating it if needed. Unreadable segments are skipped. */
+    bool Open();
+
+    /** Look headerHash up in the buffered entries and the segments, newest first. */
+    bool Find(const uint256 &headerHash, uint256 &powHash) const;
+
+    /** Buffer an entry until the next Flush(), replacing a buffered entry for the same header. */
+    void Append(const uint256 &headerHash, const uint256 &powHash);
+
+    /** Write all buffered entries as a new segment. */
+    bool Flush();
+
+    /** Merge the newest segments below MAX_SEGMENT_RECORDS into a single one, dropping shadowed duplicates. */
+    bool Compact();
+
+    /** Delete the oldest segments until at most maxRecords records are left, always keeping the newest one. */
+    void Prune(uint64_t maxRecords);
+
+    size_t PendingSize() const;
+
+    /** Number of segments Compact() would merge. */
+    size_t CompactableCount() const;
+
+    size_t SegmentCount() const;
+
+    size_t RecordCount() const;
+};
+
+#endif // BITCOIN_PRIMITIVES_POWCACHESTORE_H
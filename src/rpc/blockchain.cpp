@@ -199,7 +199,7 @@ blockToJSON(const CBlock &block, const CBlockIndex *tip, const CBlockIndex *bloc
     if (pnext)
         result.pushKV("nextblockhash", pnext->GetBlockHash().GetHex());
     if (powHash)
-        result.pushKV("powhash", block.GetPOWHash().GetHex());
+        result.pushKV("powhash", blockindex->GetPOWHash().GetHex());
 
     result.pushKV("chainlock", chainLock);
 
@@ -197,6 +197,9 @@ static const CRPCConvertParam vRPCConvertParams[] =
                 { "listaddressesbyasset", 1, "totalonly"},
                 { "listaddressesbyasset", 2, "count"},
                 { "listaddressesbyasset", 3, "start"},
+                { "listassetbalancesbyaddress", 1, "onlytotal"},
+                { "listassetbalancesbyaddress", 2, "count"},
+                { "listassetbalancesbyaddress", 3, "start"},
         };
 
 class CRPCConvertTable {
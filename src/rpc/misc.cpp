@@ -10,6 +10,7 @@
 #include <clientversion.h>
 #include <consensus/consensus.h>
 #include <core_io.h>
+#include <evo/deterministicmns.h>
 #include <evo/mnauth.h>
 #include <httpserver.h>
 #include <init.h>
@@ -18,6 +19,7 @@
 #include <net.h>
 #include <netbase.h>
 #include <node/context.h>
+#include <optional.h>
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
@@ -632,6 +634,118 @@ bool timestampSort(std::pair <CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+//! page size of the address index RPCs when a cursor is given without a limit
+static const size_t DEFAULT_ADDRESS_INDEX_PAGE = 1000;
+
+/**
+ * Read the limit and cursor of a paged address index request, returns false when neither is given. The cursor
+ * is the hex serialized index key of the last entry of the previous page, "" for the first page.
+ */
+template<typename Key>
+static bool ParseAddressIndexPage(const UniValue &param, size_t &nLimit, Optional<Key> &cursor) {
+    if (!param.isObject())
+        return false;
+    const UniValue &limitValue = find_value(param.get_obj(), "limit");
+    const UniValue &cursorValue = find_value(param.get_obj(), "cursor");
+    if (limitValue.isNull() && cursorValue.isNull())
+        return false;
+
+    nLimit = DEFAULT_ADDRESS_INDEX_PAGE;
+    if (!limitValue.isNull()) {
+        if (!limitValue.isNum() || limitValue.get_int() <= 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "limit must be a positive number");
+        nLimit = limitValue.get_int();
+    }
+    if (!cursorValue.isNull()) {
+        if (!cursorValue.isStr())
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "cursor must be a value returned as next_cursor");
+        const std::string &hex = cursorValue.get_str();
+        if (!hex.empty()) {
+            if (!IsHex(hex))
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "cursor must be a value returned as next_cursor");
+            CDataStream ss(ParseHex(hex), SER_DISK, CLIENT_VERSION);
+            Key key;
+            try {
+                ss >> key;
+            } catch (const std::exception &) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "cursor must be a value returned as next_cursor");
+            }
+            cursor = key;
+        }
+    }
+    return true;
+}
+
+/** Position of the address a cursor continues in, the addresses before it are done */
+template<typename Key>
+static size_t FirstPageAddress(const std::vector <std::pair<uint160, int>> &addresses, const Optional<Key> &cursor) {
+    if (!cursor)
+        return 0;
+    for (size_t i = 0; i < addresses.size(); i++) {
+        if (addresses[i].first == cursor->hashBytes && (unsigned int) addresses[i].second == cursor->type)
+            return i;
+    }
+    throw JSONRPCError(RPC_INVALID_PARAMETER, "cursor doesn't belong to any of the addresses");
+}
+
+/** {"<name>": entries, "next_cursor": "..."}, next_cursor is empty after the last page */
+template<typename Key>
+static UniValue AddressIndexPage(const std::string &name, const UniValue &entries, const Optional<Key> &next) {
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    if (next)
+        ss << *next;
+    UniValue result(UniValue::VOBJ);
+    result.pushKV(name, entries);
+    result.pushKV("next_cursor", HexStr(ss.str()));
+    return result;
+}
+
+static UniValue AddressUnspentToJSON(const CAddressUnspentKey &key, const CAddressUnspentValue &value) {
+    std::string address;
+    if (!getAddressFromIndex(key.type, key.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+    UniValue output(UniValue::VOBJ);
+    output.pushKV("address", address);
+    if (key.asset != "FTB") {
+        output.pushKV("assetId", key.asset);
+        if (value.isUnique)
+            output.pushKV("uniqueId", value.uniqueId);
+    }
+    output.pushKV("txid", key.txhash.GetHex());
+    output.pushKV("outputIndex", (int) key.index);
+    output.pushKV("script", HexStr(value.script));
+    output.pushKV("satoshis", value.satoshis);
+    output.pushKV("height", value.blockHeight);
+    output.pushKV("spendableHeight", value.fSpendableHeight);
+    output.pushKV("spendableTime", value.fSpendableTime);
+    return output;
+}
+
+static UniValue AddressDeltaToJSON(const CAddressIndexKey &key, CAmount amount) {
+    std::string address;
+    if (!getAddressFromIndex(key.type, key.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+
+    UniValue delta(UniValue::VOBJ);
+    delta.pushKV("satoshis", amount);
+    if (key.asset != "FTB"){
+        CAssetMetaData tmpAsset;
+        if (!passetsCache->GetAssetMetaData(key.asset, tmpAsset)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Error: Asset asset metadata not found");
+        }
+        delta.pushKV("asset", tmpAsset.name);
+        delta.pushKV("assetId", key.asset);
+    }
+    delta.pushKV("txid", key.txhash.GetHex());
+    delta.pushKV("index", (int) key.index);
+    delta.pushKV("blockindex", (int) key.txindex);
+    delta.pushKV("height", key.blockHeight);
+    delta.pushKV("address", address);
+    return delta;
+}
+
 UniValue getaddressmempool(const JSONRPCRequest &request) {
     RPCHelpMan{"getaddressmempool",
                "\nReturns all mempool deltas for an address (requires addressindex to be enabled).\n",
@@ -729,7 +843,9 @@ UniValue getaddressutxos(const JSONRPCRequest &request) {
                             {"address", RPCArg::Type::STR, /* default */ "", "The base58check encoded address"},
                     },
                 },
-                {"asset", RPCArg::Type::STR, /* default */ "FTB", "Get UTXOs for a particular asset instead of FTB ('*' for all assets).",}
+                {"asset", RPCArg::Type::STR, /* default */ "FTB", "Get UTXOs for a particular asset instead of FTB ('*' for all assets, without FTB).",},
+                {"limit", RPCArg::Type::NUM, /* default */ "", "Return at most limit UTXOs in index order (address, asset, txid) instead of by height, as {\"utxos\": [...], \"next_cursor\": \"...\"}"},
+                {"cursor", RPCArg::Type::STR_HEX, /* default */ "\"\"", "Continue after the last UTXO of a previous page, next_cursor is empty after the last page"},
             },
             {
                 RPCResult{"For FTB",
@@ -800,6 +916,50 @@ UniValue getaddressutxos(const JSONRPCRequest &request) {
         }
     }
 
+    // '*' asks for the UTXOs of all assets, which doesn't include FTB, both with and without pages
+    auto isRequestedAsset = [&](const std::string &asset) {
+        return assetId == "*" ? asset != "FTB" : asset == assetId;
+    };
+
+    auto isSpendable = [](const CAddressUnspentValue &value) {
+        int currentHeight = ::ChainActive().Tip() == nullptr ? 0 : ::ChainActive().Tip()->nHeight;
+        return (value.fSpendableHeight >= 0 && value.fSpendableHeight <= currentHeight) ||
+               (value.fSpendableTime >= 0 && value.fSpendableTime <= GetAdjustedTime());
+    };
+
+    size_t nLimit = 0;
+    Optional<CAddressUnspentKey> cursor;
+    if (ParseAddressIndexPage(request.params[0], nLimit, cursor)) {
+        // A page is read straight from the index in key order, only as far as needed
+        UniValue utxos(UniValue::VARR);
+        Optional<CAddressUnspentKey> last = cursor;
+        bool fMore = false;
+        const size_t nFirst = FirstPageAddress(addresses, cursor);
+        for (size_t i = nFirst; i < addresses.size() && !fMore; i++) {
+            const CAddressUnspentKey *after = i == nFirst && cursor ? &*cursor : nullptr;
+            bool fRead = GetAddressUnspent(addresses[i].first, addresses[i].second, assetId == "*" ? "" : assetId, after,
+                                           [&](const CAddressUnspentKey &key, const CAddressUnspentValue &value) {
+                if (!isRequestedAsset(key.asset) || (excludeUnspendable && !isSpendable(value))) {
+                    last = key;
+                    return true;
+                }
+                if (utxos.size() == nLimit) {
+                    fMore = true;
+                    return false;
+                }
+                utxos.push_back(AddressUnspentToJSON(key, value));
+                last = key;
+                return true;
+            });
+            if (!fRead) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        }
+        if (!fMore)
+            last = nullopt;
+        return AddressIndexPage("utxos", utxos, last);
+    }
+
     std::vector <std::pair<CAddressUnspentKey, CAddressUnspentValue>> unspentOutputs;
 
     for (std::vector < std::pair < uint160, int > > ::iterator it = addresses.begin(); it != addresses.end();
@@ -818,31 +978,13 @@ UniValue getaddressutxos(const JSONRPCRequest &request) {
                                                         ::const_iterator it = unspentOutputs.begin(); it !=
                                                                                                         unspentOutputs.end();
         it++) {
-            if (assetId != it->first.asset)
+            if (!isRequestedAsset(it->first.asset))
                 continue;
 
-            UniValue output(UniValue::VOBJ);
-            std::string address;
-            if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-            }
-            if (excludeUnspendable) {
-                int currentHeight = ::ChainActive().Tip() == nullptr ? 0 : ::ChainActive().Tip()->nHeight;
-                bool isFSpendable = (it->second.fSpendableHeight >= 0 && it->second.fSpendableHeight <= currentHeight) ||
-                                    (it->second.fSpendableTime >= 0 && it->second.fSpendableTime <= GetAdjustedTime());
-                if (!isFSpendable) {
-                    continue;
-                }
+            if (excludeUnspendable && !isSpendable(it->second)) {
+                continue;
             }
-            output.pushKV("address", address);
-            output.pushKV("txid", it->first.txhash.GetHex());
-            output.pushKV("outputIndex", (int) it->first.index);
-            output.pushKV("script", HexStr(it->second.script));
-            output.pushKV("satoshis", it->second.satoshis);
-            output.pushKV("height", it->second.blockHeight);
-            output.pushKV("spendableHeight", it->second.fSpendableHeight);
-            output.pushKV("spendableTime", it->second.fSpendableTime);
-            result.push_back(output);
+            result.push_back(AddressUnspentToJSON(it->first, it->second));
         }
         return result;
     } else {
@@ -852,19 +994,11 @@ UniValue getaddressutxos(const JSONRPCRequest &request) {
                                                         ::const_iterator it = unspentOutputs.begin(); it !=
                                                                                                         unspentOutputs.end();
         it++) {
-            if (it->first.asset == "FTB")
+            if (!isRequestedAsset(it->first.asset))
                 continue;
 
-            if (assetId != it->first.asset && assetId != "*")
+            if (excludeUnspendable && !isSpendable(it->second)) {
                 continue;
-
-            if (excludeUnspendable) {
-                int currentHeight = ::ChainActive().Tip() == nullptr ? 0 : ::ChainActive().Tip()->nHeight;
-                bool isFSpendable = (it->second.fSpendableHeight >= 0 && it->second.fSpendableHeight <= currentHeight) ||
-                                    (it->second.fSpendableTime >= 0 && it->second.fSpendableTime <= GetAdjustedTime());
-                if (!isFSpendable) {
-                    continue;
-                }
             }
             if (!mapassetUTXO.count(it->first.asset)){
                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> tmp;
@@ -875,24 +1009,7 @@ UniValue getaddressutxos(const JSONRPCRequest &request) {
         for (auto asset : mapassetUTXO){
             UniValue assetutxo(UniValue::VARR);
             for (auto it : asset.second){
-                UniValue output(UniValue::VOBJ);
-                std::string address;
-                if (!getAddressFromIndex(it.first.type, it.first.hashBytes, address)) {
-                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-                }
-                output.pushKV("address", address);
-                output.pushKV("assetId", it.first.asset);
-                CAssetTransfer assetTransfer;
-                if (it.second.isUnique)
-                    output.pushKV("uniqueId", it.second.uniqueId);
-                output.pushKV("txid", it.first.txhash.GetHex());
-                output.pushKV("outputIndex", (int) it.first.index);
-                output.pushKV("script", HexStr(it.second.script));
-                output.pushKV("satoshis", it.second.satoshis);
-                output.pushKV("height", it.second.blockHeight);
-                output.pushKV("spendableHeight", it.second.fSpendableHeight);
-                output.pushKV("spendableTime", it.second.fSpendableTime);
-                assetutxo.push_back(output);
+                assetutxo.push_back(AddressUnspentToJSON(it.first, it.second));
             }
 
             CAssetMetaData tmpAsset;
@@ -914,7 +1031,9 @@ UniValue getaddressdeltas(const JSONRPCRequest &request) {
                                 {"address", RPCArg::Type::STR, /* default */ "", "The base58check encoded address"},
                         },
                     },
-                    {"asset", RPCArg::Type::STR, /* default */ "FTB", "Get all changes for a particular asset instead of FTB.",}
+                    {"asset", RPCArg::Type::STR, /* default */ "FTB", "Get all changes for a particular asset instead of FTB.",},
+                    {"limit", RPCArg::Type::NUM, /* default */ "", "Return at most limit changes in index order (address, asset, height), as {\"deltas\": [...], \"next_cursor\": \"...\"}"},
+                    {"cursor", RPCArg::Type::STR_HEX, /* default */ "\"\"", "Continue after the last change of a previous page, next_cursor is empty after the last page"},
 
                },
                RPCResult{
@@ -970,6 +1089,36 @@ UniValue getaddressdeltas(const JSONRPCRequest &request) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    size_t nLimit = 0;
+    Optional<CAddressIndexKey> cursor;
+    if (ParseAddressIndexPage(request.params[0], nLimit, cursor)) {
+        // A page is read straight from the index in key order, only as far as needed
+        UniValue deltas(UniValue::VARR);
+        Optional<CAddressIndexKey> last = cursor;
+        bool fMore = false;
+        const size_t nFirst = FirstPageAddress(addresses, cursor);
+        for (size_t i = nFirst; i < addresses.size() && !fMore; i++) {
+            const CAddressIndexKey *after = i == nFirst && cursor ? &*cursor : nullptr;
+            bool fRead = GetAddressIndex(addresses[i].first, addresses[i].second, assetId == "*" ? "" : assetId,
+                                         start > 0 && end > 0 ? start : 0, start > 0 && end > 0 ? end : 0, after,
+                                         [&](const CAddressIndexKey &key, CAmount amount) {
+                if (deltas.size() == nLimit) {
+                    fMore = true;
+                    return false;
+                }
+                deltas.push_back(AddressDeltaToJSON(key, amount));
+                last = key;
+                return true;
+            });
+            if (!fRead) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        }
+        if (!fMore)
+            last = nullopt;
+        return AddressIndexPage("deltas", deltas, last);
+    }
+
     std::vector <std::pair<CAddressIndexKey, CAmount>> addressIndex;
 
     for (std::vector < std::pair < uint160, int > > ::iterator it = addresses.begin(); it != addresses.end();
@@ -993,27 +1142,7 @@ UniValue getaddressdeltas(const JSONRPCRequest &request) {
         if (it->first.asset != assetId && assetId != "*")
             continue;
 
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
-
-        UniValue delta(UniValue::VOBJ);
-        delta.pushKV("satoshis", it->second);
-        if (it->first.asset != "FTB"){
-            CAssetMetaData tmpAsset;
-            if (!passetsCache->GetAssetMetaData(it->first.asset, tmpAsset)) {
-                throw JSONRPCError(RPC_INVALID_PARAMETER, "Error: Asset asset metadata not found");
-            }
-            delta.pushKV("asset", tmpAsset.name);
-            delta.pushKV("assetId", it->first.asset);
-        }
-        delta.pushKV("txid", it->first.txhash.GetHex());
-        delta.pushKV("index", (int) it->first.index);
-        delta.pushKV("blockindex", (int) it->first.txindex);
-        delta.pushKV("height", it->first.blockHeight);
-        delta.pushKV("address", address);
-        result.push_back(delta);
+        result.push_back(AddressDeltaToJSON(it->first, it->second));
     }
 
     return result;
@@ -1080,74 +1209,53 @@ static UniValue getaddressbalance(const JSONRPCRequest &request) {
         }
     }
 
-    std::vector <std::pair<CAddressIndexKey, CAmount>> addressIndex;
+    struct balance {
+        CAmount balance{0};
+        CAmount balance_spendable{0};
+        CAmount balance_immature{0};
+        CAmount received{0};
+    };
+    std::map<std::string, balance> mapbalance;
 
-    for (std::vector < std::pair < uint160, int > > ::iterator it = addresses.begin(); it != addresses.end();
-    it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+    // coinbase outputs from this height on are still immature, the index itself is read without cs_main
+    const int nMaturityHeight = std::max(WITH_LOCK(cs_main, return ::ChainActive().Height()) - COINBASE_MATURITY + 1, 0);
+
+    for (const auto &address : addresses) {
+        std::vector <std::pair<CAddressBalanceKey, CAddressBalanceValue>> balances;
+        if (!GetAddressBalances(address.first, address.second, assetId == "*" ? "" : assetId, balances)) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
-    }
-
-    int nHeight = WITH_LOCK(cs_main, return ::ChainActive().Height());
-    if (assetId == "FTB") {
-        CAmount balance = 0;
-        CAmount balance_spendable = 0;
-        CAmount balance_immature = 0;
-        CAmount received = 0;
+        for (const auto &it : balances) {
+            balance &total = mapbalance[it.first.asset];
+            total.balance += it.second.balance;
+            total.received += it.second.received;
 
-        for (std::vector < std::pair < CAddressIndexKey, CAmount > > ::const_iterator it = addressIndex.begin(); it !=
-                                                                                                                addressIndex.end();
-        it++) {
-            if (it->first.asset != "FTB")
-                continue;
-            if (it->second > 0) {
-                received += it->second;
+            std::vector <std::pair<CAddressIndexKey, CAmount>> recent;
+            if (!GetAddressIndex(address.first, address.second, it.first.asset, nMaturityHeight, recent)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
             }
-            if (it->first.txindex == 0 && nHeight - it->first.blockHeight < COINBASE_MATURITY) {
-                balance_immature += it->second;
-            } else {
-                balance_spendable += it->second;
+            for (const auto &delta : recent) {
+                if (delta.first.txindex == 0) {
+                    total.balance_immature += delta.second;
+                }
             }
-            balance += it->second;
         }
+    }
+    for (auto &it : mapbalance) {
+        it.second.balance_spendable = it.second.balance - it.second.balance_immature;
+    }
+
+    if (assetId == "FTB") {
+        const balance &ftb = mapbalance["FTB"];
 
         UniValue result(UniValue::VOBJ);
-        result.pushKV("balance", balance);
-        result.pushKV("balance_immature", balance_immature);
-        result.pushKV("balance_spendable", balance_spendable);
-        result.pushKV("received", received);
+        result.pushKV("balance", ftb.balance);
+        result.pushKV("balance_immature", ftb.balance_immature);
+        result.pushKV("balance_spendable", ftb.balance_spendable);
+        result.pushKV("received", ftb.received);
 
         return result;
     } else {
-        struct balance {
-            CAmount balance;
-            CAmount balance_spendable;
-            CAmount balance_immature;
-            CAmount received;
-        };
-
-        std::map<std::string, balance> mapbalance;
-        for (std::vector < std::pair < CAddressIndexKey, CAmount > > ::const_iterator it = addressIndex.begin(); 
-                                                                            it != addressIndex.end(); it++) {
-            if (it->first.asset != assetId && assetId != "*")
-                continue;
-
-            if (mapbalance.find(it->first.asset) == mapbalance.end()) {
-                balance tmp;
-                mapbalance.insert(std::make_pair(it->first.asset, tmp));
-            }
-            if (it->second > 0) {
-                mapbalance[it->first.asset].received += it->second;
-            }
-            if (it->first.txindex == 0 && nHeight - it->first.blockHeight < COINBASE_MATURITY) {
-                mapbalance[it->first.asset].balance_immature += it->second;
-            } else {
-                mapbalance[it->first.asset].balance_spendable += it->second;
-            }
-            mapbalance[it->first.asset].balance += it->second;
-        }
-
         UniValue result(UniValue::VOBJ);
         for (auto it : mapbalance){
             UniValue asset(UniValue::VOBJ);
@@ -1180,6 +1288,8 @@ static UniValue getaddresstxids(const JSONRPCRequest &request) {
                                 {"address", RPCArg::Type::STR, /* default */ "", "The base58check encoded address"},
                         },
                        },
+                       {"limit", RPCArg::Type::NUM, /* default */ "", "Return at most limit txids in index order (address, asset, height) instead of by height, as {\"txids\": [...], \"next_cursor\": \"...\"}. A txid is repeated for every address and asset it touches"},
+                       {"cursor", RPCArg::Type::STR_HEX, /* default */ "\"\"", "Continue after the last txid of a previous page, next_cursor is empty after the last page"},
                },
                RPCResult{
                        RPCResult::Type::ARR, "", "",
@@ -1208,6 +1318,40 @@ static UniValue getaddresstxids(const JSONRPCRequest &request) {
         }
     }
 
+    size_t nLimit = 0;
+    Optional<CAddressIndexKey> cursor;
+    if (ParseAddressIndexPage(request.params[0], nLimit, cursor)) {
+        // The entries of a transaction are next to each other in the index, so a page never splits one
+        UniValue txids(UniValue::VARR);
+        Optional<CAddressIndexKey> last = cursor;
+        uint256 lastTxid;
+        bool fMore = false;
+        const size_t nFirst = FirstPageAddress(addresses, cursor);
+        for (size_t i = nFirst; i < addresses.size() && !fMore; i++) {
+            const CAddressIndexKey *after = i == nFirst && cursor ? &*cursor : nullptr;
+            bool fRead = GetAddressIndex(addresses[i].first, addresses[i].second, "",
+                                         start > 0 && end > 0 ? start : 0, start > 0 && end > 0 ? end : 0, after,
+                                         [&](const CAddressIndexKey &key, CAmount) {
+                if (key.txhash != lastTxid) {
+                    if (txids.size() == nLimit) {
+                        fMore = true;
+                        return false;
+                    }
+                    txids.push_back(key.txhash.GetHex());
+                    lastTxid = key.txhash;
+                }
+                last = key;
+                return true;
+            });
+            if (!fRead) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        }
+        if (!fMore)
+            last = nullopt;
+        return AddressIndexPage("txids", txids, last);
+    }
+
     std::vector <std::pair<CAddressIndexKey, CAmount>> addressIndex;
 
     for (std::vector < std::pair < uint160, int > > ::iterator it = addresses.begin(); it != addresses.end();
@@ -1345,6 +1489,43 @@ static UniValue RPCLockedMemoryInfo() {
     return obj;
 }
 
+static UniValue RPCAssetsCacheInfo() {
+    UniValue obj(UniValue::VOBJ);
+    {
+        LOCK(cs_main);
+        if (passetsCache) {
+            obj.pushKV("usage", uint64_t(passetsCache->DynamicMemoryUsage()));
+            obj.pushKV("max", uint64_t(passetsCache->nMaxMemoryUsage));
+            obj.pushKV("assets", uint64_t(passetsCache->mapAsset.size()));
+            obj.pushKV("assetids", uint64_t(passetsCache->mapAssetId.size()));
+            obj.pushKV("balances", uint64_t(passetsCache->mapAssetAddressAmount.size()));
+        }
+    }
+    obj.pushKV("hits", assetsCacheUsage.nHits.load());
+    obj.pushKV("misses", assetsCacheUsage.nMisses.load());
+    return obj;
+}
+
+static UniValue RPCSmartnodeListCacheInfo() {
+    UniValue obj(UniValue::VOBJ);
+    if (!deterministicMNManager) {
+        return obj;
+    }
+    const auto stats = deterministicMNManager->GetCacheStats();
+    obj.pushKV("usage", uint64_t(stats.nUsage));
+    obj.pushKV("max", uint64_t(stats.nMaxUsage));
+    obj.pushKV("lists", uint64_t(stats.nLists));
+    obj.pushKV("diffs", uint64_t(stats.nDiffs));
+    obj.pushKV("checkpoint", stats.nCheckpointInterval);
+    obj.pushKV("lookups", stats.nLookups);
+    obj.pushKV("hits", stats.nHits);
+    obj.pushKV("diskreads", stats.nDiskReads);
+    obj.pushKV("replayed", stats.nReplayedDiffs);
+    obj.pushKV("maxreplay", stats.nMaxReplay);
+    obj.pushKV("evictions", stats.nEvictions);
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -1391,6 +1572,30 @@ UniValue getmemoryinfo(const JSONRPCRequest &request) {
                                                   {RPCResult::Type::NUM, "chunks_used", "Number allocated chunks"},
                                                   {RPCResult::Type::NUM, "chunks_free", "Number unused chunks"},
                                           }},
+                                         {RPCResult::Type::OBJ, "assets", "Information about the asset cache",
+                                          {
+                                                  {RPCResult::Type::NUM, "usage", "Estimated number of bytes used"},
+                                                  {RPCResult::Type::NUM, "max", "Number of bytes the cache is trimmed to stay under (-assetcache)"},
+                                                  {RPCResult::Type::NUM, "assets", "Number of cached assets"},
+                                                  {RPCResult::Type::NUM, "assetids", "Number of cached asset name to id entries"},
+                                                  {RPCResult::Type::NUM, "balances", "Number of cached address balances"},
+                                                  {RPCResult::Type::NUM, "hits", "Number of lookups served from the cache"},
+                                                  {RPCResult::Type::NUM, "misses", "Number of lookups that read the asset database"},
+                                          }},
+                                         {RPCResult::Type::OBJ, "smartnodelists", "Information about the smartnode list cache",
+                                          {
+                                                  {RPCResult::Type::NUM, "usage", "Estimated number of bytes used by cached lists and diffs"},
+                                                  {RPCResult::Type::NUM, "max", "Number of bytes the cache is trimmed to stay under (-dmnlistcache)"},
+                                                  {RPCResult::Type::NUM, "lists", "Number of cached lists"},
+                                                  {RPCResult::Type::NUM, "diffs", "Number of cached diffs"},
+                                                  {RPCResult::Type::NUM, "checkpoint", "Blocks between lists kept while rebuilding historical lists (-dmnlistcheckpoint)"},
+                                                  {RPCResult::Type::NUM, "lookups", "Number of lists requested"},
+                                                  {RPCResult::Type::NUM, "hits", "Number of lookups served from a cached list without replaying diffs"},
+                                                  {RPCResult::Type::NUM, "diskreads", "Number of snapshots and diffs read from the evo database"},
+                                                  {RPCResult::Type::NUM, "replayed", "Number of diffs replayed over all lookups"},
+                                                  {RPCResult::Type::NUM, "maxreplay", "Most diffs replayed by a single lookup"},
+                                                  {RPCResult::Type::NUM, "evictions", "Number of lists evicted to stay under the budget"},
+                                          }},
                                  }
                        },
                        RPCResult{"mode \"mallocinfo\"",
@@ -1407,6 +1612,8 @@ UniValue getmemoryinfo(const JSONRPCRequest &request) {
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("assets", RPCAssetsCacheInfo());
+        obj.pushKV("smartnodelists", RPCSmartnodeListCacheInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -811,26 +811,7 @@ UniValue listassetsbalance(const JSONRPCRequest &request) {
 
     LOCK2(cs_main, pwallet->cs_wallet);
 
-    std::map <std::string, std::vector<COutput>> mapAssetCoins;
-    pwallet->AvailableAssets(mapAssetCoins);
-
-    std::map <std::string, CAmount> mapAssetbalance;
-    for (auto asset: mapAssetCoins) {
-        CAmount balance = 0;
-        for (auto output: asset.second) {
-            CInputCoin coin(output.tx->tx, output.i);
-
-            if (!coin.txout.scriptPubKey.IsAssetScript()) {
-                continue;
-            }
-
-            CAssetTransfer transferTemp;
-            if (!GetTransferAsset(coin.txout.scriptPubKey, transferTemp))
-                continue;
-            balance += transferTemp.nAmount;
-        }
-        mapAssetbalance.insert(std::make_pair(asset.first, balance));
-    }
+    std::map <std::string, CAmount> mapAssetbalance = pwallet->GetAssetBalances();
 
     UniValue result(UniValue::VOBJ);
     for (auto asset: mapAssetbalance) {
@@ -1044,6 +1025,22 @@ UniValue listunspentassets(const JSONRPCRequest& request)
     return results;
 }
 
+/** Listing cursors are handed to clients as the hex encoded key of the last entry returned */
+static std::string ParseListCursor(const UniValue &param) {
+    const std::string &hex = param.get_str();
+    if (!hex.empty() && !IsHex(hex))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "cursor must be a value returned as next_cursor");
+    const std::vector<unsigned char> key = ParseHex(hex);
+    return std::string(key.begin(), key.end());
+}
+
+static UniValue ListPage(const std::string &name, const UniValue &entries, const std::string &cursor) {
+    UniValue result(UniValue::VOBJ);
+    result.pushKV(name, entries);
+    result.pushKV("next_cursor", HexStr(cursor));
+    return result;
+}
+
 UniValue listassets(const JSONRPCRequest &request) {
     RPCHelpMan{"listassets",
                "\nReturns a list of all assets.\n",
@@ -1051,6 +1048,7 @@ UniValue listassets(const JSONRPCRequest &request) {
             {"verbose", RPCArg::Type::BOOL, /* default */ "false", "false: return list of asset names, true: return list of asset metadata"},
             {"count", RPCArg::Type::STR, /* default */ "ALL", "truncates results to include only the first _count_ assets found"},
             {"start", RPCArg::Type::NUM, /* default */ "0", "results skip over the first _start_ assets found"},
+            {"cursor", RPCArg::Type::STR, /* default */ "", "continue after the last asset of a previous call, \"\" for the first page. start is ignored when not empty and the result becomes {\"assets\": {...}, \"next_cursor\": \"...\"}, next_cursor is empty after the last page"},
         },
         {
             RPCResult{"for verbose = false",
@@ -1110,8 +1108,13 @@ UniValue listassets(const JSONRPCRequest &request) {
         start = request.params[2].get_int();
     }
 
+    const bool fCursor = request.params.size() > 3;
+    std::string cursor;
+    if (fCursor)
+        cursor = ParseListCursor(request.params[3]);
+
     std::vector<CDatabaseAssetData> assets;
-    if (!passetsdb->GetListAssets(assets, count, start))
+    if (!passetsdb->GetListAssets(assets, count, start, cursor))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "couldn't retrieve asset directory.");
 
     UniValue result(UniValue::VOBJ);
@@ -1128,6 +1131,8 @@ UniValue listassets(const JSONRPCRequest &request) {
         }
     }
 
+    if (fCursor)
+        return ListPage("assets", result, cursor);
     return result;
 }
 
@@ -1137,9 +1142,9 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
         return "_This rpc call is not functional unless -assetindex is enabled. To enable, please run the wallet with -assetindex, this will require a reindex to occur";
     }
 
-    if (request.fHelp || !Updates().IsAssetsActive(::ChainActive().Tip()) || request.params.size() > 4 || request.params.size() < 1)
+    if (request.fHelp || !Updates().IsAssetsActive(::ChainActive().Tip()) || request.params.size() > 5 || request.params.size() < 1)
         throw std::runtime_error(
-                "listaddressesbyasset \"asset_name\" (onlytotal) (count) (start)\n"
+                "listaddressesbyasset \"asset_name\" (onlytotal) (count) (start) (\"cursor\")\n"
                 "\nReturns a list of all address that own the given asset (with balances)"
                 "\nOr returns the total size of how many address own the given asset"
 
@@ -1148,6 +1153,7 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
                 "2. \"onlytotal\"                (boolean, optional, default=false) when false result is just a list of addresses with balances -- when true the result is just a single number representing the number of addresses\n"
                 "3. \"count\"                    (integer, optional, default=50000, MAX=50000) truncates results to include only the first _count_ assets found\n"
                 "4. \"start\"                    (integer, optional, default=0) results skip over the first _start_ assets found (if negative it skips back from the end)\n"
+                "5. \"cursor\"                   (string, optional) continue after the last address of a previous call, \"\" for the first page. start is ignored when not empty\n"
 
                 "\nResult:\n"
                 "[ "
@@ -1155,18 +1161,23 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
                 "  ...\n"
                 "]\n"
 
+                "\nResult (when cursor is given):\n"
+                "{\n"
+                "  \"addresses\": { (address): balance, ... },\n"
+                "  \"next_cursor\": \"hex\"    (string) pass as cursor to get the next page, empty after the last page\n"
+                "}\n"
+
                 "\nExamples:\n"
                 + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\" false 2 0")
+                + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\" false 100 0 \"\"")
                 + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\" true")
                 + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\"")
         );
 
-    LOCK(cs_main);
-
     std::string assetId;
 
-    // try to get asset id
-    if (!passetsCache->GetAssetId(request.params[0].get_str(), assetId)) {
+    // try to get asset id, the listing below only takes cs_main for as long as it needs it
+    if (!WITH_LOCK(cs_main, return passetsCache->GetAssetId(request.params[0].get_str(), assetId))) {
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Error: Asset not found");
     }
 
@@ -1186,10 +1197,14 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
         start = request.params[3].get_int();
     }
 
-    LOCK(cs_main);
+    const bool fCursor = request.params.size() > 4;
+    std::string cursor;
+    if (fCursor)
+        cursor = ParseListCursor(request.params[4]);
+
     std::vector<std::pair<std::string, CAmount128> > vecAddressAmounts;
     int nTotalEntries = 0;
-    if (!passetsdb->GetListAddressByAssets(vecAddressAmounts, nTotalEntries, fOnlyTotal, assetId, count, start))
+    if (!passetsdb->GetListAddressByAssets(vecAddressAmounts, nTotalEntries, fOnlyTotal, assetId, count, start, cursor))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "couldn't retrieve address asset directory.");
 
     // If only the number of addresses is wanted return it
@@ -1202,6 +1217,8 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
         result.push_back(Pair(pair.first, pair.second.str()/*ValueFromAmount(pair.second, assetId*/));
     }
 
+    if (fCursor)
+        return ListPage("addresses", result, cursor);
 
     return result;
 }
@@ -1214,7 +1231,7 @@ UniValue listassetbalancesbyaddress(const JSONRPCRequest& request)
 
     if (request.fHelp || !Updates().IsAssetsActive(::ChainActive().Tip()) || request.params.size() < 1)
         throw std::runtime_error(
-            "listassetbalancesbyaddress \"address\" (onlytotal) (count) (start)\n"
+            "listassetbalancesbyaddress \"address\" (onlytotal) (count) (start) (\"cursor\")\n"
             "\nReturns a list of all asset balances for an address.\n"
 
             "\nArguments:\n"
@@ -1222,6 +1239,7 @@ UniValue listassetbalancesbyaddress(const JSONRPCRequest& request)
             "2. \"onlytotal\"                (boolean, optional, default=false) when false result is just a list of assets balances -- when true the result is just a single number representing the number of assets\n"
             "3. \"count\"                    (integer, optional, default=50000, MAX=50000) truncates results to include only the first _count_ assets found\n"
             "4. \"start\"                    (integer, optional, default=0) results skip over the first _start_ assets found (if negative it skips back from the end)\n"
+            "5. \"cursor\"                   (string, optional) continue after the last asset of a previous call, \"\" for the first page. start is ignored when not empty\n"
 
             "\nResult:\n"
             "{\n"
@@ -1229,9 +1247,16 @@ UniValue listassetbalancesbyaddress(const JSONRPCRequest& request)
             "  ...\n"
             "}\n"
 
+            "\nResult (when cursor is given):\n"
+            "{\n"
+            "  \"balances\": { (asset_name) : (quantity), ... },\n"
+            "  \"next_cursor\": \"hex\"    (string) pass as cursor to get the next page, empty after the last page\n"
+            "}\n"
+
 
             "\nExamples:\n"
             + HelpExampleCli("listassetbalancesbyaddress", "\"myaddress\" false 2 0")
+            + HelpExampleCli("listassetbalancesbyaddress", "\"myaddress\" false 100 0 \"\"")
             + HelpExampleCli("listassetbalancesbyaddress", "\"myaddress\" true")
             + HelpExampleCli("listassetbalancesbyaddress", "\"myaddress\"")
         );
@@ -1258,13 +1283,17 @@ UniValue listassetbalancesbyaddress(const JSONRPCRequest& request)
         start = request.params[3].get_int();
     }
 
+    const bool fCursor = request.params.size() > 4;
+    std::string cursor;
+    if (fCursor)
+        cursor = ParseListCursor(request.params[4]);
+
     if (!passetsdb)
         throw JSONRPCError(RPC_INTERNAL_ERROR, "asset db unavailable.");
 
-    LOCK(cs_main);
     std::vector<std::pair<std::string, CAmount128> > vecAssetAmounts;
     int nTotalEntries = 0;
-    if (!passetsdb->GetListAssetsByAddress(vecAssetAmounts, nTotalEntries, fOnlyTotal, address, count, start))
+    if (!passetsdb->GetListAssetsByAddress(vecAssetAmounts, nTotalEntries, fOnlyTotal, address, count, start, cursor))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "couldn't retrieve address asset directory.");
 
     // If only the number of addresses is wanted return it
@@ -1272,6 +1301,7 @@ UniValue listassetbalancesbyaddress(const JSONRPCRequest& request)
         return nTotalEntries;
     }
 
+    LOCK(cs_main);
     UniValue result(UniValue::VOBJ);
     for (auto& pair : vecAssetAmounts) {
         CAssetMetaData tmpAsset;
@@ -1281,6 +1311,8 @@ UniValue listassetbalancesbyaddress(const JSONRPCRequest& request)
         result.push_back(Pair(tmpAsset.name, pair.second.str()));
     }
 
+    if (fCursor)
+        return ListPage("balances", result, cursor);
     return result;
 }
 
@@ -1299,9 +1331,9 @@ static const CRPCCommand commands[] =
             {"assets",      "listassetsbalance",            &listassetsbalance,             {}},
             {"assets",      "listunspentassets",            &listunspentassets,             {"minconf", "maxconf", "addresses", "include_unsafe", "query_options"}},
 #endif //ENABLE_WALLET
-            {"assets",      "listassets",                   &listassets,                    {"verbose", "count", "start"}},
-            {"assets",      "listaddressesbyasset",         &listaddressesbyasset,          {"asset_name", "onlytotal", "count", "start"}},
-            {"assets",      "listassetbalancesbyaddress",   &listassetbalancesbyaddress,    {"address", "onlytotal", "count", "start"} },
+            {"assets",      "listassets",                   &listassets,                    {"verbose", "count", "start", "cursor"}},
+            {"assets",      "listaddressesbyasset",         &listaddressesbyasset,          {"asset_name", "onlytotal", "count", "start", "cursor"}},
+            {"assets",      "listassetbalancesbyaddress",   &listassetbalancesbyaddress,    {"address", "onlytotal", "count", "start", "cursor"} },
         };
 
 void RegisterAssetsRPCCommands(CRPCTable &tableRPC) {
@@ -9,6 +9,9 @@
 #include <hash.h>
 #include <uint256.h>
 
+#include <string>
+#include <utility>
+
 /** Helper classes for std::unordered_map and std::unordered_set hashing */
 
 template<typename T>
@@ -32,6 +35,15 @@ static std::size_t CalcHash(const std::pair <N, uint256> &v, uint64_t k0, uint64
 
 };
 
+template<>
+struct SaltedHasherImpl<std::pair < uint256, uint256>>
+{
+static std::size_t CalcHash(const std::pair <uint256, uint256> &v, uint64_t k0, uint64_t k1) {
+    return CSipHasher(k0, k1).Write(v.first.begin(), v.first.size()).Write(v.second.begin(), v.second.size()).Finalize();
+}
+
+};
+
 template<>
 struct SaltedHasherImpl<uint256> {
     static std::size_t CalcHash(const uint256 &v, uint64_t k0, uint64_t k1) {
@@ -39,6 +51,24 @@ struct SaltedHasherImpl<uint256> {
     }
 };
 
+template<>
+struct SaltedHasherImpl<std::string> {
+    static std::size_t CalcHash(const std::string &v, uint64_t k0, uint64_t k1) {
+        return CSipHasher(k0, k1).Write((const unsigned char *) v.data(), v.size()).Finalize();
+    }
+};
+
+template<>
+struct SaltedHasherImpl<std::pair < std::string, std::string>>
+{
+static std::size_t CalcHash(const std::pair <std::string, std::string> &v, uint64_t k0, uint64_t k1) {
+    // prefix the first string with its length so ("ab", "c") and ("a", "bc") don't collide
+    return CSipHasher(k0, k1).Write(v.first.size()).Write((const unsigned char *) v.first.data(), v.first.size())
+            .Write((const unsigned char *) v.second.data(), v.second.size()).Finalize();
+}
+
+};
+
 struct SaltedHasherBase {
     /** Salt */
     const uint64_t k0, k1;
@@ -241,17 +241,6 @@ const X &ReadWriteAsHelper(const X &x) { return x; }
     }                                                                                               \
     FORMATTER_METHODS(cls, obj)
 
-/** Legacy powCache support */
-#define ADD_POWCACHE_METHOD \
-    template<typename Stream> \
-    void Serialize(Stream& s) const { \
-        NCONST_PTR(this)->SerializationOp(s, CSerActionSerialize()); \
-    } \
-    template<typename Stream> \
-    void Unserialize(Stream& s) { \
-        SerializationOp(s, CSerActionUnserialize()); \
-    }
-
 #ifndef CHAR_EQUALS_INT8
 
 template<typename Stream>
@@ -0,0 +1,127 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <indices/spent_index.h>
+#include <optional.h>
+#include <txdb.h>
+
+#include <test/test_fortuneblock.h>
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(addressindex_tests, BasicTestingSetup)
+
+static CAddressBalanceValue ReadBalance(CBlockTreeDB &blockTree, const uint160 &address, const std::string &asset)
+{
+    std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue>> balances;
+    BOOST_CHECK(blockTree.ReadAddressBalances(address, 1, asset, balances));
+    BOOST_CHECK(balances.size() <= 1);
+    return balances.empty() ? CAddressBalanceValue() : balances[0].second;
+}
+
+BOOST_AUTO_TEST_CASE(address_balance_index)
+{
+    CBlockTreeDB blockTree(1 << 20, true);
+    const uint160 address(std::vector<unsigned char>(20, 0x42));
+
+    // a coinbase output at height 1, spent at height 2 into an asset transfer
+    const std::vector<std::pair<CAddressIndexKey, CAmount>> block1 = {
+            {CAddressIndexKey(1, address, 1, 0, InsecureRand256(), 0, false), 100}};
+    const std::vector<std::pair<CAddressIndexKey, CAmount>> block2 = {
+            {CAddressIndexKey(1, address, 2, 1, InsecureRand256(), 0, true), -40},
+            {CAddressIndexKey(1, address, "asset", 2, 1, InsecureRand256(), 1, false), 5}};
+
+    BOOST_CHECK(blockTree.WriteAddressIndex(block1));
+    BOOST_CHECK(blockTree.WriteAddressIndex(block2));
+    // connecting a block again after an unclean shutdown doesn't count it twice
+    BOOST_CHECK(blockTree.WriteAddressIndex(block2));
+
+    CAddressBalanceValue ftb = ReadBalance(blockTree, address, "FTB");
+    BOOST_CHECK_EQUAL(ftb.balance, 60);
+    BOOST_CHECK_EQUAL(ftb.received, 100);
+    BOOST_CHECK_EQUAL(ReadBalance(blockTree, address, "asset").balance, 5);
+
+    std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue>> balances;
+    BOOST_CHECK(blockTree.ReadAddressBalances(address, 1, "", balances));
+    BOOST_CHECK_EQUAL(balances.size(), 2);
+
+    std::vector<std::pair<CAddressIndexKey, CAmount>> recent;
+    BOOST_CHECK(blockTree.ReadAddressIndex(address, 1, "FTB", 2, recent));
+    BOOST_CHECK_EQUAL(recent.size(), 1);
+    BOOST_CHECK_EQUAL(recent[0].second, -40);
+
+    // rebuilding from the address index gives the same balances and drops the ones without deltas
+    const uint160 stale(std::vector<unsigned char>(20, 0x43));
+    CAddressBalanceValue staleBalance;
+    staleBalance.Add(7);
+    BOOST_CHECK(blockTree.Write(std::make_pair('v', CAddressBalanceKey(1, stale, "FTB")), staleBalance));
+    BOOST_CHECK_EQUAL(ReadBalance(blockTree, stale, "FTB").balance, 7);
+    BOOST_CHECK(blockTree.BuildAddressBalanceIndex());
+    ftb = ReadBalance(blockTree, address, "FTB");
+    BOOST_CHECK_EQUAL(ftb.balance, 60);
+    BOOST_CHECK_EQUAL(ftb.received, 100);
+    BOOST_CHECK(ReadBalance(blockTree, stale, "FTB").IsNull());
+
+    // disconnecting block 2 restores the balances, the asset one is gone
+    BOOST_CHECK(blockTree.EraseAddressIndex(block2));
+    BOOST_CHECK(blockTree.EraseAddressIndex(block2));
+    ftb = ReadBalance(blockTree, address, "FTB");
+    BOOST_CHECK_EQUAL(ftb.balance, 100);
+    BOOST_CHECK_EQUAL(ftb.received, 100);
+    balances.clear();
+    BOOST_CHECK(blockTree.ReadAddressBalances(address, 1, "", balances));
+    BOOST_CHECK_EQUAL(balances.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(address_index_pages)
+{
+    CBlockTreeDB blockTree(1 << 20, true);
+    const uint160 address(std::vector<unsigned char>(20, 0x42));
+
+    // deltas at heights 1..6 for two assets, "FTB" sorts before "asset" as it is shorter
+    std::vector<std::pair<CAddressIndexKey, CAmount>> deltas;
+    for (int height = 1; height <= 6; height++) {
+        deltas.emplace_back(CAddressIndexKey(1, address, height, 0, InsecureRand256(), 0, false), height);
+        deltas.emplace_back(CAddressIndexKey(1, address, "asset", height, 0, InsecureRand256(), 0, false), -height);
+    }
+    BOOST_CHECK(blockTree.WriteAddressIndex(deltas));
+
+    // heights 2..4 of both assets, two entries per page
+    std::vector<CAmount> amounts;
+    Optional<CAddressIndexKey> cursor;
+    int pages = 0;
+    do {
+        size_t page = 0;
+        const CAddressIndexKey *after = cursor ? &*cursor : nullptr;
+        bool fMore = false;
+        BOOST_CHECK(blockTree.ReadAddressIndex(address, 1, "", 2, 4, after, [&](const CAddressIndexKey &key, CAmount amount) {
+            if (page == 2) {
+                fMore = true;
+                return false;
+            }
+            BOOST_CHECK(key.blockHeight >= 2 && key.blockHeight <= 4);
+            amounts.push_back(amount);
+            cursor = key;
+            page++;
+            return true;
+        }));
+        if (!fMore)
+            cursor = nullopt;
+        pages++;
+    } while (cursor && pages < 10);
+    BOOST_CHECK_EQUAL(pages, 3);
+    BOOST_CHECK(amounts == std::vector<CAmount>({2, 3, 4, -2, -3, -4}));
+
+    // one asset from a height on
+    amounts.clear();
+    BOOST_CHECK(blockTree.ReadAddressIndex(address, 1, "FTB", 5, 0, nullptr, [&](const CAddressIndexKey &, CAmount amount) {
+        amounts.push_back(amount);
+        return true;
+    }));
+    BOOST_CHECK(amounts == std::vector<CAmount>({5, 6}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,6 +20,7 @@
 #include <validation.h>
 
 #include <assets/assets.h>
+#include <assets/assetsdb.h>
 #include <assets/assetstype.h>
 #include <core_io.h>
 #include <evo/providertx.h>
@@ -657,4 +658,303 @@ BOOST_FIXTURE_TEST_CASE(assets_invalid_cases, TestChainDIP3BeforeActivationSetup
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(assets_cache_copy, BasicTestingSetup)
+{
+    CAssetsCache base;
+    CDatabaseAssetData data;
+    data.asset.assetId = "asset_a";
+    data.asset.name = "ASSET_A";
+    data.asset.circulatingSupply = 100;
+    base.SetAsset(data.asset.assetId, data);
+    base.SetAssetId(data.asset.name, data.asset.assetId);
+    base.SetAddressAmount(std::make_pair(std::string("addr"), data.asset.assetId), 100);
+
+    // changes made through a copy must not be visible in the cache it was copied from
+    CAssetsCache view(base);
+    BOOST_CHECK(view.UpdateAsset("asset_a", 50 * COIN));
+    view.SetAddressAmount(std::make_pair(std::string("addr"), data.asset.assetId), 150);
+
+    CAssetMetaData meta;
+    BOOST_CHECK(base.GetAssetMetaData("asset_a", meta));
+    BOOST_CHECK_EQUAL(meta.circulatingSupply, 100);
+    BOOST_CHECK(base.mapAssetAddressAmount.at(std::make_pair(std::string("addr"), std::string("asset_a"))) == 100);
+    BOOST_CHECK(base.NewAssetsToAdd.size() == 0);
+    BOOST_CHECK(view.NewAssetsToAdd.size() == 1);
+
+    BOOST_CHECK(view.GetAssetMetaData("asset_a", meta));
+    BOOST_CHECK_EQUAL(meta.circulatingSupply, 150);
+    BOOST_CHECK(view.mapAssetAddressAmount.at(std::make_pair(std::string("addr"), std::string("asset_a"))) == 150);
+}
+
+static CDatabaseAssetData MakeAssetData(const std::string &assetId)
+{
+    CDatabaseAssetData data;
+    data.asset.assetId = assetId;
+    data.asset.name = "NAME_" + assetId;
+    return data;
+}
+
+BOOST_FIXTURE_TEST_CASE(assets_listing_merges_unflushed, TestingSetup)
+{
+    LOCK(cs_main);
+
+    // flushed state
+    for (const std::string assetId : {"asset_a", "asset_b"}) {
+        BOOST_CHECK(passetsdb->WriteAssetData(MakeAssetData(assetId).asset, 1, uint256()));
+    }
+    BOOST_CHECK(passetsdb->UpdateBalances({{{"asset_a", "addr_1"}, {10, false}}, {{"asset_a", "addr_2"}, {10, false}}}));
+
+    // changes not flushed yet: asset_a is removed, asset_c added, addr_2 spends its balance and addr_3 receives one
+    passetsCache->NewAssetsToRemove = passetsCache->NewAssetsToRemove.insert(MakeAssetData("asset_a"));
+    passetsCache->NewAssetsToAdd = passetsCache->NewAssetsToAdd.insert(MakeAssetData("asset_c"));
+    passetsCache->SetAddressAmount(std::make_pair(std::string("asset_a"), std::string("addr_2")), 0);
+    passetsCache->SetAddressAmount(std::make_pair(std::string("asset_a"), std::string("addr_3")), 5);
+    passetsCache->NewAssetsTranferToRemove = passetsCache->NewAssetsTranferToRemove.insert(
+            CAssetTransferEntry(CAssetTransfer("asset_a", 10), "addr_2", COutPoint(InsecureRand256(), 0)));
+    passetsCache->NewAssetsTransferToAdd = passetsCache->NewAssetsTransferToAdd.insert(
+            CAssetTransferEntry(CAssetTransfer("asset_a", 5), "addr_3", COutPoint(InsecureRand256(), 0)));
+
+    std::vector<CDatabaseAssetData> assets;
+    std::string cursor;
+    BOOST_CHECK(passetsdb->GetListAssets(assets, 1, 0, cursor));
+    BOOST_CHECK_EQUAL(assets.size(), 1);
+    BOOST_CHECK_EQUAL(assets[0].asset.assetId, "asset_b");
+    BOOST_CHECK_EQUAL(cursor, "asset_b");
+    BOOST_CHECK(passetsdb->GetListAssets(assets, 1, 0, cursor));
+    BOOST_CHECK_EQUAL(assets.size(), 2);
+    BOOST_CHECK_EQUAL(assets[1].asset.assetId, "asset_c");
+    BOOST_CHECK(cursor.empty());
+
+    for (int flushed = 0; flushed < 2; flushed++) {
+        std::vector<std::pair<std::string, CAmount128> > balances;
+        int total = 0;
+        cursor.clear();
+        BOOST_CHECK(passetsdb->GetListAddressByAssets(balances, total, true, "asset_a", 10, 0, cursor));
+        BOOST_CHECK_EQUAL(total, 2);
+        BOOST_CHECK(passetsdb->GetListAddressByAssets(balances, total, false, "asset_a", 1, 0, cursor));
+        BOOST_CHECK_EQUAL(cursor, "addr_1");
+        BOOST_CHECK(passetsdb->GetListAddressByAssets(balances, total, false, "asset_a", 1, 0, cursor));
+        BOOST_CHECK(cursor.empty());
+        BOOST_CHECK_EQUAL(balances.size(), 2);
+        BOOST_CHECK_EQUAL(balances[0].first, "addr_1");
+        BOOST_CHECK(balances[0].second == 10);
+        BOOST_CHECK_EQUAL(balances[1].first, "addr_3");
+        BOOST_CHECK(balances[1].second == 5);
+
+        BOOST_CHECK(passetsdb->GetListAssetsByAddress(balances, total, true, "addr_2", 10, 0, cursor));
+        BOOST_CHECK_EQUAL(total, 0);
+        BOOST_CHECK(passetsdb->GetListAssetsByAddress(balances, total, true, "addr_3", 10, 0, cursor));
+        BOOST_CHECK_EQUAL(total, 1);
+
+        // the same results once the changes are written out
+        BOOST_CHECK(passetsCache->DumpCacheToDatabase());
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(assets_balance_stored_flags, TestingSetup)
+{
+    LOCK(cs_main);
+    const bool fOldAssetIndex = fAssetIndex;
+    fAssetIndex = true;
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript script = GetScriptForDestination(key.GetPubKey().GetID());
+    auto holders = [] {
+        std::vector<std::pair<std::string, CAmount128> > balances;
+        int total = 0;
+        std::string cursor;
+        BOOST_CHECK(passetsdb->GetListAddressByAssets(balances, total, true, "asset_a", 10, 0, cursor));
+        return total;
+    };
+
+    // a new balance isn't stored yet, it is counted once written
+    CAssetsCache cache;
+    cache.AddAssetBlance(script, CAssetTransfer("asset_a", 5 * COIN), COutPoint(InsecureRand256(), 0));
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(passetsCache->mapBalanceStored.size() == 1 && !passetsCache->mapBalanceStored.begin()->second);
+    BOOST_CHECK(passetsCache->DumpCacheToDatabase());
+    BOOST_CHECK_EQUAL(passetsCache->mapBalanceStored.size(), 0);
+    BOOST_CHECK_EQUAL(holders(), 1);
+
+    // passetsCache holds the written balance, so it knows it is stored and it isn't counted again
+    CAssetsCache cache2;
+    cache2.AddAssetBlance(script, CAssetTransfer("asset_a", 3 * COIN), COutPoint(InsecureRand256(), 0));
+    BOOST_CHECK(cache2.mapBalanceStored.size() == 1 && cache2.mapBalanceStored.begin()->second);
+    BOOST_CHECK(cache2.Flush());
+    BOOST_CHECK(passetsCache->DumpCacheToDatabase());
+    BOOST_CHECK_EQUAL(holders(), 1);
+
+    fAssetIndex = fOldAssetIndex;
+}
+
+BOOST_FIXTURE_TEST_CASE(assets_cache_flush_changes, TestingSetup)
+{
+    LOCK(cs_main);
+
+    for (const std::string assetId : {"asset_a", "asset_b"}) {
+        CDatabaseAssetData data = MakeAssetData(assetId);
+        data.asset.mintCount = 0;
+        passetsCache->SetAsset(assetId, data);
+    }
+    // read from the db by the child cache, but not changed
+    CDatabaseAssetData stored = MakeAssetData("asset_c");
+    BOOST_CHECK(passetsdb->WriteAssetData(stored.asset, 1, uint256()));
+
+    CAssetsCache child;
+    CAssetMetaData meta;
+    BOOST_CHECK(child.GetAssetMetaData("asset_c", meta));
+    BOOST_CHECK(child.UpdateAsset("asset_a", 5 * COIN));
+    BOOST_CHECK(child.Flush());
+
+    // only the changed entry is copied, the others are left as they were
+    BOOST_CHECK_EQUAL(passetsCache->mapAsset.size(), 2);
+    BOOST_CHECK_EQUAL(passetsCache->mapAsset.at("asset_a").asset.mintCount, 1);
+    BOOST_CHECK(passetsCache->mapAsset.count("asset_b"));
+    BOOST_CHECK(!passetsCache->mapAsset.count("asset_c"));
+    BOOST_CHECK(passetsCache->NewAssetsToAdd.count(MakeAssetData("asset_a")));
+}
+
+BOOST_FIXTURE_TEST_CASE(assets_cache_trim, TestingSetup)
+{
+    LOCK(cs_main);
+
+    CAssetsCache &cache = *passetsCache;
+    for (int i = 0; i < 100; i++) {
+        CDatabaseAssetData data = MakeAssetData(strprintf("asset_%03d", i));
+        cache.SetAsset(data.asset.assetId, data);
+    }
+    CDatabaseAssetData dirty = MakeAssetData("asset_dirty");
+    cache.SetAsset(dirty.asset.assetId, dirty);
+    cache.NewAssetsToAdd = cache.NewAssetsToAdd.insert(dirty);
+
+    cache.nMaxMemoryUsage = cache.DynamicMemoryUsage();
+    cache.Trim();
+    BOOST_CHECK_EQUAL(cache.mapAsset.size(), 101);
+
+    // the most recently used entry and the one waiting to be written are kept
+    const uint64_t nHits = assetsCacheUsage.nHits;
+    CAssetMetaData meta;
+    BOOST_CHECK(cache.GetAssetMetaData("asset_000", meta));
+    BOOST_CHECK_EQUAL(assetsCacheUsage.nHits, nHits + 1);
+    BOOST_CHECK(assetsCacheUsage.IsTracked("aasset_000"));
+
+    // lookups of keys passetsCache doesn't hold are not tracked
+    BOOST_CHECK(!cache.GetAssetMetaData("asset_missing", meta));
+    BOOST_CHECK(!assetsCacheUsage.IsTracked("aasset_missing"));
+
+    // keys looked up through another cache are tracked against passetsCache
+    CAssetsCache view(cache);
+    BOOST_CHECK(view.GetAssetMetaData("asset_050", meta));
+    BOOST_CHECK(assetsCacheUsage.IsTracked("aasset_050"));
+
+    cache.nMaxMemoryUsage /= 2;
+    cache.Trim();
+    BOOST_CHECK(cache.DynamicMemoryUsage() <= cache.nMaxMemoryUsage / 4 * 3);
+    BOOST_CHECK(cache.mapAsset.size() < 101);
+    BOOST_CHECK(cache.mapAsset.count("asset_000"));
+    BOOST_CHECK(cache.mapAsset.count("asset_dirty"));
+
+    // the recency list holds exactly the keys that are left
+    BOOST_CHECK_EQUAL(assetsCacheUsage.Size(), cache.mapAsset.size());
+    for (const auto &item : cache.mapAsset)
+        BOOST_CHECK(assetsCacheUsage.IsTracked("a" + item.first));
+
+    // the running total matches the entries that are left
+    size_t usage = assetsCacheUsage.DynamicMemoryUsage();
+    for (const auto &item : cache.mapAsset)
+        usage += CAssetsCache::AssetEntryUsage(item.second);
+    for (const auto &item : cache.mapAssetId)
+        usage += CAssetsCache::AssetIdEntryUsage(item.first, item.second);
+    for (const auto &item : cache.mapAssetAddressAmount)
+        usage += CAssetsCache::BalanceEntryUsage(item.first);
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), usage);
+}
+
+BOOST_FIXTURE_TEST_CASE(assets_transfer_decoding, BasicTestingSetup)
+{
+    CKey key;
+    key.MakeNewKey(false);
+    const std::string assetId = uint256S("0x1234").ToString();
+
+    CMutableTransaction tx;
+    tx.vout.emplace_back(1 * COIN, GetScriptForDestination(key.GetPubKey().GetID()));
+    for (const CAssetTransfer &transfer : {CAssetTransfer(assetId, 5 * COIN), CAssetTransfer(assetId, 2 * COIN, 7)}) {
+        CScript scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
+        transfer.BuildAssetTransaction(scriptPubKey);
+        tx.vout.emplace_back(0, scriptPubKey);
+    }
+
+    CAssetTransfer transfer;
+    BOOST_CHECK(!GetTransferAsset(tx.vout[0].scriptPubKey, transfer));
+    BOOST_CHECK(GetTransferAsset(tx.vout[2].scriptPubKey, transfer));
+    BOOST_CHECK_EQUAL(transfer.assetId, assetId);
+    BOOST_CHECK(transfer.isUnique);
+    BOOST_CHECK_EQUAL(transfer.uniqueId, 7);
+    BOOST_CHECK_EQUAL(transfer.nAmount, 2 * COIN);
+
+    // a truncated transfer doesn't decode
+    CScript truncated(tx.vout[1].scriptPubKey.begin(), tx.vout[1].scriptPubKey.end() - 4);
+    BOOST_CHECK(!GetTransferAsset(truncated, transfer));
+
+    const CTransaction ctx(tx);
+    const CTxAssetTransfers transfers(ctx);
+    BOOST_CHECK(transfers.Get(0) == nullptr);
+    BOOST_CHECK(transfers.Get(1) != nullptr && transfers.Get(1)->nAmount == 5 * COIN && !transfers.Get(1)->isUnique);
+    BOOST_CHECK(transfers.Get(2) != nullptr && transfers.Get(2)->uniqueId == 7);
+    BOOST_CHECK(transfers.Get(3) == nullptr);
+
+    tx.vout.resize(1);
+    BOOST_CHECK(CTxAssetTransfers(CTransaction(tx)).Get(0) == nullptr);
+}
+
+BOOST_FIXTURE_TEST_CASE(assets_coin_asset_tag, BasicTestingSetup)
+{
+    CKey key;
+    key.MakeNewKey(false);
+    const std::string assetId = uint256S("0x1234").ToString();
+    CScript scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
+    CAssetTransfer(assetId, 2 * COIN, 7).BuildAssetTransaction(scriptPubKey);
+
+    CMutableTransaction tx;
+    tx.vin.emplace_back(InsecureRand256(), 0);
+    tx.vout.emplace_back(1 * COIN, GetScriptForDestination(key.GetPubKey().GetID()));
+    tx.vout.emplace_back(0, scriptPubKey);
+    const CTransaction ctx(tx);
+
+    // AddCoins decodes the tag, the caches the coin passes through afterwards copy it
+    CCoinsView base;
+    CCoinsViewCache parent(&base);
+    AddCoins(parent, ctx, 1);
+    CCoinsViewCache child(&parent);
+    const Coin &plain = child.AccessCoin(COutPoint(ctx.GetHash(), 0));
+    const Coin &coin = child.AccessCoin(COutPoint(ctx.GetHash(), 1));
+    BOOST_CHECK(plain.fAssetDecoded && !plain.IsAsset());
+    BOOST_CHECK(coin.fAssetDecoded && coin.IsAsset());
+    BOOST_CHECK(coin.pAssetId == parent.AccessCoin(COutPoint(ctx.GetHash(), 1)).pAssetId);
+    BOOST_CHECK_EQUAL(*coin.pAssetId, assetId);
+    BOOST_CHECK_EQUAL(coin.nAssetAmount, 2 * COIN);
+    BOOST_CHECK(coin.fAssetUnique && coin.nAssetUniqueId == 7);
+
+    CAssetTransfer transfer;
+    BOOST_CHECK(GetCoinTransferAsset(coin, transfer));
+    BOOST_CHECK_EQUAL(transfer.assetId, assetId);
+    BOOST_CHECK_EQUAL(transfer.uniqueId, 7);
+    BOOST_CHECK(!GetCoinTransferAsset(plain, transfer));
+
+    // the payload is serialized as the std::vector was before, the tag isn't serialized but decoded again
+    const std::vector<uint8_t> payload(84, 0x5a);
+    Coin future(CTxOut(0, scriptPubKey), 10, false, TRANSACTION_FUTURE, payload);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << future;
+    CDataStream expected(SER_DISK, CLIENT_VERSION);
+    expected << VARINT(uint32_t{20}) << Using<TxOutCompression>(future.out) << VARINT(uint16_t{TRANSACTION_FUTURE})
+             << payload;
+    BOOST_CHECK_EQUAL(HexStr(ss), HexStr(expected));
+    Coin read;
+    ss >> read;
+    BOOST_CHECK(std::vector<uint8_t>(read.vExtraPayload.begin(), read.vExtraPayload.end()) == payload);
+    BOOST_CHECK(read.fAssetDecoded && read.pAssetId == coin.pAssetId && read.nAssetAmount == 2 * COIN);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
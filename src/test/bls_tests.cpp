@@ -5,6 +5,7 @@
 
 #include <bls/bls.h>
 #include <bls/bls_batchverifier.h>
+#include <bls/bls_worker.h>
 #include <test/test_fortuneblock.h>
 
 #include <boost/test/unit_test.hpp>
@@ -152,4 +153,47 @@ BOOST_AUTO_TEST_CASE(batch_verifier_tests)
         Verify(msgs);
         }
 
+static void VerifySharded(CBLSWorker &worker, std::vector <Message> &vec, bool secureVerification,
+                          bool perMessageFallback) {
+    CBLSBatchVerifier <uint32_t, uint32_t> batchVerifier(secureVerification, perMessageFallback);
+    CBLSShardedBatchVerifier <uint32_t, uint32_t> shardedVerifier(secureVerification, perMessageFallback);
+    for (auto &m: vec) {
+        batchVerifier.PushMessage(m.sourceId, m.msgId, m.msgHash, m.sig, m.pk);
+        shardedVerifier.PushMessage(m.msgHash, m.sourceId, m.msgId, m.msgHash, m.sig, m.pk);
+    }
+
+    batchVerifier.Verify();
+    shardedVerifier.Verify(worker);
+    BOOST_CHECK_EQUAL(shardedVerifier.GetBatchCount(worker), std::min<size_t>(worker.GetVerifyThreadCount(), 8));
+
+    // same attribution as a single batch, no matter how the messages were split up
+    BOOST_CHECK(shardedVerifier.badSources == batchVerifier.badSources);
+    BOOST_CHECK(shardedVerifier.badMessages == batchVerifier.badMessages);
+}
+
+BOOST_AUTO_TEST_CASE(sharded_batch_verifier_tests)
+{
+    CBLSWorker worker;
+    worker.Start();
+
+    std::vector <Message> msgs;
+    for (uint32_t i = 0; i < 64; i++) {
+        // a few sources sending many messages, some of which share a message hash, and a few invalid ones
+        AddMessage(msgs, i % 5, i, i % 40, i % 13 != 7);
+    }
+    CBLSShardedBatchVerifier <uint32_t, uint32_t> emptyVerifier(false, true);
+    BOOST_CHECK_EQUAL(emptyVerifier.GetBatchCount(worker), 1U);
+    for (bool secure: {false, true}) {
+        for (bool perMessageFallback: {false, true}) {
+            VerifySharded(worker, msgs, secure, perMessageFallback);
+        }
+    }
+
+    // without a running pool everything is verified on the calling thread
+    CBLSWorker stoppedWorker;
+    VerifySharded(stoppedWorker, msgs, false, true);
+
+    worker.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
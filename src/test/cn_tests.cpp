@@ -17,6 +17,8 @@
 #include <util/strencodings.h>
 #include <test/test_fortuneblock.h>
 
+#include <algorithm>
+#include <array>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -172,4 +174,97 @@ BOOST_AUTO_TEST_CASE(cryptonight_turtlelite_hash) {
         "00000000000000000000000000000000000000000000000000000000000000002796a3dac94528970f4d86d90558c128adcd67409514b499ac16bf28cbc567a1");
 }
 
+BOOST_AUTO_TEST_CASE(cryptonight_accelerated_matches_standard) {
+    // Whatever implementation cn_slow_hash_autodetect() picks must agree with the portable one bit for bit
+    const std::string impl = cn_slow_hash_autodetect();
+    BOOST_TEST_MESSAGE("cn_slow_hash implementation: " << impl);
+    for (int hashSelection = 0; hashSelection < 6; ++hashSelection) {
+        for (int i = 0; i < 4; ++i) {
+            uint512 in;
+            for (unsigned char &byte: in) byte = InsecureRandBits(8);
+            uint512 accelerated, standard;
+
+            cn_slow_hash_autodetect();
+            cnHash(&in, &accelerated, 64, hashSelection);
+            cn_slow_hash_use_standard();
+            cnHash(&in, &standard, 64, hashSelection);
+
+            BOOST_CHECK_MESSAGE(accelerated == standard, impl << " differs for variant " << hashSelection);
+        }
+    }
+    cn_slow_hash_autodetect();
+}
+
+BOOST_AUTO_TEST_CASE(ghostrider_schedule) {
+    for (int i = 0; i < 8; ++i) {
+        const uint256 prevBlockHash = InsecureRand256();
+        const GhostRiderSchedule schedule(prevBlockHash);
+
+        // both orders must be permutations of all the available algorithms
+        std::array<uint8_t, GhostRiderSchedule::CORE_ALGO_COUNT> core = schedule.GetCoreIndexes();
+        std::sort(core.begin(), core.end());
+        for (int j = 0; j < GhostRiderSchedule::CORE_ALGO_COUNT; ++j) BOOST_CHECK_EQUAL(core[j], j);
+        std::array<uint8_t, GhostRiderSchedule::CN_VARIANT_COUNT> cn = schedule.GetCnIndexes();
+        std::sort(cn.begin(), cn.end());
+        for (int j = 0; j < GhostRiderSchedule::CN_VARIANT_COUNT; ++j) BOOST_CHECK_EQUAL(cn[j], j);
+
+        std::vector<unsigned char> header(80);
+        for (unsigned char &byte: header) byte = InsecureRandBits(8);
+        BOOST_CHECK(HashFortune(header.begin(), header.end(), schedule) ==
+                    HashFortune(header.begin(), header.end(), prevBlockHash));
+    }
+}
+
+static void TestHashFortune(int seed, const std::string &prevBlockHash, const std::string &desired) {
+    std::vector<unsigned char> header(80);
+    for (size_t i = 0; i < header.size(); ++i) header[i] = i * 7 + seed * 13;
+    const uint256 prev = uint256S(prevBlockHash);
+
+    BOOST_CHECK_EQUAL(HashFortune(header.begin(), header.end(), prev).ToString(), desired);
+    BOOST_CHECK_EQUAL(HashFortune(header.begin(), header.end(), GhostRiderSchedule(prev)).ToString(), desired);
+    uint256 batched;
+    HashFortuneBatch(header.data(), header.size(), 1, GhostRiderSchedule(prev), &batched);
+    BOOST_CHECK_EQUAL(batched.ToString(), desired);
+}
+
+BOOST_AUTO_TEST_CASE(ghostrider_known_answers) {
+    // produced by the HashSelection based implementation this code replaced
+    TestHashFortune(0, "00000000000000000000000000000000000000000000000000000000000000ff",
+                    "518cd853b0c405054119d16b9405f77a9ac0adafac300bd6fb2de918e51ce1cd");
+    TestHashFortune(1, "7ac1d6a4c1b2f0e2d3c4b5a69788796a5b4c3d2e1f00112233445566778899aa",
+                    "8bc79bf555711b024c9c81fe7db30abd8eb6e4a7d877effb636e8e83953c6ac5");
+    TestHashFortune(2, "0000000000000000000000000000000000000000000000000000000000000000",
+                    "1dc39b9ea0248cd99ba48b363fa7eb0455e9284821af42e904100c14fabade3f");
+}
+
+BOOST_AUTO_TEST_CASE(core_hash_batch_matches_single) {
+    BOOST_TEST_MESSAGE("core hash implementation: " << CoreHashAutoDetect());
+    // 7 inputs: one full group of four for the multi-buffer path plus a remainder hashed one by one
+    std::vector<uint512> in(7), batch(7);
+    for (uint512 &input: in) {
+        for (unsigned char &byte: input) byte = InsecureRandBits(8);
+    }
+    for (int algo = 0; algo < GhostRiderSchedule::CORE_ALGO_COUNT; ++algo) {
+        coreHashBatch(in.data(), batch.data(), in.size(), algo);
+        for (size_t i = 0; i < in.size(); ++i) {
+            uint512 single;
+            coreHash(&in[i], &single, 64, algo);
+            BOOST_CHECK_MESSAGE(batch[i] == single, "algo " << algo << " differs for input " << i);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ghostrider_batch_matches_single) {
+    const GhostRiderSchedule schedule(InsecureRand256());
+    const size_t count = 5;
+    std::vector<unsigned char> headers(80 * count);
+    for (unsigned char &byte: headers) byte = InsecureRandBits(8);
+
+    uint256 hashes[count];
+    HashFortuneBatch(headers.data(), 80, count, schedule, hashes);
+    for (size_t i = 0; i < count; ++i) {
+        BOOST_CHECK(hashes[i] == HashFortune(headers.begin() + 80 * i, headers.begin() + 80 * (i + 1), schedule));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
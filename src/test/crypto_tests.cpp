@@ -746,4 +746,20 @@ BOOST_AUTO_TEST_CASE(sha256d64)
                 }
         }
 
+BOOST_AUTO_TEST_CASE(sha256_64)
+        {
+                for (int i = 0; i <= 32; ++i) {
+                    unsigned char in[64 * 32];
+                    unsigned char out1[32 * 32], out2[32 * 32];
+                    for (int j = 0; j < 64 * i; ++j) {
+                        in[j] = InsecureRandBits(8);
+                    }
+                    for (int j = 0; j < i; ++j) {
+                        CSHA256().Write(in + 64 * j, 64).Finalize(out1 + 32 * j);
+                    }
+                    SHA256_64(out2, in, i);
+                    BOOST_CHECK(memcmp(out1, out2, 32 * i) == 0);
+                }
+        }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,7 @@
 #include <evo/specialtx.h>
 #include <evo/providertx.h>
 #include <evo/deterministicmns.h>
+#include <evo/simplifiedmns.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -1252,4 +1253,296 @@ CoinsTip(),
 4, 2));
 }
 
+static int ExpectedPaymentHeight(const CDeterministicMNCPtr &dmn) {
+    const auto &state = *dmn->pdmnState;
+    if (state.nPoSeRevivedHeight != -1 && state.nPoSeRevivedHeight > state.nLastPaidHeight) {
+        return state.nPoSeRevivedHeight;
+    }
+    return state.nLastPaidHeight != 0 ? state.nLastPaidHeight : state.nRegisteredHeight;
+}
+
+static std::vector <CDeterministicMNCPtr> ExpectedPayees(const CDeterministicMNList &mnList) {
+    std::vector <CDeterministicMNCPtr> result;
+    mnList.ForEachMN(true, [&](const CDeterministicMNCPtr &dmn) { result.emplace_back(dmn); });
+    std::sort(result.begin(), result.end(), [](const CDeterministicMNCPtr &a, const CDeterministicMNCPtr &b) {
+        int ah = ExpectedPaymentHeight(a), bh = ExpectedPaymentHeight(b);
+        return ah != bh ? ah < bh : a->proTxHash < b->proTxHash;
+    });
+    return result;
+}
+
+static void CheckPaymentOrder(const CDeterministicMNList &mnList) {
+    auto expected = ExpectedPayees(mnList);
+    BOOST_CHECK(mnList.GetProjectedMNPayees(expected.size() + 10) == expected);
+    BOOST_CHECK_EQUAL(mnList.GetProjectedMNPayees(5).size(), std::min<size_t>(5, expected.size()));
+    BOOST_CHECK(mnList.GetMNPayee() == (expected.empty() ? nullptr : expected.front()));
+}
+
+BOOST_FIXTURE_TEST_CASE(dmn_payment_order, RegTestingSetup)
+{
+    const CAmount nPayableCollateral = Params().GetConsensus().nCollaterals.getCollateral(0);
+
+    CDeterministicMNList mnList(uint256(), 0, 0);
+    for (int i = 0; i < 100; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>(i);
+        dmn->proTxHash = InsecureRand256();
+        dmn->collateralOutpoint = COutPoint(InsecureRand256(), 0);
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->keyIDOwner.SetHex(strprintf("%040x", i + 1));
+        // plenty of equal heights so the proTxHash tie break matters
+        state->nRegisteredHeight = InsecureRandRange(20);
+        state->nLastPaidHeight = InsecureRandBool() ? 0 : InsecureRandRange(20);
+        // a few MNs with a collateral which is not payable and a few banned ones
+        state->nCollateralAmount = i % 10 == 0 ? nPayableCollateral + 1 : nPayableCollateral;
+        if (i % 7 == 0) {
+            state->BanIfNotBanned(10);
+        }
+        dmn->pdmnState = state;
+        mnList.AddMN(dmn);
+    }
+    CheckPaymentOrder(mnList);
+
+    // pay, ban, revive and remove MNs the way ProcessBlock does, the snapshot must not see any of it
+    const CDeterministicMNList snapshot = mnList;
+    const auto snapshotPayees = ExpectedPayees(snapshot);
+    for (int nHeight = 20; nHeight < 120; nHeight++) {
+        auto payee = mnList.GetMNPayee();
+        BOOST_REQUIRE(payee);
+        auto newState = std::make_shared<CDeterministicMNState>(*payee->pdmnState);
+        newState->nLastPaidHeight = nHeight;
+        mnList.UpdateMN(payee, newState);
+
+        auto dmn = mnList.GetMNByInternalId(InsecureRandRange(100));
+        if (!dmn) {
+            continue;
+        }
+        switch (InsecureRandRange(4)) {
+        case 0: {
+            auto state = std::make_shared<CDeterministicMNState>(*dmn->pdmnState);
+            state->BanIfNotBanned(nHeight);
+            mnList.UpdateMN(dmn->proTxHash, state);
+            break;
+        }
+        case 1: {
+            auto state = std::make_shared<CDeterministicMNState>(*dmn->pdmnState);
+            state->Revive(nHeight);
+            mnList.UpdateMN(dmn, CDeterministicMNStateDiff(*dmn->pdmnState, *state));
+            break;
+        }
+        case 2:
+            mnList.RemoveMN(dmn->proTxHash);
+            break;
+        }
+        CheckPaymentOrder(mnList);
+    }
+    BOOST_CHECK(snapshot.GetProjectedMNPayees(snapshotPayees.size()) == snapshotPayees);
+
+    // the order is not serialized, it must be rebuilt when reading the list back
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << mnList;
+    CDeterministicMNList mnList2;
+    ss >> mnList2;
+    BOOST_CHECK(mnList2.GetProjectedMNPayees(mnList2.GetAllMNsCount()) == ExpectedPayees(mnList));
+}
+
+BOOST_FIXTURE_TEST_CASE(dmn_quorum_calculation, RegTestingSetup)
+{
+    const CAmount nPayableCollateral = Params().GetConsensus().nCollaterals.getCollateral(0);
+
+    CDeterministicMNList mnList(uint256(), 0, 0);
+    for (int i = 0; i < 77; i++) {
+        auto dmn = std::make_shared<CDeterministicMN>(i);
+        dmn->proTxHash = InsecureRand256();
+        dmn->collateralOutpoint = COutPoint(InsecureRand256(), 0);
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->keyIDOwner.SetHex(strprintf("%040x", i + 1));
+        state->nCollateralAmount = nPayableCollateral;
+        // unconfirmed MNs never make it into a quorum
+        if (i % 5 != 0) {
+            state->UpdateConfirmedHash(dmn->proTxHash, InsecureRand256());
+        }
+        dmn->pdmnState = state;
+        mnList.AddMN(dmn);
+    }
+
+    // scores and the full sort the way they were computed before the partial selection and batched hashing
+    const uint256 modifier = InsecureRand256();
+    std::vector <std::pair<arith_uint256, CDeterministicMNCPtr>> expected;
+    mnList.ForEachMN(true, mnList.GetHeight(), [&](const CDeterministicMNCPtr &dmn) {
+        if (dmn->pdmnState->confirmedHash.IsNull()) {
+            return;
+        }
+        uint256 h;
+        CSHA256()
+                .Write(dmn->pdmnState->confirmedHashWithProRegTxHash.begin(), 32)
+                .Write(modifier.begin(), modifier.size())
+                .Finalize(h.begin());
+        expected.emplace_back(UintToArith256(h), dmn);
+    });
+    std::sort(expected.begin(), expected.end(), [](const auto &a, const auto &b) {
+        return a.first != b.first ? b.first < a.first : b.second->collateralOutpoint < a.second->collateralOutpoint;
+    });
+
+    for (size_t quorumSize: {0, 1, 10, 61, 100}) {
+        auto quorum = mnList.CalculateQuorum(quorumSize, modifier);
+        BOOST_REQUIRE_EQUAL(quorum.size(), std::min(quorumSize, expected.size()));
+        for (size_t i = 0; i < quorum.size(); i++) {
+            BOOST_CHECK(quorum[i] == expected[i].second);
+        }
+    }
+}
+
+// in the order the diff sends them, which must not depend on how it was built
+static std::vector <std::string> SimplifiedDiffToStrings(const CSimplifiedMNListDiff &diff) {
+    std::vector <std::string> result;
+    for (const auto &proTxHash: diff.deletedMNs) {
+        result.emplace_back("deleted " + proTxHash.ToString());
+    }
+    for (const auto &e: diff.mnList) {
+        result.emplace_back(e.ToString());
+    }
+    return result;
+}
+
+BOOST_FIXTURE_TEST_CASE(dmn_simplified_diff, RegTestingSetup)
+{
+    const CAmount nPayableCollateral = Params().GetConsensus().nCollaterals.getCollateral(0);
+
+    auto newMN = [&](uint64_t internalId) {
+        auto dmn = std::make_shared<CDeterministicMN>(internalId);
+        dmn->proTxHash = InsecureRand256();
+        dmn->collateralOutpoint = COutPoint(InsecureRand256(), 0);
+        auto state = std::make_shared<CDeterministicMNState>();
+        state->keyIDOwner.SetHex(strprintf("%040x", internalId + 1));
+        state->keyIDVoting = state->keyIDOwner;
+        state->nCollateralAmount = nPayableCollateral;
+        dmn->pdmnState = state;
+        return dmn;
+    };
+
+    std::vector <CDeterministicMNList> lists;
+    std::vector <CDeterministicMNListDiff> diffs;
+    CDeterministicMNList mnList(uint256(), 0, 0);
+    for (int i = 0; i < 30; i++) {
+        mnList.AddMN(newMN(mnList.GetTotalRegisteredCount()));
+    }
+    lists.emplace_back(mnList);
+    diffs.emplace_back();
+
+    // register, update, ban and remove MNs, some blocks don't change the simplified list at all
+    for (int nHeight = 1; nHeight < 40; nHeight++) {
+        mnList.SetHeight(nHeight);
+        mnList.SetBlockHash(ArithToUint256(nHeight));
+        for (int j = InsecureRandRange(3); j > 0; j--) {
+            auto dmn = mnList.GetMNByInternalId(InsecureRandRange(mnList.GetTotalRegisteredCount()));
+            switch (InsecureRandRange(5)) {
+            case 0:
+                mnList.AddMN(newMN(mnList.GetTotalRegisteredCount()));
+                break;
+            case 1:
+                if (dmn) {
+                    mnList.RemoveMN(dmn->proTxHash);
+                }
+                break;
+            case 2:
+                if (dmn) {
+                    auto state = std::make_shared<CDeterministicMNState>(*dmn->pdmnState);
+                    state->BanIfNotBanned(nHeight);
+                    mnList.UpdateMN(dmn->proTxHash, state);
+                }
+                break;
+            case 3:
+                if (dmn) {
+                    auto state = std::make_shared<CDeterministicMNState>(*dmn->pdmnState);
+                    state->keyIDVoting.SetHex(strprintf("%040x", InsecureRandRange(1000)));
+                    mnList.UpdateMN(dmn->proTxHash, state);
+                }
+                break;
+            case 4:
+                // not part of the simplified list
+                if (dmn) {
+                    auto state = std::make_shared<CDeterministicMNState>(*dmn->pdmnState);
+                    state->nLastPaidHeight = nHeight;
+                    mnList.UpdateMN(dmn->proTxHash, state);
+                }
+                break;
+            }
+        }
+        diffs.emplace_back(lists.back().BuildDiff(mnList));
+        lists.emplace_back(mnList);
+    }
+
+    // replaying the ids of the per-block diffs in between gives the same diff as comparing the full lists
+    for (size_t base = 0; base < lists.size(); base++) {
+        std::set <uint64_t> changedIds;
+        for (size_t i = base; i < lists.size(); i++) {
+            if (i > base) {
+                for (const auto &dmn: diffs[i].addedMNs) {
+                    changedIds.emplace(dmn->GetInternalId());
+                }
+                for (const auto &p: diffs[i].updatedMNs) {
+                    changedIds.emplace(p.first);
+                }
+                changedIds.insert(diffs[i].removedMns.begin(), diffs[i].removedMns.end());
+            }
+            auto expected = lists[base].BuildSimplifiedDiff(lists[i]);
+            auto diff = lists[base].BuildSimplifiedDiff(lists[i], changedIds);
+            BOOST_CHECK(diff.baseBlockHash == expected.baseBlockHash);
+            BOOST_CHECK(diff.blockHash == expected.blockHash);
+            BOOST_CHECK(SimplifiedDiffToStrings(diff) == SimplifiedDiffToStrings(expected));
+        }
+    }
+}
+
+static std::string SerializeMNList(const CDeterministicMNList &mnList) {
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << mnList;
+    return ss.str();
+}
+
+BOOST_FIXTURE_TEST_CASE(dmn_list_cache, TestChainDIP3Setup)
+{
+    const CBlockIndex *tip = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+
+    // a manager with an empty cache and a checkpoint every 10 blocks, the global one serves as reference
+    CDeterministicMNManager mnManager(*evoDb, *m_node.connman, 10);
+    mnManager.UpdatedBlockTip(tip);
+
+    const CBlockIndex *pindex = tip->GetAncestor(tip->nHeight - 5);
+    BOOST_CHECK(SerializeMNList(mnManager.GetListForBlock(pindex)) ==
+                SerializeMNList(deterministicMNManager->GetListForBlock(pindex)));
+    auto stats = mnManager.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.nLookups, 1U);
+    BOOST_CHECK_EQUAL(stats.nHits, 0U);
+    BOOST_CHECK(stats.nDiskReads > 10);
+    BOOST_CHECK(stats.nMaxReplay > 10);
+
+    // the replay above left a checkpoint every 10 blocks, nothing below it replays more than 9 diffs now
+    for (int nHeight = tip->nHeight - 6; nHeight > tip->nHeight - 40; nHeight--) {
+        pindex = tip->GetAncestor(nHeight);
+        const uint64_t nReplayed = mnManager.GetCacheStats().nReplayedDiffs;
+        BOOST_CHECK(SerializeMNList(mnManager.GetListForBlock(pindex)) ==
+                    SerializeMNList(deterministicMNManager->GetListForBlock(pindex)));
+        stats = mnManager.GetCacheStats();
+        BOOST_CHECK_LE(stats.nReplayedDiffs - nReplayed, 9U);
+        if (nHeight % 10 == 0) {
+            BOOST_CHECK_EQUAL(stats.nReplayedDiffs, nReplayed);
+        }
+    }
+    BOOST_CHECK(stats.nHits >= 3);
+    BOOST_CHECK_EQUAL(stats.nEvictions, 0U);
+
+    // with no budget everything but the tip list is evicted again after each lookup, which still gets the right list
+    CDeterministicMNManager mnTinyManager(*evoDb, *m_node.connman, 10, 1);
+    mnTinyManager.UpdatedBlockTip(tip);
+    pindex = tip->GetAncestor(tip->nHeight - 5);
+    BOOST_CHECK(SerializeMNList(mnTinyManager.GetListForBlock(pindex)) ==
+                SerializeMNList(deterministicMNManager->GetListForBlock(pindex)));
+    stats = mnTinyManager.GetCacheStats();
+    BOOST_CHECK(stats.nEvictions > 0);
+    BOOST_CHECK_EQUAL(stats.nLists, 0U);
+    BOOST_CHECK_EQUAL(stats.nDiffs, 0U);
+    BOOST_CHECK_EQUAL(stats.nUsage, 0U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -70,4 +70,51 @@ BOOST_AUTO_TEST_CASE(simplifiedmns_merkleroots)
         BOOST_CHECK(expectedMerkleRoot == calculatedMerkleRoot);
         }
 
+BOOST_AUTO_TEST_CASE(simplifiedmns_merkle_cache)
+{
+    std::vector <CSimplifiedMNListEntry> entries;
+    for (size_t i = 0; i < 40; i++) {
+        CSimplifiedMNListEntry smle;
+        smle.proRegTxHash = InsecureRand256();
+        smle.confirmedHash = InsecureRand256();
+        smle.keyIDVoting.SetHex(strprintf("%040x", i));
+        smle.isValid = true;
+        entries.emplace_back(smle);
+    }
+
+    // add, change and remove entries from one list to the next, the root must match the one computed from scratch
+    CSimplifiedMNListMerkleCache merkleCache;
+    for (int i = 0; i < 50; i++) {
+        switch (InsecureRandRange(4)) {
+        case 0: {
+            CSimplifiedMNListEntry smle;
+            smle.proRegTxHash = InsecureRand256();
+            smle.isValid = true;
+            entries.emplace_back(smle);
+            break;
+        }
+        case 1:
+            entries[InsecureRandRange(entries.size())].isValid ^= true;
+            break;
+        case 2:
+            entries.erase(entries.begin() + InsecureRandRange(entries.size()));
+            break;
+        }
+
+        CSimplifiedMNList sml(entries);
+        bool mutated = true;
+        const uint256 expectedMerkleRoot = sml.CalcMerkleRoot(nullptr);
+        BOOST_CHECK(merkleCache.CalcMerkleRoot(std::move(sml), &mutated) == expectedMerkleRoot);
+        BOOST_CHECK(!mutated);
+    }
+
+    // two leaves with the same hash make the tree mutated, also when the root comes from the unchanged list
+    const std::vector <CSimplifiedMNListEntry> duplicates(2, entries.front());
+    for (int i = 0; i < 2; i++) {
+        bool mutated = false;
+        merkleCache.CalcMerkleRoot(CSimplifiedMNList(duplicates), &mutated);
+        BOOST_CHECK(mutated);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,176 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/test_fortuneblock.h>
+
+#include <bls/bls.h>
+#include <llmq/quorums_instantsend.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+BOOST_FIXTURE_TEST_SUITE(llmq_instantsend_tests, BasicTestingSetup
+)
+
+static CInstantSendLockPtr BuildISLock(uint8_t nVersion) {
+    auto islock = std::make_shared<CInstantSendLock>(nVersion);
+    islock->inputs.emplace_back(InsecureRand256(), 0);
+    islock->inputs.emplace_back(InsecureRand256(), 1);
+    islock->txid = InsecureRand256();
+    CBLSSecretKey sk;
+    sk.MakeNewKey();
+    islock->sig.Set(sk.Sign(islock->txid));
+    return islock;
+}
+
+class FailingInstantSendDb : public CInstantSendDb {
+public:
+    using CInstantSendDb::CInstantSendDb;
+
+    bool fFail{true};
+
+protected:
+    bool WriteCommitBatch(CDBBatch &batch) override
+    {
+        return !fFail && CInstantSendDb::WriteCommitBatch(batch);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(isdb_batch_visible_before_commit)
+{
+    CInstantSendDb db(true, true);
+
+    CInstantSendDb::Batch batch;
+    std::vector <CInstantSendLockPtr> islocks;
+    for (int i = 0; i < 10; i++) {
+        islocks.emplace_back(BuildISLock(CInstantSendLock::isdlock_version));
+        db.WriteNewInstantSendLock(::SerializeHash(*islocks.back()), *islocks.back(), &batch);
+    }
+
+    // the later stages of the same batch already see the new locks, nobody else does before the commit
+    for (const auto &islock: islocks) {
+        const uint256 hash = ::SerializeHash(*islock);
+        BOOST_CHECK(db.KnownInstantSendLock(hash, &batch));
+        const auto staged = db.GetInstantSendLockByTxid(islock->txid, &batch);
+        BOOST_CHECK(staged != nullptr && ::SerializeHash(*staged) == hash);
+        BOOST_CHECK(db.GetInstantSendLockByInput(islock->inputs.back(), &batch) != nullptr);
+        BOOST_CHECK(!db.KnownInstantSendLock(hash));
+        BOOST_CHECK(db.GetInstantSendLockByTxid(islock->txid) == nullptr);
+    }
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), 0U);
+
+    // writers without the batch are not held back by it
+    auto other = BuildISLock(CInstantSendLock::isdlock_version);
+    db.WriteNewInstantSendLock(::SerializeHash(*other), *other);
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), 1U);
+
+    BOOST_CHECK(db.CommitBatch(batch));
+    BOOST_CHECK(batch.empty());
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), islocks.size() + 1);
+    for (const auto &islock: islocks) {
+        const uint256 hash = ::SerializeHash(*islock);
+        BOOST_CHECK(db.GetInstantSendLockByHash(hash, false) != nullptr);
+        BOOST_CHECK(db.GetInstantSendLockHashByTxid(islock->txid) == hash);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(isdb_batch_keeps_write_order)
+{
+    CInstantSendDb db(true, true);
+
+    // a deterministic lock replacing a non-deterministic one for the same TX within the same batch
+    auto islock = BuildISLock(CInstantSendLock::islock_version);
+    auto isdlock = std::make_shared<CInstantSendLock>(*islock);
+    isdlock->nVersion = CInstantSendLock::isdlock_version;
+    isdlock->cycleHash = InsecureRand256();
+    const uint256 hash = ::SerializeHash(*islock);
+    const uint256 dhash = ::SerializeHash(*isdlock);
+
+    CInstantSendDb::Batch batch;
+    db.WriteNewInstantSendLock(hash, *islock, &batch);
+    db.RemoveAndArchiveInstantSendLock(islock, 100, &batch);
+    BOOST_CHECK(db.KnownInstantSendLock(hash, &batch));
+    BOOST_CHECK(db.GetInstantSendLockByTxid(islock->txid, &batch) == nullptr);
+    db.WriteNewInstantSendLock(dhash, *isdlock, &batch);
+    BOOST_CHECK(db.CommitBatch(batch));
+
+    BOOST_CHECK(db.GetInstantSendLockByHash(hash, false) == nullptr);
+    BOOST_CHECK(db.KnownInstantSendLock(hash));
+    BOOST_CHECK(db.GetInstantSendLockByHash(dhash, false) != nullptr);
+    BOOST_CHECK(db.GetInstantSendLockHashByTxid(isdlock->txid) == dhash);
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(isdb_batch_races_remove_confirmed)
+{
+    CInstantSendDb db(true, true);
+
+    auto mined = BuildISLock(CInstantSendLock::islock_version);
+    const uint256 minedHash = ::SerializeHash(*mined);
+    db.WriteNewInstantSendLock(minedHash, *mined);
+    db.WriteInstantSendLockMined(minedHash, 5);
+
+    // the batch archives the mined lock and adds a new one which is mined as well
+    CInstantSendDb::Batch batch;
+    auto islock = BuildISLock(CInstantSendLock::isdlock_version);
+    const uint256 hash = ::SerializeHash(*islock);
+    db.RemoveAndArchiveInstantSendLock(mined, 20, &batch);
+    db.WriteNewInstantSendLock(hash, *islock, &batch);
+    db.WriteInstantSendLockMined(hash, 5, &batch);
+
+    // a ChainLock confirms height 5 before the batch is committed
+    auto removed = db.RemoveConfirmedInstantSendLocks(10);
+    BOOST_CHECK_EQUAL(removed.size(), 1U);
+    BOOST_CHECK(removed.count(minedHash));
+    BOOST_CHECK(db.GetInstantSendLockByHash(hash) == nullptr);
+
+    BOOST_CHECK(db.CommitBatch(batch));
+    // the already removed lock is not written back, the new one made it to the disk and the caches alike
+    BOOST_CHECK(db.GetInstantSendLockByHash(minedHash, false) == nullptr);
+    BOOST_CHECK(db.KnownInstantSendLock(minedHash));
+    BOOST_CHECK(db.GetInstantSendLockByHash(hash, false) != nullptr);
+    BOOST_CHECK(db.GetInstantSendLockByHash(hash) != nullptr);
+    BOOST_CHECK(db.GetInstantSendLockByInput(islock->inputs.front()) != nullptr);
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), 1U);
+
+    // and its mined entry came along, so the next ChainLock removes it as well
+    removed = db.RemoveConfirmedInstantSendLocks(10);
+    BOOST_CHECK_EQUAL(removed.size(), 1U);
+    BOOST_CHECK(removed.count(hash));
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(isdb_batch_commit_failure)
+{
+    FailingInstantSendDb db(true, true);
+
+    auto old = BuildISLock(CInstantSendLock::islock_version);
+    const uint256 oldHash = ::SerializeHash(*old);
+    db.fFail = false;
+    db.WriteNewInstantSendLock(oldHash, *old);
+
+    CInstantSendDb::Batch batch;
+    auto islock = BuildISLock(CInstantSendLock::isdlock_version);
+    const uint256 hash = ::SerializeHash(*islock);
+    db.RemoveAndArchiveInstantSendLock(old, 100, &batch);
+    db.WriteNewInstantSendLock(hash, *islock, &batch);
+
+    db.fFail = true;
+    BOOST_CHECK(!db.CommitBatch(batch));
+    BOOST_CHECK(batch.empty());
+
+    // neither the DB nor the caches know about the batch
+    BOOST_CHECK(!db.KnownInstantSendLock(hash));
+    BOOST_CHECK(db.GetInstantSendLockByHash(hash) == nullptr);
+    BOOST_CHECK(db.GetInstantSendLockByTxid(islock->txid) == nullptr);
+    BOOST_CHECK(db.GetInstantSendLockByInput(islock->inputs.front()) == nullptr);
+    BOOST_CHECK(db.GetInstantSendLockByHash(oldHash) != nullptr);
+    BOOST_CHECK(db.GetInstantSendLockByHash(oldHash, false) != nullptr);
+    BOOST_CHECK(db.GetInstantSendLockHashByTxid(old->txid) == oldHash);
+    BOOST_CHECK(db.GetInstantSendLockByInput(old->inputs.front()) != nullptr);
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
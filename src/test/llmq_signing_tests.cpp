@@ -0,0 +1,104 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/test_fortuneblock.h>
+
+#include <bls/bls.h>
+#include <llmq/quorums_signing.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+BOOST_FIXTURE_TEST_SUITE(llmq_signing_tests, BasicTestingSetup
+)
+
+static std::shared_ptr<const CRecoveredSig> BuildRecSig() {
+    CBLSSecretKey sk;
+    sk.MakeNewKey();
+    const uint256 msgHash = InsecureRand256();
+    return std::make_shared<const CRecoveredSig>(Consensus::LLMQ_5_60, InsecureRand256(), InsecureRand256(),
+                                                 msgHash, sk.Sign(msgHash));
+}
+
+static void CheckHasRecSig(const CRecoveredSigsDb &db, const CRecoveredSig &recSig, bool fExpected) {
+    BOOST_CHECK_EQUAL(db.HasRecoveredSig(recSig.getLlmqType(), recSig.getId(), recSig.getMsgHash()), fExpected);
+    BOOST_CHECK_EQUAL(db.HasRecoveredSigForId(recSig.getLlmqType(), recSig.getId()), fExpected);
+    BOOST_CHECK_EQUAL(db.HasRecoveredSigForSession(recSig.buildSignHash()), fExpected);
+    BOOST_CHECK_EQUAL(db.HasRecoveredSigForHash(recSig.GetHash()), fExpected);
+
+    CRecoveredSig ret;
+    BOOST_CHECK_EQUAL(db.GetRecoveredSigById(recSig.getLlmqType(), recSig.getId(), ret), fExpected);
+    if (fExpected) {
+        BOOST_CHECK(ret.GetHash() == recSig.GetHash());
+    }
+    CRecoveredSig ret2;
+    BOOST_CHECK_EQUAL(db.GetRecoveredSigByHash(recSig.GetHash(), ret2), fExpected);
+}
+
+BOOST_AUTO_TEST_CASE(recsigdb_read_your_writes)
+{
+    CRecoveredSigsDb db(true, true);
+
+    std::vector <std::shared_ptr<const CRecoveredSig>> recSigs;
+    for (int i = 0; i < 10; i++) {
+        recSigs.emplace_back(BuildRecSig());
+        db.WriteRecoveredSig(*recSigs.back());
+    }
+
+    // queued writes are visible before they hit the db
+    BOOST_CHECK_EQUAL(db.GetPendingWriteCount(), recSigs.size());
+    for (const auto &recSig: recSigs) {
+        CheckHasRecSig(db, *recSig, true);
+        BOOST_CHECK(!db.HasRecoveredSig(recSig->getLlmqType(), recSig->getId(), InsecureRand256()));
+    }
+
+    db.FlushPendingWrites();
+    BOOST_CHECK_EQUAL(db.GetPendingWriteCount(), 0U);
+    for (const auto &recSig: recSigs) {
+        CheckHasRecSig(db, *recSig, true);
+    }
+
+    // truncating a queued recSig flushes it first, so the byHash key stays in place
+    auto recSig = BuildRecSig();
+    db.WriteRecoveredSig(*recSig);
+    db.TruncateRecoveredSig(recSig->getLlmqType(), recSig->getId());
+    BOOST_CHECK_EQUAL(db.GetPendingWriteCount(), 0U);
+    BOOST_CHECK(!db.HasRecoveredSigForId(recSig->getLlmqType(), recSig->getId()));
+    BOOST_CHECK(db.HasRecoveredSigForHash(recSig->GetHash()));
+}
+
+BOOST_AUTO_TEST_CASE(recsigdb_cleanup_whole_buckets)
+{
+    CRecoveredSigsDb db(true, true);
+
+    const int64_t bucket = CRecoveredSigsDb::CLEANUP_BUCKET_SECONDS;
+    const int64_t maxAge = 2 * bucket;
+    const int64_t t0 = 1000 * bucket;
+
+    SetMockTime(t0);
+    auto recSig1 = BuildRecSig();
+    db.WriteRecoveredSig(*recSig1);
+    db.FlushPendingWrites();
+
+    SetMockTime(t0 + bucket / 2);
+    auto recSig2 = BuildRecSig();
+    db.WriteRecoveredSig(*recSig2);
+    db.FlushPendingWrites();
+
+    // both are older than maxAge, but their bucket has not fully expired yet
+    SetMockTime(t0 + maxAge + bucket - 1);
+    db.CleanupOldRecoveredSigs(maxAge);
+    CheckHasRecSig(db, *recSig1, true);
+    CheckHasRecSig(db, *recSig2, true);
+
+    SetMockTime(t0 + maxAge + bucket);
+    db.CleanupOldRecoveredSigs(maxAge);
+    CheckHasRecSig(db, *recSig1, false);
+    CheckHasRecSig(db, *recSig2, false);
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
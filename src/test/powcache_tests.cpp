@@ -0,0 +1,294 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <primitives/powcache.h>
+#include <primitives/powcachestore.h>
+#include <streams.h>
+#include <txdb.h>
+#include <version.h>
+
+#include <test/test_fortuneblock.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(powcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(powcache_get_or_compute)
+{
+    CPowCache cache(1000, false, 10);
+    const uint256 headerHash = InsecureRand256();
+    const uint256 powHash = InsecureRand256();
+
+    int calls = 0;
+    auto compute = [&] { ++calls; return powHash; };
+
+    BOOST_CHECK(cache.GetOrCompute(headerHash, compute) == powHash);
+    BOOST_CHECK(cache.GetOrCompute(headerHash, compute) == powHash);
+    BOOST_CHECK_EQUAL(calls, 1);
+
+    // bypassing the cache always recomputes
+    BOOST_CHECK(cache.GetOrCompute(headerHash, compute, false) == powHash);
+    BOOST_CHECK_EQUAL(calls, 2);
+
+    uint256 cached;
+    BOOST_CHECK(cache.get(headerHash, cached));
+    BOOST_CHECK(cached == powHash);
+    cache.erase(headerHash);
+    BOOST_CHECK(!cache.exists(headerHash));
+}
+
+BOOST_AUTO_TEST_CASE(powcache_concurrent_dedup)
+{
+    CPowCache cache(1000, false, 10);
+    const uint256 headerHash = InsecureRand256();
+    const uint256 powHash = InsecureRand256();
+
+    std::atomic<int> calls{0};
+    auto compute = [&] {
+        ++calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        return powHash;
+    };
+
+    std::vector<std::thread> threads;
+    std::atomic<int> mismatches{0};
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&] {
+            if (cache.GetOrCompute(headerHash, compute) != powHash) ++mismatches;
+        });
+    }
+    for (auto &t : threads) t.join();
+
+    BOOST_CHECK_EQUAL(calls, 1);
+    BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(powcache_serialize_roundtrip)
+{
+    CPowCache cache(1000, false, 10);
+    std::vector<std::pair<uint256, uint256>> entries;
+    for (int i = 0; i < 100; ++i) {
+        entries.emplace_back(InsecureRand256(), InsecureRand256());
+        cache.insert(entries.back().first, entries.back().second);
+    }
+    BOOST_CHECK_EQUAL(cache.size(), 100U);
+
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << cache;
+
+    CPowCache loaded(1000, false, 10);
+    ss >> loaded;
+    BOOST_CHECK_EQUAL(loaded.size(), 100U);
+    for (const auto &entry : entries) {
+        uint256 powHash;
+        BOOST_CHECK(loaded.get(entry.first, powHash));
+        BOOST_CHECK(powHash == entry.second);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(powcache_store_flush_and_compact)
+{
+    const fs::path dir = GetDataDir() / "powcache_store";
+    std::vector<std::pair<uint256, uint256>> entries;
+    {
+        CPowCacheStore store(dir);
+        BOOST_CHECK(store.Open());
+        for (int segment = 0; segment < 3; ++segment) {
+            for (int i = 0; i < 50; ++i) {
+                entries.emplace_back(InsecureRand256(), InsecureRand256());
+                store.Append(entries.back().first, entries.back().second);
+            }
+            BOOST_CHECK(store.Flush());
+        }
+        // a newer segment shadows an older value for the same header
+        entries[0].second = InsecureRand256();
+        store.Append(entries[0].first, entries[0].second);
+        BOOST_CHECK(store.Flush());
+        BOOST_CHECK_EQUAL(store.PendingSize(), 0U);
+        BOOST_CHECK_EQUAL(store.SegmentCount(), 4U);
+        BOOST_CHECK_EQUAL(store.RecordCount(), 151U);
+
+        uint256 powHash;
+        BOOST_CHECK(store.Find(entries[0].first, powHash));
+        BOOST_CHECK(powHash == entries[0].second);
+        BOOST_CHECK(!store.Find(InsecureRand256(), powHash));
+    }
+
+    // reopening maps the segments written before, compaction keeps the newest values
+    CPowCacheStore store(dir);
+    BOOST_CHECK(store.Open());
+    BOOST_CHECK_EQUAL(store.SegmentCount(), 4U);
+    BOOST_CHECK(store.Compact());
+    BOOST_CHECK_EQUAL(store.SegmentCount(), 1U);
+    BOOST_CHECK_EQUAL(store.RecordCount(), 150U);
+    for (const auto &entry : entries) {
+        uint256 powHash;
+        BOOST_CHECK(store.Find(entry.first, powHash));
+        BOOST_CHECK(powHash == entry.second);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(powcache_reads_through_store)
+{
+    const fs::path dir = GetDataDir() / "powcache_readthrough";
+    const uint256 headerHash = InsecureRand256();
+    const uint256 powHash = InsecureRand256();
+
+    int calls = 0;
+    auto compute = [&] { ++calls; return powHash; };
+    {
+        CPowCache cache(1000, false, 10);
+        BOOST_CHECK(cache.Open(dir));
+        BOOST_CHECK(cache.GetOrCompute(headerHash, compute) == powHash);
+        BOOST_CHECK(cache.Flush());
+    }
+
+    // a fresh cache has nothing in memory but finds the hash on disk
+    CPowCache cache(1000, false, 10);
+    BOOST_CHECK(cache.Open(dir));
+    BOOST_CHECK_EQUAL(cache.size(), 0U);
+    BOOST_CHECK(cache.exists(headerHash));
+    BOOST_CHECK(cache.GetOrCompute(headerHash, compute) == powHash);
+    BOOST_CHECK_EQUAL(calls, 1);
+    BOOST_CHECK_EQUAL(cache.size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(powcache_get_and_insert_use_store)
+{
+    const fs::path dir = GetDataDir() / "powcache_get_insert";
+    const uint256 headerHash = InsecureRand256();
+    const uint256 powHash = InsecureRand256();
+    {
+        CPowCache cache(1000, false, 10);
+        BOOST_CHECK(cache.Open(dir));
+        cache.insert(headerHash, powHash);
+        // the store finds buffered entries before they are flushed
+        cache.erase(headerHash);
+        uint256 buffered;
+        BOOST_CHECK(cache.get(headerHash, buffered));
+        BOOST_CHECK(buffered == powHash);
+        BOOST_CHECK(cache.Flush());
+    }
+
+    CPowCache cache(1000, false, 10);
+    BOOST_CHECK(cache.Open(dir));
+    BOOST_CHECK_EQUAL(cache.size(), 0U);
+    uint256 stored;
+    BOOST_CHECK(cache.get(headerHash, stored));
+    BOOST_CHECK(stored == powHash);
+    // the hit is kept in memory
+    BOOST_CHECK_EQUAL(cache.size(), 1U);
+    BOOST_CHECK(!cache.get(InsecureRand256(), stored));
+}
+
+BOOST_AUTO_TEST_CASE(powcache_store_prune)
+{
+    CPowCacheStore store(GetDataDir() / "powcache_prune");
+    BOOST_CHECK(store.Open());
+    std::vector<std::pair<uint256, uint256>> entries;
+    for (int segment = 0; segment < 3; ++segment) {
+        for (int i = 0; i < 50; ++i) {
+            entries.emplace_back(InsecureRand256(), InsecureRand256());
+            store.Append(entries.back().first, entries.back().second);
+        }
+        BOOST_CHECK(store.Flush());
+    }
+    BOOST_CHECK_EQUAL(store.CompactableCount(), 3U);
+
+    // below the limit nothing is removed
+    store.Prune(150);
+    BOOST_CHECK_EQUAL(store.RecordCount(), 150U);
+
+    // the oldest segments go first
+    store.Prune(100);
+    BOOST_CHECK_EQUAL(store.SegmentCount(), 2U);
+    uint256 powHash;
+    BOOST_CHECK(!store.Find(entries[0].first, powHash));
+    BOOST_CHECK(store.Find(entries[50].first, powHash));
+
+    // the newest segment is always kept
+    store.Prune(0);
+    BOOST_CHECK_EQUAL(store.SegmentCount(), 1U);
+    BOOST_CHECK(store.Find(entries[149].first, powHash));
+    BOOST_CHECK(powHash == entries[149].second);
+}
+
+BOOST_AUTO_TEST_CASE(block_tree_stores_pow_hash)
+{
+    CBlockTreeDB blockTree(1 << 20, true);
+    const uint256 hashWithPow = InsecureRand256();
+    const uint256 hashWithoutPow = InsecureRand256();
+
+    CBlockIndex withPow;
+    withPow.phashBlock = &hashWithPow;
+    withPow.hashPow = InsecureRand256();
+    CBlockIndex withoutPow;
+    withoutPow.phashBlock = &hashWithoutPow;
+    BOOST_CHECK(blockTree.WriteBatchSync({}, 0, {&withPow, &withoutPow}));
+
+    std::vector<std::pair<uint256, uint256>> stored;
+    BOOST_CHECK(blockTree.ReadPOWHashes([&stored](const uint256 &blockHash, const uint256 &powHash) {
+        stored.emplace_back(blockHash, powHash);
+    }));
+    BOOST_REQUIRE_EQUAL(stored.size(), 1U);
+    BOOST_CHECK(stored[0].first == hashWithPow);
+    BOOST_CHECK(stored[0].second == withPow.hashPow);
+
+    // importing into the PoW cache skips hashes the store already has
+    CPowCache cache(1000, false, 10);
+    BOOST_CHECK(cache.Open(GetDataDir() / "powcache_import"));
+    cache.Import(hashWithPow, withPow.hashPow);
+    BOOST_CHECK(cache.Flush());
+    cache.Import(hashWithPow, withPow.hashPow);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(cache.exists(hashWithPow));
+    BOOST_CHECK(cache.ToString().find("stored: 1 in 1 segments") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(block_tree_loads_pow_hash)
+{
+    const Consensus::Params &consensus = Params().GetConsensus();
+    CBlockTreeDB blockTree(1 << 20, true);
+    const uint256 hashes[3] = {InsecureRand256(), InsecureRand256(), InsecureRand256()};
+    CBlockIndex written[3];
+    for (int i = 0; i < 3; ++i) {
+        written[i].phashBlock = &hashes[i];
+        written[i].nBits = UintToArith256(consensus.powLimit).GetCompact();
+        written[i].hashPow = uint256S("01");
+    }
+    // a hash that doesn't meet the target
+    written[1].hashPow = uint256S("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    BOOST_CHECK(blockTree.WriteBatchSync({}, 0, {&written[0], &written[1], &written[2]}));
+    // a PoW hash without its block index entry
+    BOOST_CHECK(blockTree.Erase(std::make_pair('b', hashes[2]), true));
+
+    std::map<uint256, std::unique_ptr<CBlockIndex>> index;
+    auto insert = [&index](const uint256 &hash) -> CBlockIndex * {
+        if (hash.IsNull()) return nullptr;
+        auto it = index.emplace(hash, std::make_unique<CBlockIndex>()).first;
+        it->second->phashBlock = &it->first;
+        return it->second.get();
+    };
+    auto lookup = [&index](const uint256 &hash) -> CBlockIndex * {
+        auto it = index.find(hash);
+        return it == index.end() ? nullptr : it->second.get();
+    };
+    BOOST_CHECK(blockTree.LoadBlockIndexGuts(consensus, insert, lookup));
+
+    // the orphan hash doesn't create an entry, the invalid one is dropped
+    BOOST_REQUIRE_EQUAL(index.size(), 2U);
+    BOOST_CHECK(index.at(hashes[0])->hashPow == written[0].hashPow);
+    BOOST_CHECK(index.at(hashes[1])->hashPow.IsNull());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -71,6 +71,8 @@ BasicTestingSetup::BasicTestingSetup(const std::string &chainName)
     SelectParams(chainName);
     SeedInsecureRand();
     SHA256AutoDetect();
+    cn_slow_hash_autodetect();
+    CoreHashAutoDetect();
     ECC_Start();
     RandomInit();
     BLSInit();
@@ -82,6 +84,7 @@ BasicTestingSetup::BasicTestingSetup(const std::string &chainName)
     g_wallet_init_interface.Construct(m_node);
     fCheckBlockIndex = true;
     passetsCache.reset(new CAssetsCache());
+    assetsCacheUsage.Clear();
     evoDb.reset(new CEvoDB(1 << 20, true, true));
     connman = MakeUnique<CConnman>(0x1337, 0x1337);
     deterministicMNManager.reset(new CDeterministicMNManager(*evoDb, *connman));
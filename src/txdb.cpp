@@ -18,6 +18,7 @@
 #include <ui_interface.h>
 
 #include <stdint.h>
+#include <limits>
 
 #include <boost/thread.hpp>
 
@@ -26,10 +27,12 @@ static const char DB_COINS = 'c';
 static const char DB_BLOCK_FILES = 'f';
 static const char DB_ADDRESSINDEX = 'a';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
+static const char DB_ADDRESSBALANCEINDEX = 'v';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
 static const char DB_FUTUREINDEX = 'n';
 static const char DB_BLOCK_INDEX = 'b';
+static const char DB_BLOCK_POWHASH = 'w';
 
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_HEAD_BLOCKS = 'H';
@@ -234,6 +237,10 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector <std::pair<int, const CBlock
     batch.Write(DB_LAST_BLOCK, nLastFile);
     for (std::vector<const CBlockIndex *>::const_iterator it = blockinfo.begin(); it != blockinfo.end(); it++) {
         batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), CDiskBlockIndex(*it));
+        // kept under its own key instead of in CDiskBlockIndex so older versions can still read the index
+        if (!(*it)->hashPow.IsNull()) {
+            batch.Write(std::make_pair(DB_BLOCK_POWHASH, (*it)->GetBlockHash()), (*it)->hashPow);
+        }
     }
     return WriteBatch(batch, true);
 }
@@ -299,32 +306,85 @@ CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector <std::pair<CAddressUns
 
 bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
                                            std::vector <std::pair<CAddressUnspentKey, CAddressUnspentValue>> &unspentOutputs) {
+    return ReadAddressUnspentIndex(addressHash, type, "", nullptr,
+                                   [&](const CAddressUnspentKey &key, const CAddressUnspentValue &value) {
+                                       unspentOutputs.push_back(std::make_pair(key, value));
+                                       return true;
+                                   });
+}
+
+bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type, const std::string &asset,
+                                           const CAddressUnspentKey *after,
+                                           const std::function<bool(const CAddressUnspentKey &, const CAddressUnspentValue &)> &fn) {
 
     std::unique_ptr <CDBIterator> pcursor(NewIterator());
 
-    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    if (after) {
+        // keys of the same index never prefix each other, so the key followed by a zero byte is the next one
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, std::make_pair(*after, '\0')));
+    } else if (asset.empty()) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorAssetKey(type, addressHash, asset)));
+    }
 
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char, CAddressUnspentKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
-            CAddressUnspentValue nValue;
-            if (pcursor->GetValue(nValue)) {
-                unspentOutputs.push_back(std::make_pair(key.second, nValue));
-                pcursor->Next();
-            } else {
-                return error("failed to get address unspent value");
-            }
-        } else {
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSUNSPENTINDEX || key.second.type != (unsigned int)type ||
+            key.second.hashBytes != addressHash || (!asset.empty() && key.second.asset != asset)) {
+            break;
+        }
+        CAddressUnspentValue nValue;
+        if (!pcursor->GetValue(nValue)) {
+            return error("failed to get address unspent value");
+        }
+        if (!fn(key.second, nValue)) {
             break;
         }
+        pcursor->Next();
     }
 
     return true;
 }
 
+/**
+ * Apply the deltas of the address index entries about to be written (or erased) to the balance index in the
+ * same batch. Nothing is applied if the entries are already written (or already gone), so a block connected
+ * again after an unclean shutdown is not counted twice. The entries of a block are always written and erased
+ * together in one batch, so looking at the first one is enough.
+ */
+static void UpdateAddressBalanceIndex(CBlockTreeDB &db, CDBBatch &batch,
+                                      const std::vector <std::pair<CAddressIndexKey, CAmount>> &vect, bool fErase) {
+    if (vect.empty() || db.Exists(std::make_pair(DB_ADDRESSINDEX, vect.front().first)) != fErase)
+        return;
+    std::map <CAddressBalanceKey, CAddressBalanceValue> balances;
+    for (const auto &entry : vect) {
+        CAddressBalanceKey key(entry.first);
+        auto it = balances.find(key);
+        if (it == balances.end()) {
+            CAddressBalanceValue value;
+            db.Read(std::make_pair(DB_ADDRESSBALANCEINDEX, key), value);
+            it = balances.emplace(key, value).first;
+        }
+        if (fErase) {
+            it->second.Remove(entry.second);
+        } else {
+            it->second.Add(entry.second);
+        }
+    }
+    for (const auto &it : balances) {
+        if (it.second.IsNull()) {
+            batch.Erase(std::make_pair(DB_ADDRESSBALANCEINDEX, it.first));
+        } else {
+            batch.Write(std::make_pair(DB_ADDRESSBALANCEINDEX, it.first), it.second);
+        }
+    }
+}
+
 bool CBlockTreeDB::WriteAddressIndex(const std::vector <std::pair<CAddressIndexKey, CAmount>> &vect) {
     CDBBatch batch(*this);
+    UpdateAddressBalanceIndex(*this, batch, vect, false);
     for (std::vector < std::pair < CAddressIndexKey, CAmount > > ::const_iterator it = vect.begin(); it != vect.end();
     it++)
     batch.Write(std::make_pair(DB_ADDRESSINDEX, it->first), it->second);
@@ -333,6 +393,7 @@ bool CBlockTreeDB::WriteAddressIndex(const std::vector <std::pair<CAddressIndexK
 
 bool CBlockTreeDB::EraseAddressIndex(const std::vector <std::pair<CAddressIndexKey, CAmount>> &vect) {
     CDBBatch batch(*this);
+    UpdateAddressBalanceIndex(*this, batch, vect, true);
     for (std::vector < std::pair < CAddressIndexKey, CAmount > > ::const_iterator it = vect.begin(); it != vect.end();
     it++)
     batch.Erase(std::make_pair(DB_ADDRESSINDEX, it->first));
@@ -342,28 +403,97 @@ bool CBlockTreeDB::EraseAddressIndex(const std::vector <std::pair<CAddressIndexK
 bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
                                     std::vector <std::pair<CAddressIndexKey, CAmount>> &addressIndex,
                                     int start, int end) {
+    return ReadAddressIndex(addressHash, type, "", start > 0 && end > 0 ? start : 0, end, nullptr,
+                            [&](const CAddressIndexKey &key, CAmount nValue) {
+                                addressIndex.push_back(std::make_pair(key, nValue));
+                                return true;
+                            });
+}
+
+bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type, const std::string &asset, int start,
+                                    std::vector <std::pair<CAddressIndexKey, CAmount>> &addressIndex) {
+    return ReadAddressIndex(addressHash, type, asset, start, 0, nullptr,
+                            [&](const CAddressIndexKey &key, CAmount nValue) {
+                                addressIndex.push_back(std::make_pair(key, nValue));
+                                return true;
+                            });
+}
+
+bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type, const std::string &asset, int start, int end,
+                                    const CAddressIndexKey *after,
+                                    const std::function<bool(const CAddressIndexKey &, CAmount)> &fn) {
 
     std::unique_ptr <CDBIterator> pcursor(NewIterator());
 
-    if (start > 0 && end > 0) {
-        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
-    } else {
+    if (after) {
+        // keys of the same index never prefix each other, so the key followed by a zero byte is the next one
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, std::make_pair(*after, '\0')));
+    } else if (asset.empty()) {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorAssetHeightKey(type, addressHash, asset, start)));
     }
 
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char, CAddressIndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash) {
-            if (end > 0 && key.second.blockHeight > end) {
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX || key.second.type != (unsigned int)type ||
+            key.second.hashBytes != addressHash || (!asset.empty() && key.second.asset != asset)) {
+            break;
+        }
+        // the entries of an asset are sorted by height, so out of range heights are skipped with one seek
+        if (key.second.blockHeight < start) {
+            pcursor->Seek(std::make_pair(DB_ADDRESSINDEX,
+                                         CAddressIndexIteratorAssetHeightKey(type, addressHash, key.second.asset, start)));
+            continue;
+        }
+        if (end > 0 && key.second.blockHeight > end) {
+            if (!asset.empty()) {
                 break;
             }
-            CAmount nValue;
-            if (pcursor->GetValue(nValue)) {
-                addressIndex.push_back(std::make_pair(key.second, nValue));
+            pcursor->Seek(std::make_pair(DB_ADDRESSINDEX,
+                                         CAddressIndexIteratorAssetHeightKey(type, addressHash, key.second.asset,
+                                                                             std::numeric_limits<int>::max())));
+            continue;
+        }
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue)) {
+            return error("failed to get address index value");
+        }
+        if (!fn(key.second, nValue)) {
+            break;
+        }
+        pcursor->Next();
+    }
+
+    return true;
+}
+
+bool CBlockTreeDB::ReadAddressBalances(uint160 addressHash, int type, const std::string &asset,
+                                       std::vector <std::pair<CAddressBalanceKey, CAddressBalanceValue>> &balances) {
+    if (!asset.empty()) {
+        CAddressBalanceKey key(type, addressHash, asset);
+        CAddressBalanceValue value;
+        if (Read(std::make_pair(DB_ADDRESSBALANCEINDEX, key), value))
+            balances.push_back(std::make_pair(key, value));
+        return true;
+    }
+
+    std::unique_ptr <CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSBALANCEINDEX, CAddressIndexIteratorKey(type, addressHash)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CAddressBalanceKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSBALANCEINDEX && key.second.type == (unsigned int)type &&
+            key.second.hashBytes == addressHash) {
+            CAddressBalanceValue value;
+            if (pcursor->GetValue(value)) {
+                balances.push_back(std::make_pair(key.second, value));
                 pcursor->Next();
             } else {
-                return error("failed to get address index value");
+                return error("failed to get address balance value");
             }
         } else {
             break;
@@ -373,6 +503,72 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
     return true;
 }
 
+bool CBlockTreeDB::BuildAddressBalanceIndex() {
+    LogPrintf("Building the address balance index...\n");
+
+    // Wipe what an interrupted build or an older version may have left, balances without deltas would stay otherwise
+    CDBBatch batch(*this);
+    {
+        std::unique_ptr <CDBIterator> pcursor(NewIterator());
+        pcursor->Seek(DB_ADDRESSBALANCEINDEX);
+        std::pair<char, CAddressBalanceKey> key;
+        while (pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_ADDRESSBALANCEINDEX) {
+            boost::this_thread::interruption_point();
+            batch.Erase(key);
+            if (batch.SizeEstimate() > 16 << 20) {
+                if (!WriteBatch(batch))
+                    return error("%s: failed to wipe address balances", __func__);
+                batch.Clear();
+            }
+            pcursor->Next();
+        }
+    }
+
+    std::unique_ptr <CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey()));
+
+    // The address index is sorted by address and asset, so the deltas of each balance are next to each other
+    CAddressBalanceKey balanceKey;
+    CAddressBalanceValue balance;
+    bool fHaveBalance = false;
+    size_t nBalances = 0;
+    while (true) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CAddressIndexKey> key;
+        const bool fValid = pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX;
+        if (fHaveBalance && (!fValid || !(CAddressBalanceKey(key.second) == balanceKey))) {
+            if (!balance.IsNull())
+                batch.Write(std::make_pair(DB_ADDRESSBALANCEINDEX, balanceKey), balance);
+            nBalances++;
+            fHaveBalance = false;
+            if (batch.SizeEstimate() > 16 << 20) {
+                if (!WriteBatch(batch))
+                    return error("%s: failed to write address balances", __func__);
+                batch.Clear();
+            }
+        }
+        if (!fValid)
+            break;
+
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue))
+            return error("%s: failed to get address index value", __func__);
+        if (!fHaveBalance) {
+            balanceKey = CAddressBalanceKey(key.second);
+            balance.SetNull();
+            fHaveBalance = true;
+        }
+        balance.Add(nValue);
+        pcursor->Next();
+    }
+
+    batch.Write(std::make_pair(DB_FLAG, std::string("addressbalanceindex")), '1');
+    if (!WriteBatch(batch, true))
+        return error("%s: failed to write address balances", __func__);
+    LogPrintf("Address balance index built for %u balances\n", nBalances);
+    return true;
+}
+
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
     CDBBatch batch(*this);
     batch.Write(std::make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
@@ -413,7 +609,8 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
 }
 
 bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params &consensusParams,
-                                      std::function<CBlockIndex *(const uint256 &)> insertBlockIndex) {
+                                      std::function<CBlockIndex *(const uint256 &)> insertBlockIndex,
+                                      std::function<CBlockIndex *(const uint256 &)> lookupBlockIndex) {
     std::unique_ptr <CDBIterator> pcursor(NewIterator());
 
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
@@ -440,9 +637,6 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params &consensusParams,
                 pindexNew->nNonce = diskindex.nNonce;
                 pindexNew->nStatus = diskindex.nStatus;
                 pindexNew->nTx = diskindex.nTx;
-                // TODO: replace this check with something faster
-//                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams))
-//                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
 
                 pcursor->Next();
             } else {
@@ -453,6 +647,45 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params &consensusParams,
         }
     }
 
+    // Recomputing GhostRider for every header is far too slow, but the stored PoW hashes are cheap to check.
+    // A hash left behind for a block that is not in the index (e.g. by an interrupted write) is skipped, one
+    // that doesn't meet the target is dropped so the PoW is recomputed when the block is checked next time.
+    return ReadPOWHashes([&](const uint256 &blockHash, const uint256 &powHash) {
+        CBlockIndex *pindex = lookupBlockIndex(blockHash);
+        if (pindex == nullptr) {
+            LogPrintf("%s: ignoring PoW hash of unknown block %s\n", __func__, blockHash.ToString());
+            return;
+        }
+        if (!CheckProofOfWork(powHash, pindex->nBits, consensusParams)) {
+            LogPrintf("%s: ignoring stored PoW hash %s failing CheckProofOfWork: %s\n", __func__,
+                      powHash.ToString(), pindex->ToString());
+            return;
+        }
+        pindex->hashPow = powHash;
+    });
+}
+
+bool CBlockTreeDB::ReadPOWHashes(std::function<void(const uint256 &, const uint256 &)> fn) {
+    std::unique_ptr <CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_BLOCK_POWHASH, uint256()));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        if (ShutdownRequested()) return false;
+        std::pair<char, uint256> key;
+        if (pcursor->GetKey(key) && key.first == DB_BLOCK_POWHASH) {
+            uint256 powHash;
+            if (!pcursor->GetValue(powHash)) {
+                return error("%s: failed to read value", __func__);
+            }
+            fn(key.second, powHash);
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
     return true;
 }
 
@@ -13,6 +13,7 @@
 #include <indices/future_index.h>
 #include <primitives/block.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -134,6 +135,14 @@ public:
     bool ReadAddressUnspentIndex(uint160 addressHash, int type,
                                  std::vector <std::pair<CAddressUnspentKey, CAddressUnspentValue>> &vect);
 
+    /**
+     * Visit the unspent outputs of an address in key order (asset, txid, index), starting right after the key
+     * after when it is set. An empty asset visits every asset. Stops early when fn returns false.
+     */
+    bool ReadAddressUnspentIndex(uint160 addressHash, int type, const std::string &asset,
+                                 const CAddressUnspentKey *after,
+                                 const std::function<bool(const CAddressUnspentKey &, const CAddressUnspentValue &)> &fn);
+
     bool WriteAddressIndex(const std::vector <std::pair<CAddressIndexKey, CAmount>> &vect);
 
     bool EraseAddressIndex(const std::vector <std::pair<CAddressIndexKey, CAmount>> &vect);
@@ -142,6 +151,26 @@ public:
                           std::vector <std::pair<CAddressIndexKey, CAmount>> &addressIndex,
                           int start = 0, int end = 0);
 
+    /** Read the deltas of one asset of an address from height start on */
+    bool ReadAddressIndex(uint160 addressHash, int type, const std::string &asset, int start,
+                          std::vector <std::pair<CAddressIndexKey, CAmount>> &addressIndex);
+
+    /**
+     * Visit the deltas of an address in key order (asset, height, block index, ...), starting right after the key
+     * after when it is set. An empty asset visits every asset. Heights outside [start, end] (end = 0: no upper
+     * bound) are skipped by seeking within each asset rather than read. Stops early when fn returns false.
+     */
+    bool ReadAddressIndex(uint160 addressHash, int type, const std::string &asset, int start, int end,
+                          const CAddressIndexKey *after,
+                          const std::function<bool(const CAddressIndexKey &, CAmount)> &fn);
+
+    /** Read the balance of an address for one asset, or for every asset it ever held when asset is empty */
+    bool ReadAddressBalances(uint160 addressHash, int type, const std::string &asset,
+                             std::vector <std::pair<CAddressBalanceKey, CAddressBalanceValue>> &balances);
+
+    /** Sum up the address index into the balance index, for address indexes written before it was kept */
+    bool BuildAddressBalanceIndex();
+
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
 
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector <uint256> &vect);
@@ -150,8 +179,16 @@ public:
 
     bool ReadFlag(const std::string &name, bool &fValue);
 
+    /**
+     * Load all block index entries through insertBlockIndex, then attach the stored PoW hashes to the entries
+     * lookupBlockIndex finds.
+     */
     bool LoadBlockIndexGuts(const Consensus::Params &consensusParams,
-                            std::function<CBlockIndex *(const uint256 &)> insertBlockIndex);
+                            std::function<CBlockIndex *(const uint256 &)> insertBlockIndex,
+                            std::function<CBlockIndex *(const uint256 &)> lookupBlockIndex);
+
+    /** Call fn(blockHash, powHash) for every verified PoW hash stored with the block index. */
+    bool ReadPOWHashes(std::function<void(const uint256 &, const uint256 &)> fn);
 };
 
 #endif // BITCOIN_TXDB_H
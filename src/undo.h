@@ -44,6 +44,7 @@ struct TxInUndoFormatter {
             ::Unserialize(s, VARINT(nVersionDummy));
         }
         ::Unserialize(s, Using<TxOutCompression>(txout.out));
+        txout.DecodeAssetTag();
     }
 };
 
@@ -92,6 +92,13 @@ public:
         return cacheMap.size();
     }
 
+    template<typename Callback>
+    void for_each(Callback &&callback) const {
+        for (const auto &p : cacheMap) {
+            callback(p.first, p.second.first);
+        }
+    }
+
 private:
     void truncate_if_needed() {
         typedef typename MapType::iterator Iterator;
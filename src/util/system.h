@@ -61,6 +61,7 @@ int64_t GetStartupTime();
 
 static const int64_t DEFAULT_POW_CACHE_SIZE = 1000000;
 static const int DEFAULT_MAX_LOAD_SIZE = 720;
+static const int64_t DEFAULT_POW_CACHE_STORE_SIZE = 8000000;
 static bool DEFAULT_VALIDATE_POW_CACHE = false;
 
 extern const char *const BITCOIN_CONF_FILENAME;
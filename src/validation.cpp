@@ -13,6 +13,7 @@
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <checkqueue.h>
+#include <ctpl_stl.h>
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
 #include <consensus/tx_check.h>
@@ -949,6 +950,40 @@ bool GetAddressIndex(uint160 addressHash, int type,
     return true;
 }
 
+bool GetAddressIndex(uint160 addressHash, int type, const std::string &asset, int start,
+                     std::vector <std::pair<CAddressIndexKey, CAmount>> &addressIndex) {
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressIndex(addressHash, type, asset, start, addressIndex))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool GetAddressIndex(uint160 addressHash, int type, const std::string &asset, int start, int end,
+                     const CAddressIndexKey *after,
+                     const std::function<bool(const CAddressIndexKey &, CAmount)> &fn) {
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressIndex(addressHash, type, asset, start, end, after, fn))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool GetAddressBalances(uint160 addressHash, int type, const std::string &asset,
+                        std::vector <std::pair<CAddressBalanceKey, CAddressBalanceValue>> &balances) {
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressBalances(addressHash, type, asset, balances))
+        return error("unable to get balances for address");
+
+    return true;
+}
+
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector <std::pair<CAddressUnspentKey, CAddressUnspentValue>> &unspentOutputs) {
     if (!fAddressIndex)
@@ -960,6 +995,17 @@ bool GetAddressUnspent(uint160 addressHash, int type,
     return true;
 }
 
+bool GetAddressUnspent(uint160 addressHash, int type, const std::string &asset, const CAddressUnspentKey *after,
+                       const std::function<bool(const CAddressUnspentKey &, const CAddressUnspentValue &)> &fn) {
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, asset, after, fn))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
 CTransactionRef
 GetTransaction(const CBlockIndex *const block_index, const CTxMemPool *const mempool, const uint256 &hash,
                const Consensus::Params &consensusParams, uint256 &hashBlock) {
@@ -1319,15 +1365,15 @@ void CChainState::InvalidBlockFound(CBlockIndex *pindex, const CValidationState
 
 void
 UpdateCoins(const CTransaction &tx, CCoinsViewCache &inputs, CTxUndo &txundo, int nHeight, CAssetsCache *assetCache,
-            std::pair <std::string, CBlockAssetUndo> *undoAssetData) {
+            std::pair <std::string, CBlockAssetUndo> *undoAssetData, const CTxAssetTransfers *assetTransfers) {
     // mark inputs spent
     if (!tx.IsCoinBase()) {
         txundo.vprevout.reserve(tx.vin.size());
         for (const CTxIn &txin: tx.vin) {
             if (fAssetIndex) {
                 const Coin &coin = inputs.AccessCoin(txin.prevout);
-                if (coin.out.scriptPubKey.IsAssetScript()) {
-                assetCache->RemoveAddressBalance(coin.out.scriptPubKey, txin.prevout);
+                if (coin.IsAsset()) {
+                    assetCache->RemoveAddressBalance(coin, txin.prevout);
                 }
             }
             txundo.vprevout.emplace_back();
@@ -1337,7 +1383,7 @@ UpdateCoins(const CTransaction &tx, CCoinsViewCache &inputs, CTxUndo &txundo, in
     }
 
     // add outputs
-    AddAssets(tx, nHeight, assetCache, undoAssetData);
+    AddAssets(tx, nHeight, assetCache, undoAssetData, assetTransfers);
     AddCoins(inputs, tx, nHeight);
 }
 
@@ -1717,8 +1763,8 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock &block, const CBlockI
                 }
                 if (fAssetIndex) {
                     if (Updates().IsAssetsActive(::ChainActive().Tip()) && assetsCache) {
-                        if (coin.out.scriptPubKey.IsAssetScript()) {
-                            assetsCache->RemoveAddressBalance(coin.out.scriptPubKey, out);
+                        if (coin.IsAsset()) {
+                            assetsCache->RemoveAddressBalance(coin, out);
                         }
                     }
                 }
@@ -1782,8 +1828,8 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock &block, const CBlockI
                 if (fAssetIndex) {
                     if (Updates().IsAssetsActive(::ChainActive().Tip()) && assetsCache) {
                         const Coin &coin = view.AccessCoin(tx.vin[j].prevout);
-                        if (coin.out.scriptPubKey.IsAssetScript()) {
-                            assetsCache->AddAssetBlance(coin.out.scriptPubKey, tx.vin[j].prevout);
+                        if (coin.IsAsset()) {
+                            assetsCache->AddAssetBlance(coin, tx.vin[j].prevout);
                         }
                     }
                 }
@@ -1848,16 +1894,13 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock &block, const CBlockI
                                                prevout.nValue));
                         addressUnspentIndex.push_back(
                                 std::make_pair(CAddressUnspentKey(1, hashBytes, hash, j), CAddressUnspentValue()));
-                    } else if (prevout.scriptPubKey.IsAssetScript()) {
-                        CAssetTransfer assetTransfer;
-                        if (GetTransferAsset(prevout.scriptPubKey, assetTransfer)) {
-                            uint160 hashBytes(std::vector <unsigned char>(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23));
-                            addressIndex.push_back(
-                                    std::make_pair(CAddressIndexKey(1, hashBytes, assetTransfer.assetId, pindex->nHeight, i, hash, j, false),
-                                                assetTransfer.nAmount));
-                            addressUnspentIndex.push_back(
-                                    std::make_pair(CAddressUnspentKey(1, hashBytes, assetTransfer.assetId, hash, j), CAddressUnspentValue()));
-                        }
+                    } else if (coin.IsAsset()) {
+                        uint160 hashBytes(std::vector <unsigned char>(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23));
+                        addressIndex.push_back(
+                                std::make_pair(CAddressIndexKey(1, hashBytes, *coin.pAssetId, pindex->nHeight, i, hash, j, false),
+                                            coin.nAssetAmount));
+                        addressUnspentIndex.push_back(
+                                std::make_pair(CAddressUnspentKey(1, hashBytes, *coin.pAssetId, hash, j), CAddressUnspentValue()));
                     }
                 } else {
                     continue;
@@ -2065,7 +2108,10 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state, CBl
     // is enforced in ContextualCheckBlockHeader(); we wouldn't want to
     // re-enforce that rule here (at least until we make it impossible for
     // GetAdjustedTime() to go backward).
-    if (!CheckBlock(block, state, chainparams.GetConsensus(), pindex->nHeight, !fJustCheck, !fJustCheck)) {
+    // A stored PoW hash means the header already passed the PoW check, which is the expensive part on
+    // -reindex-chainstate. -powcachevalidate asks for stored hashes to be checked again, so they are not trusted then.
+    const bool fCheckPOW = !fJustCheck && (pindex->hashPow.IsNull() || CPowCache::Instance().IsValidate());
+    if (!CheckBlock(block, state, chainparams.GetConsensus(), pindex->nHeight, fCheckPOW, !fJustCheck)) {
         if (state.CorruptionPossible()) {
             // We don't write down blocks to disk if they may have been
             // corrupted, so this should be impossible unless we're having hardware
@@ -2074,6 +2120,15 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state, CBl
         }
         return error("%s: Consensus::CheckBlock: %s", __func__, FormatStateMessage(state));
     }
+    if (fCheckPOW && block.GetHash() != chainparams.GetConsensus().hashGenesisBlock) {
+        // Blocks accepted before the PoW hash was kept in the block index get it the first time it is
+        // computed again, so the next -reindex-chainstate doesn't have to. A wrong one is corrected.
+        const uint256 hashPow = block.GetPOWHash();
+        if (pindex->hashPow != hashPow) {
+            pindex->hashPow = hashPow;
+            setDirtyBlockIndex.insert(pindex);
+        }
+    }
 
     if (pindex->pprev && pindex->phashBlock &&
         llmq::chainLocksHandler->HasConflictingChainLock(pindex->nHeight, pindex->GetBlockHash())) {
@@ -2196,6 +2251,8 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state, CBl
     for (unsigned int i = 0; i < block.vtx.size(); i++) {
         const CTransaction &tx = *(block.vtx[i]);
         const uint256 txhash = tx.GetHash();
+        // the asset outputs are decoded once for the indexes, the supply and the balances
+        const CTxAssetTransfers assetTransfers(tx);
 
         nInputs += tx.vin.size();
 
@@ -2240,7 +2297,6 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state, CBl
                     const CTxOut &prevout = coin.out;
                     uint160 hashBytes;
                     int addressType;
-                    CAssetTransfer assetTransfer;
                     bool isAsset = false;
 
                     if (prevout.scriptPubKey.IsPayToScriptHash()) {
@@ -2257,13 +2313,12 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state, CBl
                     } else {
                         hashBytes.SetNull();
                         addressType = 0;
-                        if (prevout.scriptPubKey.IsAssetScript()) {
-                            if (GetTransferAsset(prevout.scriptPubKey, assetTransfer)) {
-                                hashBytes = uint160(std::vector <unsigned char>(prevout.scriptPubKey.begin()+3,
-                                                                                prevout.scriptPubKey.begin()+23));
-                                isAsset = true;
-                                addressType = 1;
-                            }
+                        // the coins cache has decoded the asset transfer already
+                        if (coin.IsAsset()) {
+                            hashBytes = uint160(std::vector <unsigned char>(prevout.scriptPubKey.begin()+3,
+                                                                            prevout.scriptPubKey.begin()+23));
+                            isAsset = true;
+                            addressType = 1;
                         }
                     }
 
@@ -2271,12 +2326,12 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state, CBl
                         if (isAsset){
                             // record spending activity
                             addressIndex.push_back(std::make_pair(
-                                    CAddressIndexKey(addressType, hashBytes, assetTransfer.assetId, pindex->nHeight, i, txhash, j, true),
-                                     assetTransfer.nAmount * -1));
+                                    CAddressIndexKey(addressType, hashBytes, *coin.pAssetId, pindex->nHeight, i, txhash, j, true),
+                                     coin.nAssetAmount * -1));
 
                             // remove address from unspent index
                             addressUnspentIndex.push_back(std::make_pair(
-                                    CAddressUnspentKey(addressType, hashBytes, assetTransfer.assetId, input.prevout.hash, input.prevout.n),
+                                    CAddressUnspentKey(addressType, hashBytes, *coin.pAssetId, input.prevout.hash, input.prevout.n),
                                     CAddressUnspentValue()));
                         } else {
                             // record spending activity
@@ -2379,28 +2434,25 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state, CBl
                                                                                           pindex->nHeight,
                                                                                           vSpendableHeight,
                                                                                           vSpendableTime)));
-                    } else if (out.scriptPubKey.IsAssetScript()) {
-                        CAssetTransfer assetTransfer;
-                        if (GetTransferAsset(out.scriptPubKey, assetTransfer)){
-                            uint160 hashBytes(std::vector <unsigned char>(out.scriptPubKey.begin()+3,
-                                                                          out.scriptPubKey.begin()+23));
-                            addressIndex.push_back(
-                                    std::make_pair(CAddressIndexKey(1, hashBytes, assetTransfer.assetId, pindex->nHeight, i, txhash, k, false),
-                                                assetTransfer.nAmount));
-                            addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, assetTransfer.assetId, txhash, k),
-                                                                     CAddressUnspentValue(assetTransfer.nAmount, out.scriptPubKey,
-                                                                                          assetTransfer.assetId, assetTransfer.isUnique,
-                                                                                          assetTransfer.uniqueId,
-                                                                                          pindex->nHeight,
-                                                                                          vSpendableHeight,
-                                                                                          vSpendableTime)));
-                        }
+                    } else if (const CAssetTransfer *assetTransfer = assetTransfers.Get(k)) {
+                        uint160 hashBytes(std::vector <unsigned char>(out.scriptPubKey.begin()+3,
+                                                                      out.scriptPubKey.begin()+23));
+                        addressIndex.push_back(
+                                std::make_pair(CAddressIndexKey(1, hashBytes, assetTransfer->assetId, pindex->nHeight, i, txhash, k, false),
+                                            assetTransfer->nAmount));
+                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, assetTransfer->assetId, txhash, k),
+                                                                 CAddressUnspentValue(assetTransfer->nAmount, out.scriptPubKey,
+                                                                                      assetTransfer->assetId, assetTransfer->isUnique,
+                                                                                      assetTransfer->uniqueId,
+                                                                                      pindex->nHeight,
+                                                                                      vSpendableHeight,
+                                                                                      vSpendableTime)));
                     }
                 }
                 if (fFutureIndex && spendableHeight >= 0 && spendableTime >= 0 && k == lockOutputIndex) {
                     uint160 addressHash;
                     int addressType;
-                    CAssetTransfer assetTransfer;
+                    const CAssetTransfer *assetTransfer = nullptr;
                     bool isAsset = false;
                     if (out.scriptPubKey.IsPayToScriptHash()) {
                         addressHash = uint160(std::vector<unsigned char>(out.scriptPubKey.begin() + 2,
@@ -2414,7 +2466,8 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state, CBl
                         addressHash = Hash160(out.scriptPubKey.begin() + 1, out.scriptPubKey.end() - 1);
                         addressType = 1;
                     } else if (out.scriptPubKey.IsAssetScript()) {
-                        if (GetTransferAsset(out.scriptPubKey, assetTransfer)){
+                        assetTransfer = assetTransfers.Get(k);
+                        if (assetTransfer){
                             addressHash = uint160(std::vector <unsigned char>(out.scriptPubKey.begin()+3,
                                                                               out.scriptPubKey.begin()+23));
 
@@ -2426,7 +2479,7 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state, CBl
                         addressType = 0;
                     }
                     futureIndex.push_back(std::make_pair(CFutureIndexKey(txhash, k),
-                                                         CFutureIndexValue(isAsset ? assetTransfer.nAmount : out.nValue, addressType, addressHash,
+                                                         CFutureIndexValue(isAsset ? assetTransfer->nAmount : out.nValue, addressType, addressHash,
                                                                            pindex->nHeight, spendableHeight,
                                                                            spendableTime)));
                 }
@@ -2442,7 +2495,7 @@ bool CChainState::ConnectBlock(const CBlock &block, CValidationState &state, CBl
         std::pair <std::string, CBlockAssetUndo> *undoAssetData = &undoPair;
 
         UpdateCoins(tx, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight, assetsCache,
-                    undoAssetData);
+                    undoAssetData, &assetTransfers);
 
         if (!undoAssetData->first.empty()) {
             vUndoAssetMetaData.emplace_back(*undoAssetData);
@@ -4096,8 +4149,13 @@ BlockManager::AcceptBlockHeader(const CBlockHeader &block, CValidationState &sta
                              REJECT_INVALID, "bad-chainlock");
         }
     }
-    if (pindex == nullptr)
+    if (pindex == nullptr) {
         pindex = AddToBlockIndex(block);
+        // CheckBlockHeader() above verified the PoW, keep the hash so it never has to be recomputed for this block
+        if (hash != chainparams.GetConsensus().hashGenesisBlock) {
+            pindex->hashPow = block.GetPOWHash();
+        }
+    }
 
     if (ppindex)
         *ppindex = pindex;
@@ -4108,85 +4166,53 @@ BlockManager::AcceptBlockHeader(const CBlockHeader &block, CValidationState &sta
     return true;
 }
 
-struct HeadersToProcess {
-    uint256 hash;
-    CBlockHeader header;
-    HeadersToProcess() {};
-    HeadersToProcess(uint256 hh, CBlockHeader hr) {
-        hash = hh;
-        header = hr;
-    }
-};
+/** Workers computing the GhostRider PoW hashes of received header batches before they are validated */
+static ctpl::thread_pool powHeaderWorkers;
 
-std::vector<HeadersToProcess> headersQueue;
-std::mutex queueMutex;
-std::atomic<std::int32_t> TasksDone;
-
-static void ProcessHeadersQueue() {
-    try {
-        CPowCache &cache(CPowCache::Instance());
-        while (true){
-            HeadersToProcess header;
-            std::unique_lock<std::mutex> lock(queueMutex);
-            if (headersQueue.begin() != headersQueue.end()) {
-                header = headersQueue.back();
-                headersQueue.pop_back();
-            } else {
-                lock.unlock();
-                TasksDone++;
-                return;
-            }
-            lock.unlock();
-            uint256 powHash = header.header.ComputeHash();
-            {
-                LOCK(cs_pow);
-                cache.insert(header.hash, powHash);
-            }
-        }
-    } catch (const std::runtime_error &e) {
-        TasksDone++;
-        return;
-    }
+void StartPowHeaderWorkerThreads(int threads_num) {
+    powHeaderWorkers.resize(threads_num);
+    RenameThreadPool(powHeaderWorkers, "powhdr");
 }
 
-void computePOWHeaderHash(const std::vector <CBlockHeader> &headers) {
-    static int cores = std::min((int)gArgs.GetArg("-powheaderthreads", DEFAULT_POWHEADERTHREADS), GetNumCores());
+void StopPowHeaderWorkerThreads() {
+    powHeaderWorkers.clear_queue();
+    powHeaderWorkers.stop(true);
+}
 
-    //if we have only a few headers or 1 core skip as there is no benefit
-    if (headers.size() <= 4 && cores <= 1)
+void PrecomputeHeadersPoW(const std::vector <CBlockHeader> &headers) {
+    const int workers = powHeaderWorkers.size();
+    //if we have only a few headers or no workers skip as there is no benefit
+    if (workers == 0 || headers.size() <= 4)
         return;
 
-    int nheader = 0;
-    {
-        //check if POW cache contain entry for the block header if no add to the queue
-        LOCK(cs_pow);
-        CPowCache &cache(CPowCache::Instance());
-        std::unique_lock<std::mutex> lock(queueMutex);
-        //make sure the queue is empty
-        headersQueue.clear();
-        for (const CBlockHeader &header: headers) {
-            uint256 headerHash = header.GetHash();
-            uint256 powHash;
-            if (!cache.get(headerHash, powHash)) {
-                headersQueue.push_back(HeadersToProcess(headerHash, header));
-                nheader++;
-            }
+    //only hand out headers the POW cache doesn't know about yet
+    CPowCache &cache(CPowCache::Instance());
+    std::vector <std::pair<uint256, const CBlockHeader *>> missing;
+    missing.reserve(headers.size());
+    for (const CBlockHeader &header: headers) {
+        uint256 headerHash = header.GetHash();
+        if (!cache.exists(headerHash)) {
+            missing.emplace_back(headerHash, &header);
         }
-        lock.unlock();
     }
+    if (missing.size() <= 4)
+        return;
 
-    //if we have only a few headers skip as there is no benefit
-    if (nheader > 4) {
-        TasksDone = 0;
-        //if we have headers to compute the POW hash start the worker threads
-        boost::thread_group processHeadertThreads;
-        for (int i = 0; i < cores; i++) {
-            processHeadertThreads.create_thread(boost::bind(&ProcessHeadersQueue));
-        }
-        //wait until all worker threads finish
-        while (TasksDone < cores) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        }
+    //interleave the headers over the workers, GetOrCompute() fills the cache and skips
+    //headers that are concurrently being hashed by another thread (e.g. a compact block)
+    const size_t nTasks = std::min(missing.size(), (size_t) workers);
+    std::vector <std::future<void>> futures;
+    futures.reserve(nTasks);
+    for (size_t task = 0; task < nTasks; task++) {
+        futures.emplace_back(powHeaderWorkers.push([&cache, &missing, task, nTasks](int) {
+            for (size_t i = task; i < missing.size(); i += nTasks) {
+                const CBlockHeader *header = missing[i].second;
+                cache.GetOrCompute(missing[i].first, [header] { return header->ComputeHash(); });
+            }
+        }));
+    }
+    for (auto &future: futures) {
+        future.get();
     }
 }
 
@@ -4198,9 +4224,6 @@ bool ChainstateManager::ProcessNewBlockHeaders(const std::vector <CBlockHeader>
     if (first_invalid != nullptr)
         first_invalid->SetNull();
 
-    //compute POW hash first using multiple threads
-    computePOWHeaderHash(headers);
-
     // Scoped for the lock
     {
         // This lock can be held for a long time.  Use the flag to warn others
@@ -4617,7 +4640,11 @@ bool BlockManager::LoadBlockIndex(
         CBlockTreeDB &blocktree,
         std::set<CBlockIndex *, CBlockIndexWorkComparator> &block_index_candidates) {
     if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256 &hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
-    { return this->InsertBlockIndex(hash); }))
+    { return this->InsertBlockIndex(hash); }, [this](const uint256 &hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+    {
+        BlockMap::const_iterator it = m_block_index.find(hash);
+        return it == m_block_index.end() ? nullptr : it->second;
+    }))
     return false;
 
     boost::this_thread::interruption_point();
@@ -4746,6 +4773,12 @@ EXCLUSIVE_LOCKS_REQUIRED(cs_main)
                 pblocktree->ReadFlag("addressindex", fAddressIndex);
                 LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
 
+                // Address indexes written by older versions don't have the balance index yet
+                bool fAddressBalanceIndex = false;
+                pblocktree->ReadFlag("addressbalanceindex", fAddressBalanceIndex);
+                if (fAddressIndex && !fAddressBalanceIndex && !pblocktree->BuildAddressBalanceIndex())
+                    return false;
+
                 // Check whether we have an address index
                 pblocktree->ReadFlag("assetindex", fAssetIndex);
                 LogPrintf("%s: asset index %s\n", __func__, fAssetIndex ? "enabled" : "disabled");
@@ -5070,6 +5103,7 @@ bool ChainstateManager::LoadBlockIndex(const CChainParams &chainparams) {
         // Use the provided setting for -addressindex in the new database
         fAddressIndex = gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
         pblocktree->WriteFlag("addressindex", fAddressIndex);
+        pblocktree->WriteFlag("addressbalanceindex", true);
 
         // Use the provided setting for -assetindex in the new database
         fAssetIndex = gArgs.GetBoolArg("-assetindex", DEFAULT_ASSETINDEX);
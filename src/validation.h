@@ -30,6 +30,7 @@
 #include <algorithm>
 #include <atomic>
 #include <exception>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
@@ -70,6 +71,7 @@ struct CBlockAssetUndo;
 class CAssetsDB;
 
 class CAssetsCache;
+class CTxAssetTransfers;
 
 struct ChainTxData;
 
@@ -269,6 +271,19 @@ void StartScriptCheckWorkerThreads(int threads_num);
 /** Stop all of the script checking worker threads. */
 void StopScriptCheckWorkerThreads();
 
+/** Run instances of header PoW hashing worker threads */
+void StartPowHeaderWorkerThreads(int threads_num);
+
+/** Stop all of the header PoW hashing worker threads. */
+void StopPowHeaderWorkerThreads();
+
+/**
+ * Compute the GhostRider PoW hashes of a batch of headers on the header PoW worker threads and store them in
+ * the PoW cache, so the subsequent ProcessNewBlockHeaders() call only has to look them up while holding cs_main.
+ * Returns once all hashes are cached. Does nothing if no workers are running or the batch is small.
+ */
+void PrecomputeHeadersPoW(const std::vector <CBlockHeader> &headers);
+
 /**
  * Return transaction from the block at block_index.
  * If block_index is not provided, fall back to mempool.
@@ -332,7 +347,8 @@ int GetUTXOConfirmations(const COutPoint &outpoint);
 void UpdateCoins(const CTransaction &tx, CCoinsViewCache &inputs, int nHeight);
 
 void UpdateCoins(const CTransaction &tx, CCoinsViewCache &inputs, CTxUndo &txundo, int nHeight,
-                 CAssetsCache *assetCache = nullptr, std::pair <std::string, CBlockAssetUndo> *undoAssetData = nullptr);
+                 CAssetsCache *assetCache = nullptr, std::pair <std::string, CBlockAssetUndo> *undoAssetData = nullptr,
+                 const CTxAssetTransfers *assetTransfers = nullptr);
 
 /** Transaction validation functions */
 
@@ -412,9 +428,25 @@ bool GetFutureIndex(CFutureIndexKey &key, CFutureIndexValue &value);
 bool GetAddressIndex(uint160 addressHash, int type, std::vector <std::pair<CAddressIndexKey, CAmount>> &addressIndex,
                      int start = 0, int end = 0);
 
+bool GetAddressIndex(uint160 addressHash, int type, const std::string &asset, int start,
+                     std::vector <std::pair<CAddressIndexKey, CAmount>> &addressIndex);
+
+/** Visit the address index entries of an address in key order, see CBlockTreeDB::ReadAddressIndex */
+bool GetAddressIndex(uint160 addressHash, int type, const std::string &asset, int start, int end,
+                     const CAddressIndexKey *after,
+                     const std::function<bool(const CAddressIndexKey &, CAmount)> &fn);
+
+/** Balances of an address from the balance index, for one asset or for all of them when asset is empty */
+bool GetAddressBalances(uint160 addressHash, int type, const std::string &asset,
+                        std::vector <std::pair<CAddressBalanceKey, CAddressBalanceValue>> &balances);
+
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector <std::pair<CAddressUnspentKey, CAddressUnspentValue>> &unspentOutputs);
 
+/** Visit the unspent outputs of an address in key order, see CBlockTreeDB::ReadAddressUnspentIndex */
+bool GetAddressUnspent(uint160 addressHash, int type, const std::string &asset, const CAddressUnspentKey *after,
+                       const std::function<bool(const CAddressUnspentKey &, const CAddressUnspentValue &)> &fn);
+
 /** Initializes the script-execution cache */
 void InitScriptExecutionCache();
 
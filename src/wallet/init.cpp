@@ -67,6 +67,10 @@ void WalletInit::AddWalletOptions() const {
     gArgs.AddArg("-rescan=<mode>", "Rescan the block chain for missing wallet transactions on startup"
                                    " (1 = start from wallet creation time, 2 = start from genesis block)",
                  ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
+    gArgs.AddArg("-rescanthreads=<n>", strprintf(
+            "Number of threads to read blocks ahead of a rescan with and check them for wallet transactions"
+            " (0 = one per core, 1 = no read-ahead, maximum: %d, default: %d)", MAX_RESCAN_THREADS,
+            DEFAULT_RESCAN_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
     gArgs.AddArg("-spendzeroconfchange", strprintf("Spend unconfirmed change when sending transactions (default: %u)",
                                                    DEFAULT_SPEND_ZEROCONF_CHANGE), ArgsManager::ALLOW_ANY,
                  OptionsCategory::WALLET);
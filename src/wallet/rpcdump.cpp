@@ -151,6 +151,7 @@ UniValue importprivkey(const JSONRPCRequest &request) {
             if (!pwallet->AddKeyPubKeyWithDB(batch, key, pubkey)) {
                 throw JSONRPCError(RPC_WALLET_ERROR, "Error adding key to wallet");
             }
+            pwallet->RebuildWalletUTXOIndex();
         }
     }
     if (fRescan) {
@@ -332,6 +333,7 @@ UniValue importaddress(const JSONRPCRequest &request) {
         } else {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid Fortuneblock address or script");
         }
+        pwallet->RebuildWalletUTXOIndex();
     }
     if (fRescan) {
         int64_t scanned_time = pwallet->RescanFromTime(TIMESTAMP_MIN, reserver, true /* update */);
@@ -502,6 +504,7 @@ UniValue importpubkey(const JSONRPCRequest &request) {
 
         ImportAddress(pwallet, pubKey.GetID(), strLabel);
         ImportScript(pwallet, GetScriptForRawPubKey(pubKey), strLabel, false);
+        pwallet->RebuildWalletUTXOIndex();
     }
     if (fRescan) {
         int64_t scanned_time = pwallet->RescanFromTime(TIMESTAMP_MIN, reserver, true /* update */);
@@ -667,6 +670,7 @@ UniValue importwallet(const JSONRPCRequest &request) {
         }
         pwallet->chain().showProgress("", 100, false); // hide progress dialog in GUI
         pwallet->UpdateTimeFirstKey(nTimeBegin);
+        pwallet->RebuildWalletUTXOIndex();
     }
     pwallet->chain().showProgress("", 100, false); // hide progress dialog in GUI
     RescanWallet(*pwallet, reserver, nTimeBegin, false /* update */);
@@ -709,7 +713,7 @@ UniValue importelectrumwallet(const JSONRPCRequest &request) {
         throw JSONRPCError(RPC_WALLET_ERROR, "Error: Private keys are disabled for this wallet");
     }
 
-    LOCK(pwallet->cs_wallet);
+    WAIT_LOCK(pwallet->cs_wallet, lock);
 
     EnsureWalletIsUnlocked(pwallet);
 
@@ -800,6 +804,7 @@ UniValue importelectrumwallet(const JSONRPCRequest &request) {
     }
     file.close();
     pwallet->ShowProgress("", 100); // hide progress dialog in GUI
+    pwallet->RebuildWalletUTXOIndex();
 
     const int32_t tip_height = pwallet->chain().getHeight().value_or(std::numeric_limits<int32_t>::max());
 
@@ -819,7 +824,11 @@ UniValue importelectrumwallet(const JSONRPCRequest &request) {
     if (!reserver.reserve()) {
         throw JSONRPCError(RPC_WALLET_ERROR, "Wallet is currently rescanning. Abort existing rescan or wait.");
     }
-    pwallet->ScanForWalletTransactions(pwallet->chain().getBlockHash(nStartHeight), {}, reserver, true);
+    {
+        // the rescan takes cs_wallet for every block it syncs
+        REVERSE_LOCK(lock);
+        pwallet->ScanForWalletTransactions(pwallet->chain().getBlockHash(nStartHeight), {}, reserver, true);
+    }
 
     if (!fGood)
         throw JSONRPCError(RPC_WALLET_ERROR, "Error adding some keys to wallet");
@@ -1671,6 +1680,7 @@ UniValue importmulti(const JSONRPCRequest &mainRequest) {
                 nLowestTimestamp = timestamp;
             }
         }
+        pwallet->RebuildWalletUTXOIndex();
     }
     if (fRescan && fRunScan && requests.size()) {
         int64_t scannedTime = pwallet->RescanFromTime(nLowestTimestamp, reserver, true /* update */);
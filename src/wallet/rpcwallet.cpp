@@ -2890,7 +2890,7 @@ UniValue upgradetohd(const JSONRPCRequest &request) {
     if (!wallet) return NullUniValue;
     CWallet *const pwallet = wallet.get();
 
-    LOCK(pwallet->cs_wallet);
+    WAIT_LOCK(pwallet->cs_wallet, lock);
 
     // Do not do anything to HD wallets
     if (pwallet->IsHDEnabled()) {
@@ -2963,6 +2963,8 @@ UniValue upgradetohd(const JSONRPCRequest &request) {
         if (!reserver.reserve()) {
             throw JSONRPCError(RPC_WALLET_ERROR, "Wallet is currently rescanning. Abort existing rescan or wait.");
         }
+        // the rescan takes cs_wallet for every block it syncs
+        REVERSE_LOCK(lock);
         pwallet->ScanForWalletTransactions(pwallet->chain().getBlockHash(0), {}, reserver, true);
     }
 
@@ -46,6 +46,9 @@ public:
             LOCK2(wallet->cs_wallet, cs_main);
             wallet->AddKeyPubKey(coinbaseKey, coinbaseKey.GetPubKey());
             wallet->SetLastBlockProcessed(::ChainActive().Height(), ::ChainActive().Tip()->GetBlockHash());
+        }
+        {
+            // the rescan reads blocks on worker threads, which need cs_main and cs_wallet
             WalletRescanReserver reserver(wallet.get());
             reserver.reserve();
             CWallet::ScanResult result = wallet->ScanForWalletTransactions(::ChainActive().Genesis()->GetBlockHash(),
@@ -0,0 +1,115 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/test_fortuneblock.h>
+
+#include <wallet/utxoindex.h>
+#include <wallet/wallet.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(utxoindex_tests, BasicTestingSetup
+)
+
+static CTransactionRef MakeTx(size_t nOutputs) {
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(InsecureRand256(), 0);
+    mtx.vout.resize(nOutputs);
+    return MakeTransactionRef(mtx);
+}
+
+static CWalletUTXOIndex::Entry MakeEntry(const CWalletTx &wtx, const std::string &assetId = "", CAmount nAssetAmount = 0) {
+    CWalletUTXOIndex::Entry entry;
+    entry.wtx = &wtx;
+    entry.mine = ISMINE_SPENDABLE;
+    entry.fAssetScript = !assetId.empty();
+    entry.assetId = assetId;
+    entry.nAssetAmount = nAssetAmount;
+    return entry;
+}
+
+static CWalletUTXOIndex::SettledCredit MakeCredit(CAmount nCredit, const std::string &assetId = "", CAmount nAssetAmount = 0) {
+    CWalletUTXOIndex::SettledCredit credit;
+    credit.nCredit = nCredit;
+    if (!assetId.empty()) {
+        credit.vecAssetAmounts.emplace_back(assetId, nAssetAmount);
+    }
+    return credit;
+}
+
+BOOST_AUTO_TEST_CASE(utxoindex_entries)
+{
+    CWalletUTXOIndex index;
+    CWalletTx wtx1(nullptr, MakeTx(3));
+    CWalletTx wtx2(nullptr, MakeTx(2));
+
+    BOOST_CHECK(index.Add(COutPoint(wtx1.GetHash(), 0), MakeEntry(wtx1)));
+    BOOST_CHECK(index.Add(COutPoint(wtx1.GetHash(), 2), MakeEntry(wtx1, "asset", 7)));
+    BOOST_CHECK(index.Add(COutPoint(wtx2.GetHash(), 1), MakeEntry(wtx2)));
+    // replacing an entry re-caches it but doesn't count as a new UTXO
+    BOOST_CHECK(!index.Add(COutPoint(wtx2.GetHash(), 1), MakeEntry(wtx2, "asset", 3)));
+
+    BOOST_CHECK_EQUAL(index.size(), 3U);
+    BOOST_CHECK_EQUAL(index.GetSpendableTXs().size(), 2U);
+    BOOST_CHECK_EQUAL(index.GetUnsettledTXs().size(), 2U);
+    BOOST_CHECK_EQUAL(index.GetAssetOutpoints().size(), 2U);
+    BOOST_CHECK(index.Find(COutPoint(wtx1.GetHash(), 1)) == nullptr);
+    BOOST_CHECK_EQUAL(index.Find(COutPoint(wtx2.GetHash(), 1))->nAssetAmount, 3);
+
+    BOOST_CHECK(index.Erase(COutPoint(wtx2.GetHash(), 1)));
+    BOOST_CHECK(!index.Erase(COutPoint(wtx2.GetHash(), 1)));
+    BOOST_CHECK_EQUAL(index.GetSpendableTXs().size(), 1U);
+    BOOST_CHECK_EQUAL(index.GetUnsettledTXs().size(), 1U);
+    BOOST_CHECK_EQUAL(index.GetAssetOutpoints().size(), 1U);
+
+    index.Clear();
+    BOOST_CHECK_EQUAL(index.size(), 0U);
+    BOOST_CHECK(index.GetSpendableTXs().empty());
+    BOOST_CHECK(index.GetUnsettledTXs().empty());
+}
+
+BOOST_AUTO_TEST_CASE(utxoindex_settled_totals)
+{
+    CWalletUTXOIndex index;
+    CWalletTx wtx1(nullptr, MakeTx(3));
+    CWalletTx wtx2(nullptr, MakeTx(2));
+
+    index.Add(COutPoint(wtx1.GetHash(), 0), MakeEntry(wtx1));
+    index.Add(COutPoint(wtx1.GetHash(), 1), MakeEntry(wtx1, "asset", 7));
+    index.Add(COutPoint(wtx2.GetHash(), 0), MakeEntry(wtx2));
+
+    index.SettleTx(&wtx1, MakeCredit(5 * COIN, "asset", 7));
+    index.SettleTx(&wtx2, MakeCredit(2 * COIN));
+    // settling twice doesn't count twice
+    index.SettleTx(&wtx2, MakeCredit(2 * COIN));
+    BOOST_CHECK_EQUAL(index.GetSettledTXCount(), 2U);
+    BOOST_CHECK(index.GetUnsettledTXs().empty());
+    BOOST_CHECK_EQUAL(index.GetSettledTotal().nCredit, 7 * COIN);
+    BOOST_CHECK_EQUAL(index.GetSettledAssetAmounts().at("asset"), 7);
+
+    // a new UTXO for a settled tx unsettles it
+    index.Add(COutPoint(wtx1.GetHash(), 2), MakeEntry(wtx1));
+    BOOST_CHECK_EQUAL(index.GetUnsettledTXs().count(&wtx1), 1U);
+    BOOST_CHECK_EQUAL(index.GetSettledTotal().nCredit, 2 * COIN);
+    BOOST_CHECK(index.GetSettledAssetAmounts().empty());
+
+    // and so does spending one
+    index.SettleTx(&wtx1, MakeCredit(6 * COIN, "asset", 7));
+    index.Erase(COutPoint(wtx1.GetHash(), 0));
+    BOOST_CHECK_EQUAL(index.GetUnsettledTXs().count(&wtx1), 1U);
+    BOOST_CHECK_EQUAL(index.GetSettledTotal().nCredit, 2 * COIN);
+
+    // spending the last UTXO of a settled tx removes it
+    index.Erase(COutPoint(wtx2.GetHash(), 0));
+    BOOST_CHECK_EQUAL(index.GetSettledTXCount(), 0U);
+    BOOST_CHECK_EQUAL(index.GetSettledTotal().nCredit, 0);
+
+    index.SettleTx(&wtx1, MakeCredit(4 * COIN));
+    index.UnsettleAll();
+    BOOST_CHECK_EQUAL(index.GetSettledTXCount(), 0U);
+    BOOST_CHECK_EQUAL(index.GetUnsettledTXs().size(), 1U);
+    BOOST_CHECK_EQUAL(index.GetSettledTotal().nCredit, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -33,6 +33,8 @@ extern UniValue importwallet(const JSONRPCRequest &request);
 
 extern UniValue getnewaddress(const JSONRPCRequest &request);
 
+extern UniValue importelectrumwallet(const JSONRPCRequest &request);
+
 BOOST_FIXTURE_TEST_SUITE(wallet_tests, WalletTestingSetup
 )
 
@@ -804,6 +806,131 @@ size(),
 2U);
 }
 
+static void CheckSettledBalance(const CWallet &wallet) {
+    // coin control makes GetBalance walk all spendable TXs instead of using the running totals of the settled ones
+    CCoinControl coinControl;
+    const auto settled = wallet.GetBalance();
+    const auto walked = wallet.GetBalance(0, false, &coinControl);
+    BOOST_CHECK_EQUAL(settled.m_mine_trusted, walked.m_mine_trusted);
+    BOOST_CHECK_EQUAL(settled.m_mine_untrusted_pending, walked.m_mine_untrusted_pending);
+    BOOST_CHECK_EQUAL(settled.m_mine_immature, walked.m_mine_immature);
+    BOOST_CHECK_EQUAL(settled.m_watchonly_trusted, walked.m_watchonly_trusted);
+}
+
+BOOST_FIXTURE_TEST_CASE(balance_settled_txs, ListCoinsTestingSetup)
+{
+    // the mature coinbase is deep enough to be settled
+    CheckSettledBalance(*wallet);
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_trusted, 4 * COIN);
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_trusted, wallet->GetAvailableBalance());
+
+    // spending it unsettles the coinbase, its change is not deep enough to be settled
+    AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN, false /* subtract fee */});
+    CheckSettledBalance(*wallet);
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_trusted, wallet->GetAvailableBalance());
+
+    // locked coins still count for the balance, locking and unlocking them must keep the running totals intact
+    std::vector <COutput> available;
+    {
+        LOCK(wallet->cs_wallet);
+        wallet->AvailableCoins(available);
+        for (const auto &coin: available) {
+            wallet->LockCoin(COutPoint(coin.tx->GetHash(), coin.i));
+        }
+    }
+    CheckSettledBalance(*wallet);
+    {
+        LOCK(wallet->cs_wallet);
+        wallet->UnlockAllCoins();
+    }
+    CheckSettledBalance(*wallet);
+}
+
+BOOST_FIXTURE_TEST_CASE(zap_keeps_utxo_index, ListCoinsTestingSetup)
+{
+    const CAmount nBalance = wallet->GetAvailableBalance();
+    const uint256 hash = AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN, false /* subtract fee */}).GetHash();
+    BOOST_CHECK(wallet->GetAvailableBalance() < nBalance);
+
+    std::vector <uint256> vHashIn{hash}, vHashOut;
+    {
+        LOCK(wallet->cs_wallet);
+        BOOST_CHECK(wallet->ZapSelectTx(vHashIn, vHashOut) == DBErrors::LOAD_OK);
+    }
+    BOOST_CHECK_EQUAL(vHashOut.size(), 1U);
+
+    // the change is gone with the TX and the coin it spent is available again
+    std::vector <COutput> available;
+    {
+        LOCK(wallet->cs_wallet);
+        BOOST_CHECK_EQUAL(wallet->mapWallet.count(hash), 0U);
+        wallet->AvailableCoins(available);
+    }
+    for (const auto &coin: available) {
+        BOOST_CHECK(coin.tx->GetHash() != hash);
+    }
+    BOOST_CHECK_EQUAL(wallet->GetAvailableBalance(), nBalance);
+    CheckSettledBalance(*wallet);
+}
+
+// The spend is only found through the wallet transactions it spends, the recipient isn't in the rescanned wallets
+BOOST_FIXTURE_TEST_CASE(rescan_threads, ListCoinsTestingSetup)
+{
+    CKey otherKey;
+    otherKey.MakeNewKey(true);
+    const uint256 spendHash = AddTx(CRecipient{GetScriptForRawPubKey(otherKey.GetPubKey()), 10 * COIN,
+                                               false /* subtract fee */}).GetHash();
+    const size_t nWalletTxs = WITH_LOCK(wallet->cs_wallet, return wallet->mapWallet.size());
+
+    for (int nThreads : {1, 4}) {
+        gArgs.ForceSetArg("-rescanthreads", std::to_string(nThreads));
+        CWallet rescanWallet(m_chain.get(), WalletLocation(), CreateMockWalletDatabase());
+        AddKey(rescanWallet, coinbaseKey);
+        WalletRescanReserver reserver(&rescanWallet);
+        reserver.reserve();
+        CWallet::ScanResult result = rescanWallet.ScanForWalletTransactions(::ChainActive().Genesis()->GetBlockHash(),
+                                                                            {} /* stop_block */, reserver,
+                                                                            false /* update */);
+        BOOST_CHECK_EQUAL(result.status, CWallet::ScanResult::SUCCESS);
+        BOOST_CHECK_EQUAL(result.last_scanned_block, ::ChainActive().Tip()->GetBlockHash());
+        BOOST_CHECK_EQUAL(*result.last_scanned_height, ::ChainActive().Height());
+
+        LOCK(rescanWallet.cs_wallet);
+        BOOST_CHECK(rescanWallet.mapWallet.count(spendHash));
+        BOOST_CHECK_EQUAL(rescanWallet.mapWallet.size(), nWalletTxs);
+    }
+    gArgs.ForceSetArg("-rescanthreads", std::to_string(DEFAULT_RESCAN_THREADS));
+}
+
+// The RPC holds cs_wallet until the keys are imported, the rescan workers must not wait for it afterwards
+BOOST_FIXTURE_TEST_CASE(importelectrumwallet_rescan_threads, ListCoinsTestingSetup)
+{
+    const size_t nWalletTxs = WITH_LOCK(wallet->cs_wallet, return wallet->mapWallet.size());
+    const std::string import_file = (SetDataDir("importelectrumwallet_rescan_threads") / "electrum.csv").string();
+    {
+        fsbridge::ofstream file(import_file);
+        file << "address,private_key\n";
+        file << EncodeDestination(coinbaseKey.GetPubKey().GetID()) << "," << EncodeSecret(coinbaseKey) << "\n";
+    }
+
+    gArgs.ForceSetArg("-rescanthreads", "4");
+    std::shared_ptr <CWallet> importWallet = std::make_shared<CWallet>(m_chain.get(), WalletLocation(),
+                                                                      CreateMockWalletDatabase());
+    util::Ref context;
+    JSONRPCRequest request(context);
+    request.params.setArray();
+    request.params.push_back(import_file);
+    request.params.push_back(0);
+    AddWallet(importWallet);
+    ::importelectrumwallet(request);
+    RemoveWallet(importWallet);
+    gArgs.ForceSetArg("-rescanthreads", std::to_string(DEFAULT_RESCAN_THREADS));
+
+    LOCK(importWallet->cs_wallet);
+    BOOST_CHECK(importWallet->HaveKey(coinbaseKey.GetPubKey().GetID()));
+    BOOST_CHECK_EQUAL(importWallet->mapWallet.size(), nWalletTxs);
+}
+
 class CreateTransactionTestSetup : public TestChain100Setup {
 public:
     enum ChangeTest {
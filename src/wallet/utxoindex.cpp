@@ -0,0 +1,130 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <wallet/utxoindex.h>
+
+#include <cassert>
+
+bool CWalletUTXOIndex::Add(const COutPoint &outpoint, Entry entry) {
+    assert(entry.wtx != nullptr);
+
+    auto it = mapEntries.find(outpoint);
+    const bool fNew = it == mapEntries.end();
+    if (fNew && mapSpendableTXs[entry.wtx].nUTXOs++ == 0) {
+        setUnsettledTXs.emplace(entry.wtx);
+    }
+    UnsettleTx(entry.wtx);
+
+    if (entry.fAssetScript) {
+        setAssetOutpoints.emplace(outpoint);
+    } else {
+        setAssetOutpoints.erase(outpoint);
+    }
+
+    if (fNew) {
+        mapEntries.emplace(outpoint, std::move(entry));
+    } else {
+        it->second = std::move(entry);
+    }
+    return fNew;
+}
+
+bool CWalletUTXOIndex::Erase(const COutPoint &outpoint) {
+    auto it = mapEntries.find(outpoint);
+    if (it == mapEntries.end()) {
+        return false;
+    }
+
+    const CWalletTx *wtx = it->second.wtx;
+    UnsettleTx(wtx);
+    auto jt = mapSpendableTXs.find(wtx);
+    assert(jt != mapSpendableTXs.end() && jt->second.nUTXOs > 0);
+    if (--jt->second.nUTXOs == 0) {
+        mapSpendableTXs.erase(jt);
+        setUnsettledTXs.erase(wtx);
+    }
+
+    setAssetOutpoints.erase(outpoint);
+    mapEntries.erase(it);
+    return true;
+}
+
+void CWalletUTXOIndex::Clear() {
+    mapEntries.clear();
+    setAssetOutpoints.clear();
+    mapSpendableTXs.clear();
+    setUnsettledTXs.clear();
+    settledTotal = SettledCredit();
+    mapSettledAssetAmounts.clear();
+}
+
+const CWalletUTXOIndex::Entry *CWalletUTXOIndex::Find(const COutPoint &outpoint) const {
+    auto it = mapEntries.find(outpoint);
+    return it != mapEntries.end() ? &it->second : nullptr;
+}
+
+std::vector<const CWalletTx *> CWalletUTXOIndex::GetSpendableTXs() const {
+    std::vector<const CWalletTx *> ret;
+    ret.reserve(mapSpendableTXs.size());
+    for (const auto &p: mapSpendableTXs) {
+        ret.emplace_back(p.first);
+    }
+    return ret;
+}
+
+void CWalletUTXOIndex::SettleTx(const CWalletTx *wtx, SettledCredit credit) const {
+    auto it = mapSpendableTXs.find(wtx);
+    if (it == mapSpendableTXs.end() || it->second.fSettled) {
+        return;
+    }
+
+    settledTotal.nCredit += credit.nCredit;
+    settledTotal.nWatchCredit += credit.nWatchCredit;
+    settledTotal.nAnonymizedCredit += credit.nAnonymizedCredit;
+    settledTotal.nDenominatedCredit += credit.nDenominatedCredit;
+    for (const auto &p: credit.vecAssetAmounts) {
+        mapSettledAssetAmounts[p.first] += p.second;
+    }
+
+    it->second.fSettled = true;
+    it->second.credit = std::move(credit);
+    setUnsettledTXs.erase(wtx);
+}
+
+void CWalletUTXOIndex::UnsettleTx(const CWalletTx *wtx) const {
+    auto it = mapSpendableTXs.find(wtx);
+    if (it == mapSpendableTXs.end() || !it->second.fSettled) {
+        return;
+    }
+
+    const SettledCredit &credit = it->second.credit;
+    settledTotal.nCredit -= credit.nCredit;
+    settledTotal.nWatchCredit -= credit.nWatchCredit;
+    settledTotal.nAnonymizedCredit -= credit.nAnonymizedCredit;
+    settledTotal.nDenominatedCredit -= credit.nDenominatedCredit;
+    for (const auto &p: credit.vecAssetAmounts) {
+        auto jt = mapSettledAssetAmounts.find(p.first);
+        assert(jt != mapSettledAssetAmounts.end());
+        jt->second -= p.second;
+        if (jt->second == 0) {
+            mapSettledAssetAmounts.erase(jt);
+        }
+    }
+
+    it->second.fSettled = false;
+    it->second.credit = SettledCredit();
+    setUnsettledTXs.emplace(wtx);
+}
+
+void CWalletUTXOIndex::UnsettleAll() const {
+    for (auto &p: mapSpendableTXs) {
+        if (p.second.fSettled) {
+            p.second.fSettled = false;
+            p.second.credit = SettledCredit();
+            setUnsettledTXs.emplace(p.first);
+        }
+    }
+    settledTotal = SettledCredit();
+    mapSettledAssetAmounts.clear();
+}
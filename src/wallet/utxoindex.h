@@ -0,0 +1,111 @@
+// Copyright (c) 2024 The FortuneBlock developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_UTXOINDEX_H
+#define BITCOIN_WALLET_UTXOINDEX_H
+
+#include <amount.h>
+#include <primitives/transaction.h>
+#include <wallet/ismine.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+class CWalletTx;
+
+/**
+ * The unspent outputs of a wallet, keyed by outpoint.
+ *
+ * Each entry caches what GetBalance/AvailableCoins would otherwise re-derive from the script on every call: the
+ * ismine type and, for asset outputs, the transferred asset. The index also tracks the transactions which have
+ * unspent outputs ("spendable transactions").
+ *
+ * Once a spendable transaction is deep enough in the chain that new blocks no longer change how it is counted, the
+ * wallet settles it: its credits are added to running totals, so balances only need to walk the transactions which
+ * are not settled yet. Adding or removing one of its outputs or marking the transaction dirty unsettles it again.
+ */
+class CWalletUTXOIndex {
+public:
+    struct Entry {
+        const CWalletTx *wtx{nullptr};
+        isminetype mine{ISMINE_NO};
+        bool fAssetScript{false};
+        //! empty unless the output is a valid asset transfer
+        std::string assetId;
+        CAmount nAssetAmount{0};
+    };
+
+    /** What a settled transaction contributes to the running totals */
+    struct SettledCredit {
+        CAmount nCredit{0};
+        CAmount nWatchCredit{0};
+        CAmount nAnonymizedCredit{0};
+        CAmount nDenominatedCredit{0};
+        //! amounts of its unlocked asset outputs
+        std::vector<std::pair<std::string, CAmount>> vecAssetAmounts;
+    };
+
+private:
+    struct SpendableTx {
+        size_t nUTXOs{0};
+        bool fSettled{false};
+        SettledCredit credit;
+    };
+
+    std::map<COutPoint, Entry> mapEntries;
+    std::set<COutPoint> setAssetOutpoints;
+
+    // settling only caches what the balance calls computed anyway, so it is allowed from const methods
+    mutable std::unordered_map<const CWalletTx *, SpendableTx> mapSpendableTXs;
+    mutable std::unordered_set<const CWalletTx *> setUnsettledTXs;
+    mutable SettledCredit settledTotal;
+    mutable std::map<std::string, CAmount> mapSettledAssetAmounts;
+
+public:
+    /** Add or replace the entry of an unspent output. Returns true if the outpoint was not in the index yet. */
+    bool Add(const COutPoint &outpoint, Entry entry);
+
+    /** Returns true if the outpoint was in the index. */
+    bool Erase(const COutPoint &outpoint);
+
+    void Clear();
+
+    const Entry *Find(const COutPoint &outpoint) const;
+
+    bool Contains(const COutPoint &outpoint) const { return mapEntries.count(outpoint) != 0; }
+
+    size_t size() const { return mapEntries.size(); }
+
+    //! sorted by outpoint, so all outputs of a transaction are neighbors
+    const std::map<COutPoint, Entry> &GetEntries() const { return mapEntries; }
+
+    //! the outpoints of all entries with fAssetScript set
+    const std::set<COutPoint> &GetAssetOutpoints() const { return setAssetOutpoints; }
+
+    std::vector<const CWalletTx *> GetSpendableTXs() const;
+
+    //! whether any entry still points to wtx
+    bool HasSpendableTx(const CWalletTx *wtx) const { return mapSpendableTXs.count(wtx) != 0; }
+
+    const std::unordered_set<const CWalletTx *> &GetUnsettledTXs() const { return setUnsettledTXs; }
+
+    size_t GetSettledTXCount() const { return mapSpendableTXs.size() - setUnsettledTXs.size(); }
+
+    void SettleTx(const CWalletTx *wtx, SettledCredit credit) const;
+
+    void UnsettleTx(const CWalletTx *wtx) const;
+
+    void UnsettleAll() const;
+
+    const SettledCredit &GetSettledTotal() const { return settledTotal; }
+
+    const std::map<std::string, CAmount> &GetSettledAssetAmounts() const { return mapSettledAssetAmounts; }
+};
+
+#endif // BITCOIN_WALLET_UTXOINDEX_H
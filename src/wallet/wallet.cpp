@@ -11,6 +11,7 @@
 #include <chainparams.h>
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <ctpl_stl.h>
 #include <fs.h>
 #include <interfaces/chain.h>
 #include <interfaces/wallet.h>
@@ -54,6 +55,7 @@
 #include <rpc/specialtx_utilities.h>
 
 #include <assert.h>
+#include <deque>
 #include <future>
 
 #include <boost/algorithm/string/replace.hpp>
@@ -952,7 +954,7 @@ bool CWallet::IsSpent(const uint256 &hash, unsigned int n) const {
 
 void CWallet::AddToSpends(const COutPoint &outpoint, const uint256 &wtxid) {
     mapTxSpends.insert(std::make_pair(outpoint, wtxid));
-    setWalletUTXO.erase(outpoint);
+    walletUTXOIndex.Erase(outpoint);
 
     setLockedCoins.erase(outpoint);
 
@@ -1187,8 +1189,7 @@ bool CWallet::AddToWallet(const CWalletTx &wtxIn, bool fFlushOnClose, bool resca
 
         auto mnList = deterministicMNManager->GetListAtChainTip();
         for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
-            if (IsMine(wtx.tx->vout[i]) && !IsSpent(hash, i)) {
-                setWalletUTXO.insert(COutPoint(hash, i));
+            if (UpdateWalletUTXO(wtx, i)) {
                 if (deterministicMNManager->IsProTxWithCollateral(wtx.tx, i) ||
                     mnList.HasMNByCollateral(COutPoint(hash, i))) {
                     LockCoin(COutPoint(hash, i));
@@ -1217,14 +1218,12 @@ bool CWallet::AddToWallet(const CWalletTx &wtxIn, bool fFlushOnClose, bool resca
 
         auto mnList = deterministicMNManager->GetListAtChainTip();
         for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
-            if (IsMine(wtx.tx->vout[i]) && !IsSpent(hash, i)) {
-                bool new_utxo = setWalletUTXO.insert(COutPoint(hash, i)).second;
-                if (new_utxo && (deterministicMNManager->IsProTxWithCollateral(wtx.tx, i) ||
-                                 mnList.HasMNByCollateral(COutPoint(hash, i)))) {
-                    LockCoin(COutPoint(hash, i));
-                }
-                fUpdated |= new_utxo;
+            bool new_utxo = UpdateWalletUTXO(wtx, i);
+            if (new_utxo && (deterministicMNManager->IsProTxWithCollateral(wtx.tx, i) ||
+                             mnList.HasMNByCollateral(COutPoint(hash, i)))) {
+                LockCoin(COutPoint(hash, i));
             }
+            fUpdated |= new_utxo;
         }
     }
 
@@ -1419,6 +1418,10 @@ void CWallet::MarkInputsDirty(const CTransactionRef &tx) {
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            // the spending tx might have been abandoned or conflicted, which makes the output unspent again
+            if (txin.prevout.n < it->second.tx->vout.size()) {
+                UpdateWalletUTXO(it->second, txin.prevout.n);
+            }
         }
     }
 }
@@ -1602,6 +1605,9 @@ void CWallet::BlockDisconnected(const CBlock &block, int height) {
         SyncTransaction(ptx, confirm);
     }
 
+    // every settled tx lost a confirmation, some might not be deep enough anymore
+    walletUTXOIndex.UnsettleAll();
+
     // reset cache to make sure no longer mature coins are excluded
     fAnonymizableTallyCached = false;
     fAnonymizableTallyCachedNonDenom = false;
@@ -2387,6 +2393,19 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver &r
     return startTime;
 }
 
+//! Blocks a rescan keeps in flight per thread
+static const size_t RESCAN_BLOCKS_PER_THREAD = 4;
+
+/** A block read for a rescan, with the outputs of its transactions checked against the keys of the wallet */
+struct RescanBlock {
+    bool fFound{false};
+    CBlock block;
+    //! per transaction, whether one of its outputs is ours
+    std::vector<bool> vTxIsMine;
+    //! m_max_keypool_index before the outputs were checked, keys added to the keypool since then were not considered
+    int64_t nKeyPoolIndex{0};
+};
+
 /**
  * Scan the block chain (starting in start_block) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -2410,6 +2429,7 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver &r
  */
 CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256 &start_block, const uint256 &stop_block,
                                                        const WalletRescanReserver &reserver, bool fUpdate) {
+    AssertLockNotHeld(cs_wallet);
     int64_t nNow = GetTime();
 
     assert(reserver.isReserved());
@@ -2419,12 +2439,45 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256 &start_bloc
 
     WalletLogPrintf("Rescan started from block %s...\n", start_block.ToString());
 
+    // Checking the outputs of a block against our keys is the expensive part of a rescan and doesn't depend on the
+    // transactions found in the blocks before it, so it runs on the worker threads together with reading the block.
+    // Only the transactions which might be relevant are then synced in order, under cs_wallet.
+    int nThreads = gArgs.GetArg("-rescanthreads", DEFAULT_RESCAN_THREADS);
+    if (nThreads <= 0) {
+        nThreads = GetNumCores();
+    }
+    nThreads = std::max(1, std::min(nThreads, MAX_RESCAN_THREADS));
+
+    // nKeyPoolIndex is read by the scanning thread when it hands out the block, the workers never take cs_wallet
+    auto readBlock = [this](const uint256 &hash, int64_t nKeyPoolIndex) {
+        auto ret = std::make_shared<RescanBlock>();
+        ret->nKeyPoolIndex = nKeyPoolIndex;
+        ret->fFound = chain().findBlock(hash, &ret->block) && !ret->block.IsNull();
+        if (ret->fFound) {
+            ret->vTxIsMine.reserve(ret->block.vtx.size());
+            for (const CTransactionRef &tx: ret->block.vtx) {
+                ret->vTxIsMine.emplace_back(IsMine(*tx));
+            }
+        }
+        return ret;
+    };
+
+    ctpl::thread_pool workerPool;
+    std::deque<std::pair<uint256, std::future<std::shared_ptr<RescanBlock>>>> prefetchedBlocks;
+    int nNextPrefetchHeight{0};
+    const size_t nMaxPrefetchedBlocks = nThreads > 1 ? nThreads * RESCAN_BLOCKS_PER_THREAD : 0;
+    if (nThreads > 1) {
+        workerPool.resize(nThreads);
+        RenameThreadPool(workerPool, "rescan");
+    }
+
     {
         fAbortRescan = false;
         ShowProgress(strprintf("%s " + _("Rescanning..."), GetDisplayName()),
                      0); // show rescan progress in GUI as dialog or on splashscreen, if -rescan on startup
         uint256 tip_hash;
         Optional<int> block_height;
+        Optional<int> stop_height;
         double progress_begin;
         double progress_end;
         {
@@ -2432,9 +2485,15 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256 &start_bloc
                 tip_hash = chain().getBlockHash(*tip_height);
             }
             block_height = chain().getBlockHeight(block_hash);
+            if (!stop_block.IsNull()) {
+                stop_height = chain().getBlockHeight(stop_block);
+            }
             progress_begin = chain().guessVerificationProgress(block_hash);
             progress_end = chain().guessVerificationProgress(stop_block.IsNull() ? tip_hash : stop_block);
         }
+        if (block_height) {
+            nNextPrefetchHeight = *block_height;
+        }
         double progress_current = progress_begin;
         while (block_height && !fAbortRescan && !chain().shutdownRequested()) {
             m_scanning_progress = (progress_current - progress_begin) / (progress_end - progress_begin);
@@ -2447,8 +2506,38 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256 &start_bloc
                 WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", *block_height, progress_current);
             }
 
-            CBlock block;
-            if (chain().findBlock(block_hash, &block) && !block.IsNull()) {
+            if (!prefetchedBlocks.empty() && prefetchedBlocks.front().first != block_hash) {
+                // the chain was reorganized since the blocks were queued
+                prefetchedBlocks.clear();
+                nNextPrefetchHeight = *block_height;
+            }
+            const int64_t nKeyPoolIndex = WITH_LOCK(cs_wallet, return m_max_keypool_index);
+            if (nMaxPrefetchedBlocks != 0) {
+                const Optional<int> tip_height = chain().getHeight();
+                while (prefetchedBlocks.size() < nMaxPrefetchedBlocks && tip_height &&
+                       nNextPrefetchHeight <= *tip_height && (!stop_height || nNextPrefetchHeight <= *stop_height)) {
+                    // unlike getBlockHash, this doesn't abort if the tip moved back in the meantime
+                    uint256 hash;
+                    const Optional<int> height = chain().findFirstBlockWithTimeAndHeight(0, nNextPrefetchHeight, &hash);
+                    if (!height || *height != nNextPrefetchHeight) {
+                        break;
+                    }
+                    prefetchedBlocks.emplace_back(hash, workerPool.push([readBlock, hash, nKeyPoolIndex](int threadId) {
+                        return readBlock(hash, nKeyPoolIndex);
+                    }));
+                    ++nNextPrefetchHeight;
+                }
+            }
+            std::shared_ptr<RescanBlock> scanned;
+            if (!prefetchedBlocks.empty() && prefetchedBlocks.front().first == block_hash) {
+                scanned = prefetchedBlocks.front().second.get();
+                prefetchedBlocks.pop_front();
+            } else {
+                scanned = readBlock(block_hash, nKeyPoolIndex);
+            }
+
+            if (scanned->fFound) {
+                const CBlock &block = scanned->block;
                 LOCK(cs_wallet);
                 if (!chain().getBlockHeight(block_hash)) {
                     // Abort scan if current block is no longer active, to prevent
@@ -2459,10 +2548,17 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256 &start_bloc
                     result.status = ScanResult::FAILURE;
                     break;
                 }
+                // a transaction of an earlier block used a keypool key, the keys topped up since then weren't checked
+                const bool fRecheckOutputs = scanned->nKeyPoolIndex != m_max_keypool_index;
                 for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
+                    const CTransactionRef &tx = block.vtx[posInBlock];
+                    if (!scanned->vTxIsMine[posInBlock] && !(fRecheckOutputs && IsMine(*tx)) &&
+                        !IsRelatedToWalletTxs(*tx)) {
+                        continue;
+                    }
                     CWalletTx::Confirmation confirm(CWalletTx::Status::CONFIRMED, *block_height, block_hash,
                                                     posInBlock);
-                    SyncTransaction(block.vtx[posInBlock], confirm, fUpdate);
+                    SyncTransaction(tx, confirm, fUpdate);
                 }
                 // scan succeeded, record block as most recent successfully scanned
                 result.last_scanned_block = block_hash;
@@ -2506,9 +2602,27 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256 &start_bloc
             result.status = ScanResult::USER_ABORT;
         }
     }
+
+    // don't wait for blocks which are not needed anymore
+    workerPool.clear_queue();
+    workerPool.stop(true);
     return result;
 }
 
+bool CWallet::IsRelatedToWalletTxs(const CTransaction &tx) const {
+    AssertLockHeld(cs_wallet);
+
+    if (mapWallet.count(tx.GetHash())) {
+        return true;
+    }
+    for (const CTxIn &txin: tx.vin) {
+        if (mapWallet.count(txin.prevout.hash) || mapTxSpends.count(txin.prevout)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void CWallet::ReacceptWalletTransactions() {
     // If transactions aren't being broadcasted, don't let them into local mempool either
     if (!fBroadcastTransactions)
@@ -2604,6 +2718,26 @@ CAmount CWalletTx::GetDebit(const isminefilter &filter, isminefilter *mineTypes)
     return debit;
 }
 
+void CWalletTx::MarkDirty() {
+    fCreditCached = false;
+    fAvailableCreditCached = false;
+    fImmatureCreditCached = false;
+    fAnonymizedCreditCached = false;
+    fDenomUnconfCreditCached = false;
+    fDenomConfCreditCached = false;
+    fWatchDebitCached = false;
+    fWatchCreditCached = false;
+    fAvailableWatchCreditCached = false;
+    fImmatureWatchCreditCached = false;
+    fDebitCached = false;
+    fChangeCached = false;
+
+    // the settled credit of this tx was taken from the caches above
+    if (pwallet) {
+        pwallet->UnsettleWalletTx(*this);
+    }
+}
+
 CAmount CWalletTx::GetCredit(const isminefilter &filter, isminefilter *mineTypes) const {
     // Must wait until coinbase is safely deep enough in the chain before valuing it
     if (IsImmatureCoinBase())
@@ -2894,24 +3028,73 @@ void MaybeResendWalletTxs() {
  */
 
 
-std::unordered_set<const CWalletTx *, WalletTxHasher> CWallet::GetSpendableTXs() const {
+//! Spendable TXs at least this deep are settled, new blocks don't change how they are counted anymore
+static const int SETTLED_TX_DEPTH = COINBASE_MATURITY + 1;
+
+bool CWallet::UpdateWalletUTXO(const CWalletTx &wtx, unsigned int n) {
     AssertLockHeld(cs_wallet);
 
-    std::unordered_set<const CWalletTx *, WalletTxHasher> ret;
-    for (auto it = setWalletUTXO.begin(); it != setWalletUTXO.end();) {
-        const auto &outpoint = *it;
-        const auto jt = mapWallet.find(outpoint.hash);
-        if (jt != mapWallet.end()) {
-            ret.emplace(&jt->second);
+    const COutPoint outpoint(wtx.GetHash(), n);
+    const CTxOut &txout = wtx.tx->vout[n];
+
+    CWalletUTXOIndex::Entry utxo;
+    utxo.mine = IsMine(txout);
+    if (utxo.mine == ISMINE_NO || IsSpent(outpoint.hash, n)) {
+        walletUTXOIndex.Erase(outpoint);
+        return false;
+    }
+
+    utxo.wtx = &wtx;
+    utxo.fAssetScript = txout.scriptPubKey.IsAssetScript();
+    CAssetTransfer assetTransfer;
+    if (utxo.fAssetScript && GetTransferAsset(txout.scriptPubKey, assetTransfer)) {
+        utxo.assetId = assetTransfer.assetId;
+        utxo.nAssetAmount = assetTransfer.nAmount;
+    }
+    return walletUTXOIndex.Add(outpoint, std::move(utxo));
+}
+
+void CWallet::RebuildWalletUTXOIndex() {
+    AssertLockHeld(cs_wallet);
+
+    walletUTXOIndex.Clear();
+    for (const auto &pair: mapWallet) {
+        for (unsigned int i = 0; i < pair.second.tx->vout.size(); ++i) {
+            UpdateWalletUTXO(pair.second, i);
         }
+    }
+}
 
-        // setWalletUTXO is sorted by COutPoint, which means that all UTXOs for the same TX are neighbors
-        // skip entries until we encounter a new TX
-        while (it != setWalletUTXO.end() && it->hash == outpoint.hash) {
-            ++it;
+void CWallet::SettleWalletUTXOs() const {
+    AssertLockHeld(cs_wallet);
+
+    std::vector<const CWalletTx *> vecSettle;
+    for (const CWalletTx *pcoin: walletUTXOIndex.GetUnsettledTXs()) {
+        if (pcoin->GetDepthInMainChain() >= SETTLED_TX_DEPTH && pcoin->IsTrusted() && !pcoin->IsImmatureCoinBase()) {
+            vecSettle.emplace_back(pcoin);
         }
     }
-    return ret;
+
+    const auto &entries = walletUTXOIndex.GetEntries();
+    for (const CWalletTx *pcoin: vecSettle) {
+        CWalletUTXOIndex::SettledCredit credit;
+        credit.nCredit = pcoin->GetAvailableCredit(/* fUseCache */ true, ISMINE_SPENDABLE);
+        credit.nWatchCredit = pcoin->GetAvailableCredit(/* fUseCache */ true, ISMINE_WATCH_ONLY);
+        credit.nAnonymizedCredit = pcoin->GetAnonymizedCredit();
+        credit.nDenominatedCredit = pcoin->GetDenominatedCredit(false);
+
+        const uint256 &hash = pcoin->GetHash();
+        for (auto it = entries.lower_bound(COutPoint(hash, 0)); it != entries.end() && it->first.hash == hash; ++it) {
+            if (!it->second.assetId.empty() && !IsLockedCoin(hash, it->first.n)) {
+                credit.vecAssetAmounts.emplace_back(it->second.assetId, it->second.nAssetAmount);
+            }
+        }
+        walletUTXOIndex.SettleTx(pcoin, std::move(credit));
+    }
+}
+
+void CWallet::UnsettleWalletTx(const CWalletTx &wtx) const {
+    walletUTXOIndex.UnsettleTx(&wtx);
 }
 
 CWallet::Balance
@@ -2919,7 +3102,8 @@ CWallet::GetBalance(const int min_depth, const bool fAddLocked, const CCoinContr
     Balance ret;
     {
         LOCK(cs_wallet);
-        for (auto pcoin: GetSpendableTXs()) {
+
+        auto addTx = [&](const CWalletTx *pcoin) {
             const bool is_trusted{pcoin->IsTrusted()};
             const int tx_depth{pcoin->GetDepthInMainChain()};
             const CAmount tx_credit_mine{pcoin->GetAvailableCredit(/* fUseCache */ true, ISMINE_SPENDABLE)};
@@ -2939,6 +3123,53 @@ CWallet::GetBalance(const int min_depth, const bool fAddLocked, const CCoinContr
                 ret.m_denominated_trusted += pcoin->GetDenominatedCredit(false);
                 ret.m_denominated_untrusted_pending += pcoin->GetDenominatedCredit(true);
             }
+        };
+
+        // Settled TXs are trusted, mature and at least min_depth deep, so they only add to the trusted balances.
+        // Their running totals can't honor coin control selections though.
+        if (min_depth <= SETTLED_TX_DEPTH && coinControl == nullptr) {
+            SettleWalletUTXOs();
+            const auto &settled = walletUTXOIndex.GetSettledTotal();
+            ret.m_mine_trusted = settled.nCredit;
+            ret.m_watchonly_trusted = settled.nWatchCredit;
+            if (CCoinJoinClientOptions::IsEnabled()) {
+                ret.m_anonymized = settled.nAnonymizedCredit;
+                ret.m_denominated_trusted = settled.nDenominatedCredit;
+            }
+            for (const CWalletTx *pcoin: walletUTXOIndex.GetUnsettledTXs()) {
+                addTx(pcoin);
+            }
+        } else {
+            for (const CWalletTx *pcoin: walletUTXOIndex.GetSpendableTXs()) {
+                addTx(pcoin);
+            }
+        }
+    }
+
+    return ret;
+}
+
+std::map <std::string, CAmount> CWallet::GetAssetBalances() const {
+    LOCK(cs_wallet);
+
+    if (!Updates().IsAssetsActive(::ChainActive().Tip())) {
+        return {};
+    }
+
+    SettleWalletUTXOs();
+    std::map <std::string, CAmount> ret = walletUTXOIndex.GetSettledAssetAmounts();
+
+    // the same filters AvailableAssets() applies with its default arguments
+    const auto &entries = walletUTXOIndex.GetEntries();
+    for (const CWalletTx *pcoin: walletUTXOIndex.GetUnsettledTXs()) {
+        if (!chain().checkFinalTx(*pcoin->tx) || pcoin->IsImmatureCoinBase()) continue;
+        if (pcoin->GetDepthInMainChain() == 0 && !pcoin->InMempool()) continue;
+        if (!pcoin->IsTrusted()) continue;
+
+        const uint256 &hash = pcoin->GetHash();
+        for (auto it = entries.lower_bound(COutPoint(hash, 0)); it != entries.end() && it->first.hash == hash; ++it) {
+            if (it->second.assetId.empty() || IsLockedCoin(hash, it->first.n) || IsSpent(hash, it->first.n)) continue;
+            ret[it->second.assetId] += it->second.nAssetAmount;
         }
     }
 
@@ -2975,7 +3206,8 @@ float CWallet::GetAverageAnonymizedRounds() const {
     int nCount = 0;
 
     LOCK(cs_wallet);
-    for (const auto &outpoint: setWalletUTXO) {
+    for (const auto &utxo: walletUTXOIndex.GetEntries()) {
+        const COutPoint &outpoint = utxo.first;
         if (!IsDenominated(outpoint)) continue;
 
         nTotal += GetCappedOutpointCoinJoinRounds(outpoint);
@@ -2995,13 +3227,13 @@ CAmount CWallet::GetNormalizedAnonymizedBalance() const {
     CAmount nTotal = 0;
 
     LOCK(cs_wallet);
-    for (const auto &outpoint: setWalletUTXO) {
-        const auto it = mapWallet.find(outpoint.hash);
-        if (it == mapWallet.end()) continue;
+    for (const auto &utxo: walletUTXOIndex.GetEntries()) {
+        const COutPoint &outpoint = utxo.first;
+        const CWalletTx *wtx = utxo.second.wtx;
 
-        CAmount nValue = it->second.tx->vout[outpoint.n].nValue;
+        CAmount nValue = wtx->tx->vout[outpoint.n].nValue;
         if (!CCoinJoin::IsDenominatedAmount(nValue)) continue;
-        if (it->second.GetDepthInMainChain() < 0) continue;
+        if (wtx->GetDepthInMainChain() < 0) continue;
 
         int nRounds = GetCappedOutpointCoinJoinRounds(outpoint);
         nTotal += nValue * nRounds / CCoinJoinClientOptions::GetRounds();
@@ -3101,150 +3333,164 @@ void CWallet::AvailableCoins(std::vector <COutput> &vCoins, std::map <std::strin
     std::set <std::string> setAssetMaxFound;
 
     bool fGetAssets = Updates().IsAssetsActive(::ChainActive().Tip()) && fOnlyAssets;
+    if (!fGetFTB && !fGetAssets) {
+        return;
+    }
 
-    for (auto pcoin: GetSpendableTXs()) {
-        const uint256 &wtxid = pcoin->GetHash();
+    // the TX of the previous output, all UTXOs for the same TX are neighbors in the index
+    const CWalletTx *pcoin = nullptr;
+    bool fSkipTx = false;
+    int nDepth = 0;
+    bool safeTx = false;
 
-        if (!chain().checkFinalTx(*pcoin->tx))
-            continue;
-
-        if (pcoin->IsImmatureCoinBase())
-            continue;
+    auto addOutput = [&](const COutPoint &outpoint, const CWalletUTXOIndex::Entry &utxo) {
+        // Asset outputs are only returned when asking for assets
+        if (utxo.fAssetScript && !fGetAssets)
+            return;
 
-        int nDepth = pcoin->GetDepthInMainChain();
+        if (utxo.wtx != pcoin) {
+            pcoin = utxo.wtx;
+            fSkipTx = true;
 
-        // We should not consider coins which aren't at least in our mempool
-        // It's possible for these to be conflicted via ancestors which we may never be able to detect
-        if (nDepth == 0 && !pcoin->InMempool())
-            continue;
+            if (!chain().checkFinalTx(*pcoin->tx))
+                return;
 
-        bool safeTx = pcoin->IsTrusted(); // This doesn't account for future Tx outputs - we check that below.
+            if (pcoin->IsImmatureCoinBase())
+                return;
 
-        if (fOnlySafe && !safeTx) {
-            continue;
-        }
+            nDepth = pcoin->GetDepthInMainChain();
 
-        if (nDepth < nMinDepth || nDepth > nMaxDepth)
-            continue;
+            // We should not consider coins which aren't at least in our mempool
+            // It's possible for these to be conflicted via ancestors which we may never be able to detect
+            if (nDepth == 0 && !pcoin->InMempool())
+                return;
 
-        for (unsigned int i = 0; i < pcoin->tx->vout.size(); i++) {
-            bool found = false;
-            if (nCoinType == CoinType::ONLY_FULLY_MIXED) {
-                if (!CCoinJoin::IsDenominatedAmount(pcoin->tx->vout[i].nValue)) continue;
-                found = IsFullyMixed(COutPoint(wtxid, i));
-            } else if (nCoinType == CoinType::ONLY_READY_TO_MIX) {
-                if (!CCoinJoin::IsDenominatedAmount(pcoin->tx->vout[i].nValue)) continue;
-                found = !IsFullyMixed(COutPoint(wtxid, i));
-            } else if (nCoinType == CoinType::ONLY_NONDENOMINATED) {
-                if (CCoinJoin::IsCollateralAmount(pcoin->tx->vout[i].nValue)) continue; // do not use collateral amounts
-                found = !CCoinJoin::IsDenominatedAmount(pcoin->tx->vout[i].nValue);
-            } else if (nCoinType == CoinType::ONLY_SMARTNODE_COLLATERAL) {
-                found = collaterals.isValidCollateral(pcoin->tx->vout[i].nValue);
-            } else if (nCoinType == CoinType::ONLY_COINJOIN_COLLATERAL) {
-                found = CCoinJoin::IsCollateralAmount(pcoin->tx->vout[i].nValue);
-            } else {
-                found = true;
-            }
-            if (!found) continue;
+            safeTx = pcoin->IsTrusted(); // This doesn't account for future Tx outputs - we check that below.
 
-            bool isAssetScript = pcoin->tx->vout[i].scriptPubKey.IsAssetScript();
+            if (fOnlySafe && !safeTx)
+                return;
 
-            if (!isAssetScript &&
-                (pcoin->tx->vout[i].nValue < nMinimumAmount || pcoin->tx->vout[i].nValue > nMaximumAmount))
-                continue;
+            if (nDepth < nMinDepth || nDepth > nMaxDepth)
+                return;
 
-            if (coinControl && !isAssetScript && coinControl->HasSelected() && !coinControl->fAllowOtherInputs &&
-                !coinControl->IsSelected(COutPoint(wtxid, i)))
-                continue;
+            fSkipTx = false;
+        }
+        if (fSkipTx)
+            return;
 
-            if (coinControl && isAssetScript && coinControl->HasAssetSelected() && !coinControl->fAllowOtherInputs &&
-                !coinControl->IsAssetSelected(COutPoint(wtxid, i)))
-                continue;
+        const uint256 &wtxid = outpoint.hash;
+        const unsigned int i = outpoint.n;
+        const CTxOut &txout = pcoin->tx->vout[i];
+
+        bool found = false;
+        if (nCoinType == CoinType::ONLY_FULLY_MIXED) {
+            if (!CCoinJoin::IsDenominatedAmount(txout.nValue)) return;
+            found = IsFullyMixed(outpoint);
+        } else if (nCoinType == CoinType::ONLY_READY_TO_MIX) {
+            if (!CCoinJoin::IsDenominatedAmount(txout.nValue)) return;
+            found = !IsFullyMixed(outpoint);
+        } else if (nCoinType == CoinType::ONLY_NONDENOMINATED) {
+            if (CCoinJoin::IsCollateralAmount(txout.nValue)) return; // do not use collateral amounts
+            found = !CCoinJoin::IsDenominatedAmount(txout.nValue);
+        } else if (nCoinType == CoinType::ONLY_SMARTNODE_COLLATERAL) {
+            found = collaterals.isValidCollateral(txout.nValue);
+        } else if (nCoinType == CoinType::ONLY_COINJOIN_COLLATERAL) {
+            found = CCoinJoin::IsCollateralAmount(txout.nValue);
+        } else {
+            found = true;
+        }
+        if (!found) return;
 
-            if (IsLockedCoin(wtxid, i) && nCoinType != CoinType::ONLY_SMARTNODE_COLLATERAL)
-                continue;
+        bool isAssetScript = utxo.fAssetScript;
 
-            if (IsSpent(wtxid, i))
-                continue;
+        if (!isAssetScript && (txout.nValue < nMinimumAmount || txout.nValue > nMaximumAmount))
+            return;
 
-            isminetype mine = IsMine(pcoin->tx->vout[i]);
+        if (coinControl && !isAssetScript && coinControl->HasSelected() && !coinControl->fAllowOtherInputs &&
+            !coinControl->IsSelected(outpoint))
+            return;
 
-            if (mine == ISMINE_NO) {
-                continue;
-            }
+        if (coinControl && isAssetScript && coinControl->HasAssetSelected() && !coinControl->fAllowOtherInputs &&
+            !coinControl->IsAssetSelected(outpoint))
+            return;
 
-            bool fSpendableIn = ((mine & ISMINE_SPENDABLE) != ISMINE_NO) ||
-                                (coinControl && coinControl->fAllowWatchOnly &&
-                                 (mine & ISMINE_WATCH_SOLVABLE) != ISMINE_NO);
-            bool fSolvableIn = (mine & (ISMINE_SPENDABLE | ISMINE_WATCH_SOLVABLE)) != ISMINE_NO;
-            bool isCoinSpendable = pcoin->isFutureSpendable(i);
+        if (IsLockedCoin(wtxid, i) && nCoinType != CoinType::ONLY_SMARTNODE_COLLATERAL)
+            return;
 
-            std::string address;
-            if (fGetAssets && isAssetScript) {
-                CAssetTransfer assetTransfer;
-                if (!GetTransferAsset(pcoin->tx->vout[i].scriptPubKey, assetTransfer))
-                    continue;
+        if (IsSpent(wtxid, i))
+            return;
 
-                CTxDestination destination;
-                ExtractDestination(pcoin->tx->vout[i].scriptPubKey, destination);
-                address = EncodeDestination(destination);
-                // If we already have the maximum amount or size for this asset, skip it
-                if (setAssetMaxFound.count(assetTransfer.assetId))
-                    continue;
+        isminetype mine = utxo.mine;
 
-                // Initialize the map vector is it doesn't exist yet
-                if (!mapAssetCoins.count(assetTransfer.assetId)) {
-                    std::vector <COutput> vOutput;
-                    mapAssetCoins.insert(std::make_pair(assetTransfer.assetId, vOutput));
-                }
+        bool fSpendableIn = ((mine & ISMINE_SPENDABLE) != ISMINE_NO) ||
+                            (coinControl && coinControl->fAllowWatchOnly &&
+                             (mine & ISMINE_WATCH_SOLVABLE) != ISMINE_NO);
+        bool fSolvableIn = (mine & (ISMINE_SPENDABLE | ISMINE_WATCH_SOLVABLE)) != ISMINE_NO;
+        bool isCoinSpendable = pcoin->isFutureSpendable(i);
 
-                // Add the COutput to the map of available Asset Coins
-                mapAssetCoins.at(assetTransfer.assetId).push_back(
-                        COutput(pcoin, i, nDepth, fSpendableIn, fSolvableIn, safeTx && isCoinSpendable,
-                                pcoin->tx->nType == TRANSACTION_FUTURE, isCoinSpendable));
+        if (fGetAssets && isAssetScript) {
+            if (utxo.assetId.empty())
+                return;
 
-                // Initialize the map of current asset totals
-                if (!mapAssetTotals.count(assetTransfer.assetId))
-                    mapAssetTotals[assetTransfer.assetId] = 0;
+            const std::string &assetId = utxo.assetId;
+            // If we already have the maximum amount or size for this asset, skip it
+            if (setAssetMaxFound.count(assetId))
+                return;
 
-                // Update the map of totals depending the which type of asset tx we are looking at
-                mapAssetTotals[assetTransfer.assetId] += assetTransfer.nAmount;
+            // Add the COutput to the map of available Asset Coins
+            auto &vAssetCoins = mapAssetCoins[assetId];
+            vAssetCoins.push_back(COutput(pcoin, i, nDepth, fSpendableIn, fSolvableIn, safeTx && isCoinSpendable,
+                                          pcoin->tx->nType == TRANSACTION_FUTURE, isCoinSpendable));
 
-                // Checks the sum amount of all UTXO's, and adds to the set of assets that we found the max for
-                if (nMinimumSumAmount != MAX_MONEY) {
-                    if (mapAssetTotals[assetTransfer.assetId] >= nMinimumSumAmount)
-                        setAssetMaxFound.insert(assetTransfer.assetId);
-                }
+            // Update the map of totals depending the which type of asset tx we are looking at
+            CAmount &nAssetTotal = mapAssetTotals[assetId];
+            nAssetTotal += utxo.nAssetAmount;
 
-                // Checks the maximum number of UTXO's, and addes to set of of asset that we found the max for
-                if (nMaximumCount > 0 && mapAssetCoins[assetTransfer.assetId].size() >= nMaximumCount) {
-                    setAssetMaxFound.insert(assetTransfer.assetId);
-                }
+            // Checks the sum amount of all UTXO's, and adds to the set of assets that we found the max for
+            if (nMinimumSumAmount != MAX_MONEY) {
+                if (nAssetTotal >= nMinimumSumAmount)
+                    setAssetMaxFound.insert(assetId);
             }
 
-            if (fGetFTB) {
-                if (fFTBLimitHit) // We hit our limit
-                    continue;
-                // We only want FTB OutPoints. Don't include Asset OutPoints
-                if (isAssetScript)
-                    continue;
+            // Checks the maximum number of UTXO's, and addes to set of of asset that we found the max for
+            if (nMaximumCount > 0 && vAssetCoins.size() >= nMaximumCount) {
+                setAssetMaxFound.insert(assetId);
+            }
+        }
 
-                vCoins.push_back(COutput(pcoin, i, nDepth, fSpendableIn, fSolvableIn, safeTx && isCoinSpendable,
-                                         pcoin->tx->nType == TRANSACTION_FUTURE, isCoinSpendable));
-                // Checks the sum amount of all UTXO's.
-                if (nMinimumSumAmount != MAX_MONEY) {
-                    nTotal += pcoin->tx->vout[i].nValue;
+        if (fGetFTB) {
+            if (fFTBLimitHit) // We hit our limit
+                return;
+            // We only want FTB OutPoints. Don't include Asset OutPoints
+            if (isAssetScript)
+                return;
 
-                    if (nTotal >= nMinimumSumAmount) {
-                        fFTBLimitHit = true;
-                    }
-                }
+            vCoins.push_back(COutput(pcoin, i, nDepth, fSpendableIn, fSolvableIn, safeTx && isCoinSpendable,
+                                     pcoin->tx->nType == TRANSACTION_FUTURE, isCoinSpendable));
+            // Checks the sum amount of all UTXO's.
+            if (nMinimumSumAmount != MAX_MONEY) {
+                nTotal += txout.nValue;
 
-                // Checks the maximum number of UTXO's.
-                if (nMaximumCount > 0 && vCoins.size() >= nMaximumCount) {
+                if (nTotal >= nMinimumSumAmount) {
                     fFTBLimitHit = true;
                 }
             }
+
+            // Checks the maximum number of UTXO's.
+            if (nMaximumCount > 0 && vCoins.size() >= nMaximumCount) {
+                fFTBLimitHit = true;
+            }
+        }
+    };
+
+    if (!fGetFTB) {
+        // only asset outputs are returned, so there is no need to look at the others
+        for (const COutPoint &outpoint: walletUTXOIndex.GetAssetOutpoints()) {
+            addOutput(outpoint, *walletUTXOIndex.Find(outpoint));
+        }
+    } else {
+        for (const auto &utxo: walletUTXOIndex.GetEntries()) {
+            addOutput(utxo.first, utxo.second);
         }
     }
 }
@@ -4031,14 +4277,14 @@ CWallet::SelectCoinsGroupedByAddresses(bool fSkipDenominated, bool fAnonymizable
 
     // Tally
     std::map <CTxDestination, CompactTallyItem> mapTally;
-    std::set <uint256> setWalletTxesCounted;
-    for (const auto &outpoint: setWalletUTXO) {
-        if (!setWalletTxesCounted.emplace(outpoint.hash).second) continue;
+    const CWalletTx *pwtxLast = nullptr;
+    for (const auto &utxo: walletUTXOIndex.GetEntries()) {
+        // the index is sorted by COutPoint, so all UTXOs for the same TX are neighbors and the TX is only looked at once
+        if (utxo.second.wtx == pwtxLast) continue;
+        pwtxLast = utxo.second.wtx;
 
-        std::map<uint256, CWalletTx>::const_iterator it = mapWallet.find(outpoint.hash);
-        if (it == mapWallet.end()) continue;
-
-        const CWalletTx &wtx = (*it).second;
+        const COutPoint &outpoint = utxo.first;
+        const CWalletTx &wtx = *pwtxLast;
 
         if (wtx.IsCoinBase() && wtx.GetBlocksToMaturity() > 0) continue;
         if (fSkipUnconfirmed && !wtx.IsTrusted()) continue;
@@ -4140,11 +4386,10 @@ int CWallet::CountInputsWithAmount(CAmount nInputAmount) const {
 
     LOCK(cs_wallet);
 
-    for (const auto &outpoint: setWalletUTXO) {
-        const auto it = mapWallet.find(outpoint.hash);
-        if (it == mapWallet.end()) continue;
-        if (it->second.tx->vout[outpoint.n].nValue != nInputAmount) continue;
-        if (it->second.GetDepthInMainChain() < 0) continue;
+    for (const auto &utxo: walletUTXOIndex.GetEntries()) {
+        const CWalletTx *wtx = utxo.second.wtx;
+        if (wtx->tx->vout[utxo.first.n].nValue != nInputAmount) continue;
+        if (wtx->GetDepthInMainChain() < 0) continue;
 
         nTotal++;
     }
@@ -4982,13 +5227,7 @@ DBErrors CWallet::LoadWallet(bool &fFirstRunRet) {
         const Optional<int> tip_height = chain().getHeight();
         if (tip_height) {
             SetLastBlockProcessed(*tip_height, chain().getBlockHash(*tip_height));
-            for (auto &pair: mapWallet) {
-                for (unsigned int i = 0; i < pair.second.tx->vout.size(); ++i) {
-                    if (IsMine(pair.second.tx->vout[i]) && !IsSpent(pair.first, i)) {
-                        setWalletUTXO.insert(COutPoint(pair.first, i));
-                    }
-                }
-            }
+            RebuildWalletUTXOIndex();
         }
     }
 
@@ -5021,11 +5260,27 @@ void CWallet::AutoLockSmartnodeCollaterals() {
 DBErrors CWallet::ZapSelectTx(std::vector <uint256> &vHashIn, std::vector <uint256> &vHashOut) {
     AssertLockHeld(cs_wallet);
     DBErrors nZapSelectTxRet = WalletBatch(*database, "cr+").ZapSelectTx(vHashIn, vHashOut);
+    std::set <COutPoint> setPrevouts;
     for (uint256 hash: vHashOut) {
         const auto &it = mapWallet.find(hash);
+        // walletUTXOIndex points into mapWallet, so the outputs must leave it before the TX does
+        for (unsigned int i = 0; i < it->second.tx->vout.size(); ++i) {
+            walletUTXOIndex.Erase(COutPoint(hash, i));
+        }
+        assert(!walletUTXOIndex.HasSpendableTx(&it->second));
+        for (const auto &txin: it->second.tx->vin) {
+            setPrevouts.emplace(txin.prevout);
+        }
         wtxOrdered.erase(it->second.m_it_wtxOrdered);
         mapWallet.erase(it);
     }
+    // the outputs spent by the zapped TXs may be unspent again
+    for (const auto &outpoint: setPrevouts) {
+        const auto it = mapWallet.find(outpoint.hash);
+        if (it != mapWallet.end() && outpoint.n < it->second.tx->vout.size()) {
+            UpdateWalletUTXO(it->second, outpoint.n);
+        }
+    }
 
     if (nZapSelectTxRet == DBErrors::NEED_REWRITE) {
         if (database->Rewrite("\x04pool")) {
@@ -5562,6 +5817,8 @@ void CWallet::UnlockCoin(const COutPoint &output) {
 void CWallet::UnlockAllCoins() {
     AssertLockHeld(cs_wallet);
     setLockedCoins.clear();
+    // the settled asset amounts exclude locked coins
+    walletUTXOIndex.UnsettleAll();
 }
 
 bool CWallet::IsLockedCoin(uint256 hash, unsigned int n) const {
@@ -5582,13 +5839,10 @@ void CWallet::ListLockedCoins(std::vector <COutPoint> &vOutpts) const {
 
 void CWallet::GetProTxCoins(const CDeterministicMNList &mnList, std::vector <COutPoint> &vOutpts) const {
     AssertLockHeld(cs_wallet);
-    for (const auto &o: setWalletUTXO) {
-        auto it = mapWallet.find(o.hash);
-        if (it != mapWallet.end()) {
-            const auto &p = it->second;
-            if (deterministicMNManager->IsProTxWithCollateral(p.tx, o.n) || mnList.HasMNByCollateral(o)) {
-                vOutpts.emplace_back(o);
-            }
+    for (const auto &utxo: walletUTXOIndex.GetEntries()) {
+        const COutPoint &o = utxo.first;
+        if (deterministicMNManager->IsProTxWithCollateral(utxo.second.wtx->tx, o.n) || mnList.HasMNByCollateral(o)) {
+            vOutpts.emplace_back(o);
         }
     }
 }
@@ -26,6 +26,7 @@
 #include <wallet/walletdb.h>
 #include <wallet/walletutil.h>
 #include <wallet/rpcwallet.h>
+#include <wallet/utxoindex.h>
 
 #include <governance/governance-object.h>
 #include <evo/providertx.h>
@@ -107,6 +108,11 @@ static const CAmount HIGH_MAX_TX_FEE = 100 * HIGH_TX_FEE_PER_KB;
 //! if set, all keys will be derived by using BIP39/BIP44
 static const bool DEFAULT_USE_HD_WALLET = false;
 
+//! -rescanthreads default, 0 = one per core
+static const int DEFAULT_RESCAN_THREADS = 0;
+//! Maximum number of threads a rescan reads blocks ahead with
+static const int MAX_RESCAN_THREADS = 16;
+
 class CCoinControl;
 
 class CKey;
@@ -513,20 +519,7 @@ public:
     }
 
     //! make sure balances are recalculated
-    void MarkDirty() {
-        fCreditCached = false;
-        fAvailableCreditCached = false;
-        fImmatureCreditCached = false;
-        fAnonymizedCreditCached = false;
-        fDenomUnconfCreditCached = false;
-        fDenomConfCreditCached = false;
-        fWatchDebitCached = false;
-        fWatchCreditCached = false;
-        fAvailableWatchCreditCached = false;
-        fImmatureWatchCreditCached = false;
-        fDebitCached = false;
-        fChangeCached = false;
-    }
+    void MarkDirty();
 
     void BindWallet(CWallet *pwalletIn) {
         pwallet = pwalletIn;
@@ -800,7 +793,8 @@ private:
 
     void AddToSpends(const uint256 &wtxid);
 
-    std::set <COutPoint> setWalletUTXO;
+    //! our unspent outputs, see CWalletUTXOIndex
+    CWalletUTXOIndex walletUTXOIndex;
     mutable std::map<COutPoint, int> mapOutpointRoundsCache;
 
     /**
@@ -825,7 +819,9 @@ private:
     void MarkConflicted(const uint256 &hashBlock, int conflicting_height, const uint256 &hashTx);
 
     /* Mark a transaction's inputs dorty, thus forcing the outputs to be recomputed */
-    void MarkInputsDirty(const CTransactionRef &tx);
+    void MarkInputsDirty(const CTransactionRef &tx)
+
+    EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
     void SyncMetaData(std::pair <TxSpends::iterator, TxSpends::iterator>);
 
@@ -876,8 +872,13 @@ private:
     /** Internal database handle. */
     std::unique_ptr <WalletDatabase> database;
 
-    // A helper function which loops through wallet UTXOs
-    std::unordered_set<const CWalletTx *, WalletTxHasher> GetSpendableTXs() const
+    /** Add the output to walletUTXOIndex if it is ours and unspent, remove it otherwise. Returns true if it was added. */
+    bool UpdateWalletUTXO(const CWalletTx &wtx, unsigned int n)
+
+    EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    /** Settle the spendable transactions which are deep enough in the chain, see CWalletUTXOIndex */
+    void SettleWalletUTXOs() const
 
     EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
@@ -1302,6 +1303,14 @@ public:
 
     void MarkDirty();
 
+    /**
+     * Re-derive walletUTXOIndex from mapWallet, e.g. after keys or scripts were imported and the ismine
+     * type of existing outputs may have changed. This walks every wallet TX, so bulk imports call it once at the end.
+     */
+    void RebuildWalletUTXOIndex()
+
+    EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     bool AddToWallet(const CWalletTx &wtxIn, bool fFlushOnClose = true, bool rescanningOldBlock = false);
 
     void LoadToWallet(CWalletTx &wtxIn)
@@ -1339,6 +1348,14 @@ public:
     ScanResult ScanForWalletTransactions(const uint256 &first_block, const uint256 &last_block,
                                          const WalletRescanReserver &reserver, bool fUpdate);
 
+    /**
+     * Whether SyncTransaction could do anything with a transaction whose outputs are not ours: it is a wallet
+     * transaction already, spends one of their outputs or conflicts with one of them.
+     */
+    bool IsRelatedToWalletTxs(const CTransaction &tx) const
+
+    EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     void TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolRemovalReason reason) override;
 
     void ReacceptWalletTransactions()
@@ -1364,6 +1381,12 @@ public:
     Balance
     GetBalance(int min_depth = 0, const bool fAddLocked = false, const CCoinControl *coinControl = nullptr) const;
 
+    /** The summed asset amounts of the outputs AvailableAssets() returns with its default arguments, by asset id */
+    std::map <std::string, CAmount> GetAssetBalances() const;
+
+    /** Drop the settled credit of the transaction, called whenever its cached credits are invalidated */
+    void UnsettleWalletTx(const CWalletTx &wtx) const;
+
     CAmount GetAnonymizableBalance(bool fSkipDenominated = false, bool fSkipUnconfirmed = true) const;
 
     float GetAverageAnonymizedRounds() const;
@@ -340,6 +340,38 @@ class AddressIndexTest(BitcoinTestFramework):
         mempool_deltas = self.nodes[2].getaddressmempool({"addresses": [address1]})
         assert_equal(len(mempool_deltas), 2)
 
+        self.log.info("Testing that pages of UTXOs match the full list for all assets...")
+        while True:
+            try:
+                self.nodes[1].getaddressutxos({"addresses": [address1], "asset": "*"})
+                break
+            except JSONRPCException as e:
+                assert "Assets aren't active" in e.error["message"]
+                self.nodes[0].generate(10)
+                self.sync_all()
+
+        addresses = [address1, address2, address3]
+        for asset in ["FTB", "*"]:
+            full = self.nodes[1].getaddressutxos({"addresses": addresses, "asset": asset})
+            if asset == "*":
+                full = [utxo for utxos in full.values() for utxo in utxos]
+            paged = []
+            cursor = ""
+            while True:
+                page = self.nodes[1].getaddressutxos({"addresses": addresses, "asset": asset, "limit": 1, "cursor": cursor})
+                assert len(page["utxos"]) <= 1
+                paged += page["utxos"]
+                cursor = page["next_cursor"]
+                if cursor == "":
+                    break
+            key = lambda utxo: (utxo["txid"], utxo["outputIndex"])
+            assert_equal(sorted(map(key, paged)), sorted(map(key, full)))
+            # '*' means all assets, the FTB outputs of these addresses are in neither list
+            ftb = self.nodes[1].getaddressutxos({"addresses": addresses})
+            assert len(ftb) > 0
+            if asset == "*":
+                assert not set(map(key, ftb)) & set(map(key, paged))
+
         self.log.info("Passed")
 
 